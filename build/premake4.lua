@@ -86,6 +86,8 @@ solution "test"
 	project "unittest"
 		kind "ConsoleApp"
 		
+		defines { "RAPIDJSONXML_SIMD_DISPATCH" }
+
 		if _ACTION == "gmake" then
 			buildoptions "-Weffc++ -Wswitch-default"
 		end
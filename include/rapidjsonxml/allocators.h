@@ -66,7 +66,7 @@ public:
 //! Default memory allocator used by the parser and DOM.
 /*! This allocator allocate memory blocks from pre-allocated memory chunks.
 
-    It does not free memory blocks. And Realloc() only allocate new memory.
+    It does not free memory blocks. Realloc() resizes the last block in place, and only allocates new memory for the other ones.
 
     The memory chunks are allocated by BaseAllocator, which is CrtAllocator by default.
 
@@ -166,24 +166,27 @@ public:
     }
 
     //! Resizes a memory block (concept Allocator)
+    /*! The last allocation is resized in place when the chunk has room, and
+        gives back its memory when shrunk. Other blocks do not shrink.
+    */
     void* Realloc(void* originalPtr, size_t originalSize, size_t newSize) {
         if (originalPtr == 0)
             return Malloc(newSize);
 
-        // Do not shrink if new size is smaller than original
-        if (originalSize >= newSize)
-            return originalPtr;
-
-        // Simply expand it if it is the last allocation and there is sufficient space
-        if (originalPtr == (char *)(chunkHead_ + 1) + chunkHead_->size - originalSize) {
-            size_t increment = static_cast<size_t>(newSize - originalSize);
-            increment = RAPIDJSONXML_ALIGN(increment);
-            if (chunkHead_->size + increment <= chunkHead_->capacity) {
-                chunkHead_->size += increment;
+        // Simply resize it if it is the last allocation and there is sufficient space
+        const size_t alignedOriginalSize = RAPIDJSONXML_ALIGN(originalSize);
+        if (originalPtr == (char *)(chunkHead_ + 1) + chunkHead_->size - alignedOriginalSize) {
+            const size_t size = chunkHead_->size - alignedOriginalSize + RAPIDJSONXML_ALIGN(newSize);
+            if (size <= chunkHead_->capacity) {
+                chunkHead_->size = size;
                 return originalPtr;
             }
         }
 
+        // Do not shrink if new size is smaller than original
+        if (originalSize >= newSize)
+            return originalPtr;
+
         // Realloc process: allocate and copy memory, do not free original buffer.
         void* newBuffer = Malloc(newSize);
         RAPIDJSONXML_ASSERT(newBuffer != 0); // Do not handle out-of-memory explicitly.
@@ -0,0 +1,346 @@
+#ifndef RAPIDJSONXML_ATTRIBUTE_H_
+#define RAPIDJSONXML_ATTRIBUTE_H_
+
+#include "rapidjsonxml.h"
+#include "internal/strfunc.h"
+#include <string>
+
+namespace rapidjsonxml {
+
+///////////////////////////////////////////////////////////////////////////////
+// GenericStringRef
+
+//! Reference to a constant string (not taking a copy)
+/*!
+    \tparam CharType character type of the string
+
+    This helper class is used to automatically infer constant string
+    references for string literals, especially from \c const \b (!)
+    character arrays.
+
+    The main use is for creating JSON string values without copying the
+    source string via an \ref Allocator.  This requires that the referenced
+    string pointers have a sufficient lifetime, which exceeds the lifetime
+    of the associated GenericValue.
+
+    \b Example
+    \code
+    Value v("foo");   // ok, no need to copy & calculate length
+    const char foo[] = "foo";
+    v.SetString(foo); // ok
+
+    const char* bar = foo;
+    // Value x(bar); // not ok, can't rely on bar's lifetime
+    Value x(StringRef(bar)); // lifetime explicitly guaranteed by user
+    Value y(StringRef(bar, 3));  // ok, explicitly pass length
+    \endcode
+
+    \see StringRef, GenericValue::SetString
+*/
+template<typename CharType>
+struct GenericStringRef {
+    typedef CharType Ch; //!< character type of the string
+
+    //! Create string reference from \c const character array
+    /*!
+        This constructor implicitly creates a constant string reference from
+        a \c const character array.  It has better performance than
+        \ref StringRef(const CharType*) by inferring the string \ref length
+        from the array length, and also supports strings containing null
+        characters.
+
+        \tparam N length of the string, automatically inferred
+
+        \param str Constant character array, lifetime assumed to be longer
+            than the use of the string in e.g. a GenericValue
+
+        \post \ref s == str
+
+        \note Constant complexity.
+        \note There is a hidden, private overload to disallow references to
+            non-const character arrays to be created via this constructor.
+            By this, e.g. function-scope arrays used to be filled via
+            \c snprintf are excluded from consideration.
+            In such cases, the referenced string should be \b copied to the
+            GenericValue instead.
+    */
+    template<SizeType N>
+    GenericStringRef(const CharType (&str)[N])
+        : s(str), length(N-1) {}
+
+    //! Explicitly create string reference from \c const character pointer
+    /*!
+        This constructor can be used to \b explicitly  create a reference to
+        a constant string pointer.
+
+        \see StringRef(const CharType*)
+
+        \param str Constant character pointer, lifetime assumed to be longer
+            than the use of the string in e.g. a GenericValue
+
+        \post \ref s == str
+
+        \note There is a hidden, private overload to disallow references to
+            non-const character arrays to be created via this constructor.
+            By this, e.g. function-scope arrays used to be filled via
+            \c snprintf are excluded from consideration.
+            In such cases, the referenced string should be \b copied to the
+            GenericValue instead.
+    */
+    explicit GenericStringRef(const CharType* str)
+        : s(str), length(internal::StrLen(str)) {}
+
+    //! Create constant string reference from pointer and length
+    /*! \param str constant string, lifetime assumed to be longer than the use of the string in e.g. a GenericValue
+        \param len length of the string, excluding the trailing NULL terminator
+
+        \post \ref s == str && \ref length == len
+        \note Constant complexity.
+    */
+    GenericStringRef(const CharType* str, SizeType len)
+        : s(str), length(len) {
+        RAPIDJSONXML_ASSERT(s != NULL);
+    }
+
+    //! Create constant string reference from std::string
+    /*! \param str constant string, lifetime assumed to be longer than the use of the string in e.g. a GenericValue
+
+        \post \ref s == str
+        \note Constant complexity.
+    */
+    explicit GenericStringRef(const std::string& str)
+        : s(str.c_str()), length(str.length()) {}
+
+    //! implicit conversion to plain CharType pointer
+    operator const Ch *() const {
+        return s;
+    }
+
+    const Ch* const s; //!< plain CharType pointer
+    const SizeType length; //!< length of the string (excluding the trailing NULL terminator)
+
+private:
+    //! Disallow copy-assignment
+    GenericStringRef operator=(const GenericStringRef&);
+    //! Disallow construction from non-const array
+    template<SizeType N>
+    GenericStringRef(CharType (&str)[N]) /* = delete */;
+};
+
+//! Mark a character pointer as constant string
+/*! Mark a plain character pointer as a "string literal".  This function
+    can be used to avoid copying a character string to be referenced as a
+    value in a JSON GenericValue object, if the string's lifetime is known
+    to be valid long enough.
+    \tparam CharType Character type of the string
+    \param str Constant string, lifetime assumed to be longer than the use of the string in e.g. a GenericValue
+    \return GenericStringRef string reference object
+    \relatesalso GenericStringRef
+
+    \see GenericValue::GenericValue(StringRefType), GenericValue::operator=(StringRefType), GenericValue::SetString(StringRefType), GenericValue::PushBack(StringRefType, Allocator&), GenericValue::AddMember
+*/
+template<typename CharType>
+inline GenericStringRef<CharType> StringRef(const CharType* str) {
+    return GenericStringRef<CharType>(str, internal::StrLen(str));
+}
+
+//! Mark a character pointer as constant string
+/*! Mark a plain character pointer as a "string literal".  This function
+    can be used to avoid copying a character string to be referenced as a
+    value in a JSON GenericValue object, if the string's lifetime is known
+    to be valid long enough.
+
+    This version has better performance with supplied length, and also
+    supports string containing null characters.
+
+    \tparam CharType character type of the string
+    \param str Constant string, lifetime assumed to be longer than the use of the string in e.g. a GenericValue
+    \param length The length of source string.
+    \return GenericStringRef string reference object
+    \relatesalso GenericStringRef
+*/
+template<typename CharType>
+inline GenericStringRef<CharType> StringRef(const CharType* str, size_t length) {
+    return GenericStringRef<CharType>(str, SizeType(length));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// GenericAttribute
+
+//! Represents an XML attribute for a value. Use Attribute for UTF8 encoding and default allocator.
+/*!
+    An XML attribute is a pair of strings representing a name and a value.
+
+    Use the Attribute if UTF8 and default allocator
+
+    \tparam Encoding    Encoding of the value. (Even non-string values need to have the same encoding in a document)
+*/
+template <typename Encoding, typename Allocator>
+class GenericAttribute {
+public:
+    typedef Encoding EncodingType;                                                                  //!< Encoding type from template parameter.
+    typedef Allocator AllocatorType;                                                                //!< Allocator type from template parameter.
+    typedef typename Encoding::Ch Ch;                                                               //!< Character type derived from Encoding.
+    typedef GenericStringRef<Ch> StringRefType;                                                     //!< Reference to a constant string
+
+    //!@name Constructors and destructor.
+    //@{
+
+    //! Default constructor creates a null value.
+    GenericAttribute() : name_(), value_(), flags_(kConstFlag) {}
+
+private:
+    //! Copy constructor is not permitted.
+    GenericAttribute(const GenericAttribute& rhs);
+
+public:
+    //! Constructor with name and value
+    GenericAttribute(StringRefType n, StringRefType v) : name_(), value_(), flags_(kConstFlag) {
+        SetNameRaw(n);
+        SetValueRaw(v);
+    }
+
+    //! Constructor for copy-string (i.e. do make a copy of string)
+    GenericAttribute(const Ch*n, const Ch*v, Allocator& allocator) : name_(), value_(), flags_(kConstFlag) {
+        SetNameRaw(StringRef(n), allocator);
+        SetValueRaw(StringRef(v), allocator);
+    }
+
+    //! Constructor for copy-string with lengths (i.e. do make a copy of string)
+    GenericAttribute(StringRefType n, StringRefType v, Allocator& allocator) : name_(), value_(), flags_(kConstFlag) {
+        SetNameRaw(n, allocator);
+        SetValueRaw(v, allocator);
+    }
+
+    //! Constructor for copy-string (i.e. do make a copy of string)
+    GenericAttribute(const std::string& n, const std::string& v, Allocator& allocator) : name_(), value_(), flags_(kConstFlag) {
+        SetNameRaw(StringRef(n.c_str(), n.length()), allocator);
+        SetValueRaw(StringRef(v.c_str(), v.length()), allocator);
+    }
+
+    // Destructor
+    ~GenericAttribute() {
+        FreeName();
+        FreeValue();
+    }
+
+    //@}
+
+    GenericAttribute& operator=(GenericAttribute& rhs) {
+        name_ = rhs.name_;
+        value_ = rhs.value_;
+        flags_ = rhs.flags_;
+        rhs.flags_ = kConstFlag;
+        return *this;
+    }
+
+    const Ch* GetName() const {
+        return name_.str;
+    }
+
+    SizeType GetNameLength() const {
+        return name_.length;
+    }
+
+    const Ch* GetValue() const {
+        return value_.str;
+    }
+
+    SizeType GetValueLength() const {
+        return value_.length;
+    }
+
+    //! Set the name as a constant string, the previous copy is freed.
+    GenericAttribute& SetName(StringRefType s) {
+        FreeName();
+        SetNameRaw(s);
+        return *this;
+    }
+
+    //! Set the name as a copy of a string, the previous copy is freed.
+    GenericAttribute& SetName(StringRefType s, Allocator& allocator) {
+        FreeName();
+        SetNameRaw(s, allocator);
+        return *this;
+    }
+
+    //! Set the value as a constant string, the previous copy is freed.
+    GenericAttribute& SetValue(StringRefType s) {
+        FreeValue();
+        SetValueRaw(s);
+        return *this;
+    }
+
+    //! Set the value as a copy of a string, the previous copy is freed.
+    GenericAttribute& SetValue(StringRefType s, Allocator& allocator) {
+        FreeValue();
+        SetValueRaw(s, allocator);
+        return *this;
+    }
+
+private:
+    struct String {
+        const Ch* str;
+        SizeType length;
+        unsigned hashcode; //!< reserved
+    }; // 12 bytes in 32-bit mode, 16 bytes in 64-bit mode
+
+    //! Initialize this name as constant string, without calling destructor.
+    void SetNameRaw(StringRefType s) {
+        flags_ = flags_ & ~kCopyNameFlag;
+        name_.str = s;
+        name_.length = s.length;
+    }
+
+    //! Initialize this name as copy string with initial data, without calling destructor.
+    void SetNameRaw(StringRefType s, Allocator& allocator) {
+        flags_ = flags_ | kCopyNameFlag;
+        name_.str = (Ch *)allocator.Malloc((s.length + 1) * sizeof(Ch));
+        name_.length = s.length;
+        memcpy(const_cast<Ch*>(name_.str), s, s.length * sizeof(Ch));
+        const_cast<Ch*>(name_.str)[s.length] = '\0';
+    }
+
+    //! Initialize this value as constant string, without calling destructor.
+    void SetValueRaw(StringRefType s) {
+        flags_ = flags_ & ~kCopyValueFlag;
+        value_.str = s;
+        value_.length = s.length;
+    }
+
+    //! Initialize this value as copy string with initial data, without calling destructor.
+    void SetValueRaw(StringRefType s, Allocator& allocator) {
+        flags_ = flags_ | kCopyValueFlag;
+        value_.str = (Ch *)allocator.Malloc((s.length + 1) * sizeof(Ch));
+        value_.length = s.length;
+        memcpy(const_cast<Ch*>(value_.str), s, s.length * sizeof(Ch));
+        const_cast<Ch*>(value_.str)[s.length] = '\0';
+    }
+
+    void FreeName() {
+        if (Allocator::kNeedFree && (flags_ & kCopyNameFlag)) // Shortcut by Allocator's trait
+            Allocator::Free(const_cast<Ch*>(name_.str));
+    }
+
+    void FreeValue() {
+        if (Allocator::kNeedFree && (flags_ & kCopyValueFlag))
+            Allocator::Free(const_cast<Ch*>(value_.str));
+    }
+
+    enum {
+        kConstFlag = 0x00,
+        kCopyNameFlag = 0x01,
+        kCopyValueFlag = 0x02
+    };
+
+    String name_;
+    String value_;
+    unsigned flags_;
+};
+
+//! GenericAttribute with UTF8 encoding
+typedef GenericAttribute<UTF8<> > Attribute;
+
+} // namespace rapidjsonxml
+
+#endif // RAPIDJSONXML_ATTRIBUTE_H_
@@ -3,6 +3,7 @@
 
 #include "rapidjsonxml.h"
 #include "reader.h"
+#include "attribute.h"
 #include "internal/strfunc.h"
 #include <new> // placement new
 
@@ -25,6 +26,9 @@ namespace rapidjsonxml {
 template <typename Encoding, typename Allocator>
 class GenericValue;
 
+template <typename ValueType>
+class GenericMemberAccessor;
+
 //! Name-value pair in a JSON object value.
 /*!
     This class was internal to GenericValue. It used to be a inner struct.
@@ -219,300 +223,6 @@ struct GenericMemberIterator<true,Encoding,Allocator> {
 
 #endif // RAPIDJSONXML_NOMEMBERITERATORCLASS
 
-///////////////////////////////////////////////////////////////////////////////
-// GenericStringRef
-
-//! Reference to a constant string (not taking a copy)
-/*!
-    \tparam CharType character type of the string
-
-    This helper class is used to automatically infer constant string
-    references for string literals, especially from \c const \b (!)
-    character arrays.
-
-    The main use is for creating JSON string values without copying the
-    source string via an \ref Allocator.  This requires that the referenced
-    string pointers have a sufficient lifetime, which exceeds the lifetime
-    of the associated GenericValue.
-
-    \b Example
-    \code
-    Value v("foo");   // ok, no need to copy & calculate length
-    const char foo[] = "foo";
-    v.SetString(foo); // ok
-
-    const char* bar = foo;
-    // Value x(bar); // not ok, can't rely on bar's lifetime
-    Value x(StringRef(bar)); // lifetime explicitly guaranteed by user
-    Value y(StringRef(bar, 3));  // ok, explicitly pass length
-    \endcode
-
-    \see StringRef, GenericValue::SetString
-*/
-template<typename CharType>
-struct GenericStringRef {
-    typedef CharType Ch; //!< character type of the string
-
-    //! Create string reference from \c const character array
-    /*!
-        This constructor implicitly creates a constant string reference from
-        a \c const character array.  It has better performance than
-        \ref StringRef(const CharType*) by inferring the string \ref length
-        from the array length, and also supports strings containing null
-        characters.
-
-        \tparam N length of the string, automatically inferred
-
-        \param str Constant character array, lifetime assumed to be longer
-            than the use of the string in e.g. a GenericValue
-
-        \post \ref s == str
-
-        \note Constant complexity.
-        \note There is a hidden, private overload to disallow references to
-            non-const character arrays to be created via this constructor.
-            By this, e.g. function-scope arrays used to be filled via
-            \c snprintf are excluded from consideration.
-            In such cases, the referenced string should be \b copied to the
-            GenericValue instead.
-    */
-    template<SizeType N>
-    GenericStringRef(const CharType (&str)[N])
-        : s(str), length(N-1) {}
-
-    //! Explicitly create string reference from \c const character pointer
-    /*!
-        This constructor can be used to \b explicitly  create a reference to
-        a constant string pointer.
-
-        \see StringRef(const CharType*)
-
-        \param str Constant character pointer, lifetime assumed to be longer
-            than the use of the string in e.g. a GenericValue
-
-        \post \ref s == str
-
-        \note There is a hidden, private overload to disallow references to
-            non-const character arrays to be created via this constructor.
-            By this, e.g. function-scope arrays used to be filled via
-            \c snprintf are excluded from consideration.
-            In such cases, the referenced string should be \b copied to the
-            GenericValue instead.
-    */
-    explicit GenericStringRef(const CharType* str)
-        : s(str), length(internal::StrLen(str)) {}
-
-    //! Create constant string reference from pointer and length
-    /*! \param str constant string, lifetime assumed to be longer than the use of the string in e.g. a GenericValue
-        \param len length of the string, excluding the trailing NULL terminator
-
-        \post \ref s == str && \ref length == len
-        \note Constant complexity.
-    */
-    GenericStringRef(const CharType* str, SizeType len)
-        : s(str), length(len) {
-        RAPIDJSONXML_ASSERT(s != NULL);
-    }
-
-    //! Create constant string reference from std::string
-    /*! \param str constant string, lifetime assumed to be longer than the use of the string in e.g. a GenericValue
-
-        \post \ref s == str
-        \note Constant complexity.
-    */
-    explicit GenericStringRef(const std::string& str)
-        : s(str.c_str()), length(str.length()) {}
-
-    //! implicit conversion to plain CharType pointer
-    operator const Ch *() const {
-        return s;
-    }
-
-    const Ch* const s; //!< plain CharType pointer
-    const SizeType length; //!< length of the string (excluding the trailing NULL terminator)
-
-private:
-    //! Disallow copy-assignment
-    GenericStringRef operator=(const GenericStringRef&);
-    //! Disallow construction from non-const array
-    template<SizeType N>
-    GenericStringRef(CharType (&str)[N]) /* = delete */;
-};
-
-//! Mark a character pointer as constant string
-/*! Mark a plain character pointer as a "string literal".  This function
-    can be used to avoid copying a character string to be referenced as a
-    value in a JSON GenericValue object, if the string's lifetime is known
-    to be valid long enough.
-    \tparam CharType Character type of the string
-    \param str Constant string, lifetime assumed to be longer than the use of the string in e.g. a GenericValue
-    \return GenericStringRef string reference object
-    \relatesalso GenericStringRef
-
-    \see GenericValue::GenericValue(StringRefType), GenericValue::operator=(StringRefType), GenericValue::SetString(StringRefType), GenericValue::PushBack(StringRefType, Allocator&), GenericValue::AddMember
-*/
-template<typename CharType>
-inline GenericStringRef<CharType> StringRef(const CharType* str) {
-    return GenericStringRef<CharType>(str, internal::StrLen(str));
-}
-
-//! Mark a character pointer as constant string
-/*! Mark a plain character pointer as a "string literal".  This function
-    can be used to avoid copying a character string to be referenced as a
-    value in a JSON GenericValue object, if the string's lifetime is known
-    to be valid long enough.
-
-    This version has better performance with supplied length, and also
-    supports string containing null characters.
-
-    \tparam CharType character type of the string
-    \param str Constant string, lifetime assumed to be longer than the use of the string in e.g. a GenericValue
-    \param length The length of source string.
-    \return GenericStringRef string reference object
-    \relatesalso GenericStringRef
-*/
-template<typename CharType>
-inline GenericStringRef<CharType> StringRef(const CharType* str, size_t length) {
-    return GenericStringRef<CharType>(str, SizeType(length));
-}
-
-///////////////////////////////////////////////////////////////////////////////
-// GenericAttribute
-
-//! Represents an XML attribute for a value. Use Attribute for UTF8 encoding and default allocator.
-/*!
-    An XML attribute is a pair of strings representing a name and a value.
-
-    Use the Attribute if UTF8 and default allocator
-
-    \tparam Encoding    Encoding of the value. (Even non-string values need to have the same encoding in a document)
-*/
-template <typename Encoding, typename Allocator>
-class GenericAttribute {
-public:
-    typedef Encoding EncodingType;                                                                  //!< Encoding type from template parameter.
-    typedef Allocator AllocatorType;                                                                //!< Allocator type from template parameter.
-    typedef typename Encoding::Ch Ch;                                                               //!< Character type derived from Encoding.
-    typedef GenericStringRef<Ch> StringRefType;                                                     //!< Reference to a constant string
-
-    //!@name Constructors and destructor.
-    //@{
-
-    //! Default constructor creates a null value.
-    GenericAttribute() : name_(), value_(), flags_(kConstFlag) {}
-
-private:
-    //! Copy constructor is not permitted.
-    GenericAttribute(const GenericAttribute& rhs);
-
-public:
-    //! Constructor with name and value
-    GenericAttribute(StringRefType n, StringRefType v) : name_(), value_(), flags_(kConstFlag) {
-        SetNameRaw(n);
-        SetValueRaw(v);
-    }
-
-    //! Constructor for copy-string (i.e. do make a copy of string)
-    GenericAttribute(const Ch*n, const Ch*v, Allocator& allocator) : name_(), value_(), flags_(kConstFlag) {
-        SetNameRaw(StringRef(n), allocator);
-        SetValueRaw(StringRef(v), allocator);
-    }
-
-    //! Constructor for copy-string (i.e. do make a copy of string)
-    GenericAttribute(const std::string& n, const std::string& v, Allocator& allocator) : name_(), value_(), flags_(kConstFlag) {
-        SetNameRaw(StringRef(n.c_str(), n.length()), allocator);
-        SetValueRaw(StringRef(v.c_str(), v.length()), allocator);
-    }
-
-    // Destructor
-    ~GenericAttribute() {
-        if (Allocator::kNeedFree) { // Shortcut by Allocator's trait
-            if (flags_ & kCopyNameFlag)
-                Allocator::Free(const_cast<Ch*>(name_.str));
-            if (flags_ & kCopyValueFlag)
-                Allocator::Free(const_cast<Ch*>(value_.str));
-        }
-    }
-
-    //@}
-
-    GenericAttribute& operator=(GenericAttribute& rhs) {
-        name_ = rhs.name_;
-        value_ = rhs.value_;
-        flags_ = rhs.flags_;
-        rhs.flags_ = kConstFlag;
-        return *this;
-    }
-
-    const Ch* GetName() const {
-        return name_.str;
-    }
-
-    SizeType GetNameLength() const {
-        return name_.length;
-    }
-
-    const Ch* GetValue() const {
-        return value_.str;
-    }
-
-    SizeType GetValueLength() const {
-        return value_.length;
-    }
-
-private:
-    struct String {
-        const Ch* str;
-        SizeType length;
-        unsigned hashcode; //!< reserved
-    }; // 12 bytes in 32-bit mode, 16 bytes in 64-bit mode
-
-    //! Initialize this name as constant string, without calling destructor.
-    void SetNameRaw(StringRefType s) {
-        flags_ = flags_ & !kCopyNameFlag;
-        name_.str = s;
-        name_.length = s.length;
-    }
-
-    //! Initialize this name as copy string with initial data, without calling destructor.
-    void SetNameRaw(StringRefType s, Allocator& allocator) {
-        flags_ = flags_ | kCopyNameFlag;
-        name_.str = (Ch *)allocator.Malloc((s.length + 1) * sizeof(Ch));
-        name_.length = s.length;
-        memcpy(const_cast<Ch*>(name_.str), s, s.length * sizeof(Ch));
-        const_cast<Ch*>(name_.str)[s.length] = '\0';
-    }
-
-    //! Initialize this value as constant string, without calling destructor.
-    void SetValueRaw(StringRefType s) {
-        flags_ = flags_ & !kCopyValueFlag;
-        value_.str = s;
-        value_.length = s.length;
-    }
-
-    //! Initialize this value as copy string with initial data, without calling destructor.
-    void SetValueRaw(StringRefType s, Allocator& allocator) {
-        flags_ = flags_ | kCopyValueFlag;
-        value_.str = (Ch *)allocator.Malloc((s.length + 1) * sizeof(Ch));
-        value_.length = s.length;
-        memcpy(const_cast<Ch*>(value_.str), s, s.length * sizeof(Ch));
-        const_cast<Ch*>(value_.str)[s.length] = '\0';
-    }
-
-    enum {
-        kConstFlag = 0x00,
-        kCopyNameFlag = 0x01,
-        kCopyValueFlag = 0x02
-    };
-
-    String name_;
-    String value_;
-    unsigned flags_;
-};
-
-//! GenericAttribute with UTF8 encoding
-typedef GenericAttribute<UTF8<> > Attribute;
-
 ///////////////////////////////////////////////////////////////////////////////
 // GenericValue
 
@@ -550,7 +260,7 @@ public:
     //@{
 
     //! Default constructor creates a null value.
-    GenericValue() : data_(), flags_(kNullFlag), attributes_() {}
+    GenericValue() : data_() { data_.f.flags = kNullFlag; }
 
 private:
     //! Copy constructor is not permitted.
@@ -563,13 +273,13 @@ public:
         \param type Type of the value.
         \note Default content for number is zero.
     */
-    GenericValue(Type type) : data_(), flags_(), attributes_() {
-        static const unsigned defaultFlags[7] = {
+    GenericValue(Type type) : data_() {
+        static const uint16_t defaultFlags[7] = {
             kNullFlag, kFalseFlag, kTrueFlag, kObjectFlag, kArrayFlag, kConstStringFlag,
             kNumberAnyFlag
         };
         RAPIDJSONXML_ASSERT(type <= kNumberType);
-        flags_ = defaultFlags[type];
+        data_.f.flags = defaultFlags[type];
     }
 
     //! Explicit copy constructor (with allocator)
@@ -594,74 +304,79 @@ public:
 #else
     explicit GenericValue(bool b)
 #endif
-        : data_(), flags_(b ? kTrueFlag : kFalseFlag), attributes_() {}
+        : data_() { data_.f.flags = b ? kTrueFlag : kFalseFlag; }
 
     //! Constructor for int value.
-    explicit GenericValue(int i) : data_(), flags_(kNumberIntFlag), attributes_() {
+    explicit GenericValue(int i) : data_() {
+        data_.f.flags = kNumberIntFlag;
         data_.n.i64 = i;
         if (i >= 0)
-            flags_ |= kUintFlag | kUint64Flag;
+            data_.f.flags |= kUintFlag | kUint64Flag;
     }
 
     //! Constructor for unsigned value.
-    explicit GenericValue(unsigned u) : data_(), flags_(kNumberUintFlag), attributes_() {
+    explicit GenericValue(unsigned u) : data_() {
+        data_.f.flags = kNumberUintFlag;
         data_.n.u64 = u;
         if (!(u & 0x80000000))
-            flags_ |= kIntFlag | kInt64Flag;
+            data_.f.flags |= kIntFlag | kInt64Flag;
     }
 
     //! Constructor for int64_t value.
-    explicit GenericValue(int64_t i64) : data_(), flags_(kNumberInt64Flag), attributes_() {
+    explicit GenericValue(int64_t i64) : data_() {
+        data_.f.flags = kNumberInt64Flag;
         data_.n.i64 = i64;
         if (i64 >= 0) {
-            flags_ |= kNumberUint64Flag;
+            data_.f.flags |= kNumberUint64Flag;
             if (!(static_cast<uint64_t>(i64) & UINT64_C(0xFFFFFFFF00000000)))
-                flags_ |= kUintFlag;
+                data_.f.flags |= kUintFlag;
             if (!(static_cast<uint64_t>(i64) & UINT64_C(0xFFFFFFFF80000000)))
-                flags_ |= kIntFlag;
+                data_.f.flags |= kIntFlag;
         }
         else if (i64 >= INT64_C(-2147483648))
-            flags_ |= kIntFlag;
+            data_.f.flags |= kIntFlag;
     }
 
     //! Constructor for uint64_t value.
-    explicit GenericValue(uint64_t u64) : data_(), flags_(kNumberUint64Flag), attributes_() {
+    explicit GenericValue(uint64_t u64) : data_() {
+        data_.f.flags = kNumberUint64Flag;
         data_.n.u64 = u64;
         if (!(u64 & UINT64_C(0x8000000000000000)))
-            flags_ |= kInt64Flag;
+            data_.f.flags |= kInt64Flag;
         if (!(u64 & UINT64_C(0xFFFFFFFF00000000)))
-            flags_ |= kUintFlag;
+            data_.f.flags |= kUintFlag;
         if (!(u64 & UINT64_C(0xFFFFFFFF80000000)))
-            flags_ |= kIntFlag;
+            data_.f.flags |= kIntFlag;
     }
 
     //! Constructor for double value.
-    explicit GenericValue(double d) : data_(), flags_(kNumberDoubleFlag), attributes_() {
+    explicit GenericValue(double d) : data_() {
+        data_.f.flags = kNumberDoubleFlag;
         data_.n.d = d;
     }
 
     //! Constructor for constant string (i.e. do not make a copy of string)
-    GenericValue(const Ch* s, SizeType length) : data_(), flags_(), attributes_() {
+    GenericValue(const Ch* s, SizeType length) : data_() {
         SetStringRaw(StringRef(s, length));
     }
 
     //! Constructor for constant string (i.e. do not make a copy of string)
-    explicit GenericValue(StringRefType s) : data_(), flags_(), attributes_() {
+    explicit GenericValue(StringRefType s) : data_() {
         SetStringRaw(s);
     }
 
     //! Constructor for copy-string (i.e. do make a copy of string)
-    GenericValue(const Ch* s, SizeType length, Allocator& allocator) : data_(), flags_(), attributes_() {
+    GenericValue(const Ch* s, SizeType length, Allocator& allocator) : data_() {
         SetStringRaw(StringRef(s, length), allocator);
     }
 
     //! Constructor for copy-string (i.e. do make a copy of string)
-    GenericValue(const Ch*s, Allocator& allocator) : data_(), flags_(), attributes_() {
+    GenericValue(const Ch*s, Allocator& allocator) : data_() {
         SetStringRaw(StringRef(s), allocator);
     }
 
     //! Constructor for copy-string (i.e. do make a copy of string)
-    GenericValue(const std::string& s, Allocator& allocator) : data_(), flags_(), attributes_() {
+    GenericValue(const std::string& s, Allocator& allocator) : data_() {
         SetStringRaw(StringRef(s.c_str(), s.length()), allocator);
     }
 
@@ -670,11 +385,11 @@ public:
     */
     ~GenericValue() {
         if (Allocator::kNeedFree) { // Shortcut by Allocator's trait
-            switch(flags_) {
+            switch(GetFlags()) {
             case kArrayFlag:
-                for (GenericValue* v = data_.a.elements; v != data_.a.elements + data_.a.size; ++v)
+                for (ValueIterator v = Begin(); v != End(); ++v)
                     v->~GenericValue();
-                Allocator::Free(data_.a.elements);
+                Allocator::Free(GetElementsPointer());
                 break;
 
             case kObjectFlag:
@@ -682,11 +397,11 @@ public:
                     m->name.~GenericValue();
                     m->value.~GenericValue();
                 }
-                Allocator::Free(data_.o.members);
+                Allocator::Free(GetMembersPointer());
                 break;
 
             case kCopyStringFlag:
-                Allocator::Free(const_cast<Ch*>(data_.s.str));
+                Allocator::Free(const_cast<Ch*>(GetStringPointer()));
                 break;
 
             default:
@@ -694,9 +409,13 @@ public:
             }
 
             // Destroy attributes
-            for (AttributeIterator a = attributes_.elements; a != attributes_.elements + attributes_.size; ++a)
-                a->~GenericAttribute();
-            Allocator::Free(attributes_.elements);
+            if (data_.f.flags & kAttributeFlag) {
+                AttributeArray* attributes = GetAttributeArray();
+                for (AttributeIterator a = attributes->elements; a != attributes->elements + attributes->size; ++a)
+                    a->~GenericAttribute();
+                Allocator::Free(attributes->elements);
+                Allocator::Free(attributes);
+            }
         }
     }
 
@@ -778,50 +497,115 @@ public:
     }
     //@}
 
+    //!@name Equal-to and not-equal-to operators
+    //@{
+    //! Equal-to operator
+    /*!
+        \note The members of an object are compared in place while the names are in the same order,
+            then with the member of the same name in the other one. With repeated names, as from the
+            repeated elements of GenericXmlReader, the k-th member of a name is compared with the k-th
+            member of this name in the other one.
+        \note Linear time complexity (number of all values in the subtree and total lengths of all strings)
+            for objects with their members in the same order.
+        \note The attributes are not compared.
+    */
+    bool operator==(const GenericValue& rhs) const {
+        if (GetType() != rhs.GetType())
+            return false;
+
+        switch (GetType()) {
+        case kObjectType: { // Warning: O(n^2) inner-loop for members in another order, without member index or with repeated names
+            if (data_.o.size != rhs.data_.o.size)
+                return false;
+            ConstMemberIterator lhsMemberItr = MemberBegin(), rhsMemberItr = rhs.MemberBegin();
+            for (; lhsMemberItr != MemberEnd() && lhsMemberItr->name.StringEqual(rhsMemberItr->name); ++lhsMemberItr, ++rhsMemberItr)
+                if (lhsMemberItr->value != rhsMemberItr->value)
+                    return false;
+            const bool unique = HasUniqueNames() && rhs.HasUniqueNames();
+            for (; lhsMemberItr != MemberEnd(); ++lhsMemberItr) {
+                rhsMemberItr = unique ? rhs.FindMember(lhsMemberItr->name) :
+                    rhs.FindMemberOccurrence(lhsMemberItr->name, CountMembers(MemberBegin(), lhsMemberItr, lhsMemberItr->name));
+                if (rhsMemberItr == rhs.MemberEnd() || lhsMemberItr->value != rhsMemberItr->value)
+                    return false;
+            }
+            return true;
+        }
+
+        case kArrayType:
+            if (data_.a.size != rhs.data_.a.size)
+                return false;
+            for (SizeType i = 0; i < data_.a.size; i++)
+                if ((*this)[i] != rhs[i])
+                    return false;
+            return true;
+
+        case kStringType:
+            return StringEqual(rhs);
+
+        case kNumberType:
+            if (IsDouble() || rhs.IsDouble())
+                return GetDouble() == rhs.GetDouble(); // May convert one operand from integer to double.
+            return IsInt64() == rhs.IsInt64() && data_.n.u64 == rhs.data_.n.u64;
+
+        default: // kTrueType, kFalseType, kNullType
+            return true;
+        }
+    }
+
+    //! Equal-to operator with const C-string pointer
+    bool operator==(const Ch* rhs) const { return *this == GenericValue(StringRef(rhs)); }
+
+    //! Not-equal-to operator
+    bool operator!=(const GenericValue& rhs) const { return !(*this == rhs); }
+
+    //! Not-equal-to operator with const C-string pointer
+    bool operator!=(const Ch* rhs) const { return !(*this == rhs); }
+    //@}
+
     //!@name Type
     //@{
 
     Type GetType() const {
-        return static_cast<Type>(flags_ & kTypeMask);
+        return static_cast<Type>(data_.f.flags & kTypeMask);
     }
     bool IsNull() const {
-        return flags_ == kNullFlag;
+        return GetFlags() == kNullFlag;
     }
     bool IsFalse() const {
-        return flags_ == kFalseFlag;
+        return GetFlags() == kFalseFlag;
     }
     bool IsTrue() const {
-        return flags_ == kTrueFlag;
+        return GetFlags() == kTrueFlag;
     }
     bool IsBool() const {
-        return (flags_ & kBoolFlag) != 0;
+        return (data_.f.flags & kBoolFlag) != 0;
     }
     bool IsObject() const {
-        return flags_ == kObjectFlag;
+        return GetFlags() == kObjectFlag;
     }
     bool IsArray() const {
-        return flags_ == kArrayFlag;
+        return GetFlags() == kArrayFlag;
     }
     bool IsNumber() const {
-        return (flags_ & kNumberFlag) != 0;
+        return (data_.f.flags & kNumberFlag) != 0;
     }
     bool IsInt() const {
-        return (flags_ & kIntFlag) != 0;
+        return (data_.f.flags & kIntFlag) != 0;
     }
     bool IsUint() const {
-        return (flags_ & kUintFlag) != 0;
+        return (data_.f.flags & kUintFlag) != 0;
     }
     bool IsInt64() const {
-        return (flags_ & kInt64Flag) != 0;
+        return (data_.f.flags & kInt64Flag) != 0;
     }
     bool IsUint64() const {
-        return (flags_ & kUint64Flag) != 0;
+        return (data_.f.flags & kUint64Flag) != 0;
     }
     bool IsDouble() const {
-        return (flags_ & kDoubleFlag) != 0;
+        return (data_.f.flags & kDoubleFlag) != 0;
     }
     bool IsString() const {
-        return (flags_ & kStringFlag) != 0;
+        return (data_.f.flags & kStringFlag) != 0;
     }
 
     //@}
@@ -830,40 +614,47 @@ public:
     //@{
     //! Check whether there are attributes.
     bool HasAttributes() const {
-        return attributes_.size != 0;
+        return (data_.f.flags & kAttributeFlag) && GetAttributeArray()->size != 0;
     }
 
     //! Get the number of attributes.
     SizeType CountAttributes() const {
-        return attributes_.size;
+        return (data_.f.flags & kAttributeFlag) ? GetAttributeArray()->size : 0;
     }
 
     //! Remove all attributes.
     /*! This function do not deallocate memory in the array, i.e. the capacity is unchanged.
      */
     void ClearAttributes() {
-        for (SizeType i = 0; i < attributes_.size; ++i)
-            attributes_.elements[i].~GenericAttribute();
-        attributes_.size = 0;
+        if (!(data_.f.flags & kAttributeFlag))
+            return;
+        AttributeArray* attributes = GetAttributeArray();
+        for (SizeType i = 0; i < attributes->size; ++i)
+            attributes->elements[i].~GenericAttribute();
+        attributes->size = 0;
     }
 
     //! Add an attribute.
     GenericValue& AddAttribute(AttributeType& attribute, Allocator& allocator) {
-        if (attributes_.size >= attributes_.capacity) {
-            SizeType newCapacity = attributes_.capacity == 0 ? kDefaultArrayCapacity : attributes_.capacity * 2;
-            attributes_.elements = (AttributeType*)allocator.Realloc(attributes_.elements, attributes_.capacity * sizeof(AttributeType), newCapacity * sizeof(AttributeType));
-            attributes_.capacity = newCapacity;
+        AttributeArray* attributes = ReserveAttributes(allocator);
+        if (attributes->size >= attributes->capacity) {
+            SizeType newCapacity = attributes->capacity == 0 ? kDefaultAttributeCapacity : attributes->capacity * 2;
+            attributes->elements = (AttributeType*)allocator.Realloc(attributes->elements, attributes->capacity * sizeof(AttributeType), newCapacity * sizeof(AttributeType));
+            attributes->capacity = newCapacity;
         }
-        attributes_.elements[attributes_.size++] = attribute;
+        attributes->elements[attributes->size++] = attribute;
         return *this;
     }
 
     //! Element iterator
     AttributeIterator AttributeBegin() {
-        return attributes_.elements;
+        return (data_.f.flags & kAttributeFlag) ? GetAttributeArray()->elements : 0;
     }
     AttributeIterator AttributeEnd() {
-        return attributes_.elements + attributes_.size;
+        if (!(data_.f.flags & kAttributeFlag))
+            return 0;
+        AttributeArray* attributes = GetAttributeArray();
+        return attributes->elements + attributes->size;
     }
     ConstAttributeIterator AttributeBegin() const {
         return const_cast<GenericValue&>(*this).AttributeBegin();
@@ -877,16 +668,22 @@ public:
     GenericValue& CloneAttributes(const GenericValue<Encoding,SourceAllocator>& rhs, Allocator& allocator) {
         RAPIDJSONXML_ASSERT((void*)this != (void const*)&rhs);
         ClearAttributes();
-        if (attributes_.capacity < rhs.attributes_.size) {
-            SizeType newCapacity = attributes_.capacity == 0 ? kDefaultArrayCapacity : attributes_.capacity * 2;
-            while (newCapacity < rhs.attributes_.size)
+        const SizeType count = rhs.CountAttributes();
+        if (count == 0)
+            return *this;
+        AttributeArray* attributes = ReserveAttributes(allocator);
+        if (attributes->capacity < count) {
+            SizeType newCapacity = attributes->capacity == 0 ? kDefaultAttributeCapacity : attributes->capacity * 2;
+            while (newCapacity < count)
                 newCapacity *= 2;
-            attributes_.elements = (AttributeType*)allocator.Realloc(attributes_.elements, attributes_.capacity * sizeof(AttributeType), newCapacity * sizeof(AttributeType));
-            attributes_.capacity = newCapacity;
+            attributes->elements = (AttributeType*)allocator.Realloc(attributes->elements, attributes->capacity * sizeof(AttributeType), newCapacity * sizeof(AttributeType));
+            attributes->capacity = newCapacity;
         }
-        for (SizeType i = 0; i < rhs.attributes_.size; ++i)
-            attributes_.elements[i] = rhs.attributes_.elements[i];
-        attributes_.size = rhs.attributes_.size;
+        typename GenericValue<Encoding,SourceAllocator>::ConstAttributeIterator a = rhs.AttributeBegin();
+        for (SizeType i = 0; i < count; ++i)
+            new (&attributes->elements[i]) AttributeType(StringRefType(a[i].GetName(), a[i].GetNameLength()),
+                StringRefType(a[i].GetValue(), a[i].GetValueLength()), allocator);
+        attributes->size = count;
         return *this;
     }
 
@@ -908,7 +705,7 @@ public:
 
     bool GetBool() const {
         RAPIDJSONXML_ASSERT(IsBool());
-        return flags_ == kTrueFlag;
+        return GetFlags() == kTrueFlag;
     }
     //!< Set boolean value
     /*! \post IsBool() == true */
@@ -966,25 +763,25 @@ public:
     /*! \pre IsObject() == true */
     ConstMemberIterator MemberBegin() const {
         RAPIDJSONXML_ASSERT(IsObject());
-        return ConstMemberIterator(data_.o.members);
+        return ConstMemberIterator(GetMembersPointer());
     }
     //! Const \em past-the-end member iterator
     /*! \pre IsObject() == true */
     ConstMemberIterator MemberEnd() const {
         RAPIDJSONXML_ASSERT(IsObject());
-        return ConstMemberIterator(data_.o.members + data_.o.size);
+        return ConstMemberIterator(GetMembersPointer() + data_.o.size);
     }
     //! Member iterator
     /*! \pre IsObject() == true */
     MemberIterator MemberBegin() {
         RAPIDJSONXML_ASSERT(IsObject());
-        return MemberIterator(data_.o.members);
+        return MemberIterator(GetMembersPointer());
     }
     //! \em Past-the-end member iterator
     /*! \pre IsObject() == true */
     MemberIterator MemberEnd() {
         RAPIDJSONXML_ASSERT(IsObject());
-        return MemberIterator(data_.o.members + data_.o.size);
+        return MemberIterator(GetMembersPointer() + data_.o.size);
     }
 
     //! Check whether a member exists in the object.
@@ -1022,14 +819,30 @@ public:
 
     // This version is faster because it does not need a StrLen().
     // It can also handle string with null character.
+    // Large objects are searched with their hash index (see RAPIDJSONXML_MEMBER_INDEX_CAPACITY),
+    // and the names of the same length are rejected by their hashes when known.
     MemberIterator FindMember(const GenericValue& name) {
         RAPIDJSONXML_ASSERT(IsObject());
         RAPIDJSONXML_ASSERT(name.IsString());
-        SizeType len = name.data_.s.length;
+        if (HasMemberIndex(data_.o.capacity))
+            return FindMemberIndexed(name);
+        SizeType len = name.GetStringLength();
+        const Ch* str = name.GetStringPointer();
+        SizeType hash = name.GetCachedStringHash(); // computed at the first name with a hash
         MemberIterator member = MemberBegin();
-        for ( ; member != MemberEnd(); ++member)
-            if (member->name.data_.s.length == len && memcmp(member->name.data_.s.str, name.data_.s.str, len * sizeof(Ch)) == 0)
+        for ( ; member != MemberEnd(); ++member) {
+            if (member->name.GetStringLength() != len)
+                continue;
+            SizeType memberHash = member->name.GetCachedStringHash();
+            if (memberHash != 0) {
+                if (hash == 0)
+                    hash = internal::StrHash(str, len);
+                if (memberHash != hash)
+                    continue;
+            }
+            if (memcmp(member->name.GetStringPointer(), str, len * sizeof(Ch)) == 0)
                 break;
+        }
         return member;
     }
     ConstMemberIterator FindMember(const GenericValue& name) const {
@@ -1042,6 +855,7 @@ public:
         \param allocator Allocator for reallocating memory. It must be the same one as used before. Commonly use GenericDocument::GetAllocator().
         \return The value itself for fluent API.
         \note The ownership of \c name and \c value will be transferred to this object on success.
+        \note The names of the members must not be modified once added, as they are hashed by large objects.
         \pre  IsObject() && name.IsString()
         \post name.IsNull() && value.IsNull()
     */
@@ -1053,17 +867,23 @@ public:
         if (o.size >= o.capacity) {
             if (o.capacity == 0) {
                 o.capacity = kDefaultObjectCapacity;
-                o.members = reinterpret_cast<Member*>(allocator.Malloc(o.capacity * sizeof(Member)));
+                SetMembersPointer(reinterpret_cast<Member*>(allocator.Malloc(MembersAllocationSize(o.capacity))));
             }
             else {
                 SizeType oldCapacity = o.capacity;
                 o.capacity *= 2;
-                o.members = reinterpret_cast<Member*>(allocator.Realloc(o.members, oldCapacity * sizeof(Member), o.capacity * sizeof(Member)));
+                SetMembersPointer(reinterpret_cast<Member*>(allocator.Realloc(GetMembersPointer(), MembersAllocationSize(oldCapacity), MembersAllocationSize(o.capacity))));
             }
+            if (HasMemberIndex(o.capacity))
+                SetUniqueNames(BuildMemberIndex());
         }
-        o.members[o.size].name.RawAssign(name);
-        o.members[o.size].value.RawAssign(value);
+        Member* members = GetMembersPointer();
+        members[o.size].name.RawAssign(name);
+        members[o.size].name.CacheStringHash();
+        members[o.size].value.RawAssign(value);
         o.size++;
+        // Only the member index tells whether the name is new
+        SetUniqueNames(HasMemberIndex(o.capacity) && AddMemberIndex(o.size - 1) && HasUniqueNames());
         return *this;
     }
 
@@ -1156,10 +976,12 @@ public:
     MemberIterator RemoveMember(MemberIterator m) {
         RAPIDJSONXML_ASSERT(IsObject());
         RAPIDJSONXML_ASSERT(data_.o.size > 0);
-        RAPIDJSONXML_ASSERT(data_.o.members != 0);
+        RAPIDJSONXML_ASSERT(GetMembersPointer() != 0);
         RAPIDJSONXML_ASSERT(m >= MemberBegin() && m < MemberEnd());
 
-        MemberIterator last(data_.o.members + (data_.o.size - 1));
+        MemberIterator last(GetMembersPointer() + (data_.o.size - 1));
+        if (HasMemberIndex(data_.o.capacity))
+            RemoveMemberIndex(static_cast<SizeType>(m - MemberBegin()));
         if (data_.o.size > 1 && m != last) {
             // Move the last one to this place
             m->name = last->name;
@@ -1210,8 +1032,9 @@ public:
     */
     void Clear() {
         RAPIDJSONXML_ASSERT(IsArray());
+        GenericValue* e = GetElementsPointer();
         for (SizeType i = 0; i < data_.a.size; ++i)
-            data_.a.elements[i].~GenericValue();
+            e[i].~GenericValue();
         data_.a.size = 0;
     }
 
@@ -1228,7 +1051,7 @@ public:
     GenericValue& operator[](SizeType index) {
         RAPIDJSONXML_ASSERT(IsArray());
         RAPIDJSONXML_ASSERT(index < data_.a.size);
-        return data_.a.elements[index];
+        return GetElementsPointer()[index];
     }
     const GenericValue& operator[](SizeType index) const {
         return const_cast<GenericValue&>(*this)[index];
@@ -1237,11 +1060,11 @@ public:
     //! Element iterator
     ValueIterator Begin() {
         RAPIDJSONXML_ASSERT(IsArray());
-        return data_.a.elements;
+        return GetElementsPointer();
     }
     ValueIterator End() {
         RAPIDJSONXML_ASSERT(IsArray());
-        return data_.a.elements + data_.a.size;
+        return GetElementsPointer() + data_.a.size;
     }
     ConstValueIterator Begin() const {
         return const_cast<GenericValue&>(*this).Begin();
@@ -1258,7 +1081,7 @@ public:
     GenericValue& Reserve(SizeType newCapacity, Allocator &allocator) {
         RAPIDJSONXML_ASSERT(IsArray());
         if (newCapacity > data_.a.capacity) {
-            data_.a.elements = (GenericValue*)allocator.Realloc(data_.a.elements, data_.a.capacity * sizeof(GenericValue), newCapacity * sizeof(GenericValue));
+            SetElementsPointer((GenericValue*)allocator.Realloc(GetElementsPointer(), data_.a.capacity * sizeof(GenericValue), newCapacity * sizeof(GenericValue)));
             data_.a.capacity = newCapacity;
         }
         return *this;
@@ -1277,7 +1100,7 @@ public:
         RAPIDJSONXML_ASSERT(IsArray());
         if (data_.a.size >= data_.a.capacity)
             Reserve(data_.a.capacity == 0 ? kDefaultArrayCapacity : data_.a.capacity * 2, allocator);
-        data_.a.elements[data_.a.size++].RawAssign(value);
+        GetElementsPointer()[data_.a.size++].RawAssign(value);
         return *this;
     }
 
@@ -1330,7 +1153,7 @@ public:
     GenericValue& PopBack() {
         RAPIDJSONXML_ASSERT(IsArray());
         RAPIDJSONXML_ASSERT(!Empty());
-        data_.a.elements[--data_.a.size].~GenericValue();
+        GetElementsPointer()[--data_.a.size].~GenericValue();
         return *this;
     }
     //@}
@@ -1339,29 +1162,29 @@ public:
     //@{
 
     int GetInt() const {
-        RAPIDJSONXML_ASSERT(flags_ & kIntFlag);
+        RAPIDJSONXML_ASSERT(data_.f.flags & kIntFlag);
         return data_.n.i.i;
     }
     unsigned GetUint() const {
-        RAPIDJSONXML_ASSERT(flags_ & kUintFlag);
+        RAPIDJSONXML_ASSERT(data_.f.flags & kUintFlag);
         return data_.n.u.u;
     }
     int64_t GetInt64() const {
-        RAPIDJSONXML_ASSERT(flags_ & kInt64Flag);
+        RAPIDJSONXML_ASSERT(data_.f.flags & kInt64Flag);
         return data_.n.i64;
     }
     uint64_t GetUint64() const {
-        RAPIDJSONXML_ASSERT(flags_ & kUint64Flag);
+        RAPIDJSONXML_ASSERT(data_.f.flags & kUint64Flag);
         return data_.n.u64;
     }
 
     double GetDouble() const {
         RAPIDJSONXML_ASSERT(IsNumber());
-        if ((flags_ & kDoubleFlag) != 0)    return data_.n.d;           // exact type, no conversion.
-        if ((flags_ & kIntFlag) != 0)       return data_.n.i.i;         // int -> double
-        if ((flags_ & kUintFlag) != 0)      return data_.n.u.u;         // unsigned -> double
-        if ((flags_ & kInt64Flag) != 0)     return (double)data_.n.i64; // int64_t -> double (may lose precision)
-        RAPIDJSONXML_ASSERT((flags_ & kUint64Flag) != 0);
+        if ((data_.f.flags & kDoubleFlag) != 0)    return data_.n.d;           // exact type, no conversion.
+        if ((data_.f.flags & kIntFlag) != 0)       return data_.n.i.i;         // int -> double
+        if ((data_.f.flags & kUintFlag) != 0)      return data_.n.u.u;         // unsigned -> double
+        if ((data_.f.flags & kInt64Flag) != 0)     return (double)data_.n.i64; // int64_t -> double (may lose precision)
+        RAPIDJSONXML_ASSERT((data_.f.flags & kUint64Flag) != 0);
         return (double)data_.n.u64;                                     // uint64_t -> double (may lose precision)
     }
 
@@ -1398,7 +1221,7 @@ public:
 
     const Ch* GetString() const {
         RAPIDJSONXML_ASSERT(IsString());
-        return data_.s.str;
+        return GetStringPointer();
     }
 
     //! Get the length of string.
@@ -1406,7 +1229,19 @@ public:
     */
     SizeType GetStringLength() const {
         RAPIDJSONXML_ASSERT(IsString());
-        return data_.s.length;
+        return (data_.f.flags & kInlineStrFlag) ? data_.ss.GetLength() : data_.s.length;
+    }
+
+    //! Get the hash of string.
+    /*! The hash is computed when copying the string, or when adding it as
+        member name, and then kept in the value. It is computed at each call
+        for constant strings not used as member names and for short strings.
+        \see internal::StrHash()
+    */
+    SizeType GetStringHash() const {
+        RAPIDJSONXML_ASSERT(IsString());
+        const SizeType hash = GetCachedStringHash();
+        return hash != 0 ? hash : internal::StrHash(GetStringPointer(), GetStringLength());
     }
 
     //! Set this value as a string without copying source string.
@@ -1485,11 +1320,11 @@ public:
                     ConstValueIterator v = m->value.Begin();
                     attribs_list[1] = AttributeIteratorPair(v->AttributeBegin(), v->AttributeEnd());
                 }
-                if (!handler.OpenTag(m->name.data_.s.str, m->name.data_.s.length, attribs_list, (m->name.flags_ & kCopyFlag) != 0))
+                if (!handler.OpenTag(m->name.GetStringPointer(), m->name.GetStringLength(), attribs_list, (m->name.data_.f.flags & kCopyFlag) != 0))
                     return false;
                 if (!m->value.Accept(handler))
                     return false;
-                if (!handler.CloseTag(m->name.data_.s.str, m->name.data_.s.length, (m->name.flags_ & kCopyFlag) != 0))
+                if (!handler.CloseTag(m->name.GetStringPointer(), m->name.GetStringLength(), (m->name.data_.f.flags & kCopyFlag) != 0))
                     return false;
             }
             return handler.EndObject(data_.o.size);
@@ -1497,13 +1332,13 @@ public:
         case kArrayType:
             if (!handler.StartArray())
                 return false;
-            for (GenericValue* v = data_.a.elements; v != data_.a.elements + data_.a.size; ++v)
-                if (!v->Accept(handler))
+            for (const GenericValue* v = Begin(); v != End(); ++v)
+                if (!internal::ElementAttributesEvent<Handler>::Send(handler, AttributeIteratorPair(v->AttributeBegin(), v->AttributeEnd())) || !v->Accept(handler))
                     return false;
             return handler.EndArray(data_.a.size);
 
         case kStringType:
-            return handler.String(data_.s.str, data_.s.length, (flags_ & kCopyFlag) != 0);
+            return handler.String(GetStringPointer(), GetStringLength(), (data_.f.flags & kCopyFlag) != 0);
 
         case kNumberType:
             if (IsInt())            return handler.Int(data_.n.i.i);
@@ -1521,17 +1356,21 @@ public:
 private:
     template <typename, typename>
     friend class GenericDocument;
+    template <typename> friend class GenericMemberAccessor; // for kUniqueNamesFlag
 
     enum {
-        kBoolFlag = 0x100,
-        kNumberFlag = 0x200,
-        kIntFlag = 0x400,
-        kUintFlag = 0x800,
-        kInt64Flag = 0x1000,
-        kUint64Flag = 0x2000,
-        kDoubleFlag = 0x4000,
-        kStringFlag = 0x100000,
-        kCopyFlag = 0x200000,
+        kBoolFlag = 0x0008,
+        kNumberFlag = 0x0010,
+        kIntFlag = 0x0020,
+        kUintFlag = 0x0040,
+        kInt64Flag = 0x0080,
+        kUint64Flag = 0x0100,
+        kDoubleFlag = 0x0200,
+        kStringFlag = 0x0400,
+        kCopyFlag = 0x0800,
+        kAttributeFlag = 0x1000, // attributes are stored out of line, see AttributeArray
+        kInlineStrFlag = 0x2000,
+        kUniqueNamesFlag = 0x4000, // objects whose members are known to have different names, see HasUniqueNames()
 
         // Initial flags of different types.
         kNullFlag = kNullType,
@@ -1545,19 +1384,35 @@ private:
         kNumberAnyFlag = kNumberType | kNumberFlag | kIntFlag | kInt64Flag | kUintFlag | kUint64Flag | kDoubleFlag,
         kConstStringFlag = kStringType | kStringFlag,
         kCopyStringFlag = kStringType | kStringFlag | kCopyFlag,
+        kShortStringFlag = kStringType | kStringFlag | kCopyFlag | kInlineStrFlag,
         kObjectFlag = kObjectType,
         kArrayFlag = kArrayType,
 
-        kTypeMask = 0xFF // bitwise-and with mask of 0xFF can be optimized by compiler
+        kTypeMask = 0x07
     };
 
     static const SizeType kDefaultArrayCapacity = 16;
     static const SizeType kDefaultObjectCapacity = 16;
+    static const SizeType kDefaultAttributeCapacity = 4;
+
+    // The pointers of strings, objects and arrays are at the same place, after
+    // two SizeType, and the flags are in the last two bytes of the value: in the
+    // 16 upper bits of the pointer with RAPIDJSONXML_48BITPOINTER_OPTIMIZATION.
+    struct Flag {
+#if RAPIDJSONXML_48BITPOINTER_OPTIMIZATION
+        char payload[sizeof(SizeType) * 2 + 6];                 // 2 x SizeType + lower 48-bit pointer
+#elif RAPIDJSONXML_64BIT
+        char payload[sizeof(SizeType) * 2 + sizeof(void*) + 6]; // 6 padding bytes
+#else
+        char payload[sizeof(SizeType) * 2 + sizeof(void*) + 2]; // 2 padding bytes
+#endif
+        uint16_t flags;
+    };
 
     struct String {
-        const Ch* str;
         SizeType length;
-        unsigned hashcode; //!< reserved
+        SizeType hashcode; //!< internal::StrHash() of the string, 0 until computed
+        const Ch* str;
     }; // 12 bytes in 32-bit mode, 16 bytes in 64-bit mode
 
     // By using proper binary layout, retrieval of different integer types do not need conversions.
@@ -1586,74 +1441,409 @@ private:
         double d;
     }; // 8 bytes
 
+    //! Object, with the hash index of its members after the capacity members when HasMemberIndex(capacity).
     struct Object {
-        Member* members;
         SizeType size;
         SizeType capacity;
+        Member* members;
     }; // 12 bytes in 32-bit mode, 16 bytes in 64-bit mode
 
     struct Array {
-        GenericValue* elements;
         SizeType size;
         SizeType capacity;
+        GenericValue* elements;
+    }; // 12 bytes in 32-bit mode, 16 bytes in 64-bit mode
+
+    //! Pointer of any type, the AttributeArray when kAttributeFlag is set.
+    struct Pointer {
+        SizeType padding[2];
+        void* p;
     }; // 12 bytes in 32-bit mode, 16 bytes in 64-bit mode
 
+    //! Copied string stored inside the value, in place of the length and of the pointer.
+    /*! The last character keeps MaxSize - length, so that it is also the null
+        terminator of a string of MaxSize characters.
+    */
+    struct ShortString {
+        enum { MaxChars = sizeof(static_cast<Flag*>(0)->payload) / sizeof(Ch), MaxSize = MaxChars - 1, LenPos = MaxSize };
+        Ch str[MaxChars];
+
+        static bool Usable(SizeType length) { return MaxSize >= length; }
+        void SetLength(SizeType length) { str[LenPos] = static_cast<Ch>(MaxSize - length); }
+        SizeType GetLength() const { return static_cast<SizeType>(MaxSize - str[LenPos]); }
+    }; // at most 13 chars in 32-bit mode and with RAPIDJSONXML_48BITPOINTER_OPTIMIZATION, 21 chars in 64-bit mode (for UTF-8)
+
     union Data {
         String s;
+        ShortString ss;
         Number n;
         Object o;
         Array a;
-    }; // 12 bytes in 32-bit mode, 16 bytes in 64-bit mode
-
+        Pointer p;
+        Flag f;
+    }; // 16 bytes in 32-bit mode, 24 bytes in 64-bit mode, 16 bytes with RAPIDJSONXML_48BITPOINTER_OPTIMIZATION
+
+    //! Attributes of a value, allocated at the first one.
+    /*! Most values have no attribute: instead of making every value larger, the
+        pointer of the value is moved here and replaced by the pointer of the
+        AttributeArray, with kAttributeFlag.
+    */
     struct AttributeArray {
         AttributeType* elements;
         SizeType size;
         SizeType capacity;
-    }; // 12 bytes in 32-bit mode, 16 bytes in 64-bit mode
+        void* pointer;  //!< string, members or elements of the value
+    };
+
+    //! Flags of the value, without kAttributeFlag and kUniqueNamesFlag.
+    uint16_t GetFlags() const {
+        return static_cast<uint16_t>(data_.f.flags & ~(kAttributeFlag | kUniqueNamesFlag));
+    }
+
+    //! Whether the object is known to have no two members of the same name.
+    /*! Set by SetObjectRaw() after checking the names, kept by AddMember()
+        when the member index tells that the name is new, and by RemoveMember().
+        It is not set for the other objects, which may still have unique names.
+    */
+    bool HasUniqueNames() const {
+        return (data_.f.flags & kUniqueNamesFlag) != 0;
+    }
+
+    void SetUniqueNames(bool unique) {
+        if (unique)
+            data_.f.flags |= kUniqueNamesFlag;
+        else
+            data_.f.flags &= static_cast<uint16_t>(~kUniqueNamesFlag);
+    }
+
+    //! Set the flags of the value, keeping its attributes.
+    void SetFlags(uint16_t flags) {
+        data_.f.flags = static_cast<uint16_t>((data_.f.flags & kAttributeFlag) | flags);
+    }
+
+    AttributeArray* GetAttributeArray() const {
+        RAPIDJSONXML_ASSERT(data_.f.flags & kAttributeFlag);
+        return static_cast<AttributeArray*>(RAPIDJSONXML_GETPOINTER(void, data_.p.p));
+    }
+
+    //! Get the attributes, allocating them and moving the pointer of the value at the first call.
+    AttributeArray* ReserveAttributes(Allocator& allocator) {
+        if (!(data_.f.flags & kAttributeFlag)) {
+            if (data_.f.flags & kInlineStrFlag) { // no room for the pointer
+                const SizeType length = data_.ss.GetLength();
+                Ch* str = (Ch *)allocator.Malloc((length + 1) * sizeof(Ch));
+                memcpy(str, data_.ss.str, length * sizeof(Ch));
+                str[length] = '\0';
+                data_.f.flags = kCopyStringFlag;
+                data_.s.length = length;
+                data_.s.hashcode = internal::StrHash(str, length);
+                RAPIDJSONXML_SETPOINTER(const Ch, data_.s.str, str);
+            }
+            AttributeArray* attributes = static_cast<AttributeArray*>(allocator.Malloc(sizeof(AttributeArray)));
+            attributes->elements = 0;
+            attributes->size = attributes->capacity = 0;
+            attributes->pointer = RAPIDJSONXML_GETPOINTER(void, data_.p.p);
+            RAPIDJSONXML_SETPOINTER(void, data_.p.p, attributes);
+            data_.f.flags |= kAttributeFlag;
+        }
+        return GetAttributeArray();
+    }
+
+    void* GetPointer() const {
+        return (data_.f.flags & kAttributeFlag) ? GetAttributeArray()->pointer : RAPIDJSONXML_GETPOINTER(void, data_.p.p);
+    }
+    void SetPointer(void* p) {
+        if (data_.f.flags & kAttributeFlag)
+            GetAttributeArray()->pointer = p;
+        else
+            RAPIDJSONXML_SETPOINTER(void, data_.p.p, p);
+    }
+
+    const Ch* GetStringPointer() const { return (data_.f.flags & kInlineStrFlag) ? data_.ss.str : static_cast<const Ch*>(GetPointer()); }
+    void SetStringPointer(const Ch* str) { SetPointer(const_cast<Ch*>(str)); }
+    Member* GetMembersPointer() const { return static_cast<Member*>(GetPointer()); }
+    void SetMembersPointer(Member* members) { SetPointer(members); }
+    GenericValue* GetElementsPointer() const { return static_cast<GenericValue*>(GetPointer()); }
+    void SetElementsPointer(GenericValue* elements) { SetPointer(elements); }
 
     // Initialize this value as array with initial data, without calling destructor.
     void SetArrayRaw(GenericValue* values, SizeType count, Allocator& allocator) {
-        flags_ = kArrayFlag;
-        data_.a.elements = (GenericValue*)allocator.Malloc(count * sizeof(GenericValue));
-        memcpy(data_.a.elements, values, count * sizeof(GenericValue));
+        SetFlags(kArrayFlag);
+        GenericValue* elements = (GenericValue*)allocator.Malloc(count * sizeof(GenericValue));
+        SetElementsPointer(elements);
+        memcpy(elements, values, count * sizeof(GenericValue));
         data_.a.size = data_.a.capacity = count;
     }
 
     //! Initialize this value as object with initial data, without calling destructor.
     void SetObjectRaw(Member* members, SizeType count, Allocator& allocator) {
-        flags_ = kObjectFlag;
-        data_.o.members = (Member*)allocator.Malloc(count * sizeof(Member));
-        memcpy(data_.o.members, members, count * sizeof(Member));
+        SetFlags(kObjectFlag);
+        Member* m = (Member*)allocator.Malloc(MembersAllocationSize(count));
+        SetMembersPointer(m);
+        memcpy(m, members, count * sizeof(Member));
         data_.o.size = data_.o.capacity = count;
+        if (HasMemberIndex(count)) {
+            for (SizeType i = 0; i < count; i++)
+                m[i].name.CacheStringHash();
+            SetUniqueNames(BuildMemberIndex());
+        }
+        else
+            SetUniqueNames(CheckUniqueNames(m, count));
+    }
+
+    //! Cache the hashes of the names of a small object, and check that they are all different.
+    /*! The names are put in a local hash table, and only the names of the same
+        hash are compared. Objects above the size of the table are not checked.
+    */
+    static bool CheckUniqueNames(Member* members, SizeType count) {
+        static const SizeType kTableSize = 64;
+        SizeType table[kTableSize] = {}; // position + 1 of a member
+        SizeType hashes[kTableSize / 2];
+        bool unique = count <= kTableSize / 2;
+        for (SizeType i = 0; i < count; i++) {
+            const SizeType hash = members[i].name.CacheStringHash();
+            if (!unique)
+                continue;
+            hashes[i] = hash;
+            SizeType b = hash & (kTableSize - 1);
+            for (; table[b] != 0; b = (b + 1) & (kTableSize - 1))
+                if (hashes[table[b] - 1] == hash && members[table[b] - 1].name.StringEqual(members[i].name))
+                    unique = false;
+            table[b] = i + 1;
+        }
+        return unique;
+    }
+
+    //! Whether an object of this capacity has a hash index of its members.
+    static bool HasMemberIndex(SizeType capacity) {
+        return RAPIDJSONXML_MEMBER_INDEX_CAPACITY != 0 && capacity >= RAPIDJSONXML_MEMBER_INDEX_CAPACITY;
+    }
+
+    //! Number of buckets of the member index: the power of two above twice the capacity.
+    static SizeType MemberIndexSize(SizeType capacity) {
+        SizeType n = capacity * 2 - 1;
+        for (unsigned shift = 1; shift < sizeof(SizeType) * 8; shift *= 2)
+            n |= n >> shift;
+        return n + 1;
+    }
+
+    //! Size of the allocation of the members, with their index.
+    static size_t MembersAllocationSize(SizeType capacity) {
+        return capacity * sizeof(Member) + (HasMemberIndex(capacity) ? MemberIndexSize(capacity) * sizeof(SizeType) : 0);
+    }
+
+    //! Buckets of the member index, each one 0 or the position of a member plus 1.
+    SizeType* GetMemberIndex() const {
+        RAPIDJSONXML_ASSERT(HasMemberIndex(data_.o.capacity));
+        return reinterpret_cast<SizeType*>(GetMembersPointer() + data_.o.capacity);
+    }
+
+    //! Hash kept in String::hashcode, 0 if not computed yet or if the string is stored in the value.
+    SizeType GetCachedStringHash() const {
+        return (data_.f.flags & kInlineStrFlag) ? 0 : data_.s.hashcode;
+    }
+
+    //! Get the hash of the string, keeping it in String::hashcode unless the string is stored in the value.
+    SizeType CacheStringHash() {
+        RAPIDJSONXML_ASSERT(IsString());
+        if (!(data_.f.flags & kInlineStrFlag) && data_.s.hashcode == 0)
+            data_.s.hashcode = internal::StrHash(GetStringPointer(), data_.s.length);
+        return GetStringHash();
+    }
+
+    //! Compare with another string, rejecting different strings by their hashes when both are known.
+    bool StringEqual(const GenericValue& rhs) const {
+        RAPIDJSONXML_ASSERT(IsString());
+        RAPIDJSONXML_ASSERT(rhs.IsString());
+        const SizeType len = GetStringLength();
+        if (len != rhs.GetStringLength())
+            return false;
+        const SizeType hash = GetCachedStringHash(), rhsHash = rhs.GetCachedStringHash();
+        if (hash != 0 && rhsHash != 0 && hash != rhsHash)
+            return false;
+        const Ch* const str = GetStringPointer();
+        const Ch* const rhsStr = rhs.GetStringPointer();
+        return str == rhsStr || memcmp(str, rhsStr, len * sizeof(Ch)) == 0;
+    }
+
+    //! Number of the members of a name in a range.
+    static SizeType CountMembers(ConstMemberIterator begin, ConstMemberIterator end, const GenericValue& name) {
+        SizeType count = 0;
+        for (; begin != end; ++begin)
+            if (begin->name.StringEqual(name))
+                ++count;
+        return count;
+    }
+
+    //! Find the member of a name after \c count others of this name, for operator==.
+    ConstMemberIterator FindMemberOccurrence(const GenericValue& name, SizeType count) const {
+        ConstMemberIterator member = MemberBegin();
+        for (; member != MemberEnd(); ++member)
+            if (member->name.StringEqual(name) && count-- == 0)
+                break;
+        return member;
+    }
+
+    //! Bit of the buckets of the member index set when other members have the same name.
+    static const SizeType kMemberIndexDuplicate = static_cast<SizeType>(1) << (sizeof(SizeType) * 8 - 1);
+
+    //! Fill the member index from the members.
+    /*! \return Whether the names of the members are all different.
+    */
+    bool BuildMemberIndex() {
+        memset(GetMemberIndex(), 0, MemberIndexSize(data_.o.capacity) * sizeof(SizeType));
+        bool unique = true;
+        for (SizeType i = 0; i < data_.o.size; i++)
+            unique = AddMemberIndex(i) && unique;
+        return unique;
+    }
+
+    //! Bucket of the index with this name, or empty bucket where to add it.
+    SizeType FindMemberIndexBucket(const GenericValue& name, SizeType hash) const {
+        const SizeType* index = GetMemberIndex();
+        const SizeType mask = MemberIndexSize(data_.o.capacity) - 1;
+        const Member* members = GetMembersPointer();
+        SizeType b = hash & mask;
+        while (index[b] != 0 && !members[(index[b] & ~kMemberIndexDuplicate) - 1].name.StringEqual(name))
+            b = (b + 1) & mask;
+        return b;
+    }
+
+    SizeType FindMemberIndexBucket(SizeType i) {
+        GenericValue& name = GetMembersPointer()[i].name;
+        return FindMemberIndexBucket(name, name.CacheStringHash());
+    }
+
+    //! Add the member at position \c i to the index.
+    /*! Only the first member of each name is in the index, as found by a
+        linear search, and its bucket is marked when it has duplicates: they
+        would otherwise make a single long probe sequence.
+        \return Whether no other member has the name.
+    */
+    bool AddMemberIndex(SizeType i) {
+        SizeType* index = GetMemberIndex();
+        SizeType b = FindMemberIndexBucket(i);
+        if (index[b] != 0) {
+            index[b] |= kMemberIndexDuplicate;
+            return false;
+        }
+        index[b] = i + 1;
+        return true;
+    }
+
+    //! Find a member by name with the index.
+    MemberIterator FindMemberIndexed(const GenericValue& name) {
+        SizeType entry = GetMemberIndex()[FindMemberIndexBucket(name, name.GetStringHash())];
+        return entry != 0 ? MemberIterator(GetMembersPointer() + ((entry & ~kMemberIndexDuplicate) - 1)) : MemberEnd();
+    }
+
+    //! Update the index before removing the member at position \c i, and moving the last one at its place.
+    void RemoveMemberIndex(SizeType i) {
+        SizeType* index = GetMemberIndex();
+        Member* members = GetMembersPointer();
+        const SizeType last = data_.o.size - 1;
+
+        SizeType b = FindMemberIndexBucket(i);
+        if ((index[b] & ~kMemberIndexDuplicate) == i + 1) {
+            if (index[b] & kMemberIndexDuplicate) {
+                // Index the next member of this name, at its position after the move of the last one
+                SizeType first = last, count = 0;
+                for (SizeType j = 0; j <= last; j++) {
+                    if (j != i && members[j].name.StringEqual(members[i].name)) {
+                        SizeType position = (j == last) ? i : j;
+                        if (position < first)
+                            first = position;
+                        count++;
+                    }
+                }
+                if (count != 0)
+                    index[b] = (first + 1) | (count > 1 ? kMemberIndexDuplicate : 0);
+                else
+                    RemoveMemberIndexBucket(b);
+            }
+            else
+                RemoveMemberIndexBucket(b);
+        }
+
+        if (i != last) {
+            b = FindMemberIndexBucket(last);
+            RAPIDJSONXML_ASSERT(index[b] != 0);
+            if ((index[b] & ~kMemberIndexDuplicate) > i) // the moved member becomes the first of its name
+                index[b] = (i + 1) | (index[b] & kMemberIndexDuplicate);
+        }
+    }
+
+    //! Empty a bucket of the member index.
+    /*! The following buckets of the probe sequence are shifted back, instead
+        of leaving a tombstone.
+    */
+    void RemoveMemberIndexBucket(SizeType hole) {
+        SizeType* index = GetMemberIndex();
+        const SizeType mask = MemberIndexSize(data_.o.capacity) - 1;
+        Member* members = GetMembersPointer();
+        for (SizeType b = (hole + 1) & mask; index[b] != 0; b = (b + 1) & mask) {
+            SizeType home = members[(index[b] & ~kMemberIndexDuplicate) - 1].name.GetStringHash() & mask;
+            // Move the bucket to the hole unless its home is cyclically in (hole, b]
+            if (((b - home) & mask) >= ((b - hole) & mask)) {
+                index[hole] = index[b];
+                hole = b;
+            }
+        }
+        index[hole] = 0;
+    }
+
+    //! Initialize the attributes as copies of the given ones, without calling destructor.
+    /*! The array is allocated once with the exact size, instead of growing as AddAttribute().
+    */
+    void SetAttributesRaw(const AttributeType* begin, const AttributeType* end, Allocator& allocator) {
+        RAPIDJSONXML_ASSERT(!(data_.f.flags & kAttributeFlag));
+        const SizeType count = static_cast<SizeType>(end - begin);
+        if (count == 0)
+            return;
+        AttributeArray* attributes = ReserveAttributes(allocator);
+        attributes->elements = (AttributeType*)allocator.Malloc(count * sizeof(AttributeType));
+        for (SizeType i = 0; i < count; i++)
+            new (&attributes->elements[i]) AttributeType(StringRefType(begin[i].GetName(), begin[i].GetNameLength()),
+                StringRefType(begin[i].GetValue(), begin[i].GetValueLength()), allocator);
+        attributes->size = attributes->capacity = count;
     }
 
     //! Initialize this value as constant string, without calling destructor.
     void SetStringRaw(StringRefType s) {
-        flags_ = kConstStringFlag;
-        data_.s.str = s;
+        data_.f.flags = kConstStringFlag;
+        SetStringPointer(s);
         data_.s.length = s.length;
+        data_.s.hashcode = 0;
     }
 
     //! Initialize this value as copy string with initial data, without calling destructor.
+    /*! Short strings are stored in the value instead of being allocated.
+    */
     void SetStringRaw(StringRefType s, Allocator& allocator) {
-        flags_ = kCopyStringFlag;
-        data_.s.str = (Ch *)allocator.Malloc((s.length + 1) * sizeof(Ch));
-        data_.s.length = s.length;
-        memcpy(const_cast<Ch*>(data_.s.str), s, s.length * sizeof(Ch));
-        const_cast<Ch*>(data_.s.str)[s.length] = '\0';
+        Ch* str;
+        if (ShortString::Usable(s.length)) {
+            data_.f.flags = kShortStringFlag;
+            data_.ss.SetLength(s.length);
+            str = data_.ss.str;
+        }
+        else {
+            data_.f.flags = kCopyStringFlag;
+            str = (Ch *)allocator.Malloc((s.length + 1) * sizeof(Ch));
+            SetStringPointer(str);
+            data_.s.length = s.length;
+            data_.s.hashcode = internal::StrHash(s.s, s.length);
+        }
+        memcpy(str, s, s.length * sizeof(Ch));
+        str[s.length] = '\0';
     }
 
     //! Assignment without calling destructor
     void RawAssign(GenericValue& rhs) {
         data_ = rhs.data_;
-        flags_ = rhs.flags_;
-        attributes_ = rhs.attributes_;
-        rhs.flags_ = kNullFlag;
+        rhs.data_.f.flags = kNullFlag;
     }
 
     Data data_;
-    unsigned flags_;
-    AttributeArray attributes_;
 };
 #pragma pack (pop)
 
@@ -1683,7 +1873,8 @@ public:
     /*! \param allocator        Optional allocator for allocating stack memory.
         \param stackCapacity    Initial capacity of stack in bytes.
     */
-    GenericDocument(Allocator* allocator = 0, size_t stackCapacity = kDefaultStackCapacity) : stack_(allocator, stackCapacity), parseResult_() {}
+    GenericDocument(Allocator* allocator = 0, size_t stackCapacity = kDefaultStackCapacity) : stack_(allocator, stackCapacity), parseResult_(), attributes_(), elementAttributes_(),
+        internKeys_(false), keys_(0), keyCount_(0), keyCapacity_(0) {}
 
     //!@name Parse from stream
     //!@{
@@ -1796,6 +1987,79 @@ public:
     }
     //!@}
 
+    //!@name Parse XML text
+    //!@{
+
+    //! Parse XML text from an input stream (with Encoding conversion)
+    /*! The elements are loaded as described in GenericXmlReader.
+        \tparam parseFlags Combination of \ref ParseFlag.
+        \tparam SourceEncoding Encoding of input stream
+        \tparam InputStream Type of input stream, implementing Stream concept
+        \param is Input stream to be parsed.
+        \return The document itself for fluent API.
+    */
+    template <unsigned parseFlags, typename SourceEncoding, typename InputStream>
+    GenericDocument& ParseXmlStream(InputStream& is) {
+        ValueType::SetNull(); // Remove existing root if exist
+        GenericXmlReader<SourceEncoding, Encoding, Allocator> reader(&GetAllocator());
+        ClearStackOnExit scope(*this);
+        parseResult_ = reader.template Parse<parseFlags>(is, *this);
+        if (parseResult_) {
+            RAPIDJSONXML_ASSERT(stack_.GetSize() == sizeof(ValueType)); // Got one and only one root object
+            this->RawAssign(*stack_.template Pop<ValueType>(1));        // Add this-> to prevent issue 13.
+        }
+        return *this;
+    }
+
+    //! Parse XML text from an input stream
+    /*! \tparam parseFlags Combination of \ref ParseFlag.
+        \tparam InputStream Type of input stream, implementing Stream concept
+        \param is Input stream to be parsed.
+        \return The document itself for fluent API.
+    */
+    template <unsigned parseFlags, typename InputStream>
+    GenericDocument& ParseXmlStream(InputStream& is) {
+        return ParseXmlStream<parseFlags, Encoding, InputStream>(is);
+    }
+
+    //! Parse XML text from a mutable string
+    /*! \tparam parseFlags Combination of \ref ParseFlag.
+        \param str Mutable zero-terminated string to be parsed.
+        \return The document itself for fluent API.
+    */
+    template <unsigned parseFlags>
+    GenericDocument& ParseXmlInsitu(Ch* str) {
+        GenericInsituStringStream<Encoding> s(str);
+        return ParseXmlStream<parseFlags | kParseInsituFlag, Encoding>(s);
+    }
+
+    //! Parse XML text from a mutable string (with \ref kParseDefaultFlags)
+    /*! \param str Mutable zero-terminated string to be parsed.
+        \return The document itself for fluent API.
+    */
+    GenericDocument& ParseXmlInsitu(Ch* str) {
+        return ParseXmlInsitu<kParseDefaultFlags>(str);
+    }
+
+    //! Parse XML text from a read-only string
+    /*! \tparam parseFlags Combination of \ref ParseFlag (must not contain \ref kParseInsituFlag).
+        \param str Read-only zero-terminated string to be parsed.
+    */
+    template <unsigned parseFlags>
+    GenericDocument& ParseXml(const Ch* str) {
+        RAPIDJSONXML_ASSERT(!(parseFlags & kParseInsituFlag));
+        GenericStringStream<Encoding> s(str);
+        return ParseXmlStream<parseFlags, Encoding>(s);
+    }
+
+    //! Parse XML text from a read-only string (with \ref kParseDefaultFlags)
+    /*! \param str Read-only zero-terminated string to be parsed.
+    */
+    GenericDocument& ParseXml(const Ch* str) {
+        return ParseXml<kParseDefaultFlags>(str);
+    }
+    //!@}
+
     //!@name Handling parse errors
     //!@{
 
@@ -1826,6 +2090,30 @@ public:
         return stack_.GetCapacity();
     }
 
+    //!@name Key interning
+    //!@{
+
+    //! Share one copy of each member name, and of each tag name, between the values of a parsing.
+    /*! Records repeat the same few names: instead of copying each of them into
+        the allocator, the names are copied once and the values reference the copy,
+        with its hash kept for FindMember(). The names short enough to be stored in
+        the values are not concerned.
+        
+ote Only allocators which do not need Free(), like MemoryPoolAllocator, share the names.
+        
+ote The names are constant strings in the document, valid until its allocator is cleared.
+    */
+    GenericDocument& SetKeyInterning(bool intern) {
+        internKeys_ = intern;
+        return *this;
+    }
+
+    //! Whether the names are shared by SetKeyInterning().
+    bool GetKeyInterning() const {
+        return internKeys_;
+    }
+    //!@}
+
 private:
     // clear stack on any exit from ParseStream, e.g. due to exception
     struct ClearStackOnExit {
@@ -1841,36 +2129,42 @@ private:
 
     // callers of the following private Handler functions
     template <typename,typename,typename> friend class GenericReader; // for parsing
+    template <typename,typename,typename> friend class GenericXmlReader; // for parsing XML text
+    template <typename,bool> friend struct internal::KeyEvent; // for sending member names
+    template <typename> friend class internal::HasKeyEvent;
+    template <typename> friend class internal::HasAllocatedString; // for decoding strings into the allocator
+    template <typename,bool> friend struct internal::ElementAttributesEvent; // for the attributes of array elements
+    template <typename> friend class internal::HasElementAttributes;
     friend class GenericValue<Encoding,Allocator>; // for deep copying
 
     // Implementation of Handler
     bool Null() {
         new (stack_.template Push<ValueType>()) ValueType();
-        return true;
+        return TakeAttributes();
     }
     bool Bool(bool b) {
         new (stack_.template Push<ValueType>()) ValueType(b);
-        return true;
+        return TakeAttributes();
     }
     bool Int(int i) {
         new (stack_.template Push<ValueType>()) ValueType(i);
-        return true;
+        return TakeAttributes();
     }
     bool Uint(unsigned i) {
         new (stack_.template Push<ValueType>()) ValueType(i);
-        return true;
+        return TakeAttributes();
     }
     bool Int64(int64_t i) {
         new (stack_.template Push<ValueType>()) ValueType(i);
-        return true;
+        return TakeAttributes();
     }
     bool Uint64(uint64_t i) {
         new (stack_.template Push<ValueType>()) ValueType(i);
-        return true;
+        return TakeAttributes();
     }
     bool Double(double d) {
         new (stack_.template Push<ValueType>()) ValueType(d);
-        return true;
+        return TakeAttributes();
     }
 
     bool String(const Ch* str, SizeType length, bool copy) {
@@ -1878,13 +2172,44 @@ private:
             new (stack_.template Push<ValueType>()) ValueType(str, length, GetAllocator());
         else
             new (stack_.template Push<ValueType>()) ValueType(str, length);
+        return TakeAttributes();
+    }
+
+    bool Key(const Ch* str, SizeType length, bool copy) {
+        PushName(str, length, copy);
         return true;
     }
 
+    // Take the string decoded into the allocator, unless it is stored in the value or interned.
+    // Only names are hashed here, for FindMember(): the values are not read again.
+    bool AllocatedString(Ch* str, SizeType length, bool isKey) {
+        ValueType value;
+        if (ValueType::ShortString::Usable(length))
+            value.SetStringRaw(StringRef(str, length), GetAllocator());
+        else {
+            const SizeType hash = isKey ? internal::StrHash(str, length) : 0;
+            const Ch* interned = isKey && internKeys_ && !Allocator::kNeedFree ? InternKey(str, length, hash, str) : 0;
+            value.SetStringRaw(StringRef(interned ? interned : str, length));
+            if (!interned)
+                value.data_.f.flags = ValueType::kCopyStringFlag;
+            value.data_.s.hashcode = hash;
+        }
+        if (value.GetString() != str) { // given back, while it is the last allocation
+            if (Allocator::kNeedFree)
+                Allocator::Free(str);
+            else
+                GetAllocator().Realloc(str, (length + 1) * sizeof(Ch), 0);
+        }
+        new (stack_.template Push<ValueType>()) ValueType();
+        stack_.template Top<ValueType>()->RawAssign(value);
+        return isKey || TakeAttributes();
+    }
+
     bool StartObject(const AttributeIteratorPair attribs) {
-        (void)attribs;
         new (stack_.template Push<ValueType>()) ValueType(kObjectType);
-        return true;
+        if (attribs.IsValid()) // own attributes of the object, preferred to the ones of its tag
+            attributes_ = attribs;
+        return TakeAttributes();
     }
 
     bool EndObject(SizeType memberCount) {
@@ -1895,18 +2220,26 @@ private:
 
     bool StartArray() {
         new (stack_.template Push<ValueType>()) ValueType(kArrayType);
+        TakeAttributes();
+        attributes_ = elementAttributes_; // for the first element
+        elementAttributes_ = AttributeIteratorPair();
         return true;
     }
 
     bool EndArray(SizeType elementCount) {
+        attributes_ = AttributeIteratorPair(); // not taken by an empty array
         ValueType* elements = stack_.template Pop<ValueType>(elementCount);
         stack_.template Top<ValueType>()->SetArrayRaw(elements, elementCount, GetAllocator());
         return true;
     }
 
     bool OpenTag(const Ch* str, SizeType length, const AttributeIteratorPairList attribs_list, bool copy) {
-        (void) attribs_list;
-        return String(str, length, copy);
+        PushName(str, length, copy);
+        if (attribs_list) { // taken by the member value
+            attributes_ = attribs_list[0];
+            elementAttributes_ = attribs_list[1];
+        }
+        return true;
     }
 
     bool CloseTag(const Ch* str, SizeType length, bool copy) {
@@ -1916,11 +2249,89 @@ private:
         return true;
     }
 
+    bool ElementAttributes(const AttributeIteratorPair attribs) {
+        attributes_ = attribs; // taken by the next element
+        return true;
+    }
+
 private:
     //! Prohibit assignment
     GenericDocument& operator=(const GenericDocument&);
 
+    //! Copy the pending attributes of the tag into the value just pushed.
+    bool TakeAttributes() {
+        if (attributes_.IsValid()) {
+            stack_.template Top<ValueType>()->SetAttributesRaw(attributes_.begin, attributes_.end, GetAllocator());
+            attributes_ = AttributeIteratorPair();
+        }
+        return true;
+    }
+
+    //! Push a member name, shared with the previous ones when interning.
+    void PushName(const Ch* str, SizeType length, bool copy) {
+        if (copy && internKeys_ && !Allocator::kNeedFree && !ValueType::ShortString::Usable(length)) {
+            const SizeType hash = internal::StrHash(str, length);
+            const Ch* interned = InternKey(str, length, hash);
+            if (interned) {
+                ValueType* name = new (stack_.template Push<ValueType>()) ValueType(interned, length);
+                name->data_.s.hashcode = hash;
+                return;
+            }
+        }
+        if (copy)
+            new (stack_.template Push<ValueType>()) ValueType(str, length, GetAllocator());
+        else
+            new (stack_.template Push<ValueType>()) ValueType(str, length);
+    }
+
+    //! Find the shared copy of a name, adding it to the intern table if missing.
+    /*! \param owned Allocated copy of the name becoming the shared one if missing, or 0 to copy it.
+        \return The shared copy, or 0 when the table is full.
+    */
+    const Ch* InternKey(const Ch* str, SizeType length, SizeType hash, Ch* owned = 0) {
+        if (keyCount_ * 2 >= keyCapacity_ && keyCapacity_ < kMaxInternedKeys * 2)
+            GrowInternedKeys();
+        SizeType i = hash & (keyCapacity_ - 1);
+        for (; keys_[i].str; i = (i + 1) & (keyCapacity_ - 1))
+            if (keys_[i].hash == hash && keys_[i].length == length && memcmp(keys_[i].str, str, length * sizeof(Ch)) == 0)
+                return keys_[i].str;
+        if (keyCount_ * 2 >= keyCapacity_) // full: names of records are few, the other ones are copied
+            return 0;
+        Ch* copy = owned;
+        if (!copy) {
+            copy = static_cast<Ch*>(GetAllocator().Malloc((length + 1) * sizeof(Ch)));
+            memcpy(copy, str, length * sizeof(Ch));
+            copy[length] = '\0';
+        }
+        keys_[i].str = copy;
+        keys_[i].length = length;
+        keys_[i].hash = hash;
+        keyCount_++;
+        return copy;
+    }
+
+    void GrowInternedKeys() {
+        InternedKey* old = keys_;
+        const SizeType oldCapacity = keyCapacity_;
+        keyCapacity_ = oldCapacity ? oldCapacity * 2 : kDefaultInternedKeyCapacity;
+        // The memory pool only aligns to 4 bytes (RAPIDJSONXML_ALIGN), and the entries hold a pointer
+        const uintptr_t p = reinterpret_cast<uintptr_t>(GetAllocator().Malloc(keyCapacity_ * sizeof(InternedKey) + sizeof(void*) - 1));
+        keys_ = reinterpret_cast<InternedKey*>((p + sizeof(void*) - 1) & ~static_cast<uintptr_t>(sizeof(void*) - 1));
+        memset(keys_, 0, keyCapacity_ * sizeof(InternedKey));
+        for (SizeType j = 0; j < oldCapacity; j++)
+            if (old[j].str) {
+                SizeType i = old[j].hash & (keyCapacity_ - 1);
+                while (keys_[i].str)
+                    i = (i + 1) & (keyCapacity_ - 1);
+                keys_[i] = old[j];
+            }
+        // the old table stays in the allocator, which does not need Free()
+    }
+
     void ClearStack() {
+        keys_ = 0; // names are shared during one parsing only, the allocator may be cleared after it
+        keyCount_ = keyCapacity_ = 0;
+        attributes_ = elementAttributes_ = AttributeIteratorPair();
         if (Allocator::kNeedFree)
             while (stack_.GetSize() > 0) // Here assumes all elements in stack array are GenericValue (Member is actually 2 GenericValue objects)
                 (stack_.template Pop<ValueType>(1))->~ValueType();
@@ -1928,9 +2339,24 @@ private:
             stack_.Clear();
     }
 
+    //! Entry of the intern table, empty when str is 0
+    struct InternedKey {
+        const Ch* str;
+        SizeType length;
+        SizeType hash;
+    };
+
     static const size_t kDefaultStackCapacity = 1024;
+    static const SizeType kDefaultInternedKeyCapacity = 64;
+    static const SizeType kMaxInternedKeys = 4096;
     internal::Stack<Allocator> stack_;
     ParseResult parseResult_;
+    AttributeIteratorPair attributes_;          //!< attributes of the next value, from OpenTag() or ElementAttributes()
+    AttributeIteratorPair elementAttributes_;   //!< attributes of the first element of the next array, from OpenTag()
+    bool internKeys_;                           //!< whether the names are shared, see SetKeyInterning()
+    InternedKey* keys_;                         //!< open-addressing table of the shared names of the current parsing
+    SizeType keyCount_;
+    SizeType keyCapacity_;
 };
 
 //! GenericDocument with UTF8 encoding
@@ -1943,6 +2369,7 @@ inline
 GenericValue<Encoding,Allocator>::GenericValue(const GenericValue<Encoding,SourceAllocator>& rhs, Allocator& allocator)
 {
     GenericDocument<Encoding,Allocator> d(&allocator);
+    d.attributes_ = AttributeIteratorPair(rhs.AttributeBegin(), rhs.AttributeEnd()); // no tag for the root
     rhs.Accept(d);
     RawAssign(*d.stack_.template Pop<GenericValue>(1));
 }
@@ -60,6 +60,27 @@ inline const RAPIDJSONXML_ERROR_CHARTYPE* GetParseError_En(ParseErrorCode parseE
     case kParseErrorUnspecificSyntaxError:
         return RAPIDJSONXML_ERROR_STRING("Unspecific syntax error.");
 
+    case kParseErrorXmlNameInvalid:
+        return RAPIDJSONXML_ERROR_STRING("Invalid name of element or attribute.");
+    case kParseErrorXmlTagMissGreaterThan:
+        return RAPIDJSONXML_ERROR_STRING("Missing a '>' at the end of a tag.");
+    case kParseErrorXmlTagMismatch:
+        return RAPIDJSONXML_ERROR_STRING("The end tag does not match the start tag.");
+    case kParseErrorXmlElementUnterminated:
+        return RAPIDJSONXML_ERROR_STRING("Missing the end tag of an element.");
+    case kParseErrorXmlAttributeMissEquals:
+        return RAPIDJSONXML_ERROR_STRING("Missing an '=' after an attribute name.");
+    case kParseErrorXmlAttributeMissQuotationMark:
+        return RAPIDJSONXML_ERROR_STRING("Missing a quotation mark around an attribute value.");
+    case kParseErrorXmlAttributeValueInvalid:
+        return RAPIDJSONXML_ERROR_STRING("Invalid '<' in an attribute value.");
+    case kParseErrorXmlEntityInvalid:
+        return RAPIDJSONXML_ERROR_STRING("Invalid entity or character reference.");
+    case kParseErrorXmlMarkupInvalid:
+        return RAPIDJSONXML_ERROR_STRING("Invalid or unterminated comment, CDATA section, processing instruction or declaration.");
+    case kParseErrorXmlTextOutsideElement:
+        return RAPIDJSONXML_ERROR_STRING("Text outside of any element.");
+
     default:
         return RAPIDJSONXML_ERROR_STRING("Unknown error.");
     }
@@ -60,6 +60,17 @@ enum ParseErrorCode {
 
     kParseErrorTermination,                     //!< Parsing was terminated.
     kParseErrorUnspecificSyntaxError,           //!< Unspecific syntax error.
+
+    kParseErrorXmlNameInvalid,                  //!< Invalid name of element or attribute.
+    kParseErrorXmlTagMissGreaterThan,           //!< Missing a '>' at the end of a tag.
+    kParseErrorXmlTagMismatch,                  //!< The end tag does not match the start tag.
+    kParseErrorXmlElementUnterminated,          //!< Missing the end tag of an element.
+    kParseErrorXmlAttributeMissEquals,          //!< Missing an '=' after an attribute name.
+    kParseErrorXmlAttributeMissQuotationMark,   //!< Missing a quotation mark around an attribute value.
+    kParseErrorXmlAttributeValueInvalid,        //!< Invalid '<' in an attribute value.
+    kParseErrorXmlEntityInvalid,                //!< Invalid entity or character reference.
+    kParseErrorXmlMarkupInvalid,                //!< Invalid or unterminated comment, CDATA section, processing instruction or declaration.
+    kParseErrorXmlTextOutsideElement,           //!< Text outside of any element.
 };
 
 //! Result of parsing (wraps ParseErrorCode)
@@ -41,6 +41,23 @@ public:
         }
     }
 
+    void PutBlock(const char* str, size_t n) {
+        size_t avail = static_cast<size_t>(bufferEnd_ - current_);
+        while (n > avail) {
+            memcpy(current_, str, avail);
+            current_ += avail;
+            str += avail;
+            Flush();
+            n -= avail;
+            avail = static_cast<size_t>(bufferEnd_ - current_);
+        }
+
+        if (n > 0) {
+            memcpy(current_, str, n);
+            current_ += n;
+        }
+    }
+
     void Flush() {
         if (current_ != buffer_) {
             fwrite(buffer_, 1, static_cast<size_t>(current_ - buffer_), fp_);
@@ -87,6 +104,12 @@ inline void PutN(FileWriteStream& stream, char c, size_t n) {
     stream.PutN(c, n);
 }
 
+//! Implement specialized version of PutBlock() with memcpy() for better performance.
+template<>
+inline void PutBlock(FileWriteStream& stream, const char* str, size_t n) {
+    stream.PutBlock(str, n);
+}
+
 } // namespace rapidjsonxml
 
 #endif // RAPIDJSONXML_FILEWRITESTREAM_H_
@@ -0,0 +1,201 @@
+#ifndef RAPIDJSONXML_INTERNAL_BIGINTEGER_H_
+#define RAPIDJSONXML_INTERNAL_BIGINTEGER_H_
+
+#include "../rapidjsonxml.h"
+
+namespace rapidjsonxml {
+namespace internal {
+
+//! Unsigned arbitrary precision integer with a fixed capacity, for exact floating point conversions.
+class BigInteger {
+public:
+    typedef uint64_t Type;
+
+    BigInteger(const BigInteger& rhs) : digits_(), count_(rhs.count_) {
+        std::memcpy(digits_, rhs.digits_, count_ * sizeof(Type));
+    }
+
+    explicit BigInteger(uint64_t u) : digits_(), count_(1) {
+        digits_[0] = u;
+    }
+
+    //! Construct from a string of decimal digits.
+    BigInteger(const char* decimals, size_t length) : digits_(), count_(1) {
+        RAPIDJSONXML_ASSERT(length > 0);
+        digits_[0] = 0;
+        const size_t kMaxDigitPerIteration = 19;  // 10^19 < 2^64
+        for (; length >= kMaxDigitPerIteration; length -= kMaxDigitPerIteration, decimals += kMaxDigitPerIteration)
+            AppendDecimal64(decimals, kMaxDigitPerIteration);
+        if (length > 0)
+            AppendDecimal64(decimals, length);
+    }
+
+    BigInteger& operator=(const BigInteger &rhs) {
+        if (this != &rhs) {
+            count_ = rhs.count_;
+            std::memcpy(digits_, rhs.digits_, count_ * sizeof(Type));
+        }
+        return *this;
+    }
+
+    BigInteger& operator=(uint64_t u) {
+        digits_[0] = u;
+        count_ = 1;
+        return *this;
+    }
+
+    BigInteger& operator+=(uint64_t u) {
+        Type backup = digits_[0];
+        digits_[0] += u;
+        for (size_t i = 0; i < count_ - 1; i++) {
+            if (digits_[i] >= backup)
+                return *this; // no carry
+            backup = digits_[i + 1];
+            digits_[i + 1] += 1;
+        }
+
+        // Last carry
+        if (digits_[count_ - 1] < backup)
+            PushBack(1);
+
+        return *this;
+    }
+
+    BigInteger& operator*=(uint64_t u) {
+        if (u == 0) return *this = 0;
+        if (u == 1) return *this;
+        if (*this == 1) return *this = u;
+
+        uint64_t k = 0;
+        for (size_t i = 0; i < count_; i++) {
+            uint64_t hi;
+            digits_[i] = MulAdd64(digits_[i], u, k, &hi);
+            k = hi;
+        }
+
+        if (k > 0)
+            PushBack(k);
+
+        return *this;
+    }
+
+    BigInteger& operator<<=(size_t shift) {
+        if (IsZero() || shift == 0) return *this;
+
+        size_t offset = shift / kTypeBit;
+        size_t interShift = shift % kTypeBit;
+        RAPIDJSONXML_ASSERT(count_ + offset < kCapacity);
+
+        if (interShift == 0) {
+            std::memmove(&digits_[offset], &digits_[0], count_ * sizeof(Type));
+            count_ += offset;
+        }
+        else {
+            digits_[count_] = 0;
+            for (size_t i = count_; i > 0; i--)
+                digits_[i + offset] = (digits_[i] << interShift) | (digits_[i - 1] >> (kTypeBit - interShift));
+            digits_[offset] = digits_[0] << interShift;
+            count_ += offset;
+            if (digits_[count_])
+                count_++;
+        }
+
+        std::memset(digits_, 0, offset * sizeof(Type));
+
+        return *this;
+    }
+
+    bool operator==(const BigInteger& rhs) const {
+        return count_ == rhs.count_ && std::memcmp(digits_, rhs.digits_, count_ * sizeof(Type)) == 0;
+    }
+
+    bool operator==(const Type rhs) const {
+        return count_ == 1 && digits_[0] == rhs;
+    }
+
+    BigInteger& MultiplyPow5(unsigned exp) {
+        static const uint64_t kPow5[27] = {
+            1U, 5U, 25U, 125U, 625U, 3125U, 15625U, 78125U, 390625U, 1953125U, 9765625U, 48828125U, 244140625U,
+            1220703125U, UINT64_C(6103515625), UINT64_C(30517578125), UINT64_C(152587890625), UINT64_C(762939453125),
+            UINT64_C(3814697265625), UINT64_C(19073486328125), UINT64_C(95367431640625), UINT64_C(476837158203125),
+            UINT64_C(2384185791015625), UINT64_C(11920928955078125), UINT64_C(59604644775390625),
+            UINT64_C(298023223876953125), UINT64_C(1490116119384765625)
+        };
+        if (exp == 0) return *this;
+        for (; exp >= 27; exp -= 27) *this *= UINT64_C(7450580596923828125); // 5^27
+        if (exp > 0) *this *= kPow5[exp];
+        return *this;
+    }
+
+    //! Compare with another integer.
+    /*! \return -1, 0 or 1 if this integer is less than, equal to or greater than \c rhs.
+    */
+    int Compare(const BigInteger& rhs) const {
+        if (count_ != rhs.count_)
+            return count_ < rhs.count_ ? -1 : 1;
+
+        for (size_t i = count_; i-- > 0;)
+            if (digits_[i] != rhs.digits_[i])
+                return digits_[i] < rhs.digits_[i] ? -1 : 1;
+
+        return 0;
+    }
+
+    size_t GetCount() const { return count_; }
+    Type GetDigit(size_t index) const { RAPIDJSONXML_ASSERT(index < count_); return digits_[index]; }
+    bool IsZero() const { return count_ == 1 && digits_[0] == 0; }
+
+private:
+    void AppendDecimal64(const char* decimals, size_t length) {
+        uint64_t u = 0;
+        for (size_t i = 0; i < length; i++)
+            u = u * 10 + static_cast<unsigned>(decimals[i] - '0');
+        if (IsZero())
+            *this = u;
+        else
+            (MultiplyPow5(static_cast<unsigned>(length)) <<= length) += u;
+    }
+
+    void PushBack(Type digit) {
+        RAPIDJSONXML_ASSERT(count_ < kCapacity);
+        digits_[count_++] = digit;
+    }
+
+    // Assume a * b + k < 2^128
+    static uint64_t MulAdd64(uint64_t a, uint64_t b, uint64_t k, uint64_t* outHigh) {
+#if defined(__GNUC__) && defined(__x86_64__)
+        __extension__ typedef unsigned __int128 uint128;
+        uint128 p = static_cast<uint128>(a) * static_cast<uint128>(b);
+        p += k;
+        *outHigh = static_cast<uint64_t>(p >> 64);
+        return static_cast<uint64_t>(p);
+#else
+        const uint64_t a0 = a & 0xFFFFFFFF, a1 = a >> 32, b0 = b & 0xFFFFFFFF, b1 = b >> 32;
+        uint64_t x0 = a0 * b0, x1 = a0 * b1, x2 = a1 * b0, x3 = a1 * b1;
+        x1 += (x0 >> 32); // can't give carry
+        x1 += x2;
+        if (x1 < x2)
+            x3 += (static_cast<uint64_t>(1) << 32);
+        uint64_t lo = (x1 << 32) + (x0 & 0xFFFFFFFF);
+        uint64_t hi = x3 + (x1 >> 32);
+
+        lo += k;
+        if (lo < k)
+            hi++;
+        *outHigh = hi;
+        return lo;
+#endif
+    }
+
+    static const size_t kBitCount = 3328;  // 52 64-bit digits, about 10^1000
+    static const size_t kTypeBit = sizeof(Type) * 8;
+    static const size_t kCapacity = kBitCount / kTypeBit;
+
+    Type digits_[kCapacity];
+    size_t count_;
+};
+
+} // namespace internal
+} // namespace rapidjsonxml
+
+#endif // RAPIDJSONXML_INTERNAL_BIGINTEGER_H_
@@ -0,0 +1,456 @@
+#ifndef RAPIDJSONXML_INTERNAL_DTOA_
+#define RAPIDJSONXML_INTERNAL_DTOA_
+
+#include "diyfp.h"
+#include "biginteger.h"
+#include "itoa.h"
+#include <cstdio>   // snprintf() or _sprintf_s()
+
+namespace rapidjsonxml {
+namespace internal {
+
+// Digit generation of Grisu2 algorithm, see diyfp.h for the reference.
+
+inline void GrisuRound(char* buffer, int len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w ||  /// closer
+            wp_w - rest > rest + ten_kappa - wp_w)) {
+        buffer[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+inline int CountDecimalDigit32(uint32_t n) {
+    if (n < 10) return 1;
+    if (n < 100) return 2;
+    if (n < 1000) return 3;
+    if (n < 10000) return 4;
+    if (n < 100000) return 5;
+    if (n < 1000000) return 6;
+    if (n < 10000000) return 7;
+    if (n < 100000000) return 8;
+    // Will not reach 10 digits in DigitGen()
+    return 9;
+}
+
+inline void DigitGen(const DiyFp& W, const DiyFp& Mp, uint64_t delta, char* buffer, int* len, int* K) {
+    static const uint64_t kPow10[] = { 1U, 10U, 100U, 1000U, 10000U, 100000U, 1000000U, 10000000U, 100000000U,
+                                       1000000000U, UINT64_C(10000000000), UINT64_C(100000000000), UINT64_C(1000000000000),
+                                       UINT64_C(10000000000000), UINT64_C(100000000000000), UINT64_C(1000000000000000),
+                                       UINT64_C(10000000000000000), UINT64_C(100000000000000000), UINT64_C(1000000000000000000),
+                                       UINT64_C(10000000000000000000) };
+    const DiyFp one(static_cast<uint64_t>(1) << -Mp.e, Mp.e);
+    const DiyFp wp_w = Mp - W;
+    uint32_t p1 = static_cast<uint32_t>(Mp.f >> -one.e);
+    uint64_t p2 = Mp.f & (one.f - 1);
+    int kappa = CountDecimalDigit32(p1); // kappa in [0, 9]
+    *len = 0;
+
+    while (kappa > 0) {
+        uint32_t d = 0;
+        switch (kappa) {
+            case  9: d = p1 /  100000000; p1 %=  100000000; break;
+            case  8: d = p1 /   10000000; p1 %=   10000000; break;
+            case  7: d = p1 /    1000000; p1 %=    1000000; break;
+            case  6: d = p1 /     100000; p1 %=     100000; break;
+            case  5: d = p1 /      10000; p1 %=      10000; break;
+            case  4: d = p1 /       1000; p1 %=       1000; break;
+            case  3: d = p1 /        100; p1 %=        100; break;
+            case  2: d = p1 /         10; p1 %=         10; break;
+            case  1: d = p1;              p1 =           0; break;
+            default:;
+        }
+        if (d || *len)
+            buffer[(*len)++] = static_cast<char>('0' + static_cast<char>(d));
+        kappa--;
+        uint64_t tmp = (static_cast<uint64_t>(p1) << -one.e) + p2;
+        if (tmp <= delta) {
+            *K += kappa;
+            GrisuRound(buffer, *len, delta, tmp, kPow10[kappa] << -one.e, wp_w.f);
+            return;
+        }
+    }
+
+    // kappa = 0
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        char d = static_cast<char>(p2 >> -one.e);
+        if (d || *len)
+            buffer[(*len)++] = static_cast<char>('0' + d);
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta) {
+            *K += kappa;
+            int index = -kappa;
+            GrisuRound(buffer, *len, delta, p2, one.f, wp_w.f * (index < 20 ? kPow10[index] : 0));
+            return;
+        }
+    }
+}
+
+//! Generate the shortest digits of a positive finite double which round-trip.
+/*! \param value Positive finite value.
+    \param buffer Output of at most 17 digits, without leading zero.
+    \param length Number of digits written.
+    \param K Decimal exponent, value ~= digits * 10^K.
+    \param conservative If true, the rounding interval is narrowed by the error
+        of the multiplications, so the digits always round-trip but may not be
+        the shortest ones (about 0.1% of random doubles). Otherwise it is widened,
+        and the digits have to be checked with IsRoundTrip().
+*/
+inline void Grisu2(double value, char* buffer, int* length, int* K, bool conservative = true) {
+    const DiyFp v(value);
+    DiyFp w_m, w_p;
+    v.NormalizedBoundaries(&w_m, &w_p);
+
+    const DiyFp c_mk = GetCachedPower(w_p.e, K);
+    const DiyFp W = v.Normalize() * c_mk;
+    DiyFp Wp = w_p * c_mk;
+    DiyFp Wm = w_m * c_mk;
+    if (conservative) {
+        Wm.f++;
+        Wp.f--;
+    }
+    else if (~Wp.f != 0) {
+        Wm.f--;
+        Wp.f++;
+    }
+    DigitGen(W, Wp, Wp.f - Wm.f, buffer, length, K);
+}
+
+//! Check whether digits * 10^K converts back to the positive finite double.
+/*! Compares the decimal value with the boundaries of the rounding interval
+    of the double exactly.
+*/
+inline bool IsRoundTrip(double value, const char* digits, int length, int K) {
+    const DiyFp v(value);
+    uint64_t d = 0;
+    for (int i = 0; i < length; i++)
+        d = d * 10 + static_cast<uint64_t>(digits[i] - '0');
+
+    // Boundaries are the middle points with the adjacent doubles: (4f +/- 2) * 2^(e-2),
+    // the lower one is closer for powers of two
+    const bool closerLower = v.f == DiyFp::kDpHiddenBit && v.e > DiyFp::kDpMinExponent + 1;
+    BigInteger upper(4 * v.f + 2);
+    BigInteger lower(4 * v.f - (closerLower ? 1 : 2));
+    int exp2 = v.e - 2;
+
+    BigInteger c(d);
+    int cExp2 = 0;
+    if (K >= 0) {
+        c.MultiplyPow5(static_cast<unsigned>(K));
+        cExp2 = K;
+    }
+    else {
+        upper.MultiplyPow5(static_cast<unsigned>(-K));
+        lower.MultiplyPow5(static_cast<unsigned>(-K));
+        exp2 -= K;
+    }
+
+    if (cExp2 > exp2)
+        c <<= static_cast<size_t>(cExp2 - exp2);
+    else {
+        upper <<= static_cast<size_t>(exp2 - cExp2);
+        lower <<= static_cast<size_t>(exp2 - cExp2);
+    }
+
+    // Ties are rounded to the even significand
+    const int cmpLower = c.Compare(lower);
+    const int cmpUpper = c.Compare(upper);
+    if (v.f & 1)
+        return cmpLower > 0 && cmpUpper < 0;
+    return cmpLower >= 0 && cmpUpper <= 0;
+}
+
+//! Generate the shortest digits of a positive finite double which round-trip.
+/*! Grisu2() is only checked again when it needs 16 digits or more, as it
+    is when it misses a shorter representation close to the boundaries.
+*/
+inline void ShortestDigits(double value, char* buffer, int* length, int* K) {
+    Grisu2(value, buffer, length, K);
+    if (*length >= 16) {
+        char digits[20];
+        int n, k;
+        Grisu2(value, digits, &n, &k, false);
+        if (n < *length && IsRoundTrip(value, digits, n, k)) {
+            std::memcpy(buffer, digits, static_cast<size_t>(n));
+            *length = n;
+            *K = k;
+        }
+    }
+}
+
+//! Round the shortest digits of a double to \c precision significant digits.
+/*! The digits are within half an ULP of the exact value, so rounding them is
+    exact unless the dropped digits are too close to half of the last kept one.
+    \return false if the result may differ from the exact rounding.
+*/
+inline bool RoundDigits(char* buffer, int* length, int* K, int precision) {
+    RAPIDJSONXML_ASSERT(precision >= 1 && precision <= 15);
+    if (*length <= precision)
+        return true;
+
+    // Dropped digits and half of the last kept digit, as 17-digit significands
+    uint64_t tail = 0;
+    uint64_t half = 5;
+    for (int i = precision; i < 17; i++) {
+        tail = tail * 10 + static_cast<uint64_t>(i < *length ? buffer[i] - '0' : 0);
+        if (i > precision)
+            half *= 10;
+    }
+    // Half an ULP of a normal double is less than 12 units of its 17th significant digit, keep a margin
+    if ((tail > half ? tail - half : half - tail) < 16)
+        return false;
+
+    *K += *length - precision;
+    *length = precision;
+    if (tail > half) {
+        int i = precision - 1;
+        while (i >= 0 && buffer[i] == '9')
+            buffer[i--] = '0';
+        if (i >= 0)
+            buffer[i]++;
+        else { // 999 -> 1000
+            buffer[0] = '1';
+            (*K)++;
+        }
+    }
+    return true;
+}
+
+//! Write the digits with exponent in the format of printf("%.*g").
+inline char* FormatDigits(char* buffer, int length, int K, int precision) {
+    while (length > 1 && buffer[length - 1] == '0') { // %g removes trailing zeros
+        length--;
+        K++;
+    }
+    const int exponent = length + K - 1; // value = d.ddd * 10^exponent
+
+    if (exponent >= -4 && exponent < precision) {
+        if (exponent >= length - 1) {
+            // 1234e7 -> 12340000000
+            for (int i = length; i <= exponent; i++)
+                buffer[i] = '0';
+            return &buffer[exponent + 1];
+        }
+        else if (exponent >= 0) {
+            // 1234e-2 -> 12.34
+            std::memmove(&buffer[exponent + 2], &buffer[exponent + 1], static_cast<size_t>(length - exponent - 1));
+            buffer[exponent + 1] = '.';
+            return &buffer[length + 1];
+        }
+        else {
+            // 1234e-6 -> 0.001234
+            const int offset = 1 - exponent;
+            std::memmove(&buffer[offset], &buffer[0], static_cast<size_t>(length));
+            buffer[0] = '0';
+            buffer[1] = '.';
+            for (int i = 2; i < offset; i++)
+                buffer[i] = '0';
+            return &buffer[length + offset];
+        }
+    }
+
+    // 1234e30 -> 1.234e+33
+    char* p = &buffer[1];
+    if (length > 1) {
+        std::memmove(&buffer[2], &buffer[1], static_cast<size_t>(length - 1));
+        buffer[1] = '.';
+        p = &buffer[length + 1];
+    }
+    *p++ = 'e';
+    int e = exponent;
+    if (e < 0) {
+        *p++ = '-';
+        e = -e;
+    }
+    else
+        *p++ = '+';
+    if (e >= 100) {
+        *p++ = static_cast<char>('0' + e / 100);
+        e %= 100;
+    }
+    *p++ = static_cast<char>('0' + e / 10);
+    *p++ = static_cast<char>('0' + e % 10);
+    return p;
+}
+
+//! Maximum number of characters written by dtoa() and fixedtoa()
+/*! The 309 digits of the largest double with fixedtoa(), with the sign, the point and 18 decimals.
+*/
+static const int kDtoaBufferSize = 330;
+
+//! Write a double in the format of printf("%.*g"), without the trailing '\0'.
+/*! \param value Value to write.
+    \param buffer Output buffer of kDtoaBufferSize characters.
+    \param precision Number of significant digits, or 0 for the shortest
+        representation which converts back to the same double (written like "%.17g").
+    \return Pointer past the last written character.
+    \note NaN, infinity, subnormal values and precisions above 15 are written with snprintf().
+*/
+inline char* dtoa(double value, char* buffer, int precision = 0) {
+    union {
+        double d;
+        uint64_t u64;
+    } u = { value };
+    const uint64_t exponentBits = u.u64 & DiyFp::kDpExponentMask;
+
+    if (!(u.u64 & ~(static_cast<uint64_t>(1) << 63))) { // +/-0
+        if (u.u64)
+            *buffer++ = '-';
+        *buffer++ = '0';
+        return buffer;
+    }
+
+    if (exponentBits != DiyFp::kDpExponentMask && precision <= 15 && (precision == 0 || exponentBits != 0)) {
+        char* p = buffer;
+        if (value < 0)
+            *p++ = '-';
+        int length, K;
+        if (precision == 0) {
+            ShortestDigits(value < 0 ? -value : value, p, &length, &K);
+            return FormatDigits(p, length, K, 17);
+        }
+        Grisu2(value < 0 ? -value : value, p, &length, &K);
+        if (RoundDigits(p, &length, &K, precision))
+            return FormatDigits(p, length, K, precision);
+    }
+
+#ifdef _MSC_VER
+    int ret = sprintf_s(buffer, kDtoaBufferSize, "%.*g", precision, value);
+#else
+    int ret = snprintf(buffer, kDtoaBufferSize, "%.*g", precision, value);
+#endif
+    RAPIDJSONXML_ASSERT(ret >= 1);
+    return buffer + (ret < kDtoaBufferSize ? ret : kDtoaBufferSize - 1);
+}
+
+//! Maximum number of decimals written by fixedtoa()
+static const int kMaxFixedDecimals = 18;
+
+//! Round the exact value of a positive finite double times \c scale to the nearest integer.
+/*! Ties are rounded to even, as printf() does.
+    \return false if the result does not fit in 64 bits.
+*/
+inline bool ScaleToInteger(double value, uint64_t scale, uint64_t* result) {
+    const DiyFp v(value);
+    uint64_t hi, lo = Mul128(v.f, scale, &hi); // exact value is (hi:lo) * 2^e
+
+    if (v.e >= 0) {
+        if (hi != 0 || v.e >= 64 || (v.e > 0 && (lo >> (64 - v.e)) != 0))
+            return false;
+        *result = lo << v.e;
+        return true;
+    }
+
+    const unsigned shift = static_cast<unsigned>(-v.e);
+    if (shift >= 128) { // less than 2^117 / 2^128, always rounded down to 0
+        *result = 0;
+        return true;
+    }
+
+    // Split into quotient q and remainder (rh:rl), compare the remainder with half = 2^(shift-1)
+    uint64_t q, rh, rl, halfh, halfl;
+    if (shift < 64) {
+        if ((hi >> shift) != 0)
+            return false;
+        q = (lo >> shift) | (hi << (64 - shift));
+        rh = 0;
+        rl = lo & ((static_cast<uint64_t>(1) << shift) - 1);
+        halfh = 0;
+        halfl = static_cast<uint64_t>(1) << (shift - 1);
+    }
+    else if (shift == 64) {
+        q = hi;
+        rh = 0;
+        rl = lo;
+        halfh = 0;
+        halfl = static_cast<uint64_t>(1) << 63;
+    }
+    else {
+        q = hi >> (shift - 64);
+        rh = hi & ((static_cast<uint64_t>(1) << (shift - 64)) - 1);
+        rl = lo;
+        halfh = static_cast<uint64_t>(1) << (shift - 65);
+        halfl = 0;
+    }
+
+    if (rh > halfh || (rh == halfh && (rl > halfl || (rl == halfl && (q & 1))))) {
+        if (++q == 0)
+            return false;
+    }
+    *result = q;
+    return true;
+}
+
+//! Write a double in the format of printf("%.*f"), without the trailing '\0'.
+/*! The value is scaled to an integer and written by u64toa(), correctly rounded.
+    When the scaled magnitude does not fit in 64 bits, the integer part and the
+    scaled fraction are written separately. Magnitudes of 2^64 and more, which
+    have no fraction, infinity and NaN are written by snprintf().
+    \param value The value to be written.
+    \param buffer Buffer of at least \ref kDtoaBufferSize characters.
+    \param decimals Number of decimals, from 0 to \ref kMaxFixedDecimals.
+    \return The end of the written characters.
+*/
+inline char* fixedtoa(double value, char* buffer, int decimals) {
+    static const uint64_t kPow10[] = {
+        1U, 10U, 100U, 1000U, 10000U, 100000U, 1000000U, 10000000U, 100000000U, 1000000000U,
+        UINT64_C(10000000000), UINT64_C(100000000000), UINT64_C(1000000000000),
+        UINT64_C(10000000000000), UINT64_C(100000000000000), UINT64_C(1000000000000000),
+        UINT64_C(10000000000000000), UINT64_C(100000000000000000), UINT64_C(1000000000000000000)
+    };
+    RAPIDJSONXML_ASSERT(decimals >= 0 && decimals <= kMaxFixedDecimals);
+
+    union {
+        double d;
+        uint64_t u64;
+    } u = { value };
+    const double magnitude = value < 0 ? -value : value;
+    uint64_t integer, fraction;
+    if ((u.u64 & DiyFp::kDpExponentMask) == DiyFp::kDpExponentMask || magnitude >= 18446744073709551616.0) {
+#ifdef _MSC_VER
+        int ret = sprintf_s(buffer, kDtoaBufferSize, "%.*f", decimals, value);
+#else
+        int ret = snprintf(buffer, kDtoaBufferSize, "%.*f", decimals, value);
+#endif
+        RAPIDJSONXML_ASSERT(ret >= 1);
+        return buffer + (ret < kDtoaBufferSize ? ret : kDtoaBufferSize - 1);
+    }
+    uint64_t scaled;
+    if (ScaleToInteger(magnitude, kPow10[decimals], &scaled)) {
+        integer = scaled / kPow10[decimals];
+        fraction = scaled % kPow10[decimals];
+    }
+    else {
+        // The fraction of a double from 1 is exact, and its scaled value has at most 18 digits.
+        // With decimals > 0, the parity of the fraction is the one of the scaled value for the ties.
+        integer = static_cast<uint64_t>(magnitude);
+        const double rest = magnitude - static_cast<double>(integer);
+        fraction = 0;
+        if (rest > 0)
+            ScaleToInteger(rest, kPow10[decimals], &fraction); // less than 10^18, always fits
+        if (fraction == kPow10[decimals]) { // 0.9999 -> 1.000, there is a fraction below 2^53
+            integer++;
+            fraction = 0;
+        }
+    }
+
+    char* p = buffer;
+    if (u.u64 >> 63)
+        *p++ = '-';
+    p = u64toa(integer, p);
+    if (decimals > 0) {
+        // Write 10^decimals + fraction for the leading zeros, then replace the leading '1' by the point
+        char* point = p;
+        p = u64toa(kPow10[decimals] + fraction, p);
+        *point = '.';
+    }
+    return p;
+}
+
+} // namespace internal
+} // namespace rapidjsonxml
+
+#endif // RAPIDJSONXML_INTERNAL_DTOA_
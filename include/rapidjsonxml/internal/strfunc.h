@@ -17,6 +17,20 @@ inline SizeType StrLen(const Ch* s) {
     return SizeType(p - s);
 }
 
+//! FNV-1a hash of a string, which is never 0.
+/*! \tparam Ch Character type (e.g. char, wchar_t, short)
+    \param s Input string.
+    \param length Number of characters of the string.
+    \return Hash of the characters, the same for every encoding unit size.
+*/
+template <typename Ch>
+inline SizeType StrHash(const Ch* s, SizeType length) {
+    SizeType h = 2166136261u;
+    for (SizeType i = 0; i < length; i++)
+        h = (h ^ static_cast<SizeType>(s[i])) * 16777619u;
+    return h != 0 ? h : 1;
+}
+
 } // namespace internal
 } // namespace rapidjsonxml
 
@@ -0,0 +1,756 @@
+#ifndef RAPIDJSONXML_LAZYDOCUMENT_H_
+#define RAPIDJSONXML_LAZYDOCUMENT_H_
+
+#include "document.h"
+
+namespace rapidjsonxml {
+
+// Forward declarations.
+template <typename Encoding, typename Allocator>
+class GenericLazyDocument;
+
+template <typename Encoding, typename Allocator>
+class GenericLazyValueIterator;
+
+template <typename Encoding, typename Allocator>
+class GenericLazyMemberIterator;
+
+///////////////////////////////////////////////////////////////////////////////
+// GenericLazyValue
+
+//! Value of a GenericLazyDocument, decoded the first time it is read.
+/*! A lazy value is a small handle (a document and a position) with the
+    read-only API of GenericValue. Its type, the members of an object and the
+    elements of an array are known from the structure recorded by
+    GenericLazyDocument::Parse(). Strings and numbers are decoded by the first
+    call to an accessor needing them, e.g. GetString() or GetInt(), into a
+    GenericValue of the document allocator, returned again by the next calls.
+
+    A handle of a missing member is a null value.
+
+    \tparam Encoding Encoding of the text and of the decoded strings.
+    \tparam Allocator Allocator type of the document.
+    \note Reading a value for the first time updates the document: a document must not be read by several threads at the same time.
+*/
+template <typename Encoding, typename Allocator = MemoryPoolAllocator<> >
+class GenericLazyValue {
+public:
+    typedef typename Encoding::Ch Ch;                                           //!< Character type derived from Encoding.
+    typedef GenericValue<Encoding, Allocator> ValueType;                        //!< Type of the decoded values.
+    typedef GenericLazyDocument<Encoding, Allocator> DocumentType;              //!< Document of the value.
+    typedef GenericLazyValueIterator<Encoding, Allocator> ConstValueIterator;   //!< Iterator over the elements of an array.
+    typedef GenericLazyMemberIterator<Encoding, Allocator> ConstMemberIterator; //!< Iterator over the members of an object.
+
+    //! Default constructor, a null value.
+    GenericLazyValue() : document_(0), index_(0) {}
+
+    //!@name Type
+    //@{
+
+    Type GetType() const {
+        return document_ ? document_->GetNodeType(index_) : kNullType;
+    }
+    bool IsNull() const { return GetType() == kNullType; }
+    bool IsFalse() const { return GetType() == kFalseType; }
+    bool IsTrue() const { return GetType() == kTrueType; }
+    bool IsBool() const { return IsFalse() || IsTrue(); }
+    bool IsObject() const { return GetType() == kObjectType; }
+    bool IsArray() const { return GetType() == kArrayType; }
+    bool IsNumber() const { return GetType() == kNumberType; }
+    bool IsString() const { return GetType() == kStringType; }
+
+    // The type of a number is known once it is decoded
+    bool IsInt() const { return IsNumber() && GetValue().IsInt(); }
+    bool IsUint() const { return IsNumber() && GetValue().IsUint(); }
+    bool IsInt64() const { return IsNumber() && GetValue().IsInt64(); }
+    bool IsUint64() const { return IsNumber() && GetValue().IsUint64(); }
+    bool IsDouble() const { return IsNumber() && GetValue().IsDouble(); }
+
+    //@}
+
+    //!@name Scalars
+    //@{
+
+    //! Get the decoded value of a null, a boolean, a number or a string.
+    /*! The value is decoded by the first call, into the document allocator.
+        \pre IsObject() == false && IsArray() == false
+    */
+    const ValueType& GetValue() const {
+        RAPIDJSONXML_ASSERT(!IsObject() && !IsArray());
+        if (!document_) {
+            static const ValueType NullValue;
+            return NullValue;
+        }
+        return document_->Decode(index_);
+    }
+
+    bool GetBool() const {
+        RAPIDJSONXML_ASSERT(IsBool());
+        return IsTrue();
+    }
+    int GetInt() const { return GetValue().GetInt(); }
+    unsigned GetUint() const { return GetValue().GetUint(); }
+    int64_t GetInt64() const { return GetValue().GetInt64(); }
+    uint64_t GetUint64() const { return GetValue().GetUint64(); }
+    double GetDouble() const { return GetValue().GetDouble(); }
+
+    //! Get the decoded string, null-terminated.
+    const Ch* GetString() const { return GetValue().GetString(); }
+
+    //! Get the length of the decoded string.
+    SizeType GetStringLength() const { return GetValue().GetStringLength(); }
+
+    //@}
+
+    //!@name Object
+    //@{
+
+    //! Get the number of members.
+    /*! \pre IsObject() == true */
+    SizeType MemberCount() const {
+        RAPIDJSONXML_ASSERT(IsObject());
+        return document_->GetNode(index_).length;
+    }
+
+    //! Const member iterator
+    /*! \pre IsObject() == true */
+    ConstMemberIterator MemberBegin() const {
+        RAPIDJSONXML_ASSERT(IsObject());
+        return ConstMemberIterator(document_, index_ + 1);
+    }
+    //! Const \em past-the-end member iterator
+    /*! \pre IsObject() == true */
+    ConstMemberIterator MemberEnd() const {
+        RAPIDJSONXML_ASSERT(IsObject());
+        return ConstMemberIterator(document_, document_->GetNode(index_).next);
+    }
+
+    //! Find the first member with the name, comparing the names in the text when they have no escapes.
+    /*! \pre IsObject() == true
+        \return Iterator to the member, if it exists. Otherwise MemberEnd().
+    */
+    ConstMemberIterator FindMember(const Ch* name) const {
+        return FindMember(name, internal::StrLen(name));
+    }
+    ConstMemberIterator FindMember(const ValueType& name) const {
+        RAPIDJSONXML_ASSERT(name.IsString());
+        return FindMember(name.GetString(), name.GetStringLength());
+    }
+    ConstMemberIterator FindMember(const Ch* name, SizeType length) const {
+        RAPIDJSONXML_ASSERT(IsObject());
+        return ConstMemberIterator(document_, document_->FindMember(index_, name, length));
+    }
+
+    //! Check whether a member exists in the object.
+    bool HasMember(const Ch* name) const {
+        return FindMember(name) != MemberEnd();
+    }
+
+    //! Get the value associated with the name.
+    /*! As GenericValue::operator[](), this asserts when the member does not exist.
+        \return The value of the member, or a null value.
+    */
+    GenericLazyValue operator[](const Ch* name) const {
+        ConstMemberIterator member = FindMember(name);
+        if (member != MemberEnd())
+            return member->value;
+        RAPIDJSONXML_ASSERT(false);
+        return GenericLazyValue();
+    }
+
+    //@}
+
+    //!@name Array
+    //@{
+
+    //! Get the number of elements in array.
+    /*! \pre IsArray() == true */
+    SizeType Size() const {
+        RAPIDJSONXML_ASSERT(IsArray());
+        return document_->GetNode(index_).length;
+    }
+
+    //! Check whether the array is empty.
+    bool Empty() const {
+        return Size() == 0;
+    }
+
+    //! Get an element of the array.
+    /*! The elements are found by skipping the previous ones: this takes a
+        time linear in \c index, prefer Begin() and End() to read them all.
+        \pre IsArray() == true && index < Size()
+    */
+    GenericLazyValue operator[](SizeType index) const {
+        RAPIDJSONXML_ASSERT(index < Size());
+        SizeType i = index_ + 1;
+        while (index--)
+            i = document_->GetNext(i);
+        return GenericLazyValue(document_, i);
+    }
+
+    //! Element iterator
+    /*! \pre IsArray() == true */
+    ConstValueIterator Begin() const {
+        RAPIDJSONXML_ASSERT(IsArray());
+        return ConstValueIterator(document_, index_ + 1);
+    }
+    //! \em Past-the-end element iterator
+    /*! \pre IsArray() == true */
+    ConstValueIterator End() const {
+        RAPIDJSONXML_ASSERT(IsArray());
+        return ConstValueIterator(document_, document_->GetNode(index_).next);
+    }
+
+    //@}
+
+private:
+    friend class GenericLazyDocument<Encoding, Allocator>;
+    friend class GenericLazyValueIterator<Encoding, Allocator>;
+    friend class GenericLazyMemberIterator<Encoding, Allocator>;
+
+    GenericLazyValue(DocumentType* document, SizeType index) : document_(document), index_(index) {}
+
+    //! Move to the next value of the same container.
+    void Next() {
+        index_ = document_->GetNext(index_);
+    }
+
+    DocumentType* document_;    //!< Document of the value, 0 for a null value without document
+    SizeType index_;            //!< Position of the value in the structure of the document
+};
+
+//! Name-value pair of an object of a GenericLazyDocument.
+template <typename Encoding, typename Allocator>
+struct GenericLazyMember {
+    GenericLazyMember() : name(), value() {}
+
+    GenericLazyValue<Encoding, Allocator> name;     //!< name of member (must be a string)
+    GenericLazyValue<Encoding, Allocator> value;    //!< value of member.
+};
+
+//! Forward iterator over the elements of an array of a GenericLazyDocument.
+template <typename Encoding, typename Allocator>
+class GenericLazyValueIterator {
+public:
+    typedef GenericLazyValue<Encoding, Allocator> LazyValueType;
+
+    GenericLazyValueIterator() : value_() {}
+
+    const LazyValueType& operator*() const { return value_; }
+    const LazyValueType* operator->() const { return &value_; }
+
+    GenericLazyValueIterator& operator++() { value_.Next(); return *this; }
+    GenericLazyValueIterator operator++(int) { GenericLazyValueIterator old(*this); value_.Next(); return old; }
+
+    bool operator==(const GenericLazyValueIterator& rhs) const { return value_.index_ == rhs.value_.index_; }
+    bool operator!=(const GenericLazyValueIterator& rhs) const { return value_.index_ != rhs.value_.index_; }
+
+private:
+    friend class GenericLazyValue<Encoding, Allocator>;
+
+    GenericLazyValueIterator(GenericLazyDocument<Encoding, Allocator>* document, SizeType index) : value_(document, index) {}
+
+    LazyValueType value_;
+};
+
+//! Forward iterator over the members of an object of a GenericLazyDocument.
+template <typename Encoding, typename Allocator>
+class GenericLazyMemberIterator {
+public:
+    typedef GenericLazyMember<Encoding, Allocator> MemberType;
+
+    GenericLazyMemberIterator() : member_() {}
+
+    const MemberType& operator*() const { return member_; }
+    const MemberType* operator->() const { return &member_; }
+
+    GenericLazyMemberIterator& operator++() { Next(); return *this; }
+    GenericLazyMemberIterator operator++(int) { GenericLazyMemberIterator old(*this); Next(); return old; }
+
+    bool operator==(const GenericLazyMemberIterator& rhs) const { return member_.name.index_ == rhs.member_.name.index_; }
+    bool operator!=(const GenericLazyMemberIterator& rhs) const { return member_.name.index_ != rhs.member_.name.index_; }
+
+private:
+    friend class GenericLazyValue<Encoding, Allocator>;
+
+    // The value follows its name in the structure
+    GenericLazyMemberIterator(GenericLazyDocument<Encoding, Allocator>* document, SizeType index) : member_() {
+        member_.name = GenericLazyValue<Encoding, Allocator>(document, index);
+        member_.value = GenericLazyValue<Encoding, Allocator>(document, index + 1);
+    }
+
+    void Next() {
+        member_.value.Next();
+        member_.name = member_.value;
+        member_.value.index_++;
+    }
+
+    MemberType member_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// GenericLazyDocument
+
+//! A document recording the structure of a JSON text, and decoding its values on access.
+/*! Parse() makes a single pass over the text, checking its syntax and
+    recording the position of each value, the extent of the objects and
+    arrays, and the spans of the member names, without decoding anything.
+    The values are then read through GenericLazyValue, from GetRoot():
+    \code
+    LazyDocument d;
+    d.Parse(json);
+    if (!d.HasParseError()) {
+        LazyValue order = d.GetRoot()["order"];
+        Use(order["id"].GetUint64(), order["customer"].GetString());
+    }
+    \endcode
+    This is faster than GenericDocument when only a few values of a large text
+    are read: the other strings are not copied and the other numbers are not
+    converted.
+
+    Each value takes 16 bytes in the structure, of a CrtAllocator, and the
+    values read take a GenericValue, and their strings, in the allocator. The member names without
+    escapes are compared in the text, the other ones are decoded once.
+
+    \tparam Encoding Encoding of the text, and of the decoded strings.
+    \tparam Allocator Allocator for the decoded values.
+    \note The text is referenced, not copied: it must live as long as the values are read.
+    \note Only the errors of syntax are found by Parse(). A number too big for a double is read as a null value.
+*/
+template <typename Encoding, typename Allocator = MemoryPoolAllocator<> >
+class GenericLazyDocument {
+public:
+    typedef typename Encoding::Ch Ch;                           //!< Character type derived from Encoding.
+    typedef GenericValue<Encoding, Allocator> ValueType;        //!< Type of the decoded values.
+    typedef GenericLazyValue<Encoding, Allocator> LazyValueType; //!< Type of the values of the document.
+    typedef Allocator AllocatorType;                            //!< Allocator type from template parameter.
+
+    //! Constructor
+    /*! \param allocator        Optional allocator for the decoded values.
+        \param stackCapacity    Initial capacity of the structure in bytes.
+    */
+    GenericLazyDocument(Allocator* allocator = 0, size_t stackCapacity = kDefaultStackCapacity) : allocator_(allocator), ownAllocator_(0), stackAllocator_(),
+        nodes_(&stackAllocator_, stackCapacity), containers_(&stackAllocator_, kDefaultContainerCapacity), decoded_(&stackAllocator_, kDefaultContainerCapacity),
+        reader_(&stackAllocator_), json_(0), parseResult_(), fullPrecision_(false) {
+        if (!allocator_)
+            ownAllocator_ = allocator_ = new Allocator();
+    }
+
+    //! Destructor, freeing the allocator if it is owned by the document
+    ~GenericLazyDocument() {
+        delete ownAllocator_;
+    }
+
+    //!@name Parse from read-only string
+    //!@{
+
+    //! Record the structure of a JSON text from a read-only string
+    /*! \tparam parseFlags Combination of \ref ParseFlag: \ref kParseStopWhenDoneFlag,
+            and \ref kParseFullPrecisionFlag for the numbers decoded later.
+        \param str Read-only zero-terminated string to be parsed, which must outlive the reading of the values.
+        \return The document itself for fluent API.
+    */
+    template <unsigned parseFlags>
+    GenericLazyDocument& Parse(const Ch* str) {
+        RAPIDJSONXML_ASSERT(!(parseFlags & (kParseInsituFlag | kParseValidateEncodingFlag)));
+        json_ = str;
+        nodes_.Clear();
+        containers_.Clear();
+        decoded_.Clear();
+        parseResult_.Clear();
+        fullPrecision_ = (parseFlags & kParseFullPrecisionFlag) != 0;
+
+        GenericStringStream<Encoding> is(str);
+        SkipSpaces(is);
+        if (is.Peek() != '{' && is.Peek() != '[')
+            parseResult_.Set(is.Peek() == '\0' ? kParseErrorDocumentEmpty : kParseErrorDocumentRootNotObjectOrArray, is.Tell());
+        else if (ScanValues(is) && !(parseFlags & kParseStopWhenDoneFlag)) {
+            SkipSpaces(is);
+            if (is.Peek() != '\0')
+                parseResult_.Set(kParseErrorDocumentRootNotSingular, is.Tell());
+        }
+        if (parseResult_.IsError())
+            nodes_.Clear();
+        return *this;
+    }
+
+    //! Record the structure of a JSON text from a read-only string (with \ref kParseDefaultFlags)
+    /*! \param str Read-only zero-terminated string to be parsed, which must outlive the reading of the values.
+    */
+    GenericLazyDocument& Parse(const Ch* str) {
+        return Parse<kParseDefaultFlags>(str);
+    }
+    //!@}
+
+    //! Whether a parse error was occured in the last parsing.
+    bool HasParseError() const {
+        return parseResult_.IsError();
+    }
+
+    //! Get the message of parsing error.
+    ParseErrorCode GetParseError() const {
+        return parseResult_.Code();
+    }
+
+    //! Get the offset in character of the parsing error.
+    size_t GetErrorOffset() const {
+        return parseResult_.Offset();
+    }
+
+    //! Get the root object or array, or a null value without a successful parsing.
+    LazyValueType GetRoot() {
+        return nodes_.Empty() ? LazyValueType() : LazyValueType(this, 0);
+    }
+
+    //! Get the allocator of this document.
+    Allocator& GetAllocator() {
+        return *allocator_;
+    }
+
+private:
+    friend class GenericLazyValue<Encoding, Allocator>;
+
+    // Prohibit copying
+    GenericLazyDocument(const GenericLazyDocument&);
+    GenericLazyDocument& operator=(const GenericLazyDocument&);
+
+    //! Recorded value, followed by its members or elements for an object or an array
+    struct Node {
+        SizeType offset;    //!< Position of the value in the text
+        SizeType length;    //!< Characters between the quotes of a string, number of members or elements of an object or an array
+        SizeType next;      //!< Position of the value after an object or an array, 1 + position of the decoded scalar in decoded_ (0 before the first access)
+        unsigned flags;     //!< Type, with kEscapedFlag for a string with escapes
+    };
+
+    enum {
+        kTypeMask = 0xFF,
+        kEscapedFlag = 0x100
+    };
+
+    //! Handler receiving the events of a single value, decoded into a GenericValue
+    struct Decoder : BaseReaderHandler<Encoding> {
+        Decoder(ValueType& value, Allocator& allocator) : value_(value), allocator_(allocator) {}
+        bool Int(int i) { value_.SetInt(i); return true; }
+        bool Uint(unsigned u) { value_.SetUint(u); return true; }
+        bool Int64(int64_t i) { value_.SetInt64(i); return true; }
+        bool Uint64(uint64_t u) { value_.SetUint64(u); return true; }
+        bool Double(double d) { value_.SetDouble(d); return true; }
+        bool String(const Ch* str, SizeType length, bool) { value_.SetString(str, length, allocator_); return true; }
+
+    private:
+        Decoder(const Decoder&);
+        Decoder& operator=(const Decoder&);
+
+        ValueType& value_;
+        Allocator& allocator_;
+    };
+
+    Node& GetNode(SizeType index) {
+        return nodes_.template Bottom<Node>()[index];
+    }
+
+    SizeType GetNodeCount() const {
+        return static_cast<SizeType>(nodes_.GetSize() / sizeof(Node));
+    }
+
+    //! Position of the next value of the same container
+    SizeType GetNext(SizeType index) {
+        const Node& node = GetNode(index);
+        return node.flags == kObjectType || node.flags == kArrayType ? node.next : index + 1;
+    }
+
+    Type GetNodeType(SizeType index) {
+        return static_cast<Type>(GetNode(index).flags & kTypeMask);
+    }
+
+    //! Decode a scalar once, into a value of the allocator.
+    const ValueType& Decode(SizeType index) {
+        Node& node = GetNode(index);
+        if (node.next)
+            return *decoded_.template Bottom<ValueType*>()[node.next - 1];
+        ValueType* value = new (GetAllocator().Malloc(sizeof(ValueType))) ValueType();
+        switch (node.flags) {
+        case kFalseType:
+            value->SetBool(false);
+            break;
+        case kTrueType:
+            value->SetBool(true);
+            break;
+        case kStringType:   // without escapes, copied to be null-terminated
+            value->SetString(json_ + node.offset + 1, node.length, GetAllocator());
+            break;
+        case kNumberType:
+        case kStringType | kEscapedFlag: {
+                Decoder decoder(*value, GetAllocator());
+                GenericStringStream<Encoding> is(json_ + node.offset);
+                if (fullPrecision_)
+                    reader_.template ParseFragment<kParseFullPrecisionFlag>(is, decoder);
+                else
+                    reader_.template ParseFragment<kParseDefaultFlags>(is, decoder);
+            }
+            break;
+        default:
+            break;
+        }
+        *decoded_.template Push<ValueType*>() = value;
+        node.next = static_cast<SizeType>(decoded_.GetSize() / sizeof(ValueType*));
+        return *value;
+    }
+
+    //! Position of the name of the first member with the name, or the end of the object
+    SizeType FindMember(SizeType object, const Ch* name, SizeType length) {
+        const SizeType end = GetNode(object).next;
+        SizeType i = object + 1;
+        while (i != end && !IsName(i, name, length))
+            i = GetNext(i + 1);
+        return i;
+    }
+
+    bool IsName(SizeType index, const Ch* name, SizeType length) {
+        const Node& node = GetNode(index);
+        if (!(node.flags & kEscapedFlag))
+            return node.length == length && memcmp(json_ + node.offset + 1, name, length * sizeof(Ch)) == 0;
+        const ValueType& decoded = Decode(index);
+        return decoded.GetStringLength() == length && memcmp(decoded.GetString(), name, length * sizeof(Ch)) == 0;
+    }
+
+    Node* PushNode(SizeType offset, unsigned flags) {
+        Node* node = nodes_.template Push<Node>();
+        node->offset = offset;
+        node->length = 0;
+        node->next = 0;
+        node->flags = flags;
+        return node;
+    }
+
+    // Compact texts have few spaces: test the first character before the SIMD instructions
+    static void SkipSpaces(GenericStringStream<Encoding>& is) {
+        if (static_cast<unsigned>(is.Peek()) <= ' ')
+            SkipWhitespace(is);
+    }
+
+    bool Error(ParseErrorCode code, size_t offset) {
+        parseResult_.Set(code, offset);
+        return false;
+    }
+
+    //! Record the values from an opening '{' or '[', up to the matching closing one.
+    /*! The containers being recorded are kept on containers_, instead of recursing. */
+    bool ScanValues(GenericStringStream<Encoding>& is) {
+        for (;;) {
+            // A value, opening the objects and the arrays up to their first value
+            bool empty = false;
+            for (;;) {
+                const Ch c = is.Peek();
+                if (c != '{' && c != '[') {
+                    if (!ScanScalar(is))
+                        return false;
+                    break;
+                }
+                *containers_.template Push<SizeType>() = GetNodeCount();
+                PushNode(static_cast<SizeType>(is.Tell()), c == '{' ? kObjectType : kArrayType);
+                is.Take();
+                SkipSpaces(is);
+                if (is.Peek() == (c == '{' ? '}' : ']')) {
+                    empty = true;
+                    break;
+                }
+                if (c == '{' && !ScanName(is))
+                    return false;
+            }
+
+            // The containers ending after it
+            for (;;) {
+                if (containers_.Empty())
+                    return true;
+                Node& container = GetNode(*containers_.template Top<SizeType>());
+                const bool object = container.flags == kObjectType;
+                if (!empty)
+                    container.length++;
+                empty = false;
+                SkipSpaces(is);
+                const Ch c = is.Take();
+                if (c == ',') {
+                    SkipSpaces(is);
+                    if (object && !ScanName(is))
+                        return false;
+                    break;
+                }
+                if (c != (object ? '}' : ']'))
+                    return Error(object ? kParseErrorObjectMissCommaOrCurlyBracket : kParseErrorArrayMissCommaOrSquareBracket, is.Tell());
+                container.next = GetNodeCount();
+                containers_.template Pop<SizeType>(1);
+            }
+        }
+    }
+
+    //! Record a member name, and skip the colon after it
+    bool ScanName(GenericStringStream<Encoding>& is) {
+        if (is.Peek() != '"')
+            return Error(kParseErrorObjectMissName, is.Tell());
+        if (!ScanString(is))
+            return false;
+        SkipSpaces(is);
+        if (is.Take() != ':')
+            return Error(kParseErrorObjectMissColon, is.Tell());
+        SkipSpaces(is);
+        return true;
+    }
+
+    bool ScanScalar(GenericStringStream<Encoding>& is) {
+        switch (is.Peek()) {
+        case '"':
+            return ScanString(is);
+        case 'n':
+            return ScanLiteral(is, "null", kNullType);
+        case 't':
+            return ScanLiteral(is, "true", kTrueType);
+        case 'f':
+            return ScanLiteral(is, "false", kFalseType);
+        default:
+            return ScanNumber(is);
+        }
+    }
+
+    bool ScanLiteral(GenericStringStream<Encoding>& is, const char* literal, Type type) {
+        const SizeType offset = static_cast<SizeType>(is.Tell());
+        const Ch* p = is.src_;
+        for (; *literal; ++literal, ++p)
+            if (*p != static_cast<Ch>(*literal))
+                return Error(kParseErrorValueInvalid, offset);
+        PushNode(offset, type)->length = static_cast<SizeType>(p - is.src_);
+        is.src_ = p;
+        return true;
+    }
+
+    static bool IsDigit(Ch c) {
+        return c >= '0' && c <= '9';
+    }
+
+    // Checks the grammar of the number, which is converted on access
+    bool ScanNumber(GenericStringStream<Encoding>& is) {
+        const Ch* p = is.src_;
+        if (*p == '-')
+            ++p;
+        if (*p == '0')
+            ++p;
+        else if (*p >= '1' && *p <= '9')
+            while (IsDigit(*++p))
+                ;
+        else
+            return Error(kParseErrorValueInvalid, is.Tell());
+        if (*p == '.') {
+            if (!IsDigit(*++p))
+                return Error(kParseErrorNumberMissFraction, static_cast<size_t>(p - is.head_));
+            while (IsDigit(*++p))
+                ;
+        }
+        if (*p == 'e' || *p == 'E') {
+            if (*++p == '+' || *p == '-')
+                ++p;
+            if (!IsDigit(*p))
+                return Error(kParseErrorNumberMissExponent, static_cast<size_t>(p - is.head_));
+            while (IsDigit(*++p))
+                ;
+        }
+        PushNode(static_cast<SizeType>(is.Tell()), kNumberType)->length = static_cast<SizeType>(p - is.src_);
+        is.src_ = p;
+        return true;
+    }
+
+    // End of the characters up to the next '"', '\\' or control character
+    template<typename CharType>
+    static const CharType* ScanUnescaped(const CharType* p) {
+        while (*p != '"' && *p != '\\' && static_cast<unsigned>(*p) >= 0x20)
+            ++p;
+        return p;
+    }
+
+#ifdef RAPIDJSONXML_SIMD
+    static const char* ScanUnescaped(const char* p) {
+        // Short strings end before the SIMD instructions pay off
+        for (const char* end = p + 8; p != end; ++p)
+            if (*p == '"' || *p == '\\' || static_cast<unsigned char>(*p) < 0x20)
+                return p;
+        return p + ScanUnescapedString_SIMD(p);
+    }
+#endif
+
+    //! Value of four hexadecimal digits, or -1
+    static int Hex4(const Ch* p) {
+        int codepoint = 0;
+        for (int i = 0; i < 4; i++) {
+            const Ch c = p[i];
+            codepoint <<= 4;
+            if (c >= '0' && c <= '9')
+                codepoint += c - '0';
+            else if (c >= 'A' && c <= 'F')
+                codepoint += c - 'A' + 10;
+            else if (c >= 'a' && c <= 'f')
+                codepoint += c - 'a' + 10;
+            else
+                return -1;
+        }
+        return codepoint;
+    }
+
+    // Checks the escapes, as the decoding on access must not fail
+    bool ScanString(GenericStringStream<Encoding>& is) {
+        RAPIDJSONXML_ASSERT(is.Peek() == '"');
+        Node* node = PushNode(static_cast<SizeType>(is.Tell()), kStringType);
+        const Ch* head = is.src_ + 1;
+        const Ch* p = head;
+        for (;;) {
+            p = ScanUnescaped(p);
+            if (*p == '"')
+                break;
+            if (*p != '\\')
+                return Error(*p == '\0' ? kParseErrorStringMissQuotationMark : kParseErrorStringEscapeInvalid, static_cast<size_t>(p - is.head_));
+            node->flags |= kEscapedFlag;
+            const Ch e = *++p;
+            if (e == 'u') {
+                const int codepoint = Hex4(p + 1);
+                if (codepoint < 0)
+                    return Error(kParseErrorStringUnicodeEscapeInvalidHex, static_cast<size_t>(p - is.head_));
+                p += 5;
+                if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+                    // UTF-16 surrogate pair
+                    const int codepoint2 = p[0] == '\\' && p[1] == 'u' ? Hex4(p + 2) : -1;
+                    if (codepoint2 < 0xDC00 || codepoint2 > 0xDFFF)
+                        return Error(kParseErrorStringUnicodeSurrogateInvalid, static_cast<size_t>(p - is.head_));
+                    p += 6;
+                }
+            }
+            else if (e == '"' || e == '\\' || e == '/' || e == 'b' || e == 'f' || e == 'n' || e == 'r' || e == 't')
+                ++p;
+            else
+                return Error(kParseErrorStringEscapeInvalid, static_cast<size_t>(p - is.head_));
+        }
+        node->length = static_cast<SizeType>(p - head);
+        is.src_ = p + 1;
+        return true;
+    }
+
+    static const size_t kDefaultStackCapacity = 1024;
+    static const size_t kDefaultContainerCapacity = 256;
+    Allocator* allocator_;                                  //!< Allocator of the decoded values
+    Allocator* ownAllocator_;
+    CrtAllocator stackAllocator_;                           //!< Allocator of the structure, freed and grown in place unlike a memory pool
+    internal::Stack<CrtAllocator> nodes_;                   //!< Structure of the text, a Node per value
+    internal::Stack<CrtAllocator> containers_;              //!< Positions of the objects and arrays being recorded
+    internal::Stack<CrtAllocator> decoded_;                 //!< Decoded scalars, allocated once each
+    GenericReader<Encoding, Encoding, CrtAllocator> reader_; //!< Reader of the values decoded on access
+    const Ch* json_;                                        //!< Text of the last parsing
+    ParseResult parseResult_;
+    bool fullPrecision_;                                    //!< Whether the numbers are decoded with kParseFullPrecisionFlag
+};
+
+//! GenericLazyDocument with UTF8 encoding
+typedef GenericLazyDocument<UTF8<> > LazyDocument;
+
+//! GenericLazyValue with UTF8 encoding
+typedef GenericLazyValue<UTF8<> > LazyValue;
+
+} // namespace rapidjsonxml
+
+#endif // RAPIDJSONXML_LAZYDOCUMENT_H_
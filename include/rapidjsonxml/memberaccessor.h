@@ -0,0 +1,117 @@
+#ifndef RAPIDJSONXML_MEMBERACCESSOR_H_
+#define RAPIDJSONXML_MEMBERACCESSOR_H_
+
+#include "document.h"
+
+namespace rapidjsonxml {
+
+//! Reusable accessor of an object member, remembering where the member was found.
+/*!
+    Documents of the same shape have their members at the same positions.
+    The accessor keeps the position of the member in the last object, and
+    checks this member first in the next one, before falling back to
+    GenericValue::FindMember() when the name is not there:
+    \code
+    static const MemberAccessor id("id"), name("name");
+    for (Value::ConstValueIterator r = records.Begin(); r != records.End(); ++r) {
+        const Value* v = id.Get(*r);
+        if (v)
+            Use(v->GetInt(), name.Get(*r));
+    }
+    \endcode
+    As FindMember(), the accessor returns the first member of the name: a
+    member at the remembered position is only taken when none of the members
+    before it has the same name, as with the repeated elements of
+    GenericXmlReader. The objects of a parsing, and the indexed ones built by
+    AddMember(), know whether their names are all different: a hit then costs
+    one name comparison. For the other objects, the members before the
+    position are rejected by their lengths and hashes before comparing names.
+
+    \tparam ValueType Type of GenericValue.
+    \note The name is referenced, as by GenericStringRef: it must live as long as the accessor.
+    \note An accessor must not be used by several threads at the same time, as it updates the position.
+*/
+template <typename ValueType>
+class GenericMemberAccessor {
+public:
+    typedef typename ValueType::Ch Ch;                                          //!< Character type derived from the value.
+    typedef typename ValueType::StringRefType StringRefType;                    //!< Reference to a constant string
+    typedef typename ValueType::MemberIterator MemberIterator;                  //!< Member iterator for iterating in object.
+    typedef typename ValueType::ConstMemberIterator ConstMemberIterator;        //!< Constant member iterator for iterating in object.
+
+    //! Constructor with the name of the member.
+    explicit GenericMemberAccessor(StringRefType name) : name_(name), hash_(name_.GetStringHash()), position_(0) {}
+
+    //! Name of the member.
+    const ValueType& GetName() const { return name_; }
+
+    //! Find the member in an object.
+    /*! \pre object.IsObject() == true
+        \return Iterator to the member, if it exists. Otherwise object.MemberEnd().
+    */
+    MemberIterator Find(ValueType& object) const {
+        RAPIDJSONXML_ASSERT(object.IsObject());
+        MemberIterator begin = object.MemberBegin();
+        if (position_ < static_cast<SizeType>(object.MemberEnd() - begin) && IsName(begin[position_].name) &&
+            (object.HasUniqueNames() || IsFirst(begin)))
+            return begin + position_;
+        MemberIterator member = object.FindMember(name_);
+        if (member != object.MemberEnd())
+            position_ = static_cast<SizeType>(member - begin);
+        return member;
+    }
+    ConstMemberIterator Find(const ValueType& object) const {
+        return Find(const_cast<ValueType&>(object));
+    }
+
+    //! Get the value of the member in an object.
+    /*! \pre object.IsObject() == true
+        \return The value of the member, or null if the object has no such member.
+    */
+    ValueType* Get(ValueType& object) const {
+        MemberIterator member = Find(object);
+        return member != object.MemberEnd() ? &member->value : 0;
+    }
+    const ValueType* Get(const ValueType& object) const {
+        return Get(const_cast<ValueType&>(object));
+    }
+
+    //! Check whether an object has the member.
+    bool Has(const ValueType& object) const {
+        return Find(object) != object.MemberEnd();
+    }
+
+private:
+    GenericMemberAccessor(const GenericMemberAccessor&);
+    GenericMemberAccessor& operator=(const GenericMemberAccessor&);
+
+    bool IsName(const ValueType& name) const {
+        const SizeType length = name_.GetStringLength();
+        return name.GetStringLength() == length && memcmp(name.GetString(), name_.GetString(), length * sizeof(Ch)) == 0;
+    }
+
+    //! Check that no member before the position has the name.
+    bool IsFirst(ConstMemberIterator begin) const {
+        const SizeType length = name_.GetStringLength();
+        for (SizeType i = 0; i < position_; i++) {
+            const ValueType& name = begin[i].name;
+            if (name.GetStringLength() != length)
+                continue;
+            const SizeType hash = name.GetCachedStringHash();
+            if ((hash == 0 || hash == hash_) && memcmp(name.GetString(), name_.GetString(), length * sizeof(Ch)) == 0)
+                return false;
+        }
+        return true;
+    }
+
+    ValueType name_;            //!< Constant string of the name
+    SizeType hash_;             //!< Hash of the name, compared with the ones cached by the member names
+    mutable SizeType position_; //!< Position of the member in the last object
+};
+
+//! GenericMemberAccessor for Value.
+typedef GenericMemberAccessor<Value> MemberAccessor;
+
+} // namespace rapidjsonxml
+
+#endif // RAPIDJSONXML_MEMBERACCESSOR_H_
@@ -23,7 +23,7 @@ struct MemoryStream {
     MemoryStream(const Ch *src, size_t size) : src_(src), begin_(src), end_(src + size), size_(size) {}
 
     Ch Peek() const {
-        return *src_;
+        return (src_ == end_) ? '\0' : *src_;
     }
     Ch Take() {
         return (src_ == end_) ? '\0' : *src_++;
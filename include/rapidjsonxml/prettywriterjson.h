@@ -39,6 +39,12 @@ public:
         return *this;
     }
 
+    //! Overridden for fluent API, see \ref WriterJson::SetFixedDecimals()
+    PrettyWriterJson& SetFixedDecimals(int n) {
+        Base::SetFixedDecimals(n);
+        return *this;
+    }
+
     //! Set custom indentation.
     /*! \param indentChar       Character for indentation. Must be whitespace character (' ', '\\t', '\\n', '\\r').
         \param indentCharCount  Number of indent characters for each indentation level.
@@ -166,6 +172,15 @@ public:
         return ret;
     }
 
+    //! Overridden for fluent API, see \ref WriterJson::FixedDouble()
+    bool FixedDouble(double d, int decimals) {
+        int oldDecimals = Base::GetFixedDecimals();
+        SetFixedDecimals(decimals);
+        bool ret = Double(d);
+        SetFixedDecimals(oldDecimals);
+        return ret;
+    }
+
     //@}
 protected:
     void PrettyPrefix(Type type) {
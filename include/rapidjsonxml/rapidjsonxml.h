@@ -109,6 +109,61 @@
 #define RAPIDJSONXML_ALIGN(x) ((x + 3u) & ~3u)
 #endif
 
+///////////////////////////////////////////////////////////////////////////////
+// RAPIDJSONXML_64BIT
+
+//! Whether using 64-bit architecture
+#ifndef RAPIDJSONXML_64BIT
+#if defined(__LP64__) || defined(_WIN64)
+#define RAPIDJSONXML_64BIT 1
+#else
+#define RAPIDJSONXML_64BIT 0
+#endif
+#endif // RAPIDJSONXML_64BIT
+
+///////////////////////////////////////////////////////////////////////////////
+// RAPIDJSONXML_48BITPOINTER_OPTIMIZATION
+
+//! Use only lower 48-bit address for some pointers.
+/*!
+    This optimization uses the fact that current x86-64 and AArch64 architectures
+    only implement lower 48-bit virtual address. The higher 16 bits of a pointer
+    are then used for the flags of GenericValue, which takes 16 bytes instead of
+    24 bytes. The pointers are read and written with RAPIDJSONXML_GETPOINTER()
+    and RAPIDJSONXML_SETPOINTER(). User can define it to 0 to disable it.
+*/
+#ifndef RAPIDJSONXML_48BITPOINTER_OPTIMIZATION
+#if defined(__amd64__) || defined(__amd64) || defined(__x86_64__) || defined(__x86_64) || defined(_M_X64) || defined(_M_AMD64) || defined(__aarch64__)
+#define RAPIDJSONXML_48BITPOINTER_OPTIMIZATION 1
+#else
+#define RAPIDJSONXML_48BITPOINTER_OPTIMIZATION 0
+#endif
+#endif // RAPIDJSONXML_48BITPOINTER_OPTIMIZATION
+
+#if RAPIDJSONXML_48BITPOINTER_OPTIMIZATION == 1
+#if RAPIDJSONXML_64BIT != 1
+#error RAPIDJSONXML_48BITPOINTER_OPTIMIZATION can only be set to 1 when RAPIDJSONXML_64BIT=1
+#endif
+#define RAPIDJSONXML_SETPOINTER(type, p, x) (p = reinterpret_cast<type *>((reinterpret_cast<uintptr_t>(p) & static_cast<uintptr_t>(UINT64_C(0xFFFF000000000000))) | reinterpret_cast<uintptr_t>(reinterpret_cast<const void*>(x))))
+#define RAPIDJSONXML_GETPOINTER(type, p) (reinterpret_cast<type *>(reinterpret_cast<uintptr_t>(p) & static_cast<uintptr_t>(UINT64_C(0x0000FFFFFFFFFFFF))))
+#else
+#define RAPIDJSONXML_SETPOINTER(type, p, x) (p = (x))
+#define RAPIDJSONXML_GETPOINTER(type, p) (p)
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// RAPIDJSONXML_MEMBER_INDEX_CAPACITY
+
+//! Minimum member capacity of the objects indexed by a hash table.
+/*!
+    Objects with at least this capacity keep an open-addressing hash table of
+    their members after the member array, so GenericValue::FindMember() does
+    not scan all the members. User can define it to 0 to disable the index.
+*/
+#ifndef RAPIDJSONXML_MEMBER_INDEX_CAPACITY
+#define RAPIDJSONXML_MEMBER_INDEX_CAPACITY 32
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 // RAPIDJSONXML_SSE2/RAPIDJSONXML_SSE42/RAPIDJSONXML_SIMD
 
@@ -118,7 +173,14 @@
 // Enable SSE4.2 optimization.
 //#define RAPIDJSONXML_SSE42
 
-#if defined(RAPIDJSONXML_SSE2) || defined(RAPIDJSONXML_SSE42)
+// Enable the scalar, SSE2, SSE4.2 and AVX2 code paths, selected at run time from CPUID (see simd.h).
+//#define RAPIDJSONXML_SIMD_DISPATCH
+
+#if defined(RAPIDJSONXML_SIMD_DISPATCH) && !(defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64))
+#undef RAPIDJSONXML_SIMD_DISPATCH // x86 only
+#endif
+
+#if defined(RAPIDJSONXML_SSE2) || defined(RAPIDJSONXML_SSE42) || defined(RAPIDJSONXML_SIMD_DISPATCH)
 #define RAPIDJSONXML_SIMD
 #endif
 
@@ -313,6 +375,13 @@ inline void PutN(Stream& stream, Ch c, size_t n) {
         stream.Put(c);
 }
 
+//! Put a block of n characters to a stream.
+template<typename Stream, typename Ch>
+inline void PutBlock(Stream& stream, const Ch* str, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        stream.Put(str[i]);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // StringStream
 
@@ -7,17 +7,13 @@
 #include "rapidjsonxml.h"
 #include "encodings.h"
 #include "internal/pow10.h"
+#include "internal/strtod.h"
+#include <cfloat>   // DBL_MAX
 #include "internal/stack.h"
-
-#if defined(RAPIDJSONXML_SIMD) && defined(_MSC_VER)
-#include <intrin.h>
-#pragma intrinsic(_BitScanForward)
-#endif
-#ifdef RAPIDJSONXML_SSE42
-#include <nmmintrin.h>
-#elif defined(RAPIDJSONXML_SSE2)
-#include <emmintrin.h>
-#endif
+#include "internal/meta.h"
+#include "simd.h"
+#include "attribute.h"
+#include "memorystream.h"
 
 #ifdef _MSC_VER
 RAPIDJSONXML_DIAG_PUSH
@@ -66,7 +62,11 @@ enum ParseFlag {
     kParseInsituFlag = 1,           //!< In-situ(destructive) parsing.
     kParseValidateEncodingFlag = 2, //!< Validate encoding of JSON strings.
     kParseIterativeFlag = 4,        //!< Iterative(constant complexity in terms of function call stack size) parsing.
-    kParseStopWhenDoneFlag = 8      //!< After parsing a complete JSON root from stream, stop further processing the rest of stream. When this flag is used, parser will not generate kParseErrorDocumentRootNotSingular error.
+    kParseStopWhenDoneFlag = 8,     //!< After parsing a complete JSON root from stream, stop further processing the rest of stream. When this flag is used, parser will not generate kParseErrorDocumentRootNotSingular error.
+    kParseFullPrecisionFlag = 16,   //!< Parse numbers to the nearest double (correctly rounded) instead of the faster but possibly inexact default.
+    kParseBorrowStringsFlag = 32,   //!< Send the strings without escapes of a StringStream or MemoryStream as pointers into it, which must outlive their use. Not with kParseValidateEncodingFlag.
+    kParseStructuralIndexFlag = 64, //!< Find the tokens of a StringStream, InsituStringStream or MemoryStream 64 characters at a time before parsing them, instead of skipping the whitespace. Not with kParseIterativeFlag. Only pays off on token-dense text, such as pretty-printed arrays of numbers: the index costs a pass over the text and 4 bytes per character, so it is slower on text made mostly of strings.
+    kParseXmlArraysFlag = 128       //!< With GenericXmlReader, send the consecutive sibling elements of the same name as an array, as WriterXml writes arrays. Only for a StringStream, InsituStringStream or MemoryStream, which are scanned ahead.
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -88,14 +88,29 @@ concept Handler {
     bool Uint64(uint64_t i);
     bool Double(double d);
     bool String(const Ch* str, SizeType length, bool copy);
+    bool Key(const Ch* str, SizeType length, bool copy);    // optional
+    bool AllocatedString(Ch* str, SizeType length, bool isKey); // optional, with AllocatorType& GetAllocator()
     bool StartObject(const AttributeIteratorPair attribs);
     bool EndObject(SizeType memberCount);
     bool StartArray();
     bool EndArray(SizeType elementCount);
     bool OpenTag(const Ch* str, SizeType length, const AttributeIteratorPairList attribs_list, bool copy);
     bool CloseTag(const Ch* str, SizeType length, bool copy);
+    bool ElementAttributes(const AttributeIteratorPair attribs); // optional
 };
 \endcode
+    The member names of JSON objects are sent to Key() when the handler class
+    itself declares it, and to String() otherwise, as for older handlers.
+
+    When the handler class declares AllocatedString(), the strings and names
+    not parsed in place and too long for a small buffer of the reader are decoded
+    directly into memory of its GetAllocator(), and sent to AllocatedString()
+    instead of String() and Key(). The handler then owns the (length + 1)
+    characters: it keeps them, or gives them back with Realloc() or Free().
+
+    When the handler class declares ElementAttributes(), GenericValue::Accept()
+    sends it before each element of an array with the attributes of the element,
+    which OpenTag() only gives for the first one.
 */
 ///////////////////////////////////////////////////////////////////////////////
 // BaseReaderHandler
@@ -158,6 +173,77 @@ struct BaseReaderHandler {
     }
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// KeyEvent
+
+namespace internal {
+
+//! Whether the class Handler declares bool Key(const Ch*, SizeType, bool).
+/*! A Key() inherited from a base class is not detected, so the handlers
+    deriving from BaseReaderHandler and overriding String() still receive the names.
+*/
+template <typename Handler>
+class HasKeyEvent {
+    template <typename T, bool (T::*)(const typename T::Ch*, SizeType, bool)> struct Check;
+    template <typename T> static char Test(Check<T, &T::Key>*);
+    template <typename T> static char (&Test(...))[2];
+public:
+    enum { Value = sizeof(Test<Handler>(0)) == 1 };
+};
+
+//! Send a member name to Key(), or to String() for the handlers without Key().
+template <typename Handler, bool = HasKeyEvent<Handler>::Value>
+struct KeyEvent {
+    static bool Send(Handler& handler, const typename Handler::Ch* str, SizeType length, bool copy) {
+        return handler.String(str, length, copy);
+    }
+};
+
+template <typename Handler>
+struct KeyEvent<Handler, true> {
+    static bool Send(Handler& handler, const typename Handler::Ch* str, SizeType length, bool copy) {
+        return handler.Key(str, length, copy);
+    }
+};
+
+//! Whether the class Handler declares bool AllocatedString(Ch*, SizeType, bool).
+template <typename Handler>
+class HasAllocatedString {
+    template <typename T, bool (T::*)(typename T::Ch*, SizeType, bool)> struct Check;
+    template <typename T> static char Test(Check<T, &T::AllocatedString>*);
+    template <typename T> static char (&Test(...))[2];
+public:
+    enum { Value = sizeof(Test<Handler>(0)) == 1 };
+};
+
+//! Whether the class Handler declares bool ElementAttributes(const AttributeIteratorPair).
+template <typename Handler>
+class HasElementAttributes {
+    template <typename T, bool (T::*)(const typename T::AttributeIteratorPair)> struct Check;
+    template <typename T> static char Test(Check<T, &T::ElementAttributes>*);
+    template <typename T> static char (&Test(...))[2];
+public:
+    enum { Value = sizeof(Test<Handler>(0)) == 1 };
+};
+
+//! Send the attributes of an array element to the handlers declaring ElementAttributes().
+template <typename Handler, bool = HasElementAttributes<Handler>::Value>
+struct ElementAttributesEvent {
+    template <typename AttributeIteratorPair>
+    static bool Send(Handler&, const AttributeIteratorPair) {
+        return true;
+    }
+};
+
+template <typename Handler>
+struct ElementAttributesEvent<Handler, true> {
+    static bool Send(Handler& handler, const typename Handler::AttributeIteratorPair attribs) {
+        return handler.ElementAttributes(attribs);
+    }
+};
+
+} // namespace internal
+
 ///////////////////////////////////////////////////////////////////////////////
 // StreamLocalCopy
 
@@ -202,7 +288,7 @@ private:
 
 //! Skip the JSON white spaces in a stream.
 /*! \param is A input stream for skipping white spaces.
-    \note This function has SSE2/SSE4.2 specialization.
+    \note This function has SSE2/SSE4.2/AVX2 specialization.
 */
 template<typename InputStream>
 void SkipWhitespace(InputStream& is) {
@@ -213,9 +299,9 @@ void SkipWhitespace(InputStream& is) {
         s.Take();
 }
 
-#ifdef RAPIDJSONXML_SSE42
+#if defined(RAPIDJSONXML_SSE42) || defined(RAPIDJSONXML_SIMD_DISPATCH)
 //! Skip whitespace with SSE 4.2 pcmpistrm instruction, testing 16 8-byte characters at once.
-inline const char *SkipWhitespace_SIMD(const char* p) {
+RAPIDJSONXML_TARGET_SSE42 inline const char *SkipWhitespace_SSE42(const char* p) {
     static const char whitespace[16] = " \n\r\t";
     static const char whitespaces[4][17] = {
         "                ",
@@ -273,10 +359,11 @@ inline const char *SkipWhitespace_SIMD(const char* p) {
     }
 }
 
-#elif defined(RAPIDJSONXML_SSE2)
+#endif // RAPIDJSONXML_SSE42
 
+#if (defined(RAPIDJSONXML_SSE2) && !defined(RAPIDJSONXML_SSE42)) || defined(RAPIDJSONXML_SIMD_DISPATCH)
 //! Skip whitespace with SSE2 instructions, testing 16 8-byte characters at once.
-inline const char *SkipWhitespace_SIMD(const char* p) {
+RAPIDJSONXML_TARGET_SSE2 inline const char *SkipWhitespace_SSE2(const char* p) {
     static const char whitespaces[4][17] = {
         "                ",
         "\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n",
@@ -336,580 +423,2052 @@ inline const char *SkipWhitespace_SIMD(const char* p) {
 
 #endif // RAPIDJSONXML_SSE2
 
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+//! Skip whitespace with AVX2 instructions, testing 32 8-byte characters at once.
+RAPIDJSONXML_TARGET_AVX2 inline const char* SkipWhitespace_AVX2(const char* p) {
+    // Indexed by the low nibble, the whitespace characters are the only ones equal to their entry.
+    // Characters with the high bit set are shuffled to 0.
+    const __m256i table = _mm256_setr_epi8(
+        ' ', -1, -1, -1, -1, -1, -1, -1, -1, '\t', '\n', -1, -1, '\r', -1, -1,
+        ' ', -1, -1, -1, -1, -1, -1, -1, -1, '\t', '\n', -1, -1, '\r', -1, -1);
+
+    // 32-byte align to the lower boundary
+    const char* ap = reinterpret_cast<const char*>(reinterpret_cast<size_t>(p) & ~static_cast<size_t>(31));
+    unsigned shift = static_cast<unsigned>(p - ap);
+
+    for (;; ap += 32, shift = 0) {
+        const __m256i s = _mm256_load_si256(reinterpret_cast<const __m256i*>(ap));
+        const __m256i x = _mm256_cmpeq_epi8(_mm256_shuffle_epi8(table, s), s);
+        unsigned r = ~static_cast<unsigned>(_mm256_movemask_epi8(x));
+        r = r >> shift << shift; // Clear results before p
+        if (r != 0) {
+#ifdef _MSC_VER // Find the index of first non-whitespace
+            unsigned long offset;
+            _BitScanForward(&offset, r);
+            return ap + offset;
+#else
+            return ap + __builtin_ffs(static_cast<int>(r)) - 1;
+#endif
+        }
+    }
+}
+
+//! Skip whitespace one character at a time, for CPUs without SSE2.
+inline const char* SkipWhitespace_Scalar(const char* p) {
+    while (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')
+        ++p;
+    return p;
+}
+#endif // RAPIDJSONXML_SIMD_DISPATCH
+
 #ifdef RAPIDJSONXML_SIMD
+//! Skip whitespace with the SIMD instructions selected at compile time, or at run time with RAPIDJSONXML_SIMD_DISPATCH.
+inline const char* SkipWhitespace_SIMD(const char* p) {
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+    typedef const char* (*Kernel)(const char*);
+    static const Kernel kKernels[kSimdLevelCount] = { SkipWhitespace_Scalar, SkipWhitespace_SSE2, SkipWhitespace_SSE42, SkipWhitespace_AVX2 };
+    return kKernels[GetSimdLevel()](p);
+#elif defined(RAPIDJSONXML_SSE42)
+    return SkipWhitespace_SSE42(p);
+#else
+    return SkipWhitespace_SSE2(p);
+#endif
+}
+
 //! Template function specialization for InsituStringStream
+/*! Compact texts have few spaces: the first character is tested before the SIMD instructions.
+*/
 template<> inline void SkipWhitespace(InsituStringStream& is) {
-    is.src_ = const_cast<char*>(SkipWhitespace_SIMD(is.src_));
+    if (static_cast<unsigned char>(*is.src_) <= ' ')
+        is.src_ = const_cast<char*>(SkipWhitespace_SIMD(is.src_));
 }
 
 //! Template function specialization for StringStream
 template<> inline void SkipWhitespace(StringStream& is) {
-    is.src_ = SkipWhitespace_SIMD(is.src_);
+    if (static_cast<unsigned char>(*is.src_) <= ' ')
+        is.src_ = SkipWhitespace_SIMD(is.src_);
 }
 #endif // RAPIDJSONXML_SIMD
 
 ///////////////////////////////////////////////////////////////////////////////
-// GenericReader
+// ScanUnescapedString
 
-//! SAX-style JSON parser. Use \ref Reader for UTF8 encoding and default allocator.
-/*! GenericReader parses JSON text from a stream, and send events synchronously to an
-    object implementing Handler concept.
+#ifdef RAPIDJSONXML_SIMD
+//! Count the characters before the first '"', '\\' or control character with SSE2 instructions, testing 16 8-byte characters at once.
+/*! The terminating '\0' of the string is a control character, and aligned loads never cross a memory page.
+    \note RAPIDJSONXML_SSE42 uses the same SSE2 instructions.
+*/
+RAPIDJSONXML_TARGET_SSE2 inline size_t ScanUnescapedString_SSE2(const char* p) {
+    const __m128i dq = _mm_set1_epi8('"');
+    const __m128i bs = _mm_set1_epi8('\\');
+    const __m128i sp = _mm_set1_epi8(0x1F);
 
-    It needs to allocate a stack for storing a single decoded string during
-    non-destructive parsing.
+    // 16-byte align to the lower boundary
+    const char* ap = reinterpret_cast<const char*>(reinterpret_cast<size_t>(p) & ~15);
+    unsigned char shift = reinterpret_cast<size_t>(p) & 15;
 
-    For in-situ parsing, the decoded string is directly written to the source
-    text string, no temporary buffer is required.
+    for (;; ap += 16, shift = 0) {
+        const __m128i s = _mm_load_si128(reinterpret_cast<const __m128i*>(ap));
+        __m128i x = _mm_cmpeq_epi8(s, dq);
+        x = _mm_or_si128(x, _mm_cmpeq_epi8(s, bs));
+        x = _mm_or_si128(x, _mm_cmpeq_epi8(_mm_max_epu8(s, sp), sp)); // unsigned <= 0x1F
+        unsigned short r = static_cast<unsigned short>(_mm_movemask_epi8(x));
+        r = static_cast<unsigned short>(r >> shift << shift); // Clear results before p
+        if (r != 0) {
+#ifdef _MSC_VER // Find the index of first special character
+            unsigned long offset;
+            _BitScanForward(&offset, r);
+            return static_cast<size_t>(ap + offset - p);
+#else
+            return static_cast<size_t>(ap + __builtin_ffs(r) - 1 - p);
+#endif
+        }
+    }
+}
 
-    A GenericReader object can be reused for parsing multiple JSON text.
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+//! Count the characters before the first '"', '\\' or control character with AVX2 instructions, testing 32 8-byte characters at once.
+RAPIDJSONXML_TARGET_AVX2 inline size_t ScanUnescapedString_AVX2(const char* p) {
+    const __m256i dq = _mm256_set1_epi8('"');
+    const __m256i bs = _mm256_set1_epi8('\\');
+    const __m256i sp = _mm256_set1_epi8(0x1F);
+
+    // 32-byte align to the lower boundary
+    const char* ap = reinterpret_cast<const char*>(reinterpret_cast<size_t>(p) & ~static_cast<size_t>(31));
+    unsigned shift = static_cast<unsigned>(p - ap);
+
+    for (;; ap += 32, shift = 0) {
+        const __m256i s = _mm256_load_si256(reinterpret_cast<const __m256i*>(ap));
+        __m256i x = _mm256_cmpeq_epi8(s, dq);
+        x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, bs));
+        x = _mm256_or_si256(x, _mm256_cmpeq_epi8(_mm256_max_epu8(s, sp), sp)); // unsigned <= 0x1F
+        unsigned r = static_cast<unsigned>(_mm256_movemask_epi8(x));
+        r = r >> shift << shift; // Clear results before p
+        if (r != 0) {
+#ifdef _MSC_VER // Find the index of first special character
+            unsigned long offset;
+            _BitScanForward(&offset, r);
+            return static_cast<size_t>(ap + offset - p);
+#else
+            return static_cast<size_t>(ap + __builtin_ffs(static_cast<int>(r)) - 1 - p);
+#endif
+        }
+    }
+}
 
-    \tparam SourceEncoding Encoding of the input stream.
-    \tparam TargetEncoding Encoding of the parse output.
-    \tparam Allocator Allocator type for stack.
+//! Count the characters before the first '"', '\\' or control character one at a time, for CPUs without SSE2.
+inline size_t ScanUnescapedString_Scalar(const char* p) {
+    const char* q = p;
+    while (*q != '"' && *q != '\\' && static_cast<unsigned char>(*q) >= 0x20)
+        ++q;
+    return static_cast<size_t>(q - p);
+}
+#endif // RAPIDJSONXML_SIMD_DISPATCH
+
+//! Count the characters before the first '"', '\\' or control character with the selected SIMD instructions.
+inline size_t ScanUnescapedString_SIMD(const char* p) {
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+    typedef size_t (*Kernel)(const char*);
+    static const Kernel kKernels[kSimdLevelCount] = { ScanUnescapedString_Scalar, ScanUnescapedString_SSE2, ScanUnescapedString_SSE2, ScanUnescapedString_AVX2 };
+    return kKernels[GetSimdLevel()](p);
+#else
+    return ScanUnescapedString_SSE2(p);
+#endif
+}
+#endif // RAPIDJSONXML_SIMD
+
+///////////////////////////////////////////////////////////////////////////////
+// ScanUnescapedUtf8String
+
+#ifdef RAPIDJSONXML_SIMD
+namespace internal {
+
+//! Length of the valid UTF-8 sequence of a non-ASCII character, or 0 for an ASCII character or an invalid sequence.
+/*! Accepts the same sequences as UTF8::Validate(): no overlong form, surrogate or code point above U+10FFFF.
+    Stops at the terminating '\0', which is not a continuation byte.
 */
-template <typename SourceEncoding, typename TargetEncoding, typename Allocator = MemoryPoolAllocator<> >
-class GenericReader {
-public:
-    typedef typename SourceEncoding::Ch Ch; //!< SourceEncoding character type
+inline size_t Utf8SequenceLength(const char* p) {
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(p);
+    const unsigned c = s[0];
+    if (c < 0xC2 || c > 0xF4)
+        return 0;
+    if (c < 0xE0)
+        return (s[1] & 0xC0) == 0x80 ? 2 : 0;
+    // Range of the second byte, other bytes are continuations
+    const unsigned low = (c == 0xE0) ? 0xA0 : (c == 0xF0) ? 0x90 : 0x80;
+    const unsigned high = (c == 0xED) ? 0x9F : (c == 0xF4) ? 0x8F : 0xBF;
+    if (s[1] < low || s[1] > high || (s[2] & 0xC0) != 0x80)
+        return 0;
+    if (c < 0xF0)
+        return 3;
+    return (s[3] & 0xC0) == 0x80 ? 4 : 0;
+}
 
-    //! Constructor.
-    /*! \param allocator Optional allocator for allocating stack memory. (Only use for non-destructive parsing)
-        \param stackCapacity stack capacity in bytes for storing a single decoded string.  (Only use for non-destructive parsing)
-    */
-    GenericReader(Allocator* allocator = 0, size_t stackCapacity = kDefaultStackCapacity) : stack_(allocator, stackCapacity), parseResult_() {}
+//! Tables of the lookup UTF-8 validation, indexed by the high and low nibbles of the previous byte and the high nibble of the current byte.
+/*! Each bit is an error, reported when the 3 tables have it for a pair of bytes (Keiser and Lemire, "Validating UTF-8 in less than one instruction per byte").
+    A continuation expected after a 3- or 4-byte lead sets kTwoConts, checked against the leads 2 and 3 bytes before.
+*/
+template <typename T = void>
+struct Utf8Lookup {
+    enum {
+        kTooShort = 0x01,       // 11______ 0_______, 11______ 11______
+        kTooLong = 0x02,        // 0_______ 10______
+        kOverlong3 = 0x04,      // 11100000 100_____
+        kTooLarge = 0x08,       // 11110100 1001____, 11110100 101_____, 11110101+
+        kSurrogate = 0x10,      // 11101101 101_____
+        kOverlong2 = 0x20,      // 1100000_ 10______
+        kTooLarge1000 = 0x40,   // 11110101+ 1000____
+        kOverlong4 = 0x40,      // 11110000 1000____
+        kTwoConts = 0x80,       // 10______ 10______
+        kCarry = kTooShort | kTooLong | kTwoConts
+    };
+    static const unsigned char kByte1High[16];
+    static const unsigned char kByte1Low[16];
+    static const unsigned char kByte2High[16];
+};
 
-    //! Parse JSON text.
-    /*! \tparam parseFlags Combination of \ref ParseFlag.
-        \tparam InputStream Type of input stream, implementing Stream concept.
-        \tparam Handler Type of handler, implementing Handler concept.
-        \param is Input stream to be parsed.
-        \param handler The handler to receive events.
-        \return Whether the parsing is successful.
-    */
-    template <unsigned parseFlags, typename InputStream, typename Handler>
-    ParseResult Parse(InputStream& is, Handler& handler) {
-        if (parseFlags & kParseIterativeFlag)
-            return IterativeParse<parseFlags>(is, handler);
+template <typename T> const unsigned char Utf8Lookup<T>::kByte1High[16] = {
+    kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+    kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+    kTooShort | kOverlong2,
+    kTooShort,
+    kTooShort | kOverlong3 | kSurrogate,
+    kTooShort | kTooLarge | kTooLarge1000 | kOverlong4
+};
 
-        parseResult_.Clear();
+template <typename T> const unsigned char Utf8Lookup<T>::kByte1Low[16] = {
+    kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+    kCarry | kOverlong2,
+    kCarry,
+    kCarry,
+    kCarry | kTooLarge,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000
+};
 
-        ClearStackOnExit scope(*this);
+template <typename T> const unsigned char Utf8Lookup<T>::kByte2High[16] = {
+    kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooShort, kTooShort, kTooShort, kTooShort
+};
 
-        SkipWhitespace(is);
+//! Start of the character of the last byte before a block, from p. The sequences before are valid, the last one may be truncated.
+inline const char* Utf8CharacterStart(const char* p, const char* block) {
+    if (block <= p)
+        return p;
+    const char* q = block - 1;
+    while (q != p && (static_cast<unsigned char>(*q) & 0xC0) == 0x80)
+        --q;
+    return q;
+}
 
-        if (is.Peek() == '\0') {
-            RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorDocumentEmpty, is.Tell());
-            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN(parseResult_);
-        }
-        else {
-            switch (is.Peek()) {
-            case '{':
-                ParseObject<parseFlags>(is, handler);
+} // namespace internal
+
+//! Count the characters before the first '"', '\\', control character or invalid UTF-8 sequence, one character at a time.
+/*! Ends at the start of the invalid sequence, for UTF8::Validate() to report the same error.
+*/
+inline size_t ScanUnescapedUtf8String_Scalar(const char* p) {
+    const char* q = p;
+    for (;;) {
+        const unsigned char c = static_cast<unsigned char>(*q);
+        if (c >= 0x80) {
+            const size_t length = internal::Utf8SequenceLength(q);
+            if (length == 0)
                 break;
-            case '[':
-                ParseArray<parseFlags>(is, handler);
+            q += length;
+        }
+        else if (c != '"' && c != '\\' && c >= 0x20)
+            ++q;
+        else
+            break;
+    }
+    return static_cast<size_t>(q - p);
+}
+
+//! Count the characters before the first '"', '\\', control character or invalid UTF-8 sequence with SSE2 instructions.
+/*! ASCII characters are tested 16 at once, other characters one at a time.
+    \note Without RAPIDJSONXML_SIMD_DISPATCH, RAPIDJSONXML_SSE2 only.
+*/
+RAPIDJSONXML_TARGET_SSE2 inline size_t ScanUnescapedUtf8String_SSE2(const char* p) {
+    const __m128i dq = _mm_set1_epi8('"');
+    const __m128i bs = _mm_set1_epi8('\\');
+    const __m128i sp = _mm_set1_epi8(0x1F);
+
+    const char* q = p;
+    for (;;) {
+        // 16-byte align to the lower boundary
+        const char* ap = reinterpret_cast<const char*>(reinterpret_cast<size_t>(q) & ~static_cast<size_t>(15));
+        unsigned shift = static_cast<unsigned>(q - ap);
+
+        for (;; ap += 16, shift = 0) {
+            const __m128i s = _mm_load_si128(reinterpret_cast<const __m128i*>(ap));
+            __m128i x = _mm_cmpeq_epi8(s, dq);
+            x = _mm_or_si128(x, _mm_cmpeq_epi8(s, bs));
+            x = _mm_or_si128(x, _mm_cmpeq_epi8(_mm_max_epu8(s, sp), sp)); // unsigned <= 0x1F
+            unsigned r = static_cast<unsigned>(_mm_movemask_epi8(x) | _mm_movemask_epi8(s)); // or non-ASCII
+            r = r >> shift << shift; // Clear results before q
+            if (r != 0) {
+#ifdef _MSC_VER // Find the index of first special or non-ASCII character
+                unsigned long offset;
+                _BitScanForward(&offset, r);
+                q = ap + offset;
+#else
+                q = ap + __builtin_ffs(static_cast<int>(r)) - 1;
+#endif
                 break;
-            default:
-                RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorDocumentRootNotObjectOrArray, is.Tell());
             }
-            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN(parseResult_);
+        }
 
-            if (!(parseFlags & kParseStopWhenDoneFlag)) {
-                SkipWhitespace(is);
+        const size_t length = internal::Utf8SequenceLength(q);
+        if (length == 0)
+            return static_cast<size_t>(q - p);
+        q += length;
+    }
+}
 
-                if (is.Peek() != '\0') {
-                    RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorDocumentRootNotSingular, is.Tell());
-                    RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN(parseResult_);
-                }
+#if defined(RAPIDJSONXML_SSE42) || defined(RAPIDJSONXML_SIMD_DISPATCH)
+//! Non-zero bytes at the end of the invalid UTF-8 sequences of a block, from its bytes and the ones of the previous block.
+RAPIDJSONXML_TARGET_SSE42 inline __m128i Utf8Errors_SSE42(const __m128i s, const __m128i previous) {
+    typedef internal::Utf8Lookup<> L;
+    const __m128i low = _mm_set1_epi8(0x0F);
+    const __m128i prev1 = _mm_alignr_epi8(s, previous, 15);
+    __m128i e = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(L::kByte1High)), _mm_and_si128(_mm_srli_epi16(prev1, 4), low));
+    e = _mm_and_si128(e, _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(L::kByte1Low)), _mm_and_si128(prev1, low)));
+    e = _mm_and_si128(e, _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(L::kByte2High)), _mm_and_si128(_mm_srli_epi16(s, 4), low)));
+
+    // Third and fourth bytes, high bit set after a 3- or 4-byte lead
+    const __m128i prev2 = _mm_alignr_epi8(s, previous, 14);
+    const __m128i prev3 = _mm_alignr_epi8(s, previous, 13);
+    const __m128i must23 = _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xE0 - 0x80))), _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xF0 - 0x80))));
+    return _mm_xor_si128(e, _mm_and_si128(must23, _mm_set1_epi8(static_cast<char>(0x80))));
+}
+
+//! Count the characters before the first '"', '\\', control character or invalid UTF-8 sequence with SSE4.2 instructions, validating 16 bytes at once.
+/*! Blocks of ASCII characters are only scanned. Otherwise, the SSSE3 byte shuffles look up the errors of each pair of bytes.
+    Falls back to the scalar kernel in a block with an invalid sequence, for the exact end.
+*/
+RAPIDJSONXML_TARGET_SSE42 inline size_t ScanUnescapedUtf8String_SSE42(const char* p) {
+    const __m128i dq = _mm_set1_epi8('"');
+    const __m128i bs = _mm_set1_epi8('\\');
+    const __m128i sp = _mm_set1_epi8(0x1F);
+    const __m128i zero = _mm_setzero_si128();
+
+    // 16-byte align to the lower boundary, the bytes before p become '\0'
+    const char* ap = reinterpret_cast<const char*>(reinterpret_cast<size_t>(p) & ~static_cast<size_t>(15));
+    unsigned shift = static_cast<unsigned>(p - ap);
+    __m128i s = _mm_load_si128(reinterpret_cast<const __m128i*>(ap));
+    s = _mm_andnot_si128(_mm_cmplt_epi8(_mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm_set1_epi8(static_cast<char>(shift))), s);
+
+    __m128i previous = zero;
+    unsigned previousHigh = 0;
+    for (;;) {
+        __m128i x = _mm_cmpeq_epi8(s, dq);
+        x = _mm_or_si128(x, _mm_cmpeq_epi8(s, bs));
+        x = _mm_or_si128(x, _mm_cmpeq_epi8(_mm_max_epu8(s, sp), sp)); // unsigned <= 0x1F
+        unsigned r = static_cast<unsigned>(_mm_movemask_epi8(x));
+        r = r >> shift << shift; // Clear results before p
+        const unsigned high = static_cast<unsigned>(_mm_movemask_epi8(s));
+
+        // Errors up to the first special character, which ends a truncated sequence
+        if ((high | previousHigh) != 0) {
+            const unsigned errors = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(Utf8Errors_SSE42(s, previous), zero))) & 0xFFFF;
+            if ((errors & (r ^ (r - 1))) != 0) {
+                const char* q = internal::Utf8CharacterStart(p, ap);
+                return static_cast<size_t>(q - p) + ScanUnescapedUtf8String_Scalar(q);
             }
         }
+        if (r != 0) {
+#ifdef _MSC_VER // Find the index of first special character
+            unsigned long offset;
+            _BitScanForward(&offset, r);
+            return static_cast<size_t>(ap + offset - p);
+#else
+            return static_cast<size_t>(ap + __builtin_ffs(static_cast<int>(r)) - 1 - p);
+#endif
+        }
 
-        return parseResult_;
+        previous = s;
+        previousHigh = high & 0xE000; // Leads of sequences continued in the next block
+        ap += 16;
+        shift = 0;
+        s = _mm_load_si128(reinterpret_cast<const __m128i*>(ap));
     }
+}
+#endif // RAPIDJSONXML_SSE42
+
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+//! Non-zero bytes at the end of the invalid UTF-8 sequences of a block, from its bytes and the ones of the previous block.
+RAPIDJSONXML_TARGET_AVX2 inline __m256i Utf8Errors_AVX2(const __m256i s, const __m256i previous) {
+    typedef internal::Utf8Lookup<> L;
+    const __m256i low = _mm256_set1_epi8(0x0F);
+    const __m256i shifted = _mm256_permute2x128_si256(previous, s, 0x21); // high half of previous, low half of s
+    const __m256i prev1 = _mm256_alignr_epi8(s, shifted, 15);
+    __m256i e = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(L::kByte1High))), _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low));
+    e = _mm256_and_si256(e, _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(L::kByte1Low))), _mm256_and_si256(prev1, low)));
+    e = _mm256_and_si256(e, _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(L::kByte2High))), _mm256_and_si256(_mm256_srli_epi16(s, 4), low)));
+
+    // Third and fourth bytes, high bit set after a 3- or 4-byte lead
+    const __m256i prev2 = _mm256_alignr_epi8(s, shifted, 14);
+    const __m256i prev3 = _mm256_alignr_epi8(s, shifted, 13);
+    const __m256i must23 = _mm256_or_si256(_mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80))), _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80))));
+    return _mm256_xor_si256(e, _mm256_and_si256(must23, _mm256_set1_epi8(static_cast<char>(0x80))));
+}
 
-    //! Parse JSON text (with \ref kParseDefaultFlags)
-    /*! \tparam InputStream Type of input stream, implementing Stream concept
-        \tparam Handler Type of handler, implementing Handler concept.
-        \param is Input stream to be parsed.
-        \param handler The handler to receive events.
-        \return Whether the parsing is successful.
-    */
-    template <typename InputStream, typename Handler>
-    ParseResult Parse(InputStream& is, Handler& handler) {
-        return Parse<kParseDefaultFlags>(is, handler);
-    }
+//! Count the characters before the first '"', '\\', control character or invalid UTF-8 sequence with AVX2 instructions, validating 32 bytes at once.
+RAPIDJSONXML_TARGET_AVX2 inline size_t ScanUnescapedUtf8String_AVX2(const char* p) {
+    const __m256i dq = _mm256_set1_epi8('"');
+    const __m256i bs = _mm256_set1_epi8('\\');
+    const __m256i sp = _mm256_set1_epi8(0x1F);
+    const __m256i zero = _mm256_setzero_si256();
+
+    // 32-byte align to the lower boundary, the bytes before p become '\0'
+    const char* ap = reinterpret_cast<const char*>(reinterpret_cast<size_t>(p) & ~static_cast<size_t>(31));
+    unsigned shift = static_cast<unsigned>(p - ap);
+    __m256i s = _mm256_load_si256(reinterpret_cast<const __m256i*>(ap));
+    const __m256i index = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);
+    s = _mm256_andnot_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(shift)), index), s);
+
+    __m256i previous = zero;
+    unsigned previousHigh = 0;
+    for (;;) {
+        __m256i x = _mm256_cmpeq_epi8(s, dq);
+        x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, bs));
+        x = _mm256_or_si256(x, _mm256_cmpeq_epi8(_mm256_max_epu8(s, sp), sp)); // unsigned <= 0x1F
+        unsigned r = static_cast<unsigned>(_mm256_movemask_epi8(x));
+        r = r >> shift << shift; // Clear results before p
+        const unsigned high = static_cast<unsigned>(_mm256_movemask_epi8(s));
+
+        // Errors up to the first special character, which ends a truncated sequence
+        if ((high | previousHigh) != 0) {
+            const unsigned errors = ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(Utf8Errors_AVX2(s, previous), zero)));
+            if ((errors & (r ^ (r - 1))) != 0) {
+                const char* q = internal::Utf8CharacterStart(p, ap);
+                return static_cast<size_t>(q - p) + ScanUnescapedUtf8String_Scalar(q);
+            }
+        }
+        if (r != 0) {
+#ifdef _MSC_VER // Find the index of first special character
+            unsigned long offset;
+            _BitScanForward(&offset, r);
+            return static_cast<size_t>(ap + offset - p);
+#else
+            return static_cast<size_t>(ap + __builtin_ffs(static_cast<int>(r)) - 1 - p);
+#endif
+        }
 
-    //! Whether a parse error has occured in the last parsing.
-    bool HasParseError() const {
-        return parseResult_.IsError();
+        previous = s;
+        previousHigh = high & 0xE0000000u; // Leads of sequences continued in the next block
+        ap += 32;
+        shift = 0;
+        s = _mm256_load_si256(reinterpret_cast<const __m256i*>(ap));
     }
+}
+#endif // RAPIDJSONXML_SIMD_DISPATCH
+
+//! Count the characters before the first '"', '\\', control character or invalid UTF-8 sequence with the selected SIMD instructions.
+inline size_t ScanUnescapedUtf8String_SIMD(const char* p) {
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+    typedef size_t (*Kernel)(const char*);
+    static const Kernel kKernels[kSimdLevelCount] = { ScanUnescapedUtf8String_Scalar, ScanUnescapedUtf8String_SSE2, ScanUnescapedUtf8String_SSE42, ScanUnescapedUtf8String_AVX2 };
+    return kKernels[GetSimdLevel()](p);
+#elif defined(RAPIDJSONXML_SSE42)
+    return ScanUnescapedUtf8String_SSE42(p);
+#else
+    return ScanUnescapedUtf8String_SSE2(p);
+#endif
+}
+#endif // RAPIDJSONXML_SIMD
 
-    //! Get the \ref ParseErrorCode of last parsing.
-    ParseErrorCode GetParseErrorCode() const {
-        return parseResult_.Code();
-    }
+///////////////////////////////////////////////////////////////////////////////
+// ScanXmlText
 
-    //! Get the position of last parsing error in input, 0 otherwise.
-    size_t GetErrorOffset() const {
-        return parseResult_.Offset();
-    }
+#ifdef RAPIDJSONXML_SIMD
+//! Count the characters before the first '<', '&' or '\0' with SSE2 instructions, testing 16 8-byte characters at once.
+/*! Aligned loads never cross a memory page.
+    \note RAPIDJSONXML_SSE42 uses the same SSE2 instructions.
+*/
+RAPIDJSONXML_TARGET_SSE2 inline size_t ScanXmlText_SSE2(const char* p) {
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i zero = _mm_setzero_si128();
 
-private:
-    // Prohibit copy constructor & assignment operator.
-    GenericReader(const GenericReader&);
-    GenericReader& operator=(const GenericReader&);
+    // 16-byte align to the lower boundary
+    const char* ap = reinterpret_cast<const char*>(reinterpret_cast<size_t>(p) & ~15);
+    unsigned char shift = reinterpret_cast<size_t>(p) & 15;
 
-    void ClearStack() {
-        stack_.Clear();
+    for (;; ap += 16, shift = 0) {
+        const __m128i s = _mm_load_si128(reinterpret_cast<const __m128i*>(ap));
+        __m128i x = _mm_cmpeq_epi8(s, lt);
+        x = _mm_or_si128(x, _mm_cmpeq_epi8(s, amp));
+        x = _mm_or_si128(x, _mm_cmpeq_epi8(s, zero));
+        unsigned short r = static_cast<unsigned short>(_mm_movemask_epi8(x));
+        r = static_cast<unsigned short>(r >> shift << shift); // Clear results before p
+        if (r != 0) {
+#ifdef _MSC_VER // Find the index of first special character
+            unsigned long offset;
+            _BitScanForward(&offset, r);
+            return static_cast<size_t>(ap + offset - p);
+#else
+            return static_cast<size_t>(ap + __builtin_ffs(r) - 1 - p);
+#endif
+        }
     }
+}
 
-    // clear stack on any exit from ParseStream, e.g. due to exception
-    struct ClearStackOnExit {
-        explicit ClearStackOnExit(GenericReader& r) : r_(r) {}
-        ~ClearStackOnExit() {
-            r_.ClearStack();
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+//! Count the characters before the first '<', '&' or '\0' with AVX2 instructions, testing 32 8-byte characters at once.
+RAPIDJSONXML_TARGET_AVX2 inline size_t ScanXmlText_AVX2(const char* p) {
+    const __m256i lt = _mm256_set1_epi8('<');
+    const __m256i amp = _mm256_set1_epi8('&');
+    const __m256i zero = _mm256_setzero_si256();
+
+    // 32-byte align to the lower boundary
+    const char* ap = reinterpret_cast<const char*>(reinterpret_cast<size_t>(p) & ~static_cast<size_t>(31));
+    unsigned shift = static_cast<unsigned>(p - ap);
+
+    for (;; ap += 32, shift = 0) {
+        const __m256i s = _mm256_load_si256(reinterpret_cast<const __m256i*>(ap));
+        __m256i x = _mm256_cmpeq_epi8(s, lt);
+        x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, amp));
+        x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, zero));
+        unsigned r = static_cast<unsigned>(_mm256_movemask_epi8(x));
+        r = r >> shift << shift; // Clear results before p
+        if (r != 0) {
+#ifdef _MSC_VER // Find the index of first special character
+            unsigned long offset;
+            _BitScanForward(&offset, r);
+            return static_cast<size_t>(ap + offset - p);
+#else
+            return static_cast<size_t>(ap + __builtin_ffs(static_cast<int>(r)) - 1 - p);
+#endif
         }
-    private:
-        GenericReader& r_;
-        ClearStackOnExit(const ClearStackOnExit&);
-        ClearStackOnExit& operator=(const ClearStackOnExit&);
-    };
-
-    // Parse object: { string : value, ... }
-    template<unsigned parseFlags, typename InputStream, typename Handler>
-    void ParseObject(InputStream& is, Handler& handler) {
-        RAPIDJSONXML_ASSERT(is.Peek() == '{');
-        is.Take(); // Skip '{'
-
-        if (!handler.StartObject(GenericAttributeIteratorPair<TargetEncoding>()))
-            RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
+    }
+}
 
-        SkipWhitespace(is);
+//! Count the characters before the first '<', '&' or '\0' one at a time, for CPUs without SSE2.
+inline size_t ScanXmlText_Scalar(const char* p) {
+    const char* q = p;
+    while (*q != '<' && *q != '&' && *q != '\0')
+        ++q;
+    return static_cast<size_t>(q - p);
+}
+#endif // RAPIDJSONXML_SIMD_DISPATCH
+
+//! Count the characters before the first '<', '&' or '\0' with the selected SIMD instructions.
+inline size_t ScanXmlText_SIMD(const char* p) {
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+    typedef size_t (*Kernel)(const char*);
+    static const Kernel kKernels[kSimdLevelCount] = { ScanXmlText_Scalar, ScanXmlText_SSE2, ScanXmlText_SSE2, ScanXmlText_AVX2 };
+    return kKernels[GetSimdLevel()](p);
+#else
+    return ScanXmlText_SSE2(p);
+#endif
+}
+#endif // RAPIDJSONXML_SIMD
 
-        if (is.Peek() == '}') {
-            is.Take();
-            if (!handler.EndObject(0)) // empty object
-                RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
-            return;
-        }
+///////////////////////////////////////////////////////////////////////////////
+// ParseIntegerDigits
+
+//! Parse the integer digits of a number at once.
+/*! The generic version does not consume anything, the digits are then parsed one by one.
+    \param is Input stream at the first digit.
+    \param limit Largest accepted value.
+    \param value Value of the digits.
+    \return Whether all the digits were consumed. This requires at most 19 digits with
+        a value not greater than \c limit, otherwise the stream is unchanged.
+    \note This function has SWAR/SSE4.1 specialization.
+*/
+template<typename InputStream>
+inline bool ParseIntegerDigits(InputStream& is, uint64_t limit, uint64_t* value) {
+    (void)is;
+    (void)limit;
+    (void)value;
+    return false;
+}
 
-        for (SizeType memberCount = 0;;) {
-            if (is.Peek() != '"')
-                RAPIDJSONXML_PARSE_ERROR(kParseErrorObjectMissName, is.Tell());
+namespace internal {
 
-            ParseString<parseFlags>(is, handler);
-            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+//! Index of the lowest set bit of a non-zero value.
+inline unsigned CountTrailingZero64(uint64_t x) {
+    RAPIDJSONXML_ASSERT(x != 0);
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long r;
+    _BitScanForward64(&r, x);
+    return static_cast<unsigned>(r);
+#elif defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctzll(x));
+#else
+    unsigned n = 0;
+    for (; !(x & 1); x >>= 1)
+        n++;
+    return n;
+#endif
+}
 
-            SkipWhitespace(is);
+} // namespace internal
 
-            if (is.Take() != ':')
-                RAPIDJSONXML_PARSE_ERROR(kParseErrorObjectMissColon, is.Tell());
+#if RAPIDJSONXML_ENDIAN == RAPIDJSONXML_LITTLEENDIAN
+namespace internal {
 
-            SkipWhitespace(is);
+//! Whether \c n characters can be read from \c p without crossing a memory page boundary.
+/*! Reading beyond the terminating '\0' is then harmless.
+*/
+inline bool IsPageSafe(const char* p, size_t n) {
+    return (reinterpret_cast<size_t>(p) & 4095) <= 4096 - n;
+}
 
-            ParseValue<parseFlags>(is, handler);
-            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+//! Number of leading digits in 8 characters loaded in little endian order.
+inline unsigned CountEightDigits(uint64_t v) {
+    const uint64_t nonDigits = ((v & UINT64_C(0xF0F0F0F0F0F0F0F0)) |
+        (((v + UINT64_C(0x0606060606060606)) & UINT64_C(0xF0F0F0F0F0F0F0F0)) >> 4)) ^ UINT64_C(0x3333333333333333);
+    return nonDigits ? CountTrailingZero64(nonDigits) / 8 : 8;
+}
 
-            SkipWhitespace(is);
+//! Value of 8 digits loaded in little endian order, with '0' subtracted.
+inline uint32_t EightDigitsValue(uint64_t v) {
+    v = v * 10 + (v >> 8); // 2 digits in each 16 bits
+    v = (((v & UINT64_C(0x000000FF000000FF)) * (100 + (UINT64_C(1000000) << 32))) +
+        (((v >> 16) & UINT64_C(0x000000FF000000FF)) * (1 + (UINT64_C(10000) << 32)))) >> 32;
+    return static_cast<uint32_t>(v);
+}
 
-            ++memberCount;
+} // namespace internal
 
-            switch (is.Take()) {
-            case ',':
-                SkipWhitespace(is);
-                break;
-            case '}':
-                if (!handler.EndObject(memberCount))
-                    RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
-                else
-                    return;
-            default:
-                RAPIDJSONXML_PARSE_ERROR(kParseErrorObjectMissCommaOrCurlyBracket, is.Tell());
+//! Parse up to 19 integer digits, 8 characters at once in a 64-bit register.
+/*! \return The end of the digits, or 0 if they are not accepted.
+*/
+inline const char* ParseIntegerDigits_SWAR(const char* p, uint64_t limit, uint64_t* value) {
+    static const uint32_t kPow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+    uint64_t u = 0;
+    unsigned count = 0;
+    for (;;) {
+        if (!internal::IsPageSafe(p, 8)) { // finish one by one
+            for (; *p >= '0' && *p <= '9'; ++p) {
+                if (++count > 19)
+                    return 0;
+                u = u * 10 + static_cast<unsigned>(*p - '0');
             }
+            break;
         }
+
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        const unsigned n = internal::CountEightDigits(v);
+        if (n == 0)
+            break;
+        if ((count += n) > 19)
+            return 0;
+        // Move the n digits to the least significant end, after zeros
+        u = u * kPow10[n] + internal::EightDigitsValue((v - UINT64_C(0x3030303030303030)) << (64 - 8 * n));
+        p += n;
+        if (n < 8)
+            break;
     }
 
-    // Parse array: [ value, ... ]
-    template<unsigned parseFlags, typename InputStream, typename Handler>
-    void ParseArray(InputStream& is, Handler& handler) {
-        RAPIDJSONXML_ASSERT(is.Peek() == '[');
-        is.Take(); // Skip '['
+    if (u > limit)
+        return 0;
+    *value = u;
+    return p;
+}
 
-        if (!handler.StartArray())
-            RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
+#if defined(RAPIDJSONXML_SSE42) || defined(RAPIDJSONXML_SIMD_DISPATCH)
+//! Parse up to 19 integer digits, 16 characters at once with SSE4.1 instructions.
+/*! \return The end of the digits, or 0 if they are not accepted.
+*/
+RAPIDJSONXML_TARGET_SSE42 inline const char* ParseIntegerDigits_SIMD(const char* p, uint64_t limit, uint64_t* value) {
+    static const char kShuffle[32] = {
+        -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128,
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
+    };
+    if (!internal::IsPageSafe(p, 16))
+        return ParseIntegerDigits_SWAR(p, limit, value);
+
+    const __m128i s = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), _mm_set1_epi8('0'));
+    const __m128i digits = _mm_cmpeq_epi8(_mm_min_epu8(s, _mm_set1_epi8(9)), s);
+    const unsigned nonDigits = ~static_cast<unsigned>(_mm_movemask_epi8(digits)) & 0xFFFF;
+    unsigned n = nonDigits ? internal::CountTrailingZero64(nonDigits) : 16;
+
+    // Move the n digits to the last lanes after zeros, then combine pairs of lanes
+    __m128i x = _mm_shuffle_epi8(s, _mm_loadu_si128(reinterpret_cast<const __m128i*>(kShuffle + n)));
+    x = _mm_maddubs_epi16(x, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1));
+    x = _mm_madd_epi16(x, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+    x = _mm_packus_epi32(x, x);
+    x = _mm_madd_epi16(x, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+    uint64_t u = static_cast<uint64_t>(static_cast<uint32_t>(_mm_cvtsi128_si32(x))) * 100000000 +
+        static_cast<uint32_t>(_mm_extract_epi32(x, 1));
+
+    p += n;
+    if (n == 16) { // at most 3 more
+        for (; *p >= '0' && *p <= '9'; ++p) {
+            if (++n > 19)
+                return 0;
+            u = u * 10 + static_cast<unsigned>(*p - '0');
+        }
+    }
 
-        SkipWhitespace(is);
+    if (u > limit)
+        return 0;
+    *value = u;
+    return p;
+}
+#endif // RAPIDJSONXML_SSE42
 
-        if (is.Peek() == ']') {
-            is.Take();
-            if (!handler.EndArray(0)) // empty array
-                RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
-            return;
-        }
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+//! Parse up to 19 integer digits with SSE4.1 instructions if selected, SWAR otherwise.
+inline const char* ParseIntegerDigits_Dispatch(const char* p, uint64_t limit, uint64_t* value) {
+    return GetSimdLevel() >= kSimdSSE42 ? ParseIntegerDigits_SIMD(p, limit, value) : ParseIntegerDigits_SWAR(p, limit, value);
+}
+#define RAPIDJSONXML_PARSE_INTEGER_DIGITS ParseIntegerDigits_Dispatch
+#elif defined(RAPIDJSONXML_SSE42)
+#define RAPIDJSONXML_PARSE_INTEGER_DIGITS ParseIntegerDigits_SIMD
+#else
+#define RAPIDJSONXML_PARSE_INTEGER_DIGITS ParseIntegerDigits_SWAR
+#endif
 
-        for (SizeType elementCount = 0;;) {
-            ParseValue<parseFlags>(is, handler);
-            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+//! Template function specialization for InsituStringStream
+template<> inline bool ParseIntegerDigits(InsituStringStream& is, uint64_t limit, uint64_t* value) {
+    const char* p = RAPIDJSONXML_PARSE_INTEGER_DIGITS(is.src_, limit, value);
+    if (!p)
+        return false;
+    is.src_ = const_cast<char*>(p);
+    return true;
+}
 
-            ++elementCount;
-            SkipWhitespace(is);
+//! Template function specialization for StringStream
+template<> inline bool ParseIntegerDigits(StringStream& is, uint64_t limit, uint64_t* value) {
+    const char* p = RAPIDJSONXML_PARSE_INTEGER_DIGITS(is.src_, limit, value);
+    if (!p)
+        return false;
+    is.src_ = p;
+    return true;
+}
 
-            switch (is.Take()) {
-            case ',':
-                SkipWhitespace(is);
-                break;
-            case ']':
-                if (!handler.EndArray(elementCount))
-                    RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
-                else
-                    return;
-            default:
-                RAPIDJSONXML_PARSE_ERROR(kParseErrorArrayMissCommaOrSquareBracket, is.Tell());
-            }
-        }
+#undef RAPIDJSONXML_PARSE_INTEGER_DIGITS
+#endif // RAPIDJSONXML_ENDIAN == RAPIDJSONXML_LITTLEENDIAN
+
+///////////////////////////////////////////////////////////////////////////////
+// StructuralIndex
+
+namespace internal {
+
+//! State carried from a 64-byte block to the next one by FindStructurals.
+struct StructuralState {
+    StructuralState() : escaped(0), inString(0), scalar(0) {}
+
+    uint64_t escaped;   //!< 1 if the first character of the block is escaped by a backslash.
+    uint64_t inString;  //!< All ones if the block starts inside a string.
+    uint64_t scalar;    //!< 1 if the last character was part of a number or a literal.
+};
+
+//! Append the positions of the tokens of a 64-byte block to \c out, from the masks of its characters.
+/*! The tokens are the characters of "{}[]:," outside the strings, the opening
+    quotes and the first characters of the other values. The characters after
+    them are either whitespace or invalid, so that the tokens are all that
+    needs to be looked at besides the content of the values.
+    \param state State after the previous block.
+    \param quote Bits of the '"' characters.
+    \param backslash Bits of the '\\' characters.
+    \param op Bits of the "{}[]:," characters.
+    \param space Bits of the whitespace characters.
+    \param base Position of the block.
+    \param out Where to write the positions.
+    \return The end of the written positions.
+*/
+inline SizeType* IndexStructurals(StructuralState& state, uint64_t quote, uint64_t backslash, uint64_t op, uint64_t space, SizeType base, SizeType* out) {
+    // Characters after an odd number of backslashes, the sequences starting on even bits
+    // being told apart by the carry of their addition to the starts on odd bits.
+    if (backslash | state.escaped) {
+        const uint64_t kEvenBits = UINT64_C(0x5555555555555555);
+        backslash &= ~state.escaped;
+        const uint64_t followsEscape = (backslash << 1) | state.escaped;
+        const uint64_t oddStarts = backslash & ~kEvenBits & ~followsEscape;
+        const uint64_t evenStarts = oddStarts + backslash;
+        state.escaped = evenStarts < oddStarts ? 1 : 0;
+        quote &= ~((kEvenBits ^ (evenStarts << 1)) & followsEscape);
     }
 
-    template<unsigned parseFlags, typename InputStream, typename Handler>
-    void ParseNull(InputStream& is, Handler& handler) {
-        RAPIDJSONXML_ASSERT(is.Peek() == 'n');
-        is.Take();
+    // From the opening quotes to the characters before the closing ones, by a prefix xor
+    uint64_t inString = state.inString;
+    if (quote) {
+        uint64_t x = quote;
+        x ^= x << 1;
+        x ^= x << 2;
+        x ^= x << 4;
+        x ^= x << 8;
+        x ^= x << 16;
+        x ^= x << 32;
+        inString ^= x;
+        state.inString = 0 - (inString >> 63);
+    }
 
-        if (is.Take() == 'u' && is.Take() == 'l' && is.Take() == 'l') {
-            if (!handler.Null())
-                RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
+    // First characters of the values, which are neither tokens nor whitespace
+    const uint64_t scalar = ~(op | space);
+    const uint64_t nonQuoteScalar = scalar & ~quote;
+    const uint64_t followsScalar = (nonQuoteScalar << 1) | state.scalar;
+    state.scalar = nonQuoteScalar >> 63;
+
+    // Keep the opening quotes, but nothing after them up to the closing ones
+    uint64_t tokens = (op | (scalar & ~followsScalar)) & ~(inString ^ quote);
+    while (tokens) {
+        *out++ = base + CountTrailingZero64(tokens);
+        tokens &= tokens - 1;
+    }
+    return out;
+}
+
+//! Classify 64 characters one at a time.
+inline void ClassifyStructurals_Scalar(const char* p, uint64_t& quote, uint64_t& backslash, uint64_t& op, uint64_t& space) {
+    quote = backslash = op = space = 0;
+    for (unsigned i = 0; i < 64; i++) {
+        const uint64_t bit = UINT64_C(1) << i;
+        switch (p[i]) {
+        case '"': quote |= bit; break;
+        case '\\': backslash |= bit; break;
+        case '{': case '}': case '[': case ']': case ':': case ',': op |= bit; break;
+        case ' ': case '\n': case '\r': case '\t': space |= bit; break;
+        default: break;
         }
-        else
-            RAPIDJSONXML_PARSE_ERROR(kParseErrorValueInvalid, is.Tell() - 1);
     }
+}
 
-    template<unsigned parseFlags, typename InputStream, typename Handler>
-    void ParseTrue(InputStream& is, Handler& handler) {
-        RAPIDJSONXML_ASSERT(is.Peek() == 't');
-        is.Take();
+} // namespace internal
 
-        if (is.Take() == 'r' && is.Take() == 'u' && is.Take() == 'e') {
-            if (!handler.Bool(true))
-                RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
-        }
-        else
-            RAPIDJSONXML_PARSE_ERROR(kParseErrorValueInvalid, is.Tell() - 1);
+//! Find the positions of the tokens of a text, 64 characters at a time (see internal::IndexStructurals()).
+/*! \param p Text, not necessarily null-terminated.
+    \param length Number of characters of the text.
+    \param out Where to write the positions, with room for \c length of them.
+    \return The end of the written positions.
+*/
+inline SizeType* FindStructurals_Scalar(const char* p, size_t length, SizeType* out) {
+    internal::StructuralState state;
+    uint64_t quote, backslash, op, space;
+    SizeType base = 0;
+    for (; length >= 64; p += 64, length -= 64, base += 64) {
+        internal::ClassifyStructurals_Scalar(p, quote, backslash, op, space);
+        out = internal::IndexStructurals(state, quote, backslash, op, space, base, out);
     }
+    if (length > 0) { // padded with whitespace
+        char block[64];
+        std::memset(block, ' ', sizeof(block));
+        std::memcpy(block, p, length);
+        internal::ClassifyStructurals_Scalar(block, quote, backslash, op, space);
+        out = internal::IndexStructurals(state, quote, backslash, op, space, base, out);
+    }
+    return out;
+}
 
-    template<unsigned parseFlags, typename InputStream, typename Handler>
-    void ParseFalse(InputStream& is, Handler& handler) {
-        RAPIDJSONXML_ASSERT(is.Peek() == 'f');
-        is.Take();
+#ifdef RAPIDJSONXML_SIMD
+namespace internal {
 
-        if (is.Take() == 'a' && is.Take() == 'l' && is.Take() == 's' && is.Take() == 'e') {
-            if (!handler.Bool(false))
-                RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
-        }
-        else
-            RAPIDJSONXML_PARSE_ERROR(kParseErrorValueInvalid, is.Tell() - 1);
+//! Classify 16 characters with SSE2 instructions, into the bits \c shift to \c shift + 15 of the masks.
+RAPIDJSONXML_TARGET_SSE2 inline void ClassifyStructurals_SSE2(const char* p, unsigned shift, uint64_t& quote, uint64_t& backslash, uint64_t& op, uint64_t& space) {
+    const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i lower = _mm_or_si128(s, _mm_set1_epi8(0x20)); // '[' and ']' to '{' and '}'
+    __m128i x = _mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('{')), _mm_cmpeq_epi8(lower, _mm_set1_epi8('}')));
+    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, _mm_set1_epi8(':')));
+    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, _mm_set1_epi8(',')));
+    op |= static_cast<uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(x))) << shift;
+    x = _mm_or_si128(_mm_cmpeq_epi8(s, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(s, _mm_set1_epi8('\n')));
+    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, _mm_set1_epi8('\r')));
+    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, _mm_set1_epi8('\t')));
+    space |= static_cast<uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(x))) << shift;
+    quote |= static_cast<uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(s, _mm_set1_epi8('"'))))) << shift;
+    backslash |= static_cast<uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(s, _mm_set1_epi8('\\'))))) << shift;
+}
+
+//! Classify 64 characters with SSE2 instructions.
+RAPIDJSONXML_TARGET_SSE2 inline void ClassifyStructurals_SSE2(const char* p, uint64_t& quote, uint64_t& backslash, uint64_t& op, uint64_t& space) {
+    quote = backslash = op = space = 0;
+    for (unsigned i = 0; i < 64; i += 16)
+        ClassifyStructurals_SSE2(p + i, i, quote, backslash, op, space);
+}
+
+} // namespace internal
+
+//! Find the positions of the tokens of a text with SSE2 instructions, classifying 16 characters at once.
+/*! \note RAPIDJSONXML_SSE42 uses the same SSE2 instructions.
+*/
+RAPIDJSONXML_TARGET_SSE2 inline SizeType* FindStructurals_SSE2(const char* p, size_t length, SizeType* out) {
+    internal::StructuralState state;
+    uint64_t quote, backslash, op, space;
+    SizeType base = 0;
+    for (; length >= 64; p += 64, length -= 64, base += 64) {
+        internal::ClassifyStructurals_SSE2(p, quote, backslash, op, space);
+        out = internal::IndexStructurals(state, quote, backslash, op, space, base, out);
+    }
+    if (length > 0) { // padded with whitespace
+        char block[64];
+        std::memset(block, ' ', sizeof(block));
+        std::memcpy(block, p, length);
+        internal::ClassifyStructurals_SSE2(block, quote, backslash, op, space);
+        out = internal::IndexStructurals(state, quote, backslash, op, space, base, out);
     }
+    return out;
+}
 
-    // Helper function to parse four hexidecimal digits in \uXXXX in ParseString().
-    template<typename InputStream>
-    unsigned ParseHex4(InputStream& is) {
-        unsigned codepoint = 0;
-        for (int i = 0; i < 4; i++) {
-            Ch c = is.Take();
-            codepoint <<= 4;
-            codepoint += static_cast<unsigned>(c);
-            if (c >= '0' && c <= '9')
-                codepoint -= '0';
-            else if (c >= 'A' && c <= 'F')
-                codepoint -= 'A' - 10;
-            else if (c >= 'a' && c <= 'f')
-                codepoint -= 'a' - 10;
-            else {
-                RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorStringUnicodeEscapeInvalidHex, is.Tell() - 1);
-                RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN(0);
-            }
-        }
-        return codepoint;
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+namespace internal {
+
+//! Classify 64 characters with AVX2 instructions, 32 at once.
+RAPIDJSONXML_TARGET_AVX2 inline void ClassifyStructurals_AVX2(const char* p, uint64_t& quote, uint64_t& backslash, uint64_t& op, uint64_t& space) {
+    // Indexed by the low nibble, the whitespace characters are the only ones equal to their entry
+    const __m256i table = _mm256_setr_epi8(
+        ' ', -1, -1, -1, -1, -1, -1, -1, -1, '\t', '\n', -1, -1, '\r', -1, -1,
+        ' ', -1, -1, -1, -1, -1, -1, -1, -1, '\t', '\n', -1, -1, '\r', -1, -1);
+    quote = backslash = op = space = 0;
+    for (unsigned i = 0; i < 64; i += 32) {
+        const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        const __m256i lower = _mm256_or_si256(s, _mm256_set1_epi8(0x20)); // '[' and ']' to '{' and '}'
+        __m256i x = _mm256_or_si256(_mm256_cmpeq_epi8(lower, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('}')));
+        x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, _mm256_set1_epi8(':')));
+        x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, _mm256_set1_epi8(',')));
+        op |= static_cast<uint64_t>(static_cast<unsigned>(_mm256_movemask_epi8(x))) << i;
+        space |= static_cast<uint64_t>(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_shuffle_epi8(table, s), s)))) << i;
+        quote |= static_cast<uint64_t>(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(s, _mm256_set1_epi8('"'))))) << i;
+        backslash |= static_cast<uint64_t>(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(s, _mm256_set1_epi8('\\'))))) << i;
     }
+}
 
-    class StackStream {
-    public:
-        typedef typename TargetEncoding::Ch Ch;
+} // namespace internal
 
-        StackStream(internal::Stack<Allocator>& stack) : stack_(stack), length_(0) {}
-        RAPIDJSONXML_FORCEINLINE void Put(Ch c) {
-            *stack_.template Push<Ch>() = c;
-            ++length_;
-        }
-        internal::Stack<Allocator>& stack_;
-        SizeType length_;
+//! Find the positions of the tokens of a text with AVX2 instructions, classifying 32 characters at once.
+RAPIDJSONXML_TARGET_AVX2 inline SizeType* FindStructurals_AVX2(const char* p, size_t length, SizeType* out) {
+    internal::StructuralState state;
+    uint64_t quote, backslash, op, space;
+    SizeType base = 0;
+    for (; length >= 64; p += 64, length -= 64, base += 64) {
+        internal::ClassifyStructurals_AVX2(p, quote, backslash, op, space);
+        out = internal::IndexStructurals(state, quote, backslash, op, space, base, out);
+    }
+    if (length > 0) { // padded with whitespace
+        char block[64];
+        std::memset(block, ' ', sizeof(block));
+        std::memcpy(block, p, length);
+        internal::ClassifyStructurals_AVX2(block, quote, backslash, op, space);
+        out = internal::IndexStructurals(state, quote, backslash, op, space, base, out);
+    }
+    return out;
+}
+#endif // RAPIDJSONXML_SIMD_DISPATCH
+#endif // RAPIDJSONXML_SIMD
 
-    private:
-        StackStream(const StackStream&);
-        StackStream& operator=(const StackStream&);
-    };
+//! Find the positions of the tokens of a text with the selected SIMD instructions, if any.
+inline SizeType* FindStructurals(const char* p, size_t length, SizeType* out) {
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+    typedef SizeType* (*Kernel)(const char*, size_t, SizeType*);
+    static const Kernel kKernels[kSimdLevelCount] = { FindStructurals_Scalar, FindStructurals_SSE2, FindStructurals_SSE2, FindStructurals_AVX2 };
+    return kKernels[GetSimdLevel()](p, length, out);
+#elif defined(RAPIDJSONXML_SIMD)
+    return FindStructurals_SSE2(p, length, out);
+#else
+    return FindStructurals_Scalar(p, length, out);
+#endif
+}
 
-    // Parse string and generate String event. Different code paths for kParseInsituFlag.
-    template<unsigned parseFlags, typename InputStream, typename Handler>
-    void ParseString(InputStream& is, Handler& handler) {
-        internal::StreamLocalCopy<InputStream> copy(is);
-        InputStream& s(copy.s);
+namespace internal {
 
-        if (parseFlags & kParseInsituFlag) {
-            typename InputStream::Ch *head = s.PutBegin();
-            ParseStringToStream<parseFlags, SourceEncoding, SourceEncoding>(s, s);
-            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
-            size_t length = s.PutEnd(head) - 1;
-            RAPIDJSONXML_ASSERT(length <= 0xFFFFFFFF);
-            if (!handler.String((typename TargetEncoding::Ch*)head, SizeType(length), false))
-                RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, s.Tell());
+//! Positions of the tokens of a text in memory, for \ref kParseStructuralIndexFlag.
+/*! The parser moves from a token to the next one instead of skipping the
+    whitespace. Other streams keep skipping it.
+    \tparam Allocator Allocator of the positions, owned by the index: not the
+        one of the reader, which may be the memory pool of a document.
+*/
+template <typename Allocator = CrtAllocator>
+class StructuralIndex {
+public:
+    StructuralIndex() : allocator_(), positions_(0), capacity_(0), cursor_(0), text_(0) {}
+    ~StructuralIndex() {
+        Clear();
+    }
+
+    //! Release the positions, after parsing the indexed text.
+    void Clear() {
+        Allocator::Free(positions_);
+        positions_ = 0;
+        capacity_ = 0;
+        cursor_ = 0;
+        text_ = 0;
+    }
+
+    //! Index the rest of the stream.
+    /*! \return Whether the stream can be indexed. It cannot be longer than what SizeType holds,
+        and the positions must be allocated.
+    */
+    template<typename InputStream>
+    bool Build(InputStream&) {
+        return true;
+    }
+    bool Build(StringStream& is) {
+        return Build(is.src_, std::strlen(is.src_));
+    }
+    bool Build(InsituStringStream& is) {
+        return Build(is.src_, std::strlen(is.src_));
+    }
+    bool Build(MemoryStream& is) {
+        return Build(is.src_, static_cast<size_t>(is.end_ - is.src_));
+    }
+
+    //! Move the stream from the current token to the next one.
+    template<typename InputStream>
+    RAPIDJSONXML_FORCEINLINE void Next(InputStream& is) {
+        SkipWhitespace(is);
+    }
+    RAPIDJSONXML_FORCEINLINE void Next(StringStream& is) {
+        is.src_ = Skip(is.src_);
+    }
+    RAPIDJSONXML_FORCEINLINE void Next(InsituStringStream& is) {
+        is.src_ = const_cast<char*>(Skip(is.src_));
+    }
+    RAPIDJSONXML_FORCEINLINE void Next(MemoryStream& is) {
+        is.src_ = Skip(is.src_);
+    }
+
+private:
+    // Prohibit copy constructor & assignment operator.
+    StructuralIndex(const StructuralIndex&);
+    StructuralIndex& operator=(const StructuralIndex&);
+
+    bool Build(const char* text, size_t length) {
+        if (length > static_cast<SizeType>(-1) - 1)
+            return false;
+        // The start, then the tokens, then twice the end
+        const size_t count = length + 3;
+        if (count < length || count > static_cast<size_t>(-1) / sizeof(SizeType))
+            return false;
+        if (capacity_ < count) {
+            SizeType* positions = static_cast<SizeType*>(allocator_.Realloc(positions_, capacity_ * sizeof(SizeType), count * sizeof(SizeType)));
+            if (!positions)
+                return false;
+            positions_ = positions;
+            capacity_ = count;
         }
-        else {
-            StackStream stackStream(stack_);
-            ParseStringToStream<parseFlags, SourceEncoding, TargetEncoding>(s, stackStream);
-            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
-            if (!handler.String(stack_.template Pop<typename TargetEncoding::Ch>(stackStream.length_), stackStream.length_ - 1, true))
-                RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, s.Tell());
+        positions_[0] = 0;
+        SizeType* end = FindStructurals(text, length, positions_ + 1);
+        end[0] = end[1] = static_cast<SizeType>(length);
+        cursor_ = positions_;
+        text_ = text;
+        return true;
+    }
+
+    // Only whitespace separates the current token from the next one, which the
+    // first character after the current token tells: the other characters that
+    // are not indexed are left to be reported by the parser.
+    RAPIDJSONXML_FORCEINLINE const char* Skip(const char* p) {
+        const char* next = text_ + cursor_[1];
+        RAPIDJSONXML_ASSERT(p <= next);
+        if (p == next || *p == ' ' || *p == '\n' || *p == '\r' || *p == '\t') {
+            ++cursor_;
+            return next;
         }
+        return p;
     }
 
-    // Parse string to an output is
-    // This function handles the prefix/suffix double quotes, escaping, and optional encoding validation.
-    template<unsigned parseFlags, typename SEncoding, typename TEncoding, typename InputStream, typename OutputStream>
-    RAPIDJSONXML_FORCEINLINE void ParseStringToStream(InputStream& is, OutputStream& os) {
-#define Z16 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
-        static const char escape[256] = {
-            Z16, Z16, 0, 0,'\"', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,'/',
-            Z16, Z16, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,'\\', 0, 0, 0,
-            0, 0,'\b', 0, 0, 0,'\f', 0, 0, 0, 0, 0, 0, 0,'\n', 0,
-            0, 0,'\r', 0,'\t', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-            Z16, Z16, Z16, Z16, Z16, Z16, Z16, Z16
-        };
-#undef Z16
+    Allocator allocator_;
+    SizeType* positions_;
+    size_t capacity_;
+    const SizeType* cursor_;    //!< Position of the current token.
+    const char* text_;
+};
 
-        RAPIDJSONXML_ASSERT(is.Peek() == '\"');
-        is.Take(); // Skip '\"'
+} // namespace internal
 
-        for (;;) {
-            Ch c = is.Peek();
-            if (c == '\\') { // Escape
-                is.Take();
-                Ch e = is.Take();
-                if ((sizeof(Ch) == 1 || unsigned(e) < 256) && escape[(unsigned char)e]) {
-                    os.Put(escape[(unsigned char)e]);
-                }
-                else if (e == 'u') { // Unicode
-                    unsigned codepoint = ParseHex4(is);
-                    if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
-                        // Handle UTF-16 surrogate pair
-                        if (is.Take() != '\\' || is.Take() != 'u')
-                            RAPIDJSONXML_PARSE_ERROR(kParseErrorStringUnicodeSurrogateInvalid, is.Tell() - 2);
-                        unsigned codepoint2 = ParseHex4(is);
-                        if (codepoint2 < 0xDC00 || codepoint2 > 0xDFFF)
-                            RAPIDJSONXML_PARSE_ERROR(kParseErrorStringUnicodeSurrogateInvalid, is.Tell() - 2);
-                        codepoint = (((codepoint - 0xD800) << 10) | (codepoint2 - 0xDC00)) + 0x10000;
-                    }
-                    TEncoding::Encode(os, codepoint);
-                }
-                else
-                    RAPIDJSONXML_PARSE_ERROR(kParseErrorStringEscapeInvalid, is.Tell() - 1);
-            }
-            else if (c == '"') { // Closing double quote
-                is.Take();
-                os.Put('\0'); // null-terminate the string
-                return;
-            }
-            else if (c == '\0')
-                RAPIDJSONXML_PARSE_ERROR(kParseErrorStringMissQuotationMark, is.Tell() - 1);
-            else if ((unsigned)c < 0x20) // RFC 4627: unescaped = %x20-21 / %x23-5B / %x5D-10FFFF
-                RAPIDJSONXML_PARSE_ERROR(kParseErrorStringEscapeInvalid, is.Tell() - 1);
-            else {
-                if (parseFlags & kParseValidateEncodingFlag ?
-                        !Transcoder<SEncoding, TEncoding>::Validate(is, os) :
-                        !Transcoder<SEncoding, TEncoding>::Transcode(is, os))
-                    RAPIDJSONXML_PARSE_ERROR(kParseErrorStringInvalidEncoding, is.Tell());
-            }
-        }
-    }
+///////////////////////////////////////////////////////////////////////////////
+// GenericReader
 
-    template<unsigned parseFlags, typename InputStream, typename Handler>
-    void ParseNumber(InputStream& is, Handler& handler) {
-        internal::StreamLocalCopy<InputStream> copy(is);
-        InputStream& s(copy.s);
+//! SAX-style JSON parser. Use \ref Reader for UTF8 encoding and default allocator.
+/*! GenericReader parses JSON text from a stream, and send events synchronously to an
+    object implementing Handler concept.
 
-        // Parse minus
-        bool minus = false;
-        if (s.Peek() == '-') {
-            minus = true;
-            s.Take();
-        }
+    It needs to allocate a stack for storing a single decoded string during
+    non-destructive parsing.
 
-        // Parse int: zero / ( digit1-9 *DIGIT )
-        unsigned i = 0;
-        bool try64bit = false;
-        if (s.Peek() == '0') {
-            i = 0;
-            s.Take();
-        }
-        else if (s.Peek() >= '1' && s.Peek() <= '9') {
-            i = static_cast<unsigned>(s.Take() - '0');
+    For in-situ parsing, the decoded string is directly written to the source
+    text string, no temporary buffer is required.
 
-            if (minus)
-                while (s.Peek() >= '0' && s.Peek() <= '9') {
-                    if (i >= 214748364) { // 2^31 = 2147483648
-                        if (i != 214748364 || s.Peek() > '8') {
-                            try64bit = true;
-                            break;
-                        }
-                    }
-                    i = i * 10 + static_cast<unsigned>(s.Take() - '0');
-                }
-            else
-                while (s.Peek() >= '0' && s.Peek() <= '9') {
-                    if (i >= 429496729) { // 2^32 - 1 = 4294967295
-                        if (i != 429496729 || s.Peek() > '5') {
-                            try64bit = true;
-                            break;
-                        }
-                    }
-                    i = i * 10 + static_cast<unsigned>(s.Take() - '0');
-                }
-        }
-        else
-            RAPIDJSONXML_PARSE_ERROR(kParseErrorValueInvalid, s.Tell());
+    A GenericReader object can be reused for parsing multiple JSON text.
 
-        // Parse 64bit int
-        uint64_t i64 = 0;
-        bool useDouble = false;
-        if (try64bit) {
-            i64 = i;
-            if (minus)
-                while (s.Peek() >= '0' && s.Peek() <= '9') {
-                    if (i64 >= UINT64_C(922337203685477580)) // 2^63 = 9223372036854775808
-                        if (i64 != UINT64_C(922337203685477580) || s.Peek() > '8') {
-                            useDouble = true;
-                            break;
-                        }
-                    i64 = i64 * 10 + static_cast<unsigned>(s.Take() - '0');
-                }
-            else
-                while (s.Peek() >= '0' && s.Peek() <= '9') {
-                    if (i64 >= UINT64_C(1844674407370955161)) // 2^64 - 1 = 18446744073709551615
-                        if (i64 != UINT64_C(1844674407370955161) || s.Peek() > '5') {
-                            useDouble = true;
-                            break;
-                        }
-                    i64 = i64 * 10 + static_cast<unsigned>(s.Take() - '0');
-                }
-        }
+    \tparam SourceEncoding Encoding of the input stream.
+    \tparam TargetEncoding Encoding of the parse output.
+    \tparam Allocator Allocator type for stack.
+*/
+template <typename SourceEncoding, typename TargetEncoding, typename Allocator = MemoryPoolAllocator<> >
+class GenericReader {
+public:
+    typedef typename SourceEncoding::Ch Ch; //!< SourceEncoding character type
 
-        // Force double for big integer
-        double d = 0.0;
-        if (useDouble) {
-            d = (double)i64;
-            while (s.Peek() >= '0' && s.Peek() <= '9') {
-                if (d >= 1E307)
-                    RAPIDJSONXML_PARSE_ERROR(kParseErrorNumberTooBig, s.Tell());
-                d = d * 10 + (s.Take() - '0');
-            }
-        }
+    //! Constructor.
+    /*! \param allocator Optional allocator for allocating stack memory. (Only use for non-destructive parsing)
+        \param stackCapacity stack capacity in bytes for storing a single decoded string.  (Only use for non-destructive parsing)
+    */
+    GenericReader(Allocator* allocator = 0, size_t stackCapacity = kDefaultStackCapacity) : stack_(allocator, stackCapacity), structurals_(), parseResult_() {}
 
-        // Parse frac = decimal-point 1*DIGIT
-        int expFrac = 0;
-        if (s.Peek() == '.') {
-            if (!useDouble) {
-                d = try64bit ? (double)i64 : (double)i;
-                useDouble = true;
-            }
-            s.Take();
+    //! Parse JSON text.
+    /*! \tparam parseFlags Combination of \ref ParseFlag.
+        \tparam InputStream Type of input stream, implementing Stream concept.
+        \tparam Handler Type of handler, implementing Handler concept.
+        \param is Input stream to be parsed.
+        \param handler The handler to receive events.
+        \return Whether the parsing is successful.
+    */
+    template <unsigned parseFlags, typename InputStream, typename Handler>
+    ParseResult Parse(InputStream& is, Handler& handler) {
+        if (parseFlags & kParseIterativeFlag)
+            return IterativeParse<parseFlags>(is, handler);
+        if ((parseFlags & kParseStructuralIndexFlag) && !structurals_.Build(is))
+            return Parse<parseFlags & ~static_cast<unsigned>(kParseStructuralIndexFlag)>(is, handler);
 
-            if (s.Peek() >= '0' && s.Peek() <= '9') {
-                d = d * 10 + (s.Take() - '0');
-                --expFrac;
-            }
-            else
-                RAPIDJSONXML_PARSE_ERROR(kParseErrorNumberMissFraction, s.Tell());
+        parseResult_.Clear();
 
-            while (s.Peek() >= '0' && s.Peek() <= '9') {
-                if (expFrac > -16) {
-                    d = d * 10 + (s.Peek() - '0');
-                    --expFrac;
-                }
-                s.Take();
-            }
-        }
+        ClearStackOnExit scope(*this);
 
-        // Parse exp = e [ minus / plus ] 1*DIGIT
-        int exp = 0;
-        if (s.Peek() == 'e' || s.Peek() == 'E') {
-            if (!useDouble) {
-                d = try64bit ? (double)i64 : (double)i;
-                useDouble = true;
-            }
-            s.Take();
+        NextToken<parseFlags>(is);
 
-            bool expMinus = false;
-            if (s.Peek() == '+')
-                s.Take();
-            else if (s.Peek() == '-') {
-                s.Take();
-                expMinus = true;
+        if (is.Peek() == '\0') {
+            RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorDocumentEmpty, is.Tell());
+            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN(parseResult_);
+        }
+        else {
+            switch (is.Peek()) {
+            case '{':
+                ParseObject<parseFlags>(is, handler);
+                break;
+            case '[':
+                ParseArray<parseFlags>(is, handler);
+                break;
+            default:
+                RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorDocumentRootNotObjectOrArray, is.Tell());
             }
+            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN(parseResult_);
 
-            if (s.Peek() >= '0' && s.Peek() <= '9') {
-                exp = s.Take() - '0';
-                while (s.Peek() >= '0' && s.Peek() <= '9') {
-                    exp = exp * 10 + (s.Take() - '0');
-                    if (exp > 308)
-                        RAPIDJSONXML_PARSE_ERROR(kParseErrorNumberTooBig, s.Tell());
+            if (!(parseFlags & kParseStopWhenDoneFlag)) {
+                NextToken<parseFlags>(is);
+
+                if (is.Peek() != '\0') {
+                    RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorDocumentRootNotSingular, is.Tell());
+                    RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN(parseResult_);
                 }
             }
-            else
-                RAPIDJSONXML_PARSE_ERROR(kParseErrorNumberMissExponent, s.Tell());
-
-            if (expMinus)
-                exp = -exp;
         }
 
-        // Finish parsing, call event according to the type of number.
-        bool cont = true;
-        if (useDouble) {
-            int expSum = exp + expFrac;
-            if (expSum < -308) {
-                // Prevent expSum < -308, making Pow10(expSum) = 0
-                d *= internal::Pow10(exp);
-                d *= internal::Pow10(expFrac);
-            }
-            else
-                d *= internal::Pow10(expSum);
-
-            cont = handler.Double(minus ? -d : d);
-        }
-        else {
-            if (try64bit) {
-                if (minus)
-                    cont = handler.Int64(-(int64_t)i64);
-                else
-                    cont = handler.Uint64(i64);
-            }
-            else {
-                if (minus)
-                    cont = handler.Int(-(int)i);
-                else
-                    cont = handler.Uint(i);
-            }
-        }
-        if (!cont)
-            RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, s.Tell());
+        return parseResult_;
     }
 
-    // Parse any JSON value
-    template<unsigned parseFlags, typename InputStream, typename Handler>
-    void ParseValue(InputStream& is, Handler& handler) {
-        switch (is.Peek()) {
-        case 'n':
-            ParseNull  <parseFlags>(is, handler);
-            break;
-        case 't':
-            ParseTrue  <parseFlags>(is, handler);
+    //! Parse JSON text (with \ref kParseDefaultFlags)
+    /*! \tparam InputStream Type of input stream, implementing Stream concept
+        \tparam Handler Type of handler, implementing Handler concept.
+        \param is Input stream to be parsed.
+        \param handler The handler to receive events.
+        \return Whether the parsing is successful.
+    */
+    template <typename InputStream, typename Handler>
+    ParseResult Parse(InputStream& is, Handler& handler) {
+        return Parse<kParseDefaultFlags>(is, handler);
+    }
+
+    //! Parse a single JSON value of any type, e.g. a string or a number inside a larger text.
+    /*! Unlike Parse(), the value needs not be an object or an array, and the
+        stream is left after it, as with \ref kParseStopWhenDoneFlag.
+        \tparam parseFlags Combination of \ref ParseFlag.
+        \tparam InputStream Type of input stream, implementing Stream concept.
+        \tparam Handler Type of handler, implementing Handler concept.
+        \param is Input stream, at the value or at whitespace before it.
+        \param handler The handler to receive events.
+        \return Whether the parsing is successful.
+    */
+    template <unsigned parseFlags, typename InputStream, typename Handler>
+    ParseResult ParseFragment(InputStream& is, Handler& handler) {
+        parseResult_.Clear();
+
+        ClearStackOnExit scope(*this);
+
+        SkipWhitespace(is);
+
+        if (is.Peek() == '\0')
+            RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorDocumentEmpty, is.Tell());
+        else
+            ParseValue<parseFlags & ~static_cast<unsigned>(kParseStructuralIndexFlag)>(is, handler);
+        return parseResult_;
+    }
+
+    //! Check the syntax of a JSON text, without producing any value.
+    /*! The strings are scanned without being decoded, and the numbers are
+        checked without being converted, except the ones which may be too big
+        for a double, so that the same texts are rejected as by Parse().
+        \tparam parseFlags Combination of \ref ParseFlag. With \ref kParseValidateEncodingFlag,
+            the encoding of the strings is checked too.
+        \tparam InputStream Type of input stream, implementing Stream concept.
+        \param is Input stream to be checked.
+        \return The result of the check, with the offset of the first error.
+    */
+    template <unsigned parseFlags, typename InputStream>
+    ParseResult Validate(InputStream& is) {
+        ValidationHandler handler;
+        return Parse<parseFlags>(is, handler);
+    }
+
+    //! Check the syntax of a JSON text (with \ref kParseDefaultFlags)
+    template <typename InputStream>
+    ParseResult Validate(InputStream& is) {
+        return Validate<kParseDefaultFlags>(is);
+    }
+
+    //! Whether a parse error has occured in the last parsing.
+    bool HasParseError() const {
+        return parseResult_.IsError();
+    }
+
+    //! Get the \ref ParseErrorCode of last parsing.
+    ParseErrorCode GetParseErrorCode() const {
+        return parseResult_.Code();
+    }
+
+    //! Get the position of last parsing error in input, 0 otherwise.
+    size_t GetErrorOffset() const {
+        return parseResult_.Offset();
+    }
+
+private:
+    // Prohibit copy constructor & assignment operator.
+    GenericReader(const GenericReader&);
+    GenericReader& operator=(const GenericReader&);
+
+    void ClearStack() {
+        stack_.Clear();
+        structurals_.Clear();
+    }
+
+    // clear stack on any exit from ParseStream, e.g. due to exception
+    struct ClearStackOnExit {
+        explicit ClearStackOnExit(GenericReader& r) : r_(r) {}
+        ~ClearStackOnExit() {
+            r_.ClearStack();
+        }
+    private:
+        GenericReader& r_;
+        ClearStackOnExit(const ClearStackOnExit&);
+        ClearStackOnExit& operator=(const ClearStackOnExit&);
+    };
+
+    // Skip the whitespace, or move to the next token with kParseStructuralIndexFlag
+    template<unsigned parseFlags, typename InputStream>
+    RAPIDJSONXML_FORCEINLINE void NextToken(InputStream& is) {
+        if (parseFlags & kParseStructuralIndexFlag)
+            structurals_.Next(is);
+        else
+            SkipWhitespace(is);
+    }
+
+    // Parse object: { string : value, ... }
+    template<unsigned parseFlags, typename InputStream, typename Handler>
+    void ParseObject(InputStream& is, Handler& handler) {
+        RAPIDJSONXML_ASSERT(is.Peek() == '{');
+        is.Take(); // Skip '{'
+
+        if (!handler.StartObject(GenericAttributeIteratorPair<TargetEncoding>()))
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
+
+        NextToken<parseFlags>(is);
+
+        if (is.Peek() == '}') {
+            is.Take();
+            if (!handler.EndObject(0)) // empty object
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
+            return;
+        }
+
+        for (SizeType memberCount = 0;;) {
+            if (is.Peek() != '"')
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorObjectMissName, is.Tell());
+
+            ParseString<parseFlags>(is, handler, true);
+            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+
+            NextToken<parseFlags>(is);
+
+            if (is.Take() != ':')
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorObjectMissColon, is.Tell());
+
+            NextToken<parseFlags>(is);
+
+            ParseValue<parseFlags>(is, handler);
+            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+
+            NextToken<parseFlags>(is);
+
+            ++memberCount;
+
+            switch (is.Take()) {
+            case ',':
+                NextToken<parseFlags>(is);
+                break;
+            case '}':
+                if (!handler.EndObject(memberCount))
+                    RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
+                else
+                    return;
+            default:
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorObjectMissCommaOrCurlyBracket, is.Tell());
+            }
+        }
+    }
+
+    // Parse array: [ value, ... ]
+    template<unsigned parseFlags, typename InputStream, typename Handler>
+    void ParseArray(InputStream& is, Handler& handler) {
+        RAPIDJSONXML_ASSERT(is.Peek() == '[');
+        is.Take(); // Skip '['
+
+        if (!handler.StartArray())
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
+
+        NextToken<parseFlags>(is);
+
+        if (is.Peek() == ']') {
+            is.Take();
+            if (!handler.EndArray(0)) // empty array
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
+            return;
+        }
+
+        for (SizeType elementCount = 0;;) {
+            ParseValue<parseFlags>(is, handler);
+            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+
+            ++elementCount;
+            NextToken<parseFlags>(is);
+
+            switch (is.Take()) {
+            case ',':
+                NextToken<parseFlags>(is);
+                break;
+            case ']':
+                if (!handler.EndArray(elementCount))
+                    RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
+                else
+                    return;
+            default:
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorArrayMissCommaOrSquareBracket, is.Tell());
+            }
+        }
+    }
+
+    template<unsigned parseFlags, typename InputStream, typename Handler>
+    void ParseNull(InputStream& is, Handler& handler) {
+        RAPIDJSONXML_ASSERT(is.Peek() == 'n');
+        is.Take();
+
+        if (is.Take() == 'u' && is.Take() == 'l' && is.Take() == 'l') {
+            if (!handler.Null())
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
+        }
+        else
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorValueInvalid, is.Tell() - 1);
+    }
+
+    template<unsigned parseFlags, typename InputStream, typename Handler>
+    void ParseTrue(InputStream& is, Handler& handler) {
+        RAPIDJSONXML_ASSERT(is.Peek() == 't');
+        is.Take();
+
+        if (is.Take() == 'r' && is.Take() == 'u' && is.Take() == 'e') {
+            if (!handler.Bool(true))
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
+        }
+        else
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorValueInvalid, is.Tell() - 1);
+    }
+
+    template<unsigned parseFlags, typename InputStream, typename Handler>
+    void ParseFalse(InputStream& is, Handler& handler) {
+        RAPIDJSONXML_ASSERT(is.Peek() == 'f');
+        is.Take();
+
+        if (is.Take() == 'a' && is.Take() == 'l' && is.Take() == 's' && is.Take() == 'e') {
+            if (!handler.Bool(false))
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
+        }
+        else
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorValueInvalid, is.Tell() - 1);
+    }
+
+    // Helper function to parse four hexidecimal digits in \uXXXX in ParseString().
+    template<typename InputStream>
+    unsigned ParseHex4(InputStream& is) {
+        unsigned codepoint = 0;
+        for (int i = 0; i < 4; i++) {
+            Ch c = is.Take();
+            codepoint <<= 4;
+            codepoint += static_cast<unsigned>(c);
+            if (c >= '0' && c <= '9')
+                codepoint -= '0';
+            else if (c >= 'A' && c <= 'F')
+                codepoint -= 'A' - 10;
+            else if (c >= 'a' && c <= 'f')
+                codepoint -= 'a' - 10;
+            else {
+                RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorStringUnicodeEscapeInvalidHex, is.Tell() - 1);
+                RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN(0);
+            }
+        }
+        return codepoint;
+    }
+
+    template<typename CharType>
+    class StackStream {
+    public:
+        typedef CharType Ch;
+
+        StackStream(internal::Stack<Allocator>& stack) : stack_(stack), length_(0) {}
+        RAPIDJSONXML_FORCEINLINE void Put(Ch c) {
+            *stack_.template Push<Ch>() = c;
+            ++length_;
+        }
+        internal::Stack<Allocator>& stack_;
+        SizeType length_;
+
+    private:
+        StackStream(const StackStream&);
+        StackStream& operator=(const StackStream&);
+    };
+
+    // Output stream writing into a local buffer, then into memory of an allocator when it is full
+    template<typename CharType, typename StringAllocator>
+    class AllocatorStream {
+    public:
+        typedef CharType Ch;
+
+        AllocatorStream(StringAllocator& allocator) : allocator_(allocator), str_(buffer_), length_(0), capacity_(kBufferCapacity) {}
+        RAPIDJSONXML_FORCEINLINE void Put(Ch c) {
+            *Push(1) = c;
+        }
+        RAPIDJSONXML_FORCEINLINE Ch* Push(size_t count) {
+            if (length_ + count > capacity_)
+                Expand(count);
+            Ch* p = str_ + length_;
+            length_ += static_cast<SizeType>(count);
+            return p;
+        }
+        bool IsAllocated() const {
+            return str_ != buffer_;
+        }
+        // The allocated characters, without the unused capacity
+        Ch* Shrink() {
+            RAPIDJSONXML_ASSERT(IsAllocated());
+            return static_cast<Ch*>(allocator_.Realloc(str_, capacity_ * sizeof(Ch), length_ * sizeof(Ch)));
+        }
+        void Release() {
+            if (!IsAllocated())
+                return;
+            if (StringAllocator::kNeedFree)
+                StringAllocator::Free(str_);
+            else
+                allocator_.Realloc(str_, capacity_ * sizeof(Ch), 0);
+        }
+
+        StringAllocator& allocator_;
+        Ch* str_;
+        SizeType length_;
+        SizeType capacity_;
+
+    private:
+        AllocatorStream(const AllocatorStream&);
+        AllocatorStream& operator=(const AllocatorStream&);
+
+        void Expand(size_t count) {
+            SizeType newCapacity = capacity_ * 2;
+            if (newCapacity < length_ + count)
+                newCapacity = static_cast<SizeType>(length_ + count);
+            if (IsAllocated())
+                str_ = static_cast<Ch*>(allocator_.Realloc(str_, capacity_ * sizeof(Ch), newCapacity * sizeof(Ch)));
+            else {
+                str_ = static_cast<Ch*>(allocator_.Malloc(newCapacity * sizeof(Ch)));
+                std::memcpy(str_, buffer_, length_ * sizeof(Ch));
+            }
+            capacity_ = newCapacity;
+        }
+
+        // Short strings are copied by the handler, most of them into the values
+        static const SizeType kBufferCapacity = 32;
+        Ch buffer_[kBufferCapacity];
+    };
+
+    // Output stream dropping the characters, for Validate()
+    template<typename CharType>
+    class DiscardStream {
+    public:
+        typedef CharType Ch;
+
+        RAPIDJSONXML_FORCEINLINE void Put(Ch) {}
+    };
+
+    // Handler of Validate(), whose strings and numbers are only checked
+    struct ValidationHandler : BaseReaderHandler<TargetEncoding> {};
+
+    // Parse string and generate String event, or Key event for a member name. Different code paths for kParseInsituFlag.
+    template<unsigned parseFlags, typename InputStream, typename Handler>
+    void ParseString(InputStream& is, Handler& handler, bool isKey = false) {
+        if ((parseFlags & kParseBorrowStringsFlag) && !(parseFlags & (kParseInsituFlag | kParseValidateEncodingFlag)) &&
+                ParseBorrowedString(is, handler, isKey))
+            return;
+
+        if (parseFlags & kParseInsituFlag) {
+            internal::StreamLocalCopy<InputStream> copy(is);
+            InputStream& s(copy.s);
+            typename InputStream::Ch *head = s.PutBegin();
+            ParseStringToStream<parseFlags, SourceEncoding, SourceEncoding>(s, s);
+            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+            size_t length = s.PutEnd(head) - 1;
+            RAPIDJSONXML_ASSERT(length <= 0xFFFFFFFF);
+            const typename TargetEncoding::Ch* str = (typename TargetEncoding::Ch*)head;
+            if (!(isKey ? internal::KeyEvent<Handler>::Send(handler, str, SizeType(length), false) : handler.String(str, SizeType(length), false)))
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, s.Tell());
+        }
+        else
+            ParseStringToHandler<parseFlags>(is, handler, isKey, internal::BoolType<internal::HasAllocatedString<Handler>::Value>());
+    }
+
+    // Check a string without decoding it, for Validate()
+    template<unsigned parseFlags, typename InputStream>
+    void ParseString(InputStream& is, ValidationHandler&, bool = false) {
+        internal::StreamLocalCopy<InputStream> copy(is);
+        InputStream& s(copy.s);
+        DiscardStream<typename TargetEncoding::Ch> os;
+        ParseStringToStream<parseFlags, SourceEncoding, TargetEncoding>(s, os);
+    }
+
+    // Send a string without escapes as a pointer into the input, for kParseBorrowStringsFlag.
+    // Return false, leaving the input unchanged, when the string must be decoded.
+    template<typename InputStream, typename Handler>
+    bool ParseBorrowedString(InputStream&, Handler&, bool) {
+        return false;
+    }
+
+    template<typename Handler>
+    bool ParseBorrowedString(GenericStringStream<TargetEncoding>& is, Handler& handler, bool isKey) {
+        RAPIDJSONXML_ASSERT(is.Peek() == '\"');
+        const typename TargetEncoding::Ch* head = is.src_ + 1;
+        return SendBorrowedString(is, handler, isKey, head, ScanBorrowedString(head));
+    }
+
+    // End of the characters up to the next '"', '\\' or control character
+    template<typename CharType>
+    static const CharType* ScanBorrowedString(const CharType* p) {
+        while (*p != '"' && *p != '\\' && static_cast<unsigned>(*p) >= 0x20)
+            ++p;
+        return p;
+    }
+
+#ifdef RAPIDJSONXML_SIMD
+    static const char* ScanBorrowedString(const char* p) {
+        return p + ScanUnescapedString_SIMD(p);
+    }
+#endif
+
+    template<typename Handler>
+    bool ParseBorrowedString(MemoryStream& is, Handler& handler, bool isKey) {
+        RAPIDJSONXML_ASSERT(is.Peek() == '\"');
+        if (!internal::IsSame<typename TargetEncoding::Ch, char>::Value)
+            return false;
+        const char* head = is.src_ + 1;
+        const char* p = head;
+        while (p != is.end_ && *p != '"' && *p != '\\' && static_cast<unsigned char>(*p) >= 0x20)
+            ++p;
+        if (p == is.end_)
+            return false;
+        return SendBorrowedString(is, handler, isKey, reinterpret_cast<const typename TargetEncoding::Ch*>(head), reinterpret_cast<const typename TargetEncoding::Ch*>(p));
+    }
+
+    template<typename InputStream, typename Handler>
+    bool SendBorrowedString(InputStream& is, Handler& handler, bool isKey, const typename TargetEncoding::Ch* head, const typename TargetEncoding::Ch* end) {
+        if (*end != '"')
+            return false;
+        is.src_ = reinterpret_cast<const typename InputStream::Ch*>(end + 1);
+        const SizeType length = static_cast<SizeType>(end - head);
+        if (!(isKey ? internal::KeyEvent<Handler>::Send(handler, head, length, false) : handler.String(head, length, false)))
+            RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorTermination, is.Tell());
+        return true;
+    }
+
+    // Decode the string into stack_, for a copy by the handler
+    template<unsigned parseFlags, typename InputStream, typename Handler>
+    void ParseStringToHandler(InputStream& is, Handler& handler, bool isKey, internal::BoolType<false>) {
+        internal::StreamLocalCopy<InputStream> copy(is);
+        InputStream& s(copy.s);
+        StackStream<typename TargetEncoding::Ch> stackStream(stack_);
+        ParseStringToStream<parseFlags, SourceEncoding, TargetEncoding>(s, stackStream);
+        RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+        const typename TargetEncoding::Ch* str = stack_.template Pop<typename TargetEncoding::Ch>(stackStream.length_);
+        if (!(isKey ? internal::KeyEvent<Handler>::Send(handler, str, stackStream.length_ - 1, true) : handler.String(str, stackStream.length_ - 1, true)))
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, s.Tell());
+    }
+
+    // Decode the string directly into the memory of the handler, written once, unless it is short
+    template<unsigned parseFlags, typename InputStream, typename Handler>
+    void ParseStringToHandler(InputStream& is, Handler& handler, bool isKey, internal::BoolType<true>) {
+        internal::StreamLocalCopy<InputStream> copy(is);
+        InputStream& s(copy.s);
+        AllocatorStream<typename TargetEncoding::Ch, typename Handler::AllocatorType> os(handler.GetAllocator());
+        ParseStringToStream<parseFlags, SourceEncoding, TargetEncoding>(s, os);
+        if (HasParseError()) {
+            os.Release();
+            return;
+        }
+        const SizeType length = os.length_ - 1;
+        if (!(!os.IsAllocated() ?
+                (isKey ? internal::KeyEvent<Handler>::Send(handler, os.str_, length, true) : handler.String(os.str_, length, true)) :
+                handler.AllocatedString(os.Shrink(), length, isKey)))
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, s.Tell());
+    }
+
+    // Copy the characters up to the next '"', '\\' or control character at once, checking UTF-8 with kParseValidateEncodingFlag.
+    // The generic version does nothing, the characters are then transcoded one by one.
+    template<unsigned parseFlags, typename InputStream, typename OutputStream>
+    static RAPIDJSONXML_FORCEINLINE void ScanCopyUnescapedString(InputStream&, OutputStream&) {
+    }
+
+#ifdef RAPIDJSONXML_SIMD
+    // Length of these characters, up to an invalid UTF-8 sequence with kParseValidateEncodingFlag
+    template<unsigned parseFlags>
+    static RAPIDJSONXML_FORCEINLINE size_t ScanUnescapedString(const char* p) {
+        return (parseFlags & kParseValidateEncodingFlag) ? ScanUnescapedUtf8String_SIMD(p) : ScanUnescapedString_SIMD(p);
+    }
+
+    template<unsigned parseFlags>
+    static RAPIDJSONXML_FORCEINLINE void ScanCopyUnescapedString(StringStream& is, StackStream<char>& os) {
+        const size_t length = ScanUnescapedString<parseFlags>(is.src_);
+        if (length != 0) {
+            std::memcpy(os.stack_.template Push<char>(length), is.src_, length);
+            os.length_ += static_cast<SizeType>(length);
+            is.src_ += length;
+        }
+    }
+
+    template<unsigned parseFlags, typename StringAllocator>
+    static RAPIDJSONXML_FORCEINLINE void ScanCopyUnescapedString(StringStream& is, AllocatorStream<char, StringAllocator>& os) {
+        const size_t length = ScanUnescapedString<parseFlags>(is.src_);
+        if (length != 0) {
+            std::memcpy(os.Push(length), is.src_, length);
+            is.src_ += length;
+        }
+    }
+
+    template<unsigned parseFlags>
+    static RAPIDJSONXML_FORCEINLINE void ScanCopyUnescapedString(StringStream& is, DiscardStream<char>&) {
+        is.src_ = SkipUnescapedString<parseFlags>(is.src_);
+    }
+
+    template<unsigned parseFlags>
+    static RAPIDJSONXML_FORCEINLINE void ScanCopyUnescapedString(InsituStringStream& is, DiscardStream<char>&) {
+        is.src_ = const_cast<char*>(SkipUnescapedString<parseFlags>(is.src_));
+    }
+
+    // Short strings end before the SIMD instructions pay off
+    template<unsigned parseFlags>
+    static RAPIDJSONXML_FORCEINLINE const char* SkipUnescapedString(const char* p) {
+        for (const char* end = p + 8; p != end; ++p) {
+            if (*p == '"' || *p == '\\' || static_cast<unsigned char>(*p) < 0x20)
+                return p;
+            if ((parseFlags & kParseValidateEncodingFlag) && static_cast<unsigned char>(*p) >= 0x80)
+                break;
+        }
+        return p + ScanUnescapedString<parseFlags>(p);
+    }
+
+    template<unsigned parseFlags>
+    static RAPIDJSONXML_FORCEINLINE void ScanCopyUnescapedString(InsituStringStream& is, InsituStringStream& os) {
+        const size_t length = ScanUnescapedString<parseFlags>(is.src_);
+        if (length != 0) {
+            if (os.dst_ != is.src_) // shifted by previous escapes
+                std::memmove(os.dst_, is.src_, length);
+            os.dst_ += length;
+            is.src_ += length;
+        }
+    }
+#endif // RAPIDJSONXML_SIMD
+
+    // Parse string to an output is
+    // This function handles the prefix/suffix double quotes, escaping, and optional encoding validation.
+    template<unsigned parseFlags, typename SEncoding, typename TEncoding, typename InputStream, typename OutputStream>
+    RAPIDJSONXML_FORCEINLINE void ParseStringToStream(InputStream& is, OutputStream& os) {
+#define Z16 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+        static const char escape[256] = {
+            Z16, Z16, 0, 0,'\"', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,'/',
+            Z16, Z16, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,'\\', 0, 0, 0,
+            0, 0,'\b', 0, 0, 0,'\f', 0, 0, 0, 0, 0, 0, 0,'\n', 0,
+            0, 0,'\r', 0,'\t', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            Z16, Z16, Z16, Z16, Z16, Z16, Z16, Z16
+        };
+#undef Z16
+
+        RAPIDJSONXML_ASSERT(is.Peek() == '\"');
+        is.Take(); // Skip '\"'
+
+        for (;;) {
+            // Unchanged characters at once, when they need no transcoding, nor a validation other than UTF-8
+            if (internal::IsSame<SEncoding, TEncoding>::Value && (!(parseFlags & kParseValidateEncodingFlag) || internal::IsSame<SEncoding, UTF8<> >::Value))
+                ScanCopyUnescapedString<parseFlags>(is, os);
+
+            Ch c = is.Peek();
+            if (c == '\\') { // Escape
+                is.Take();
+                Ch e = is.Take();
+                if ((sizeof(Ch) == 1 || unsigned(e) < 256) && escape[(unsigned char)e]) {
+                    os.Put(escape[(unsigned char)e]);
+                }
+                else if (e == 'u') { // Unicode
+                    unsigned codepoint = ParseHex4(is);
+                    if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+                        // Handle UTF-16 surrogate pair
+                        if (is.Take() != '\\' || is.Take() != 'u')
+                            RAPIDJSONXML_PARSE_ERROR(kParseErrorStringUnicodeSurrogateInvalid, is.Tell() - 2);
+                        unsigned codepoint2 = ParseHex4(is);
+                        if (codepoint2 < 0xDC00 || codepoint2 > 0xDFFF)
+                            RAPIDJSONXML_PARSE_ERROR(kParseErrorStringUnicodeSurrogateInvalid, is.Tell() - 2);
+                        codepoint = (((codepoint - 0xD800) << 10) | (codepoint2 - 0xDC00)) + 0x10000;
+                    }
+                    TEncoding::Encode(os, codepoint);
+                }
+                else
+                    RAPIDJSONXML_PARSE_ERROR(kParseErrorStringEscapeInvalid, is.Tell() - 1);
+            }
+            else if (c == '"') { // Closing double quote
+                is.Take();
+                os.Put('\0'); // null-terminate the string
+                return;
+            }
+            else if (c == '\0')
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorStringMissQuotationMark, is.Tell() - 1);
+            else if ((unsigned)c < 0x20) // RFC 4627: unescaped = %x20-21 / %x23-5B / %x5D-10FFFF
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorStringEscapeInvalid, is.Tell() - 1);
+            else {
+                if (parseFlags & kParseValidateEncodingFlag ?
+                        !Transcoder<SEncoding, TEncoding>::Validate(is, os) :
+                        !Transcoder<SEncoding, TEncoding>::Transcode(is, os))
+                    RAPIDJSONXML_PARSE_ERROR(kParseErrorStringInvalidEncoding, is.Tell());
+            }
+        }
+    }
+
+    // Push the digits of a non-zero significand to stack_, when further digits do not fit in it
+    size_t PushDecimals(uint64_t significand) {
+        char* buffer = stack_.template Push<char>(20);
+        size_t length = static_cast<size_t>(internal::u64toa(significand, buffer) - buffer);
+        stack_.template Pop<char>(20 - length);
+        return length;
+    }
+
+    template<unsigned parseFlags, typename InputStream, typename Handler>
+    void ParseNumber(InputStream& is, Handler& handler) {
+        internal::StreamLocalCopy<InputStream> copy(is);
+        InputStream& s(copy.s);
+
+        // Parse minus
+        bool minus = false;
+        if (s.Peek() == '-') {
+            minus = true;
+            s.Take();
+        }
+
+        // Parse int: zero / ( digit1-9 *DIGIT )
+        unsigned i = 0;
+        uint64_t i64 = 0;
+        bool try64bit = false;
+        if (s.Peek() == '0') {
+            i = 0;
+            s.Take();
+        }
+        else if (s.Peek() >= '1' && s.Peek() <= '9' &&
+                 ParseIntegerDigits(s, minus ? UINT64_C(9223372036854775808) : UINT64_C(18446744073709551615), &i64)) {
+            // All the digits at once, the value fits in 64 bits
+            if (i64 > (minus ? 2147483648u : 4294967295u))
+                try64bit = true;
+            else
+                i = static_cast<unsigned>(i64);
+        }
+        else if (s.Peek() >= '1' && s.Peek() <= '9') {
+            i = static_cast<unsigned>(s.Take() - '0');
+
+            if (minus)
+                while (s.Peek() >= '0' && s.Peek() <= '9') {
+                    if (i >= 214748364) { // 2^31 = 2147483648
+                        if (i != 214748364 || s.Peek() > '8') {
+                            i64 = i;
+                            try64bit = true;
+                            break;
+                        }
+                    }
+                    i = i * 10 + static_cast<unsigned>(s.Take() - '0');
+                }
+            else
+                while (s.Peek() >= '0' && s.Peek() <= '9') {
+                    if (i >= 429496729) { // 2^32 - 1 = 4294967295
+                        if (i != 429496729 || s.Peek() > '5') {
+                            i64 = i;
+                            try64bit = true;
+                            break;
+                        }
+                    }
+                    i = i * 10 + static_cast<unsigned>(s.Take() - '0');
+                }
+        }
+        else
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorValueInvalid, s.Tell());
+
+        // Parse 64bit int
+        bool useDouble = false;
+        if (try64bit) {
+            if (minus)
+                while (s.Peek() >= '0' && s.Peek() <= '9') {
+                    if (i64 >= UINT64_C(922337203685477580)) // 2^63 = 9223372036854775808
+                        if (i64 != UINT64_C(922337203685477580) || s.Peek() > '8') {
+                            useDouble = true;
+                            break;
+                        }
+                    i64 = i64 * 10 + static_cast<unsigned>(s.Take() - '0');
+                }
+            else
+                while (s.Peek() >= '0' && s.Peek() <= '9') {
+                    if (i64 >= UINT64_C(1844674407370955161)) // 2^64 - 1 = 18446744073709551615
+                        if (i64 != UINT64_C(1844674407370955161) || s.Peek() > '5') {
+                            useDouble = true;
+                            break;
+                        }
+                    i64 = i64 * 10 + static_cast<unsigned>(s.Take() - '0');
+                }
+        }
+
+        // Force double for big integer
+        double d = 0.0;
+        size_t decimalLength = 0; // full precision: number of significant digits in stack_ when they do not fit in i64
+        if (useDouble && (parseFlags & kParseFullPrecisionFlag)) {
+            decimalLength = PushDecimals(i64);
+            while (s.Peek() >= '0' && s.Peek() <= '9') {
+                *stack_.template Push<char>() = static_cast<char>(s.Take());
+                decimalLength++;
+            }
+        }
+        else if (useDouble) {
+            d = (double)i64;
+            while (s.Peek() >= '0' && s.Peek() <= '9') {
+                if (d >= 1E307)
+                    RAPIDJSONXML_PARSE_ERROR(kParseErrorNumberTooBig, s.Tell());
+                d = d * 10 + (s.Take() - '0');
+            }
+        }
+
+        // Parse frac = decimal-point 1*DIGIT
+        int expFrac = 0;
+        if (s.Peek() == '.') {
+            if (!useDouble) {
+                if (!try64bit)
+                    i64 = i;
+                d = (double)i64;
+                useDouble = true;
+            }
+            s.Take();
+
+            if (parseFlags & kParseFullPrecisionFlag) {
+                if (!(s.Peek() >= '0' && s.Peek() <= '9'))
+                    RAPIDJSONXML_PARSE_ERROR(kParseErrorNumberMissFraction, s.Tell());
+
+                while (s.Peek() >= '0' && s.Peek() <= '9') {
+                    if (decimalLength == 0 && i64 <= UINT64_C(1844674407370955160)) // i64 * 10 + 9 <= 2^64 - 1
+                        i64 = i64 * 10 + static_cast<unsigned>(s.Take() - '0');
+                    else {
+                        if (decimalLength == 0)
+                            decimalLength = PushDecimals(i64);
+                        *stack_.template Push<char>() = static_cast<char>(s.Take());
+                        decimalLength++;
+                    }
+                    --expFrac;
+                }
+            }
+            else if (s.Peek() >= '0' && s.Peek() <= '9') {
+                d = d * 10 + (s.Take() - '0');
+                --expFrac;
+            }
+            else
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorNumberMissFraction, s.Tell());
+
+            while (s.Peek() >= '0' && s.Peek() <= '9') {
+                if (expFrac > -16) {
+                    d = d * 10 + (s.Peek() - '0');
+                    --expFrac;
+                }
+                s.Take();
+            }
+        }
+
+        // Parse exp = e [ minus / plus ] 1*DIGIT
+        int exp = 0;
+        if (s.Peek() == 'e' || s.Peek() == 'E') {
+            if (!useDouble) {
+                if (!try64bit)
+                    i64 = i;
+                d = (double)i64;
+                useDouble = true;
+            }
+            s.Take();
+
+            bool expMinus = false;
+            if (s.Peek() == '+')
+                s.Take();
+            else if (s.Peek() == '-') {
+                s.Take();
+                expMinus = true;
+            }
+
+            if (s.Peek() >= '0' && s.Peek() <= '9') {
+                exp = s.Take() - '0';
+                while (s.Peek() >= '0' && s.Peek() <= '9') {
+                    exp = exp * 10 + (s.Take() - '0');
+                    if (parseFlags & kParseFullPrecisionFlag) {
+                        if (exp > 99999999) // the significand digits cannot compensate, saturate
+                            exp = 99999999;
+                    }
+                    else if (exp > 308)
+                        RAPIDJSONXML_PARSE_ERROR(kParseErrorNumberTooBig, s.Tell());
+                }
+            }
+            else
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorNumberMissExponent, s.Tell());
+
+            if (expMinus)
+                exp = -exp;
+        }
+
+        // Finish parsing, call event according to the type of number.
+        bool cont = true;
+        if (useDouble && (parseFlags & kParseFullPrecisionFlag)) {
+            if (decimalLength > 0)
+                d = internal::StrtodFullPrecision(stack_.template Pop<char>(decimalLength), decimalLength, exp + expFrac);
+            else
+                d = internal::StrtodFullPrecision(i64, exp + expFrac);
+            if (d > DBL_MAX)
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorNumberTooBig, s.Tell());
+
+            cont = handler.Double(minus ? -d : d);
+        }
+        else if (useDouble) {
+            int expSum = exp + expFrac;
+            if (expSum < -308) {
+                // Prevent expSum < -308, making Pow10(expSum) = 0
+                d *= internal::Pow10(exp);
+                d *= internal::Pow10(expFrac);
+            }
+            else
+                d *= internal::Pow10(expSum);
+
+            cont = handler.Double(minus ? -d : d);
+        }
+        else {
+            if (try64bit) {
+                if (minus)
+                    cont = handler.Int64(-(int64_t)i64);
+                else
+                    cont = handler.Uint64(i64);
+            }
+            else {
+                if (minus)
+                    cont = handler.Int(-(int)i);
+                else
+                    cont = handler.Uint(i);
+            }
+        }
+        if (!cont)
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, s.Tell());
+    }
+
+    // Check a number without converting it, for Validate()
+    template<unsigned parseFlags, typename InputStream>
+    void ParseNumber(InputStream& is, ValidationHandler& handler) {
+        if (!ScanNumber(is))
+            ParseNumber<parseFlags, InputStream, ValidationHandler>(is, handler);
+    }
+
+    // Check the grammar of a number in memory, false to convert it instead.
+    // The generic version does not check anything.
+    template<typename InputStream>
+    bool ScanNumber(InputStream&) {
+        return false;
+    }
+
+    bool ScanNumber(StringStream& is) {
+        return ScanNumberInMemory(is);
+    }
+
+    bool ScanNumber(InsituStringStream& is) {
+        return ScanNumberInMemory(is);
+    }
+
+    // The numbers with more than 200 integer digits or 2 exponent digits may
+    // be too big for a double: they are converted to report the same error.
+    template<typename InputStream>
+    bool ScanNumberInMemory(InputStream& is) {
+        const char* p = is.src_;
+        if (*p == '-')
+            ++p;
+        const char* digits = p;
+        if (*p == '0')
+            ++p;
+        else if (*p >= '1' && *p <= '9') {
+            while (*++p >= '0' && *p <= '9')
+                ;
+            if (p - digits > 200)
+                return false;
+        }
+        else {
+            RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorValueInvalid, static_cast<size_t>(p - is.head_));
+            return true;
+        }
+
+        if (*p == '.') {
+            if (!(*++p >= '0' && *p <= '9')) {
+                RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorNumberMissFraction, static_cast<size_t>(p - is.head_));
+                return true;
+            }
+            while (*++p >= '0' && *p <= '9')
+                ;
+        }
+
+        if (*p == 'e' || *p == 'E') {
+            if (*++p == '+' || *p == '-')
+                ++p;
+            if (!(*p >= '0' && *p <= '9')) {
+                RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorNumberMissExponent, static_cast<size_t>(p - is.head_));
+                return true;
+            }
+            digits = p;
+            while (*++p >= '0' && *p <= '9')
+                ;
+            if (p - digits > 2)
+                return false;
+        }
+        is.src_ += p - is.src_;
+        return true;
+    }
+
+    // Parse any JSON value
+    template<unsigned parseFlags, typename InputStream, typename Handler>
+    void ParseValue(InputStream& is, Handler& handler) {
+        switch (is.Peek()) {
+        case 'n':
+            ParseNull  <parseFlags>(is, handler);
+            break;
+        case 't':
+            ParseTrue  <parseFlags>(is, handler);
             break;
         case 'f':
             ParseFalse <parseFlags>(is, handler);
@@ -928,435 +2487,1456 @@ private:
         }
     }
 
-    // Iterative Parsing
+    // Iterative Parsing
+
+    // States
+    enum IterativeParsingState {
+        IterativeParsingStartState = 0,
+        IterativeParsingFinishState,
+        IterativeParsingErrorState,
+
+        // Object states
+        IterativeParsingObjectInitialState,
+        IterativeParsingMemberKeyState,
+        IterativeParsingKeyValueDelimiterState,
+        IterativeParsingMemberValueState,
+        IterativeParsingMemberDelimiterState,
+        IterativeParsingObjectFinishState,
+
+        // Array states
+        IterativeParsingArrayInitialState,
+        IterativeParsingElementState,
+        IterativeParsingElementDelimiterState,
+        IterativeParsingArrayFinishState,
+
+        cIterativeParsingStateCount
+    };
+
+    // Tokens
+    enum Token {
+        LeftBracketToken = 0,
+        RightBracketToken,
+
+        LeftCurlyBracketToken,
+        RightCurlyBracketToken,
+
+        CommaToken,
+        ColonToken,
+
+        StringToken,
+        FalseToken,
+        TrueToken,
+        NullToken,
+        NumberToken,
+
+        kTokenCount
+    };
+
+    RAPIDJSONXML_FORCEINLINE Token Tokenize(Ch c) {
+#define N NumberToken
+#define N16 N,N,N,N,N,N,N,N,N,N,N,N,N,N,N,N
+        // Maps from ASCII to Token
+        static const unsigned char tokenMap[256] = {
+            N16, // 00~0F
+            N16, // 10~1F
+            N, N, StringToken, N, N, N, N, N, N, N, N, N, CommaToken, N, N, N, // 20~2F
+            N, N, N, N, N, N, N, N, N, N, ColonToken, N, N, N, N, N, // 30~3F
+            N16, // 40~4F
+            N, N, N, N, N, N, N, N, N, N, N, LeftBracketToken, N, RightBracketToken, N, N, // 50~5F
+            N, N, N, N, N, N, FalseToken, N, N, N, N, N, N, N, NullToken, N, // 60~6F
+            N, N, N, N, TrueToken, N, N, N, N, N, N, LeftCurlyBracketToken, N, RightCurlyBracketToken, N, N, // 70~7F
+            N16, N16, N16, N16, N16, N16, N16, N16 // 80~FF
+        };
+#undef N
+#undef N16
+
+        if (sizeof(Ch) == 1 || unsigned(c) < 256)
+            return (Token)tokenMap[(unsigned char)c];
+        else
+            return NumberToken;
+    }
+
+    RAPIDJSONXML_FORCEINLINE IterativeParsingState Predict(IterativeParsingState state, Token token) {
+        // current state x one lookahead token -> new state
+        static const char G[cIterativeParsingStateCount][kTokenCount] = {
+            // Start
+            {
+                IterativeParsingArrayInitialState,  // Left bracket
+                IterativeParsingErrorState,         // Right bracket
+                IterativeParsingObjectInitialState, // Left curly bracket
+                IterativeParsingErrorState,         // Right curly bracket
+                IterativeParsingErrorState,         // Comma
+                IterativeParsingErrorState,         // Colon
+                IterativeParsingErrorState,         // String
+                IterativeParsingErrorState,         // False
+                IterativeParsingErrorState,         // True
+                IterativeParsingErrorState,         // Null
+                IterativeParsingErrorState          // Number
+            },
+            // Finish(sink state)
+            {
+                IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState,
+                IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState,
+                IterativeParsingErrorState
+            },
+            // Error(sink state)
+            {
+                IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState,
+                IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState,
+                IterativeParsingErrorState
+            },
+            // ObjectInitial
+            {
+                IterativeParsingErrorState,         // Left bracket
+                IterativeParsingErrorState,         // Right bracket
+                IterativeParsingErrorState,         // Left curly bracket
+                IterativeParsingObjectFinishState,  // Right curly bracket
+                IterativeParsingErrorState,         // Comma
+                IterativeParsingErrorState,         // Colon
+                IterativeParsingMemberKeyState,     // String
+                IterativeParsingErrorState,         // False
+                IterativeParsingErrorState,         // True
+                IterativeParsingErrorState,         // Null
+                IterativeParsingErrorState          // Number
+            },
+            // MemberKey
+            {
+                IterativeParsingErrorState,             // Left bracket
+                IterativeParsingErrorState,             // Right bracket
+                IterativeParsingErrorState,             // Left curly bracket
+                IterativeParsingErrorState,             // Right curly bracket
+                IterativeParsingErrorState,             // Comma
+                IterativeParsingKeyValueDelimiterState, // Colon
+                IterativeParsingErrorState,             // String
+                IterativeParsingErrorState,             // False
+                IterativeParsingErrorState,             // True
+                IterativeParsingErrorState,             // Null
+                IterativeParsingErrorState              // Number
+            },
+            // KeyValueDelimiter
+            {
+                IterativeParsingArrayInitialState,      // Left bracket(push MemberValue state)
+                IterativeParsingErrorState,             // Right bracket
+                IterativeParsingObjectInitialState,     // Left curly bracket(push MemberValue state)
+                IterativeParsingErrorState,             // Right curly bracket
+                IterativeParsingErrorState,             // Comma
+                IterativeParsingErrorState,             // Colon
+                IterativeParsingMemberValueState,       // String
+                IterativeParsingMemberValueState,       // False
+                IterativeParsingMemberValueState,       // True
+                IterativeParsingMemberValueState,       // Null
+                IterativeParsingMemberValueState        // Number
+            },
+            // MemberValue
+            {
+                IterativeParsingErrorState,             // Left bracket
+                IterativeParsingErrorState,             // Right bracket
+                IterativeParsingErrorState,             // Left curly bracket
+                IterativeParsingObjectFinishState,      // Right curly bracket
+                IterativeParsingMemberDelimiterState,   // Comma
+                IterativeParsingErrorState,             // Colon
+                IterativeParsingErrorState,             // String
+                IterativeParsingErrorState,             // False
+                IterativeParsingErrorState,             // True
+                IterativeParsingErrorState,             // Null
+                IterativeParsingErrorState              // Number
+            },
+            // MemberDelimiter
+            {
+                IterativeParsingErrorState,         // Left bracket
+                IterativeParsingErrorState,         // Right bracket
+                IterativeParsingErrorState,         // Left curly bracket
+                IterativeParsingErrorState,         // Right curly bracket
+                IterativeParsingErrorState,         // Comma
+                IterativeParsingErrorState,         // Colon
+                IterativeParsingMemberKeyState,     // String
+                IterativeParsingErrorState,         // False
+                IterativeParsingErrorState,         // True
+                IterativeParsingErrorState,         // Null
+                IterativeParsingErrorState          // Number
+            },
+            // ObjectFinish(sink state)
+            {
+                IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState,
+                IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState,
+                IterativeParsingErrorState
+            },
+            // ArrayInitial
+            {
+                IterativeParsingArrayInitialState,      // Left bracket(push Element state)
+                IterativeParsingArrayFinishState,       // Right bracket
+                IterativeParsingObjectInitialState,     // Left curly bracket(push Element state)
+                IterativeParsingErrorState,             // Right curly bracket
+                IterativeParsingErrorState,             // Comma
+                IterativeParsingErrorState,             // Colon
+                IterativeParsingElementState,           // String
+                IterativeParsingElementState,           // False
+                IterativeParsingElementState,           // True
+                IterativeParsingElementState,           // Null
+                IterativeParsingElementState            // Number
+            },
+            // Element
+            {
+                IterativeParsingErrorState,             // Left bracket
+                IterativeParsingArrayFinishState,       // Right bracket
+                IterativeParsingErrorState,             // Left curly bracket
+                IterativeParsingErrorState,             // Right curly bracket
+                IterativeParsingElementDelimiterState,  // Comma
+                IterativeParsingErrorState,             // Colon
+                IterativeParsingErrorState,             // String
+                IterativeParsingErrorState,             // False
+                IterativeParsingErrorState,             // True
+                IterativeParsingErrorState,             // Null
+                IterativeParsingErrorState              // Number
+            },
+            // ElementDelimiter
+            {
+                IterativeParsingArrayInitialState,      // Left bracket(push Element state)
+                IterativeParsingErrorState,             // Right bracket
+                IterativeParsingObjectInitialState,     // Left curly bracket(push Element state)
+                IterativeParsingErrorState,             // Right curly bracket
+                IterativeParsingErrorState,             // Comma
+                IterativeParsingErrorState,             // Colon
+                IterativeParsingElementState,           // String
+                IterativeParsingElementState,           // False
+                IterativeParsingElementState,           // True
+                IterativeParsingElementState,           // Null
+                IterativeParsingElementState            // Number
+            },
+            // ArrayFinish(sink state)
+            {
+                IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState,
+                IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState,
+                IterativeParsingErrorState
+            }
+        }; // End of G
+
+        return (IterativeParsingState)G[state][token];
+    }
+
+    // Make an advance in the token stream and state based on the candidate destination state which was returned by Transit().
+    // May return a new state on state pop.
+    template <unsigned parseFlags, typename InputStream, typename Handler>
+    RAPIDJSONXML_FORCEINLINE IterativeParsingState Transit(IterativeParsingState src, Token token, IterativeParsingState dst, InputStream& is, Handler& handler) {
+        switch (dst) {
+        case IterativeParsingStartState:
+            RAPIDJSONXML_ASSERT(false);
+            return IterativeParsingErrorState;
+
+        case IterativeParsingFinishState:
+            return dst;
+
+        case IterativeParsingErrorState:
+            return dst;
+
+        case IterativeParsingObjectInitialState:
+        case IterativeParsingArrayInitialState:
+        {
+            // Push the state(Element or MemeberValue) if we are nested in another array or value of member.
+            // In this way we can get the correct state on ObjectFinish or ArrayFinish by frame pop.
+            IterativeParsingState n = src;
+            if (src == IterativeParsingArrayInitialState || src == IterativeParsingElementDelimiterState)
+                n = IterativeParsingElementState;
+            else if (src == IterativeParsingKeyValueDelimiterState)
+                n = IterativeParsingMemberValueState;
+            // Push current state.
+            *stack_.template Push<SizeType>(1) = n;
+            // Initialize and push the member/element count.
+            *stack_.template Push<SizeType>(1) = 0;
+            // Call handler
+            bool hr = (dst == IterativeParsingObjectInitialState) ? handler.StartObject(GenericAttributeIteratorPair<TargetEncoding>()) : handler.StartArray();
+            // On handler short circuits the parsing.
+            if (!hr) {
+                RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorTermination, is.Tell());
+                return IterativeParsingErrorState;
+            }
+            else {
+                is.Take();
+                return dst;
+            }
+        }
+
+        case IterativeParsingMemberKeyState:
+            ParseString<parseFlags>(is, handler, true);
+            if (HasParseError())
+                return IterativeParsingErrorState;
+            else
+                return dst;
+
+        case IterativeParsingKeyValueDelimiterState:
+            if (token == ColonToken) {
+                is.Take();
+                return dst;
+            }
+            else
+                return IterativeParsingErrorState;
+
+        case IterativeParsingMemberValueState:
+            // Must be non-compound value. Or it would be ObjectInitial or ArrayInitial state.
+            ParseValue<parseFlags>(is, handler);
+            if (HasParseError()) {
+                return IterativeParsingErrorState;
+            }
+            return dst;
+
+        case IterativeParsingElementState:
+            // Must be non-compound value. Or it would be ObjectInitial or ArrayInitial state.
+            ParseValue<parseFlags>(is, handler);
+            if (HasParseError()) {
+                return IterativeParsingErrorState;
+            }
+            return dst;
+
+        case IterativeParsingMemberDelimiterState:
+        case IterativeParsingElementDelimiterState:
+            is.Take();
+            // Update member/element count.
+            *stack_.template Top<SizeType>() = *stack_.template Top<SizeType>() + 1;
+            return dst;
+
+        case IterativeParsingObjectFinishState:
+        {
+            // Get member count.
+            SizeType c = *stack_.template Pop<SizeType>(1);
+            // If the object is not empty, count the last member.
+            if (src == IterativeParsingMemberValueState)
+                ++c;
+            // Restore the state.
+            IterativeParsingState n = static_cast<IterativeParsingState>(*stack_.template Pop<SizeType>(1));
+            // Transit to Finish state if this is the topmost scope.
+            if (n == IterativeParsingStartState)
+                n = IterativeParsingFinishState;
+            // Call handler
+            bool hr = handler.EndObject(c);
+            // On handler short circuits the parsing.
+            if (!hr) {
+                RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorTermination, is.Tell());
+                return IterativeParsingErrorState;
+            }
+            else {
+                is.Take();
+                return n;
+            }
+        }
+
+        case IterativeParsingArrayFinishState:
+        {
+            // Get element count.
+            SizeType c = *stack_.template Pop<SizeType>(1);
+            // If the array is not empty, count the last element.
+            if (src == IterativeParsingElementState)
+                ++c;
+            // Restore the state.
+            IterativeParsingState n = static_cast<IterativeParsingState>(*stack_.template Pop<SizeType>(1));
+            // Transit to Finish state if this is the topmost scope.
+            if (n == IterativeParsingStartState)
+                n = IterativeParsingFinishState;
+            // Call handler
+            bool hr = handler.EndArray(c);
+            // On handler short circuits the parsing.
+            if (!hr) {
+                RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorTermination, is.Tell());
+                return IterativeParsingErrorState;
+            }
+            else {
+                is.Take();
+                return n;
+            }
+        }
+
+        default:
+            RAPIDJSONXML_ASSERT(false);
+            return IterativeParsingErrorState;
+        }
+    }
+
+    template <typename InputStream>
+    void HandleError(IterativeParsingState src, InputStream& is) {
+        if (HasParseError()) {
+            // Error flag has been set.
+            return;
+        }
+
+        switch (src) {
+        case IterativeParsingStartState:
+            RAPIDJSONXML_PARSE_ERROR(is.Peek() == '\0' ? kParseErrorDocumentEmpty : kParseErrorDocumentRootNotObjectOrArray, is.Tell());
+        case IterativeParsingFinishState:
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorDocumentRootNotSingular, is.Tell());
+        case IterativeParsingObjectInitialState:
+        case IterativeParsingMemberDelimiterState:
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorObjectMissName, is.Tell());
+        case IterativeParsingMemberKeyState:
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorObjectMissColon, is.Tell());
+        case IterativeParsingMemberValueState:
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorObjectMissCommaOrCurlyBracket, is.Tell());
+        case IterativeParsingElementState:
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorArrayMissCommaOrSquareBracket, is.Tell());
+        default:
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorUnspecificSyntaxError, is.Tell());
+        }
+    }
+
+    template <unsigned parseFlags, typename InputStream, typename Handler>
+    ParseResult IterativeParse(InputStream& is, Handler& handler) {
+        parseResult_.Clear();
+        ClearStackOnExit scope(*this);
+        IterativeParsingState state = IterativeParsingStartState;
+
+        SkipWhitespace(is);
+        while (is.Peek() != '\0') {
+            Token t = Tokenize(is.Peek());
+            IterativeParsingState n = Predict(state, t);
+            IterativeParsingState d = Transit<parseFlags>(state, t, n, is, handler);
+
+            if (d == IterativeParsingErrorState) {
+                HandleError(state, is);
+                break;
+            }
+
+            state = d;
+
+            // Do not further consume streams if a root JSON has been parsed.
+            if ((parseFlags & kParseStopWhenDoneFlag) && state == IterativeParsingFinishState)
+                break;
+
+            SkipWhitespace(is);
+        }
+
+        // Handle the end of file.
+        if (state != IterativeParsingFinishState)
+            HandleError(state, is);
+
+        return parseResult_;
+    }
+
+    static const size_t kDefaultStackCapacity = 256; //!< Default stack capacity in bytes for storing a single decoded string.
+    internal::Stack<Allocator> stack_; //!< A stack for storing decoded string temporarily during non-destructive parsing.
+    internal::StructuralIndex<> structurals_; //!< Positions of the tokens with kParseStructuralIndexFlag.
+    ParseResult parseResult_;
+}; // class GenericReader
+
+//! Reader with UTF8 encoding and default allocator.
+typedef GenericReader<UTF8<>, UTF8<> > Reader;
+
+///////////////////////////////////////////////////////////////////////////////
+// GenericXmlReader
+
+//! SAX-style XML parser. Use \ref XmlReader for UTF8 encoding and default allocator.
+/*! GenericXmlReader parses XML text from a stream, and sends the events of the
+    Handler concept to an object implementing it, as GenericReader does for JSON
+    text. The XML text can then be loaded by GenericDocument::ParseXml() or
+    converted to JSON text by WriterJson.
+
+    The events are the ones sent by GenericValue::Accept():
+    - The text is an object, with a member for each top-level element.
+    - An element is an OpenTag() with its attributes, its value and a CloseTag().
+    - An element with child elements is an object, whose StartObject() also has
+      the attributes. Each child element is a member (repeated elements are
+      repeated members), each non-blank text between them a "#text" member.
+    - With \ref kParseXmlArraysFlag, consecutive sibling elements of the same
+      name, separated by blank text only, are one member whose value is an
+      array of their values, as WriterXml writes arrays: \c <a>1</a><a>2</a>
+      is \c {"a":[1,2]}. The attributes of the elements are the ones of the
+      array elements, sent by ElementAttributes() (see \ref Handler).
+      Repeated elements which are not consecutive stay repeated members.
+    - The text of an element without child elements is its value: "null",
+      "true", "false" and JSON numbers are sent as Null(), Bool() and number
+      events (numbers are always correctly rounded), any other text or text
+      with a CDATA section as String().
+    - An empty element is an empty String().
+
+    Comments, processing instructions and document type declarations are
+    skipped. The predefined entities and the character references are decoded.
+
+    It needs to allocate a stack for storing the names of the open elements,
+    the attributes of an element and a decoded text during non-destructive
+    parsing.
+
+    For in-situ parsing, the decoded texts and attribute values are directly
+    written to the source text string, only the names are copied to the stack.
+
+    A GenericXmlReader object can be reused for parsing multiple XML text.
+
+    \tparam SourceEncoding Encoding of the input stream.
+    \tparam TargetEncoding Encoding of the parse output.
+    \tparam Allocator Allocator type for stack.
+*/
+template <typename SourceEncoding, typename TargetEncoding, typename Allocator = MemoryPoolAllocator<> >
+class GenericXmlReader {
+public:
+    typedef typename SourceEncoding::Ch Ch; //!< SourceEncoding character type
+    typedef GenericAttribute<TargetEncoding> AttributeType; //!< Type of the attributes sent with OpenTag() and StartObject()
+    typedef GenericAttributeIteratorPair<TargetEncoding> AttributeIteratorPair;
+
+    //! Constructor.
+    /*! \param allocator Optional allocator for allocating stack memory.
+        \param stackCapacity stack capacity in bytes for storing names, attributes and a single decoded text.
+    */
+    GenericXmlReader(Allocator* allocator = 0, size_t stackCapacity = kDefaultStackCapacity) :
+        stack_(allocator, stackCapacity), attributeStack_(allocator, kDefaultAttributeCapacity),
+        siblings_(allocator, kDefaultSiblingCapacity), siblingCursor_(0), parseResult_() {}
+
+    //! Parse XML text.
+    /*! \tparam parseFlags Combination of \ref ParseFlag. \ref kParseIterativeFlag,
+            \ref kParseFullPrecisionFlag and \ref kParseBorrowStringsFlag have no effect,
+            \ref kParseStopWhenDoneFlag stops after the first top-level element.
+        \tparam InputStream Type of input stream, implementing Stream concept.
+        \tparam Handler Type of handler, implementing Handler concept.
+        \param is Input stream to be parsed.
+        \param handler The handler to receive events.
+        \return Whether the parsing is successful.
+    */
+    template <unsigned parseFlags, typename InputStream, typename Handler>
+    ParseResult Parse(InputStream& is, Handler& handler) {
+        parseResult_.Clear();
+
+        ClearStackOnExit scope(*this);
+
+        if (parseFlags & kParseXmlArraysFlag)
+            FindSameSiblings<parseFlags>(is);
+
+        SizeType elementCount = 0;
+        SizeType memberCount = 0;
+        Group group;
+        for (;;) {
+            SkipWhitespace(is);
+            if (is.Peek() == '\0')
+                break;
+            if (is.Peek() != '<') {
+                RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorXmlTextOutsideElement, is.Tell());
+                RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN(parseResult_);
+            }
+            is.Take();
+
+            if (is.Peek() == '?' || is.Peek() == '!')
+                SkipMarkup(is);
+            else {
+                if (elementCount == 0 && !handler.StartObject(AttributeIteratorPair()))
+                    RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorTermination, is.Tell());
+                else
+                    ParseMember<parseFlags>(is, handler, group, memberCount);
+                ++elementCount;
+            }
+            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN(parseResult_);
+
+            if ((parseFlags & kParseStopWhenDoneFlag) && elementCount > 0)
+                break;
+        }
+
+        if (group.count > 0) {
+            CloseGroup(is, handler, group);
+            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN(parseResult_);
+        }
+        if (elementCount == 0)
+            RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorDocumentEmpty, is.Tell());
+        else if (!handler.EndObject(memberCount))
+            RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorTermination, is.Tell());
+        return parseResult_;
+    }
+
+    //! Parse XML text (with \ref kParseDefaultFlags)
+    /*! \tparam InputStream Type of input stream, implementing Stream concept
+        \tparam Handler Type of handler, implementing Handler concept.
+        \param is Input stream to be parsed.
+        \param handler The handler to receive events.
+        \return Whether the parsing is successful.
+    */
+    template <typename InputStream, typename Handler>
+    ParseResult Parse(InputStream& is, Handler& handler) {
+        return Parse<kParseDefaultFlags>(is, handler);
+    }
+
+    //! Whether a parse error has occured in the last parsing.
+    bool HasParseError() const {
+        return parseResult_.IsError();
+    }
+
+    //! Get the \ref ParseErrorCode of last parsing.
+    ParseErrorCode GetParseErrorCode() const {
+        return parseResult_.Code();
+    }
+
+    //! Get the position of last parsing error in input, 0 otherwise.
+    size_t GetErrorOffset() const {
+        return parseResult_.Offset();
+    }
+
+private:
+    typedef typename TargetEncoding::Ch TargetCh;
+
+    // Prohibit copy constructor & assignment operator.
+    GenericXmlReader(const GenericXmlReader&);
+    GenericXmlReader& operator=(const GenericXmlReader&);
+
+    void ClearStack() {
+        stack_.Clear();
+        attributeStack_.Clear();
+        siblings_.Clear();
+        siblingCursor_ = 0;
+    }
+
+    // clear stack on any exit from ParseStream, e.g. due to exception
+    struct ClearStackOnExit {
+        explicit ClearStackOnExit(GenericXmlReader& r) : r_(r) {}
+        ~ClearStackOnExit() {
+            r_.ClearStack();
+        }
+    private:
+        GenericXmlReader& r_;
+        ClearStackOnExit(const ClearStackOnExit&);
+        ClearStackOnExit& operator=(const ClearStackOnExit&);
+    };
+
+    // Position of an attribute, whose strings are in stack_ (or in the source text for in-situ parsing)
+    struct AttributeOffsets {
+        size_t name;            // offset of the name in stack_
+        SizeType nameLength;
+        size_t value;           // offset of the value in stack_
+        const TargetCh* head;   // value in the source text for in-situ parsing
+        SizeType valueLength;
+    };
+
+    // Text of an element, in stack_ (or in the source text for in-situ parsing)
+    struct Text {
+        Text() : offset(0), head(0), length(0), cdata(false) {}
+        size_t offset;          // offset in stack_
+        const TargetCh* head;   // text in the source text for in-situ parsing
+        SizeType length;
+        bool cdata;             // has a CDATA section
+    };
+
+    // Consecutive sibling elements of the same name sent as an array, with kParseXmlArraysFlag
+    struct Group {
+        Group() : nameOffset(0), nameLength(0), count(0) {}
+        size_t nameOffset;      // offset of the name in stack_, kept while the group is open
+        SizeType nameLength;
+        SizeType count;         // number of elements, 0 when no group is open
+    };
+
+    // Element whose child elements are scanned ahead, with kParseXmlArraysFlag
+    struct ScannedElement {
+        size_t last;            // 1 + index of the last child element, 0 after non-blank text
+        const char* name;       // name of the last child element in the source text
+        size_t nameLength;
+    };
+
+    template<typename CharType>
+    class StackStream {
+    public:
+        typedef CharType Ch;
+
+        StackStream(internal::Stack<Allocator>& stack) : stack_(stack), length_(0) {}
+        RAPIDJSONXML_FORCEINLINE void Put(Ch c) {
+            *stack_.template Push<Ch>() = c;
+            ++length_;
+        }
+        internal::Stack<Allocator>& stack_;
+        SizeType length_;
+
+    private:
+        StackStream(const StackStream&);
+        StackStream& operator=(const StackStream&);
+    };
+
+    template<typename T>
+    T* StackAt(size_t offset) {
+        return reinterpret_cast<T*>(stack_.template Bottom<char>() + offset);
+    }
+
+    void PopTo(internal::Stack<Allocator>& stack, size_t size) {
+        stack.template Pop<char>(stack.GetSize() - size);
+    }
+
+    static bool IsNameStartChar(Ch c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':' || static_cast<unsigned>(c) >= 0x80;
+    }
+
+    static bool IsNameChar(Ch c) {
+        return IsNameStartChar(c) || (c >= '0' && c <= '9') || c == '-' || c == '.';
+    }
+
+    static bool IsWhitespace(TargetCh c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    // Parse a child element after its '<', as a member or as an element of the array of its group.
+    template<unsigned parseFlags, typename InputStream, typename Handler>
+    void ParseMember(InputStream& is, Handler& handler, Group& group, SizeType& memberCount) {
+        size_t nameOffset = stack_.GetSize();
+        const SizeType nameLength = ParseName<parseFlags>(is);
+        RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+
+        if (group.count > 0 && (nameLength != group.nameLength ||
+            std::memcmp(StackAt<TargetCh>(group.nameOffset), StackAt<TargetCh>(nameOffset), nameLength * sizeof(TargetCh)) != 0)) {
+            CloseGroup(is, handler, group);
+            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+            // The name takes the place of the one of the group
+            std::memmove(StackAt<TargetCh>(group.nameOffset), StackAt<TargetCh>(nameOffset), (nameLength + 1) * sizeof(TargetCh));
+            nameOffset = group.nameOffset;
+            PopTo(stack_, nameOffset + (nameLength + 1) * sizeof(TargetCh));
+        }
+        if (group.count == 0)
+            ++memberCount;
+        ParseElement<parseFlags>(is, handler, nameOffset, nameLength, group);
+    }
+
+    // Generate the EndArray and CloseTag events of a group. Its name is popped by the caller.
+    template<typename InputStream, typename Handler>
+    void CloseGroup(InputStream& is, Handler& handler, Group& group) {
+        const SizeType count = group.count;
+        group.count = 0;
+        if (!handler.EndArray(count) || !handler.CloseTag(StackAt<TargetCh>(group.nameOffset), group.nameLength, true))
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
+    }
+
+    // Parse an element after its name, and generate its OpenTag, value and CloseTag events.
+    // The first element of a group also opens its array, the next ones only generate their value.
+    template<unsigned parseFlags, typename InputStream, typename Handler>
+    void ParseElement(InputStream& is, Handler& handler, size_t nameOffset, SizeType nameLength, Group& group) {
+        const bool inGroup = group.count > 0;
+        const bool startsGroup = (parseFlags & kParseXmlArraysFlag) && NextSameSibling() && !inGroup;
+
+        // Attributes
+        const size_t attributeStringOffset = stack_.GetSize();
+        const size_t attributeOffset = attributeStack_.GetSize();
+        SizeType attributeCount = 0;
+        for (;;) {
+            SkipWhitespace(is);
+            if (is.Peek() == '>' || is.Peek() == '/')
+                break;
+            ParseAttribute<parseFlags>(is);
+            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+            ++attributeCount;
+        }
+
+        const bool empty = is.Peek() == '/';
+        if (empty)
+            is.Take();
+        if (is.Peek() != '>')
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorXmlTagMissGreaterThan, is.Tell());
+        is.Take();
+
+        // Content up to the first child element or the end tag
+        Text text;
+        if (!empty) {
+            ParseText<parseFlags>(is, text);
+            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+        }
+
+        const AttributeIteratorPair attribs = MakeAttributes(attributeOffset, attributeCount);
+        bool ret;
+        if (inGroup)
+            ret = internal::ElementAttributesEvent<Handler>::Send(handler, attribs);
+        else {
+            AttributeIteratorPair attribs_list[2];
+            attribs_list[startsGroup ? 1 : 0] = attribs; // the array itself has no attributes
+            ret = handler.OpenTag(StackAt<TargetCh>(nameOffset), nameLength, attribs_list, true) &&
+                (!startsGroup || (handler.StartArray() && internal::ElementAttributesEvent<Handler>::Send(handler, attribs)));
+        }
+        if (!ret)
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
+
+        if (empty || is.Peek() == '/') { // Text value
+            static const TargetCh kEmpty[] = { '\0' };
+            if (empty)
+                ret = handler.String(kEmpty, 0, false);
+            else {
+                is.Take();
+                ret = TextValue<parseFlags>(text, handler);
+            }
+            PopTo(stack_, attributeStringOffset);
+            PopTo(attributeStack_, attributeOffset);
+            if (!ret)
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
+        }
+        else { // Object value
+            if (!handler.StartObject(attribs))
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
+            PopTo(attributeStack_, attributeOffset);
+
+            SizeType memberCount = 0;
+            Group childGroup;
+            for (;;) {
+                const bool blank = IsBlank<parseFlags>(text);
+                if (childGroup.count > 0 && (!blank || is.Peek() == '/')) {
+                    CloseGroup(is, handler, childGroup);
+                    RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+                }
+                if (!blank) {
+                    static const TargetCh kTextName[] = { '#', 't', 'e', 'x', 't', '\0' };
+                    if (!handler.OpenTag(kTextName, 5, 0, false) ||
+                        !handler.String(TextString<parseFlags>(text), text.length, !(parseFlags & kParseInsituFlag)) ||
+                        !handler.CloseTag(kTextName, 5, false))
+                        RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
+                    ++memberCount;
+                }
+                // Text (and attributes for the first one), the name of an open group stays
+                PopTo(stack_, childGroup.count > 0 ? childGroup.nameOffset + (childGroup.nameLength + 1) * sizeof(TargetCh) : attributeStringOffset);
+
+                if (is.Peek() == '/') {
+                    is.Take();
+                    break;
+                }
+                ParseMember<parseFlags>(is, handler, childGroup, memberCount);
+                RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+
+                text = Text();
+                ParseText<parseFlags>(is, text);
+                RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+            }
+
+            if (!handler.EndObject(memberCount))
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
+        }
+
+        if (!empty) {
+            ParseEndTag<parseFlags>(is, nameOffset, nameLength);
+            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+        }
+        if (inGroup)
+            ++group.count;
+        else if (startsGroup) { // the name stays for the next elements of the group
+            group.nameOffset = nameOffset;
+            group.nameLength = nameLength;
+            group.count = 1;
+            return;
+        }
+        else if (!handler.CloseTag(StackAt<TargetCh>(nameOffset), nameLength, true))
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorTermination, is.Tell());
+        PopTo(stack_, nameOffset);
+    }
+
+    // Mark the elements followed by a sibling element of the same name, separated by blank text
+    // only, for kParseXmlArraysFlag. Only the text in memory is scanned ahead, other streams are
+    // not grouped.
+    template<unsigned parseFlags, typename InputStream>
+    void FindSameSiblings(InputStream&) {
+    }
+    template<unsigned parseFlags>
+    void FindSameSiblings(StringStream& is) {
+        FindSameSiblings<parseFlags>(is.src_, 0);
+    }
+    template<unsigned parseFlags>
+    void FindSameSiblings(InsituStringStream& is) {
+        FindSameSiblings<parseFlags>(is.src_, 0);
+    }
+    template<unsigned parseFlags>
+    void FindSameSiblings(MemoryStream& is) {
+        FindSameSiblings<parseFlags>(is.src_, is.end_);
+    }
+
+    // Scan the start tags in the order of the parsing, up to the end or a null character. The
+    // syntax errors are left to the parsing, which closes the arrays itself: a wrong mark can
+    // only split an array.
+    template<unsigned parseFlags>
+    void FindSameSiblings(const char* p, const char* end) {
+        RAPIDJSONXML_ASSERT(stack_.GetSize() == 0);
+        ScannedElement* e = new (stack_.template Push<ScannedElement>()) ScannedElement(); // top level
+        for (;;) {
+            char c = PeekAt(p, end);
+            if (c == '\0')
+                break;
+            ++p;
+            if (c != '<') {
+                if (!IsWhitespace(static_cast<TargetCh>(c)))
+                    stack_.template Top<ScannedElement>()->last = 0;
+                continue;
+            }
+
+            c = PeekAt(p, end);
+            if (c == '/') { // End tag
+                p = SkipPast(p, end, ">");
+                if (stack_.GetSize() > sizeof(ScannedElement))
+                    stack_.template Pop<ScannedElement>(1);
+            }
+            else if (c == '?')
+                p = SkipPast(p, end, "?>");
+            else if (c == '!') {
+                if (PeekAt(p + 1, end) == '-')
+                    p = SkipPast(p, end, "-->");
+                else if (PeekAt(p + 1, end) == '[') { // CDATA section, blank when only whitespace
+                    const char* cdata = p + 8; // after "![CDATA["
+                    p = SkipPast(p, end, "]]>");
+                    for (; cdata < p - 3 && IsWhitespace(static_cast<TargetCh>(*cdata)); ++cdata)
+                        ;
+                    if (cdata < p - 3)
+                        stack_.template Top<ScannedElement>()->last = 0;
+                }
+                else
+                    p = SkipPast(p, end, ">");
+            }
+            else if (IsNameStartChar(static_cast<Ch>(c))) { // Start tag
+                const char* name = p;
+                while (IsNameChar(static_cast<Ch>(PeekAt(p, end))))
+                    ++p;
+                const size_t nameLength = static_cast<size_t>(p - name);
+                const size_t index = siblings_.GetSize();
+                *siblings_.template Push<char>() = 0;
+                e = stack_.template Top<ScannedElement>();
+                const bool topLevel = stack_.GetSize() == sizeof(ScannedElement);
+                if (e->last != 0 && e->nameLength == nameLength && std::memcmp(e->name, name, nameLength) == 0 &&
+                    !(topLevel && (parseFlags & kParseStopWhenDoneFlag)))
+                    siblings_.template Bottom<char>()[e->last - 1] = 1;
+                e->last = index + 1;
+                e->name = name;
+                e->nameLength = nameLength;
+
+                // Attributes, up to the '>' out of their values
+                char quote = 0, previous = 0;
+                for (c = PeekAt(p, end); c != '\0' && (quote != 0 || c != '>'); c = PeekAt(++p, end)) {
+                    if (quote != 0)
+                        quote = c == quote ? 0 : quote;
+                    else if (c == '"' || c == '\'')
+                        quote = c;
+                    previous = c;
+                }
+                if (c == '\0')
+                    break;
+                ++p;
+                if (previous != '/') // not an empty element
+                    new (stack_.template Push<ScannedElement>()) ScannedElement();
+            }
+        }
+        stack_.Clear();
+    }
+
+    // Character of a text in memory, '\0' at its end (null for a null-terminated text).
+    static char PeekAt(const char* p, const char* end) {
+        return p != end ? *p : '\0';
+    }
 
-    // States
-    enum IterativeParsingState {
-        IterativeParsingStartState = 0,
-        IterativeParsingFinishState,
-        IterativeParsingErrorState,
+    // Position after the next occurrence of a terminator, or the end of the text.
+    static const char* SkipPast(const char* p, const char* end, const char* terminator) {
+        for (; PeekAt(p, end) != '\0'; ++p) {
+            size_t i = 0;
+            while (terminator[i] != '\0' && PeekAt(p + i, end) == terminator[i])
+                ++i;
+            if (terminator[i] == '\0')
+                return p + i;
+        }
+        return p;
+    }
 
-        // Object states
-        IterativeParsingObjectInitialState,
-        IterativeParsingMemberKeyState,
-        IterativeParsingKeyValueDelimiterState,
-        IterativeParsingMemberValueState,
-        IterativeParsingMemberDelimiterState,
-        IterativeParsingObjectFinishState,
+    // Whether the element being parsed is followed by a sibling of the same name.
+    bool NextSameSibling() {
+        return siblingCursor_ < siblings_.GetSize() && siblings_.template Bottom<char>()[siblingCursor_++] != 0;
+    }
 
-        // Array states
-        IterativeParsingArrayInitialState,
-        IterativeParsingElementState,
-        IterativeParsingElementDelimiterState,
-        IterativeParsingArrayFinishState,
+    // Parse an end tag after its "</", which must match the start tag.
+    template<unsigned parseFlags, typename InputStream>
+    void ParseEndTag(InputStream& is, size_t nameOffset, SizeType nameLength) {
+        const size_t tell = is.Tell();
+        const size_t endNameOffset = stack_.GetSize();
+        const SizeType endNameLength = ParseName<parseFlags>(is);
+        if (HasParseError() || endNameLength != nameLength ||
+            std::memcmp(StackAt<TargetCh>(nameOffset), StackAt<TargetCh>(endNameOffset), nameLength * sizeof(TargetCh)) != 0) {
+            parseResult_.Clear();
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorXmlTagMismatch, tell);
+        }
+        PopTo(stack_, endNameOffset);
 
-        cIterativeParsingStateCount
-    };
+        SkipWhitespace(is);
+        if (is.Peek() != '>')
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorXmlTagMissGreaterThan, is.Tell());
+        is.Take();
+    }
 
-    // Tokens
-    enum Token {
-        LeftBracketToken = 0,
-        RightBracketToken,
+    // Parse a name to stack_, null-terminated, and return its length.
+    template<unsigned parseFlags, typename InputStream>
+    SizeType ParseName(InputStream& is) {
+        if (!IsNameStartChar(is.Peek())) {
+            RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorXmlNameInvalid, is.Tell());
+            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN(0);
+        }
 
-        LeftCurlyBracketToken,
-        RightCurlyBracketToken,
+        StackStream<TargetCh> stackStream(stack_);
+        do {
+            if (static_cast<unsigned>(is.Peek()) < 0x80)
+                stackStream.Put(static_cast<TargetCh>(is.Take()));
+            else {
+                TranscodeChar<parseFlags, SourceEncoding, TargetEncoding>(is, stackStream);
+                RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN(0);
+            }
+        } while (IsNameChar(is.Peek()));
+        stackStream.Put('\0');
+        return stackStream.length_ - 1;
+    }
 
-        CommaToken,
-        ColonToken,
+    // Parse an attribute: its name and value are kept until the events of the element.
+    template<unsigned parseFlags, typename InputStream>
+    void ParseAttribute(InputStream& is) {
+        AttributeOffsets a;
+        a.name = stack_.GetSize();
+        a.nameLength = ParseName<parseFlags>(is);
+        RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
 
-        StringToken,
-        FalseToken,
-        TrueToken,
-        NullToken,
-        NumberToken,
+        SkipWhitespace(is);
+        if (is.Peek() != '=')
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorXmlAttributeMissEquals, is.Tell());
+        is.Take();
+        SkipWhitespace(is);
 
-        kTokenCount
-    };
+        const Ch quote = is.Peek();
+        if (quote != '"' && quote != '\'')
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorXmlAttributeMissQuotationMark, is.Tell());
+        is.Take();
 
-    RAPIDJSONXML_FORCEINLINE Token Tokenize(Ch c) {
-#define N NumberToken
-#define N16 N,N,N,N,N,N,N,N,N,N,N,N,N,N,N,N
-        // Maps from ASCII to Token
-        static const unsigned char tokenMap[256] = {
-            N16, // 00~0F
-            N16, // 10~1F
-            N, N, StringToken, N, N, N, N, N, N, N, N, N, CommaToken, N, N, N, // 20~2F
-            N, N, N, N, N, N, N, N, N, N, ColonToken, N, N, N, N, N, // 30~3F
-            N16, // 40~4F
-            N, N, N, N, N, N, N, N, N, N, N, LeftBracketToken, N, RightBracketToken, N, N, // 50~5F
-            N, N, N, N, N, N, FalseToken, N, N, N, N, N, N, N, NullToken, N, // 60~6F
-            N, N, N, N, TrueToken, N, N, N, N, N, N, LeftCurlyBracketToken, N, RightCurlyBracketToken, N, N, // 70~7F
-            N16, N16, N16, N16, N16, N16, N16, N16 // 80~FF
-        };
-#undef N
-#undef N16
+        internal::StreamLocalCopy<InputStream> copy(is);
+        InputStream& s(copy.s);
 
-        if (sizeof(Ch) == 1 || unsigned(c) < 256)
-            return (Token)tokenMap[(unsigned char)c];
-        else
-            return NumberToken;
+        a.value = stack_.GetSize();
+        if (parseFlags & kParseInsituFlag) {
+            typename InputStream::Ch *head = s.PutBegin();
+            ParseAttributeValueToStream<parseFlags, SourceEncoding, SourceEncoding>(s, s, quote);
+            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+            size_t length = s.PutEnd(head) - 1;
+            RAPIDJSONXML_ASSERT(length <= 0xFFFFFFFF);
+            a.head = (const TargetCh*)head;
+            a.valueLength = SizeType(length);
+        }
+        else {
+            StackStream<TargetCh> stackStream(stack_);
+            ParseAttributeValueToStream<parseFlags, SourceEncoding, TargetEncoding>(s, stackStream, quote);
+            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+            a.head = 0;
+            a.valueLength = stackStream.length_ - 1;
+        }
+        *attributeStack_.template Push<AttributeOffsets>() = a;
     }
 
-    RAPIDJSONXML_FORCEINLINE IterativeParsingState Predict(IterativeParsingState state, Token token) {
-        // current state x one lookahead token -> new state
-        static const char G[cIterativeParsingStateCount][kTokenCount] = {
-            // Start
-            {
-                IterativeParsingArrayInitialState,  // Left bracket
-                IterativeParsingErrorState,         // Right bracket
-                IterativeParsingObjectInitialState, // Left curly bracket
-                IterativeParsingErrorState,         // Right curly bracket
-                IterativeParsingErrorState,         // Comma
-                IterativeParsingErrorState,         // Colon
-                IterativeParsingErrorState,         // String
-                IterativeParsingErrorState,         // False
-                IterativeParsingErrorState,         // True
-                IterativeParsingErrorState,         // Null
-                IterativeParsingErrorState          // Number
-            },
-            // Finish(sink state)
-            {
-                IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState,
-                IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState,
-                IterativeParsingErrorState
-            },
-            // Error(sink state)
-            {
-                IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState,
-                IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState,
-                IterativeParsingErrorState
-            },
-            // ObjectInitial
-            {
-                IterativeParsingErrorState,         // Left bracket
-                IterativeParsingErrorState,         // Right bracket
-                IterativeParsingErrorState,         // Left curly bracket
-                IterativeParsingObjectFinishState,  // Right curly bracket
-                IterativeParsingErrorState,         // Comma
-                IterativeParsingErrorState,         // Colon
-                IterativeParsingMemberKeyState,     // String
-                IterativeParsingErrorState,         // False
-                IterativeParsingErrorState,         // True
-                IterativeParsingErrorState,         // Null
-                IterativeParsingErrorState          // Number
-            },
-            // MemberKey
-            {
-                IterativeParsingErrorState,             // Left bracket
-                IterativeParsingErrorState,             // Right bracket
-                IterativeParsingErrorState,             // Left curly bracket
-                IterativeParsingErrorState,             // Right curly bracket
-                IterativeParsingErrorState,             // Comma
-                IterativeParsingKeyValueDelimiterState, // Colon
-                IterativeParsingErrorState,             // String
-                IterativeParsingErrorState,             // False
-                IterativeParsingErrorState,             // True
-                IterativeParsingErrorState,             // Null
-                IterativeParsingErrorState              // Number
-            },
-            // KeyValueDelimiter
-            {
-                IterativeParsingArrayInitialState,      // Left bracket(push MemberValue state)
-                IterativeParsingErrorState,             // Right bracket
-                IterativeParsingObjectInitialState,     // Left curly bracket(push MemberValue state)
-                IterativeParsingErrorState,             // Right curly bracket
-                IterativeParsingErrorState,             // Comma
-                IterativeParsingErrorState,             // Colon
-                IterativeParsingMemberValueState,       // String
-                IterativeParsingMemberValueState,       // False
-                IterativeParsingMemberValueState,       // True
-                IterativeParsingMemberValueState,       // Null
-                IterativeParsingMemberValueState        // Number
-            },
-            // MemberValue
-            {
-                IterativeParsingErrorState,             // Left bracket
-                IterativeParsingErrorState,             // Right bracket
-                IterativeParsingErrorState,             // Left curly bracket
-                IterativeParsingObjectFinishState,      // Right curly bracket
-                IterativeParsingMemberDelimiterState,   // Comma
-                IterativeParsingErrorState,             // Colon
-                IterativeParsingErrorState,             // String
-                IterativeParsingErrorState,             // False
-                IterativeParsingErrorState,             // True
-                IterativeParsingErrorState,             // Null
-                IterativeParsingErrorState              // Number
-            },
-            // MemberDelimiter
-            {
-                IterativeParsingErrorState,         // Left bracket
-                IterativeParsingErrorState,         // Right bracket
-                IterativeParsingErrorState,         // Left curly bracket
-                IterativeParsingErrorState,         // Right curly bracket
-                IterativeParsingErrorState,         // Comma
-                IterativeParsingErrorState,         // Colon
-                IterativeParsingMemberKeyState,     // String
-                IterativeParsingErrorState,         // False
-                IterativeParsingErrorState,         // True
-                IterativeParsingErrorState,         // Null
-                IterativeParsingErrorState          // Number
-            },
-            // ObjectFinish(sink state)
-            {
-                IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState,
-                IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState,
-                IterativeParsingErrorState
-            },
-            // ArrayInitial
-            {
-                IterativeParsingArrayInitialState,      // Left bracket(push Element state)
-                IterativeParsingArrayFinishState,       // Right bracket
-                IterativeParsingObjectInitialState,     // Left curly bracket(push Element state)
-                IterativeParsingErrorState,             // Right curly bracket
-                IterativeParsingErrorState,             // Comma
-                IterativeParsingErrorState,             // Colon
-                IterativeParsingElementState,           // String
-                IterativeParsingElementState,           // False
-                IterativeParsingElementState,           // True
-                IterativeParsingElementState,           // Null
-                IterativeParsingElementState            // Number
-            },
-            // Element
-            {
-                IterativeParsingErrorState,             // Left bracket
-                IterativeParsingArrayFinishState,       // Right bracket
-                IterativeParsingErrorState,             // Left curly bracket
-                IterativeParsingErrorState,             // Right curly bracket
-                IterativeParsingElementDelimiterState,  // Comma
-                IterativeParsingErrorState,             // Colon
-                IterativeParsingErrorState,             // String
-                IterativeParsingErrorState,             // False
-                IterativeParsingErrorState,             // True
-                IterativeParsingErrorState,             // Null
-                IterativeParsingErrorState              // Number
-            },
-            // ElementDelimiter
-            {
-                IterativeParsingArrayInitialState,      // Left bracket(push Element state)
-                IterativeParsingErrorState,             // Right bracket
-                IterativeParsingObjectInitialState,     // Left curly bracket(push Element state)
-                IterativeParsingErrorState,             // Right curly bracket
-                IterativeParsingErrorState,             // Comma
-                IterativeParsingErrorState,             // Colon
-                IterativeParsingElementState,           // String
-                IterativeParsingElementState,           // False
-                IterativeParsingElementState,           // True
-                IterativeParsingElementState,           // Null
-                IterativeParsingElementState            // Number
-            },
-            // ArrayFinish(sink state)
-            {
-                IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState,
-                IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState, IterativeParsingErrorState,
-                IterativeParsingErrorState
+    // Parse an attribute value up to the closing quotation mark, null-terminated.
+    template<unsigned parseFlags, typename SEncoding, typename TEncoding, typename InputStream, typename OutputStream>
+    void ParseAttributeValueToStream(InputStream& is, OutputStream& os, Ch quote) {
+        for (;;) {
+            Ch c = is.Peek();
+            if (c == quote) {
+                is.Take();
+                os.Put('\0'); // null-terminate the string
+                return;
             }
-        }; // End of G
+            else if (c == '&')
+                ParseEntity<TEncoding>(is, os);
+            else if (c == '<')
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorXmlAttributeValueInvalid, is.Tell());
+            else if (c == '\0')
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorXmlAttributeMissQuotationMark, is.Tell());
+            else
+                TranscodeChar<parseFlags, SEncoding, TEncoding>(is, os);
+            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+        }
+    }
+
+    // Build the attributes of an element, once stack_ does not grow until their events.
+    AttributeIteratorPair MakeAttributes(size_t attributeOffset, SizeType attributeCount) {
+        if (attributeCount == 0)
+            return AttributeIteratorPair();
+        AttributeType* attributes = attributeStack_.template Push<AttributeType>(attributeCount);
+        const AttributeOffsets* a = reinterpret_cast<const AttributeOffsets*>(attributeStack_.template Bottom<char>() + attributeOffset);
+        for (SizeType i = 0; i < attributeCount; i++, a++) {
+            const TargetCh* value = a->head ? a->head : StackAt<TargetCh>(a->value);
+            new (attributes + i) AttributeType(StringRef(StackAt<TargetCh>(a->name), a->nameLength), StringRef(value, a->valueLength));
+        }
+        return AttributeIteratorPair(attributes, attributes + attributeCount);
+    }
+
+    // Parse the text of an element up to a child element or the end tag, after their '<'.
+    // Different code paths for kParseInsituFlag.
+    template<unsigned parseFlags, typename InputStream>
+    void ParseText(InputStream& is, Text& text) {
+        internal::StreamLocalCopy<InputStream> copy(is);
+        InputStream& s(copy.s);
+
+        if (parseFlags & kParseInsituFlag) {
+            typename InputStream::Ch *head = s.PutBegin();
+            ParseTextToStream<parseFlags, SourceEncoding, SourceEncoding>(s, s, text);
+            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+            size_t length = s.PutEnd(head) - 1;
+            RAPIDJSONXML_ASSERT(length <= 0xFFFFFFFF);
+            text.head = (const TargetCh*)head;
+            text.length = SizeType(length);
+        }
+        else {
+            text.offset = stack_.GetSize();
+            StackStream<TargetCh> stackStream(stack_);
+            ParseTextToStream<parseFlags, SourceEncoding, TargetEncoding>(s, stackStream, text);
+            RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+            text.length = stackStream.length_ - 1;
+        }
+    }
 
-        return (IterativeParsingState)G[state][token];
+    // Copy the characters up to the next '<' or '&' at once.
+    // The generic version does nothing, the characters are then transcoded one by one.
+    template<typename InputStream, typename OutputStream>
+    static RAPIDJSONXML_FORCEINLINE void ScanCopyText(InputStream&, OutputStream&) {
     }
 
-    // Make an advance in the token stream and state based on the candidate destination state which was returned by Transit().
-    // May return a new state on state pop.
-    template <unsigned parseFlags, typename InputStream, typename Handler>
-    RAPIDJSONXML_FORCEINLINE IterativeParsingState Transit(IterativeParsingState src, Token token, IterativeParsingState dst, InputStream& is, Handler& handler) {
-        switch (dst) {
-        case IterativeParsingStartState:
-            RAPIDJSONXML_ASSERT(false);
-            return IterativeParsingErrorState;
+#ifdef RAPIDJSONXML_SIMD
+    static RAPIDJSONXML_FORCEINLINE void ScanCopyText(StringStream& is, StackStream<char>& os) {
+        const size_t length = ScanXmlText_SIMD(is.src_);
+        if (length != 0) {
+            std::memcpy(os.stack_.template Push<char>(length), is.src_, length);
+            os.length_ += static_cast<SizeType>(length);
+            is.src_ += length;
+        }
+    }
 
-        case IterativeParsingFinishState:
-            return dst;
+    static RAPIDJSONXML_FORCEINLINE void ScanCopyText(InsituStringStream& is, InsituStringStream& os) {
+        const size_t length = ScanXmlText_SIMD(is.src_);
+        if (length != 0) {
+            if (os.dst_ != is.src_) // shifted by previous entities
+                std::memmove(os.dst_, is.src_, length);
+            os.dst_ += length;
+            is.src_ += length;
+        }
+    }
+#endif // RAPIDJSONXML_SIMD
 
-        case IterativeParsingErrorState:
-            return dst;
+    // Parse text to an output stream, null-terminated, up to a child element or an end tag.
+    // The text of CDATA sections is appended, comments and processing instructions are skipped.
+    template<unsigned parseFlags, typename SEncoding, typename TEncoding, typename InputStream, typename OutputStream>
+    RAPIDJSONXML_FORCEINLINE void ParseTextToStream(InputStream& is, OutputStream& os, Text& text) {
+        for (;;) {
+            // Unchanged characters at once, when they need neither transcoding nor validation
+            if (!(parseFlags & kParseValidateEncodingFlag) && internal::IsSame<SEncoding, TEncoding>::Value)
+                ScanCopyText(is, os);
 
-        case IterativeParsingObjectInitialState:
-        case IterativeParsingArrayInitialState:
-        {
-            // Push the state(Element or MemeberValue) if we are nested in another array or value of member.
-            // In this way we can get the correct state on ObjectFinish or ArrayFinish by frame pop.
-            IterativeParsingState n = src;
-            if (src == IterativeParsingArrayInitialState || src == IterativeParsingElementDelimiterState)
-                n = IterativeParsingElementState;
-            else if (src == IterativeParsingKeyValueDelimiterState)
-                n = IterativeParsingMemberValueState;
-            // Push current state.
-            *stack_.template Push<SizeType>(1) = n;
-            // Initialize and push the member/element count.
-            *stack_.template Push<SizeType>(1) = 0;
-            // Call handler
-            bool hr = (dst == IterativeParsingObjectInitialState) ? handler.StartObject(GenericAttributeIteratorPair<TargetEncoding>()) : handler.StartArray();
-            // On handler short circuits the parsing.
-            if (!hr) {
-                RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorTermination, is.Tell());
-                return IterativeParsingErrorState;
+            Ch c = is.Peek();
+            if (c == '<') {
+                is.Take();
+                c = is.Peek();
+                if (c == '?') {
+                    SkipMarkup(is);
+                    RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+                }
+                else if (c == '!') {
+                    is.Take();
+                    if (is.Peek() == '[') {
+                        ParseCData<parseFlags, SEncoding, TEncoding>(is, os);
+                        text.cdata = true;
+                    }
+                    else
+                        SkipDeclaration(is);
+                    RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+                }
+                else {
+                    os.Put('\0'); // null-terminate the string, after taking the '<' for in-situ parsing
+                    return;
+                }
             }
+            else if (c == '&') {
+                ParseEntity<TEncoding>(is, os);
+                RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
+            }
+            else if (c == '\0')
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorXmlElementUnterminated, is.Tell());
             else {
-                is.Take();
-                return dst;
+                TranscodeChar<parseFlags, SEncoding, TEncoding>(is, os);
+                RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
             }
         }
+    }
 
-        case IterativeParsingMemberKeyState:
-            ParseString<parseFlags>(is, handler);
-            if (HasParseError())
-                return IterativeParsingErrorState;
-            else
-                return dst;
+    // Parse the text of a CDATA section after its "<!", up to its "]]>".
+    template<unsigned parseFlags, typename SEncoding, typename TEncoding, typename InputStream, typename OutputStream>
+    void ParseCData(InputStream& is, OutputStream& os) {
+        static const char kCData[] = "[CDATA[";
+        for (const char* p = kCData; *p; ++p)
+            if (is.Take() != *p)
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorXmlMarkupInvalid, is.Tell() - 1);
 
-        case IterativeParsingKeyValueDelimiterState:
-            if (token == ColonToken) {
+        unsigned brackets = 0; // pending ']', up to two
+        for (;;) {
+            Ch c = is.Peek();
+            if (c == ']') {
                 is.Take();
-                return dst;
+                if (brackets == 2)
+                    os.Put(']');
+                else
+                    ++brackets;
             }
-            else
-                return IterativeParsingErrorState;
-
-        case IterativeParsingMemberValueState:
-            // Must be non-compound value. Or it would be ObjectInitial or ArrayInitial state.
-            ParseValue<parseFlags>(is, handler);
-            if (HasParseError()) {
-                return IterativeParsingErrorState;
+            else if (c == '>' && brackets == 2) {
+                is.Take();
+                return;
             }
-            return dst;
-
-        case IterativeParsingElementState:
-            // Must be non-compound value. Or it would be ObjectInitial or ArrayInitial state.
-            ParseValue<parseFlags>(is, handler);
-            if (HasParseError()) {
-                return IterativeParsingErrorState;
+            else if (c == '\0')
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorXmlMarkupInvalid, is.Tell());
+            else {
+                for (; brackets > 0; --brackets)
+                    os.Put(']');
+                TranscodeChar<parseFlags, SEncoding, TEncoding>(is, os);
+                RAPIDJSONXML_PARSE_ERROR_EARLY_RETURN_VOID;
             }
-            return dst;
+        }
+    }
 
-        case IterativeParsingMemberDelimiterState:
-        case IterativeParsingElementDelimiterState:
+    // Skip a comment, a processing instruction or a declaration after its '<'.
+    template<typename InputStream>
+    void SkipMarkup(InputStream& is) {
+        if (is.Take() == '?')
+            SkipToEnd(is, '?', 1);
+        else
+            SkipDeclaration(is);
+    }
+
+    // Skip a comment or a declaration after its "<!".
+    template<typename InputStream>
+    void SkipDeclaration(InputStream& is) {
+        if (is.Peek() == '-') { // Comment
             is.Take();
-            // Update member/element count.
-            *stack_.template Top<SizeType>() = *stack_.template Top<SizeType>() + 1;
-            return dst;
+            if (is.Take() != '-')
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorXmlMarkupInvalid, is.Tell() - 1);
+            SkipToEnd(is, '-', 2);
+            return;
+        }
 
-        case IterativeParsingObjectFinishState:
-        {
-            // Get member count.
-            SizeType c = *stack_.template Pop<SizeType>(1);
-            // If the object is not empty, count the last member.
-            if (src == IterativeParsingMemberValueState)
-                ++c;
-            // Restore the state.
-            IterativeParsingState n = static_cast<IterativeParsingState>(*stack_.template Pop<SizeType>(1));
-            // Transit to Finish state if this is the topmost scope.
-            if (n == IterativeParsingStartState)
-                n = IterativeParsingFinishState;
-            // Call handler
-            bool hr = handler.EndObject(c);
-            // On handler short circuits the parsing.
-            if (!hr) {
-                RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorTermination, is.Tell());
-                return IterativeParsingErrorState;
-            }
-            else {
-                is.Take();
-                return n;
+        // Declaration, e.g. a document type with its internal subset
+        if (!IsNameStartChar(is.Peek()))
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorXmlMarkupInvalid, is.Tell());
+        unsigned depth = 0;
+        Ch quote = 0;
+        for (;;) {
+            Ch c = is.Take();
+            if (c == '\0')
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorXmlMarkupInvalid, is.Tell() - 1);
+            else if (quote != 0) {
+                if (c == quote)
+                    quote = 0;
             }
+            else if (c == '"' || c == '\'')
+                quote = c;
+            else if (c == '[')
+                ++depth;
+            else if (c == ']' && depth > 0)
+                --depth;
+            else if (c == '>' && depth == 0)
+                return;
         }
+    }
 
-        case IterativeParsingArrayFinishState:
-        {
-            // Get element count.
-            SizeType c = *stack_.template Pop<SizeType>(1);
-            // If the array is not empty, count the last element.
-            if (src == IterativeParsingElementState)
-                ++c;
-            // Restore the state.
-            IterativeParsingState n = static_cast<IterativeParsingState>(*stack_.template Pop<SizeType>(1));
-            // Transit to Finish state if this is the topmost scope.
-            if (n == IterativeParsingStartState)
-                n = IterativeParsingFinishState;
-            // Call handler
-            bool hr = handler.EndArray(c);
-            // On handler short circuits the parsing.
-            if (!hr) {
-                RAPIDJSONXML_PARSE_ERROR_NORETURN(kParseErrorTermination, is.Tell());
-                return IterativeParsingErrorState;
+    // Skip up to a '>' following the given number of the given character, e.g. "-->".
+    template<typename InputStream>
+    void SkipToEnd(InputStream& is, Ch last, unsigned count) {
+        unsigned run = 0;
+        for (;;) {
+            Ch c = is.Take();
+            if (c == '\0')
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorXmlMarkupInvalid, is.Tell() - 1);
+            if (c == '>' && run >= count)
+                return;
+            run = (c == last) ? run + 1 : 0;
+        }
+    }
+
+    // Decode an entity or a character reference.
+    template<typename TEncoding, typename InputStream, typename OutputStream>
+    void ParseEntity(InputStream& is, OutputStream& os) {
+        RAPIDJSONXML_ASSERT(is.Peek() == '&');
+        const size_t tell = is.Tell();
+        is.Take();
+
+        unsigned codepoint = 0;
+        if (is.Peek() == '#') {
+            is.Take();
+            unsigned base = 10;
+            if (is.Peek() == 'x') {
+                is.Take();
+                base = 16;
             }
-            else {
+            unsigned digits = 0;
+            for (;; ++digits) {
+                Ch c = is.Peek();
+                unsigned d;
+                if (c >= '0' && c <= '9')
+                    d = static_cast<unsigned>(c - '0');
+                else if (base == 16 && c >= 'a' && c <= 'f')
+                    d = static_cast<unsigned>(c - 'a' + 10);
+                else if (base == 16 && c >= 'A' && c <= 'F')
+                    d = static_cast<unsigned>(c - 'A' + 10);
+                else
+                    break;
+                if (codepoint <= 0x10FFFF)
+                    codepoint = codepoint * base + d;
                 is.Take();
-                return n;
             }
+            if (digits == 0 || codepoint == 0 || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorXmlEntityInvalid, tell);
         }
-
-        default:
-            RAPIDJSONXML_ASSERT(false);
-            return IterativeParsingErrorState;
+        else {
+            char name[4];
+            unsigned n = 0;
+            while (n < 4 && is.Peek() >= 'a' && is.Peek() <= 'z')
+                name[n++] = static_cast<char>(is.Take());
+            if (n == 2 && name[1] == 't' && (name[0] == 'l' || name[0] == 'g'))
+                codepoint = name[0] == 'l' ? '<' : '>';
+            else if (n == 3 && std::memcmp(name, "amp", 3) == 0)
+                codepoint = '&';
+            else if (n == 4 && std::memcmp(name, "quot", 4) == 0)
+                codepoint = '"';
+            else if (n == 4 && std::memcmp(name, "apos", 4) == 0)
+                codepoint = '\'';
+            else
+                RAPIDJSONXML_PARSE_ERROR(kParseErrorXmlEntityInvalid, tell);
         }
-    }
 
-    template <typename InputStream>
-    void HandleError(IterativeParsingState src, InputStream& is) {
-        if (HasParseError()) {
-            // Error flag has been set.
-            return;
-        }
+        if (is.Take() != ';')
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorXmlEntityInvalid, tell);
+        TEncoding::Encode(os, codepoint);
+    }
 
-        switch (src) {
-        case IterativeParsingStartState:
-            RAPIDJSONXML_PARSE_ERROR(is.Peek() == '\0' ? kParseErrorDocumentEmpty : kParseErrorDocumentRootNotObjectOrArray, is.Tell());
-        case IterativeParsingFinishState:
-            RAPIDJSONXML_PARSE_ERROR(kParseErrorDocumentRootNotSingular, is.Tell());
-        case IterativeParsingObjectInitialState:
-        case IterativeParsingMemberDelimiterState:
-            RAPIDJSONXML_PARSE_ERROR(kParseErrorObjectMissName, is.Tell());
-        case IterativeParsingMemberKeyState:
-            RAPIDJSONXML_PARSE_ERROR(kParseErrorObjectMissColon, is.Tell());
-        case IterativeParsingMemberValueState:
-            RAPIDJSONXML_PARSE_ERROR(kParseErrorObjectMissCommaOrCurlyBracket, is.Tell());
-        case IterativeParsingElementState:
-            RAPIDJSONXML_PARSE_ERROR(kParseErrorArrayMissCommaOrSquareBracket, is.Tell());
-        default:
-            RAPIDJSONXML_PARSE_ERROR(kParseErrorUnspecificSyntaxError, is.Tell());
-        }
+    template<unsigned parseFlags, typename SEncoding, typename TEncoding, typename InputStream, typename OutputStream>
+    RAPIDJSONXML_FORCEINLINE void TranscodeChar(InputStream& is, OutputStream& os) {
+        if (parseFlags & kParseValidateEncodingFlag ?
+                !Transcoder<SEncoding, TEncoding>::Validate(is, os) :
+                !Transcoder<SEncoding, TEncoding>::Transcode(is, os))
+            RAPIDJSONXML_PARSE_ERROR(kParseErrorStringInvalidEncoding, is.Tell());
     }
 
-    template <unsigned parseFlags, typename InputStream, typename Handler>
-    ParseResult IterativeParse(InputStream& is, Handler& handler) {
-        parseResult_.Clear();
-        ClearStackOnExit scope(*this);
-        IterativeParsingState state = IterativeParsingStartState;
+    template<unsigned parseFlags>
+    const TargetCh* TextString(const Text& text) {
+        return (parseFlags & kParseInsituFlag) ? text.head : StackAt<TargetCh>(text.offset);
+    }
 
-        SkipWhitespace(is);
-        while (is.Peek() != '\0') {
-            Token t = Tokenize(is.Peek());
-            IterativeParsingState n = Predict(state, t);
-            IterativeParsingState d = Transit<parseFlags>(state, t, n, is, handler);
+    template<unsigned parseFlags>
+    bool IsBlank(const Text& text) {
+        const TargetCh* str = TextString<parseFlags>(text);
+        for (SizeType i = 0; i < text.length; i++)
+            if (!IsWhitespace(str[i]))
+                return false;
+        return true;
+    }
 
-            if (d == IterativeParsingErrorState) {
-                HandleError(state, is);
-                break;
-            }
+    // Generate the event of the text value of an element.
+    template<unsigned parseFlags, typename Handler>
+    bool TextValue(const Text& text, Handler& handler) {
+        const TargetCh* str = TextString<parseFlags>(text);
+        const SizeType length = text.length;
+        if (!text.cdata) {
+            if (length == 4 && str[0] == 'n' && str[1] == 'u' && str[2] == 'l' && str[3] == 'l')
+                return handler.Null();
+            if (length == 4 && str[0] == 't' && str[1] == 'r' && str[2] == 'u' && str[3] == 'e')
+                return handler.Bool(true);
+            if (length == 5 && str[0] == 'f' && str[1] == 'a' && str[2] == 'l' && str[3] == 's' && str[4] == 'e')
+                return handler.Bool(false);
+            bool ret;
+            if (length > 0 && ((str[0] >= '0' && str[0] <= '9') || str[0] == '-') && NumberValue(str, length, handler, &ret))
+                return ret;
+        }
+        return handler.String(str, length, !(parseFlags & kParseInsituFlag));
+    }
 
-            state = d;
+    // Generate the number event of a text following the JSON number grammar.
+    // \return false if the text is not a number, otherwise the result of the handler is in *ret.
+    template<typename Handler>
+    bool NumberValue(const TargetCh* p, SizeType length, Handler& handler, bool* ret) {
+        const TargetCh* end = p + length;
+        bool minus = false;
+        if (*p == '-') {
+            minus = true;
+            ++p;
+        }
+        if (p == end || !(*p >= '0' && *p <= '9') || (*p == '0' && p + 1 != end && p[1] >= '0' && p[1] <= '9'))
+            return false;
 
-            // Do not further consume streams if a root JSON has been parsed.
-            if ((parseFlags & kParseStopWhenDoneFlag) && state == IterativeParsingFinishState)
-                break;
+        // Significant digits times 10^exp, further ones only matter by being non-zero
+        char decimals[internal::kStrtodMaxDigits + 1];
+        size_t decimalLength = 0;
+        bool sticky = false;
+        int exp = 0;
+        for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+            if (decimalLength == 0 && *p == '0')
+                continue;
+            if (decimalLength < internal::kStrtodMaxDigits)
+                decimals[decimalLength++] = static_cast<char>(*p);
+            else {
+                sticky = sticky || *p != '0';
+                ++exp;
+            }
+        }
 
-            SkipWhitespace(is);
+        bool useDouble = false;
+        if (p != end && *p == '.') {
+            useDouble = true;
+            if (++p == end || !(*p >= '0' && *p <= '9'))
+                return false;
+            for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+                if (decimalLength == 0 && *p == '0')
+                    --exp;
+                else if (decimalLength < internal::kStrtodMaxDigits) {
+                    decimals[decimalLength++] = static_cast<char>(*p);
+                    --exp;
+                }
+                else
+                    sticky = sticky || *p != '0';
+            }
         }
 
-        // Handle the end of file.
-        if (state != IterativeParsingFinishState)
-            HandleError(state, is);
+        if (p != end && (*p == 'e' || *p == 'E')) {
+            useDouble = true;
+            bool expMinus = false;
+            if (++p != end && (*p == '+' || *p == '-'))
+                expMinus = *p++ == '-';
+            if (p == end || !(*p >= '0' && *p <= '9'))
+                return false;
+            int e = 0;
+            for (; p != end && *p >= '0' && *p <= '9'; ++p)
+                if (e < 100000) // far beyond the range of double
+                    e = e * 10 + static_cast<int>(*p - '0');
+            exp += expMinus ? -e : e;
+        }
+        if (p != end)
+            return false;
+
+        if (!useDouble && decimalLength <= 20) {
+            uint64_t u = 0;
+            bool overflow = false;
+            for (size_t i = 0; i < decimalLength; i++) {
+                const unsigned d = static_cast<unsigned>(decimals[i] - '0');
+                if (u > (UINT64_C(18446744073709551615) - d) / 10)
+                    overflow = true;
+                u = u * 10 + d;
+            }
+            if (!overflow) {
+                if (!minus)
+                    *ret = u <= 0xFFFFFFFFu ? handler.Uint(static_cast<unsigned>(u)) : handler.Uint64(u);
+                else if (u <= 2147483648u)
+                    *ret = handler.Int(static_cast<int>(0u - static_cast<unsigned>(u)));
+                else if (u <= UINT64_C(9223372036854775808))
+                    *ret = handler.Int64(static_cast<int64_t>(~u + 1));
+                else
+                    overflow = true;
+                if (!overflow)
+                    return true;
+            }
+        }
 
-        return parseResult_;
+        double d = 0.0;
+        if (decimalLength > 0) {
+            if (exp + static_cast<int>(decimalLength) > 310) // not stored in double
+                return false;
+            if (exp + static_cast<int>(decimalLength) >= -330) {
+                if (sticky) { // any value strictly between the given digits and the next one
+                    decimals[decimalLength++] = '1';
+                    --exp;
+                }
+                d = internal::StrtodFullPrecision(decimals, decimalLength, exp);
+            }
+        }
+        *ret = handler.Double(minus ? -d : d);
+        return true;
     }
 
-    static const size_t kDefaultStackCapacity = 256; //!< Default stack capacity in bytes for storing a single decoded string.
-    internal::Stack<Allocator> stack_; //!< A stack for storing decoded string temporarily during non-destructive parsing.
+    static const size_t kDefaultStackCapacity = 256;        //!< Default stack capacity in bytes for storing names, attributes and a single decoded text.
+    static const size_t kDefaultAttributeCapacity = 256;    //!< Default stack capacity in bytes for storing the attributes of an element.
+    static const size_t kDefaultSiblingCapacity = 256;      //!< Default stack capacity in bytes for marking the elements with kParseXmlArraysFlag.
+    internal::Stack<Allocator> stack_;                      //!< A stack for storing names, attributes and a decoded text.
+    internal::Stack<Allocator> attributeStack_;             //!< A stack for storing the positions and objects of attributes.
+    internal::Stack<Allocator> siblings_;                   //!< Whether each element is followed by a sibling of the same name, with kParseXmlArraysFlag.
+    size_t siblingCursor_;                                  //!< Index in siblings_ of the next element to parse.
     ParseResult parseResult_;
-}; // class GenericReader
+}; // class GenericXmlReader
 
-//! Reader with UTF8 encoding and default allocator.
-typedef GenericReader<UTF8<>, UTF8<> > Reader;
+//! XmlReader with UTF8 encoding and default allocator.
+typedef GenericXmlReader<UTF8<>, UTF8<> > XmlReader;
 
 } // namespace rapidjsonxml
 
@@ -0,0 +1,148 @@
+#ifndef RAPIDJSONXML_SIMD_H_
+#define RAPIDJSONXML_SIMD_H_
+
+#include "rapidjsonxml.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// SIMD intrinsics
+
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+#ifdef _MSC_VER
+#include <intrin.h>     // __cpuidex()
+#include <immintrin.h>
+#else
+#include <cpuid.h>      // __cpuid_count()
+#include <immintrin.h>
+#endif
+#elif defined(RAPIDJSONXML_SSE42)
+#include <nmmintrin.h>
+#elif defined(RAPIDJSONXML_SSE2)
+#include <emmintrin.h>
+#endif
+
+#if defined(RAPIDJSONXML_SIMD) && defined(_MSC_VER)
+#include <intrin.h>
+#pragma intrinsic(_BitScanForward)
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// RAPIDJSONXML_TARGET_SSE2/RAPIDJSONXML_TARGET_SSE42/RAPIDJSONXML_TARGET_AVX2
+
+//! Instruction set of a function using SIMD intrinsics.
+/*! With RAPIDJSONXML_SIMD_DISPATCH, the code paths of every level are compiled
+    whatever the compiler options, and only called when the CPU supports them.
+    GCC and clang need the instruction set of each function, MSVC does not.
+*/
+#if defined(RAPIDJSONXML_SIMD_DISPATCH) && defined(__GNUC__)
+#define RAPIDJSONXML_TARGET_SSE2 __attribute__((target("sse2")))
+#define RAPIDJSONXML_TARGET_SSE42 __attribute__((target("sse4.2")))
+#define RAPIDJSONXML_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RAPIDJSONXML_TARGET_SSE2
+#define RAPIDJSONXML_TARGET_SSE42
+#define RAPIDJSONXML_TARGET_AVX2
+#endif
+
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+namespace rapidjsonxml {
+
+//! Instruction sets of the SIMD code paths, from the lowest to the highest.
+enum SimdLevel {
+    kSimdScalar = 0,    //!< No SIMD instruction.
+    kSimdSSE2,          //!< SSE2.
+    kSimdSSE42,         //!< SSE4.2.
+    kSimdAVX2,          //!< AVX2.
+    kSimdLevelCount     //!< Number of levels.
+};
+
+//@cond RAPIDJSONXML_INTERNAL
+namespace internal {
+
+inline void Cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#ifdef _MSC_VER
+    int r[4];
+    __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; i++)
+        regs[i] = static_cast<unsigned>(r[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+//! Register state enabled by the OS (XCR0).
+inline uint64_t Xgetbv() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned eax, edx;
+    __asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0)); // xgetbv
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+inline SimdLevel DetectSimdLevel() {
+    unsigned regs[4]; // eax, ebx, ecx, edx
+    Cpuid(0, 0, regs);
+    const unsigned maxLeaf = regs[0];
+    if (maxLeaf < 1)
+        return kSimdScalar;
+
+    Cpuid(1, 0, regs);
+    if (!(regs[3] & (1u << 26)))                            // SSE2
+        return kSimdScalar;
+    if ((regs[2] & (3u << 19)) != (3u << 19))               // SSE4.1 and SSE4.2
+        return kSimdSSE2;
+
+    // AVX2 also needs the OS to save the YMM registers
+    if (maxLeaf < 7 || (regs[2] & (3u << 27)) != (3u << 27) // OSXSAVE and AVX
+        || (Xgetbv() & 6) != 6)                             // XMM and YMM state
+        return kSimdSSE42;
+    Cpuid(7, 0, regs);
+    return (regs[1] & (1u << 5)) ? kSimdAVX2 : kSimdSSE42;  // AVX2
+}
+
+//! Levels of the CPU and of the code paths, detected by the static initialization.
+/*! They are only read by the parsers and the writers, and the level is only
+    written by SetSimdLevel(), so that threads do not race at their first use.
+    Before the initialization, i.e. from static initializers of other translation
+    units, both are 0 and the scalar code paths are used.
+*/
+template <typename T = void>
+struct SimdLevelStorage {
+    static const int cpuLevel;
+    static int level;
+};
+
+template <typename T> const int SimdLevelStorage<T>::cpuLevel = DetectSimdLevel();
+template <typename T> int SimdLevelStorage<T>::level = DetectSimdLevel();
+
+} // namespace internal
+//@endcond
+
+//! Get the highest SIMD level supported by the CPU.
+inline SimdLevel GetCpuSimdLevel() {
+    return static_cast<SimdLevel>(internal::SimdLevelStorage<>::cpuLevel);
+}
+
+//! Get the SIMD level of the code paths, by default the highest supported by the CPU.
+inline SimdLevel GetSimdLevel() {
+    return static_cast<SimdLevel>(internal::SimdLevelStorage<>::level);
+}
+
+//! Force the SIMD level of the code paths, e.g. to compare them.
+/*! \param level SIMD level, which must be supported by the CPU.
+    \return Whether the level is set, otherwise the current level is kept.
+    \note This is the only function changing the level, and it is not thread safe:
+    set it before starting the threads parsing or writing.
+*/
+inline bool SetSimdLevel(SimdLevel level) {
+    if (level < kSimdScalar || level > GetCpuSimdLevel())
+        return false;
+    internal::SimdLevelStorage<>::level = level;
+    return true;
+}
+
+} // namespace rapidjsonxml
+#endif // RAPIDJSONXML_SIMD_DISPATCH
+
+#endif // RAPIDJSONXML_SIMD_H_
@@ -58,6 +58,17 @@ inline void PutN(GenericStringBuffer<UTF8<> >& stream, char c, size_t n) {
     memset(stream.stack_.Push<char>(n), c, n * sizeof(c));
 }
 
+//! Implement specialized version of PutBlock() with memcpy() for better performance.
+template<>
+inline void PutBlock(GenericStringBuffer<UTF8<> >& stream, const char* str, size_t n) {
+    memcpy(stream.stack_.Push<char>(n), str, n * sizeof(char));
+}
+
+template<>
+inline void PutBlock(GenericStringBuffer<ASCII<> >& stream, const char* str, size_t n) {
+    memcpy(stream.stack_.Push<char>(n), str, n * sizeof(char));
+}
+
 } // namespace rapidjsonxml
 
 #endif // RAPIDJSONXML_STRINGBUFFER_H_
@@ -0,0 +1,168 @@
+#ifndef RAPIDJSONXML_TAGADAPTER_H_
+#define RAPIDJSONXML_TAGADAPTER_H_
+
+#include "rapidjsonxml.h"
+#include "internal/stack.h"
+#include <new>      // placement new
+
+namespace rapidjsonxml {
+
+//! Handler adapter turning the member names of a JSON event stream into tags.
+/*!
+    GenericReader sends each member name as a String() event, while WriterXml
+    expects it as OpenTag() before the member value and CloseTag() after it, as
+    sent by GenericValue::Accept(). TagAdapter keeps the name of each open
+    member and converts the events, so that JSON is converted to XML while
+    parsing, without building a document:
+    \code
+    Reader reader;
+    WriterXml<FileWriteStream> writer(os);
+    TagAdapter<WriterXml<FileWriteStream> > adapter(writer);
+    reader.Parse(is, adapter);
+    \endcode
+    The memory used depends on the depth of the JSON text and on the length of
+    its member names, not on its size.
+
+    OpenTag() and CloseTag() events are forwarded, so a source which already
+    sends tags can also be adapted.
+
+    \tparam Handler Type of the adapted handler, which must define \c AttributeIteratorPair.
+    \tparam Allocator Type of allocator for allocating memory of the stacks.
+    \note implements Handler concept
+*/
+template <typename Handler, typename Allocator = CrtAllocator>
+class TagAdapter {
+public:
+    typedef typename Handler::Ch Ch;
+    typedef typename Handler::AttributeIteratorPair AttributeIteratorPair;
+    typedef AttributeIteratorPair* AttributeIteratorPairList;
+
+    //! Constructor
+    /*! \param handler Adapted handler, receiving the converted events.
+        \param allocator User supplied allocator. If it is null, it will create a private one.
+        \param levelDepth Initial capacity of stack.
+    */
+    TagAdapter(Handler& handler, Allocator* allocator = 0, size_t levelDepth = kDefaultLevelDepth) :
+        handler_(&handler), level_stack_(allocator, levelDepth * sizeof(Level)), name_stack_(allocator, kDefaultNameCapacity) {}
+
+    //! Reset the adapter with a new handler.
+    /*! This makes the adapter reusable after a complete or an interrupted parsing.
+        \param handler New adapted handler.
+    */
+    void Reset(Handler& handler) {
+        handler_ = &handler;
+        level_stack_.Clear();
+        name_stack_.Clear(); // keeps its capacity
+    }
+
+    /*!@name Implementation of Handler
+        \see Handler
+    */
+    //@{
+
+    bool Null()                 { return handler_->Null() && EndValue(); }
+    bool Bool(bool b)           { return handler_->Bool(b) && EndValue(); }
+    bool Int(int i)             { return handler_->Int(i) && EndValue(); }
+    bool Uint(unsigned u)       { return handler_->Uint(u) && EndValue(); }
+    bool Int64(int64_t i64)     { return handler_->Int64(i64) && EndValue(); }
+    bool Uint64(uint64_t u64)   { return handler_->Uint64(u64) && EndValue(); }
+    bool Double(double d)       { return handler_->Double(d) && EndValue(); }
+
+    bool String(const Ch* str, SizeType length, bool copy) {
+        if (!level_stack_.Empty()) {
+            Level* level = level_stack_.template Top<Level>();
+            if (level->inObject && !level->hasName && !level->hasTag)
+                return Name(*level, str, length);
+        }
+        return handler_->String(str, length, copy) && EndValue();
+    }
+
+    //! Start an object, its attributes are not forwarded.
+    template <typename SourceAttributeIteratorPair>
+    bool StartObject(const SourceAttributeIteratorPair) {
+        new (level_stack_.template Push<Level>()) Level(true);
+        return handler_->StartObject(AttributeIteratorPair());
+    }
+
+    bool EndObject(SizeType memberCount) {
+        level_stack_.template Pop<Level>(1);
+        return handler_->EndObject(memberCount) && EndValue();
+    }
+
+    bool StartArray() {
+        new (level_stack_.template Push<Level>()) Level(false);
+        return handler_->StartArray();
+    }
+
+    bool EndArray(SizeType elementCount) {
+        level_stack_.template Pop<Level>(1);
+        return handler_->EndArray(elementCount) && EndValue();
+    }
+
+    //! Forward a tag of the source, the next String() is then a value.
+    template <typename SourceAttributeIteratorPairList>
+    bool OpenTag(const Ch* str, SizeType length, const SourceAttributeIteratorPairList attribs_list, bool copy) {
+        (void)attribs_list;
+        if (!level_stack_.Empty())
+            level_stack_.template Top<Level>()->hasTag = true;
+        return handler_->OpenTag(str, length, 0, copy);
+    }
+
+    bool CloseTag(const Ch* str, SizeType length, bool copy) {
+        if (!level_stack_.Empty())
+            level_stack_.template Top<Level>()->hasTag = false;
+        return handler_->CloseTag(str, length, copy);
+    }
+
+    //@}
+
+private:
+    //! Information for each nested level
+    struct Level {
+        Level(bool inObject_) : inObject(inObject_), hasName(false), hasTag(false), name(0), nameLength(0) {}
+        bool inObject;          //!< true if in object, otherwise in array
+        bool hasName;           //!< true if a member name was converted to an open tag, which is closed after the value
+        bool hasTag;            //!< true if the source sent the open tag of the member
+        size_t name;            //!< offset (in characters) of the member name in name_stack_
+        SizeType nameLength;    //!< length of the member name
+    };
+
+    static const size_t kDefaultLevelDepth = 32;
+    static const size_t kDefaultNameCapacity = 256;
+
+    //! Keep the member name, which may not outlive the String() event, and open its tag.
+    bool Name(Level& level, const Ch* str, SizeType length) {
+        level.hasName = true;
+        level.name = name_stack_.GetSize() / sizeof(Ch);
+        level.nameLength = length;
+        Ch* name = name_stack_.template Push<Ch>(length);
+        std::memcpy(name, str, length * sizeof(Ch));
+        return handler_->OpenTag(name, length, 0, true);
+    }
+
+    //! Close the tag of the member whose value is complete.
+    bool EndValue() {
+        if (level_stack_.Empty())
+            return true;
+        Level* level = level_stack_.template Top<Level>();
+        if (!level->hasName)
+            return true;
+        level->hasName = false;
+        RAPIDJSONXML_ASSERT(name_stack_.GetSize() == (level->name + level->nameLength) * sizeof(Ch));
+        bool ret = handler_->CloseTag(name_stack_.template Bottom<Ch>() + level->name, level->nameLength, true);
+        name_stack_.template Pop<Ch>(level->nameLength);
+        return ret;
+    }
+
+    //! Prohibit copy constructor & assignment operator.
+    TagAdapter(const TagAdapter&);
+    TagAdapter& operator=(const TagAdapter&);
+
+    Handler* handler_;
+    internal::Stack<Allocator> level_stack_;
+    internal::Stack<Allocator> name_stack_;
+};
+
+} // namespace rapidjsonxml
+
+#endif // RAPIDJSONXML_TAGADAPTER_H_
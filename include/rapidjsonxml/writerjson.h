@@ -5,8 +5,10 @@
 #include "internal/stack.h"
 #include "internal/strfunc.h"
 #include "internal/itoa.h"
+#include "internal/dtoa.h"
+#include "internal/meta.h"
 #include "stringbuffer.h"
-#include <cstdio>   // snprintf() or _sprintf_s()
+#include "simd.h"
 #include <new>      // placement new
 
 #ifdef _MSC_VER
@@ -16,6 +18,122 @@ RAPIDJSONXML_DIAG_OFF(4127) // conditional expression is constant
 
 namespace rapidjsonxml {
 
+#ifdef RAPIDJSONXML_SIMD
+//! Find the first character which has to be escaped by WriterJson, testing 16 8-byte characters at once.
+/*! Control characters (0x00~0x1F), '"' and '\\' are escaped, as well as non-ASCII
+    characters if \c escapeNonAscii is set. Other characters are copied.
+    Only 16-byte aligned blocks are loaded, so no memory page boundary is crossed
+    before \c p or after \c end.
+    \return Pointer to the first character to escape, or \c end if none.
+    \note As for ScanXmlEscape_SSE2(), RAPIDJSONXML_SSE42 uses the same SSE2 instructions.
+*/
+template <bool escapeNonAscii>
+RAPIDJSONXML_TARGET_SSE2 inline const char* ScanJsonEscape_SSE2(const char* p, const char* end) {
+    if (p == end)
+        return end;
+
+    const __m128i k1F = _mm_set1_epi8(0x1F);
+    const __m128i kQuote = _mm_set1_epi8('"');
+    const __m128i kBackslash = _mm_set1_epi8('\\');
+
+    // 16-byte align to the lower boundary
+    const char* ap = reinterpret_cast<const char*>(reinterpret_cast<size_t>(p) & ~static_cast<size_t>(15));
+    unsigned shift = static_cast<unsigned>(p - ap);
+
+    for (;; ap += 16) {
+        const __m128i s = _mm_load_si128(reinterpret_cast<const __m128i*>(ap));
+        __m128i x = _mm_cmpeq_epi8(_mm_max_epu8(s, k1F), k1F); // s <= 0x1F
+        x = _mm_or_si128(x, _mm_cmpeq_epi8(s, kQuote));
+        x = _mm_or_si128(x, _mm_cmpeq_epi8(s, kBackslash));
+        if (escapeNonAscii)
+            x = _mm_or_si128(x, s); // sign bit set for s >= 0x80
+        unsigned r = static_cast<unsigned>(_mm_movemask_epi8(x));
+        r = r >> shift << shift; // Clear results before p
+        shift = 0;
+        if (end - ap <= 16)
+            r &= (1u << (end - ap)) - 1; // Clear results after end
+        if (r != 0) {
+#ifdef _MSC_VER // Find the index of first escaped character
+            unsigned long offset;
+            _BitScanForward(&offset, r);
+            return ap + offset;
+#else
+            return ap + __builtin_ffs(static_cast<int>(r)) - 1;
+#endif
+        }
+        if (end - ap <= 16)
+            return end;
+    }
+}
+
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+//! Find the first character which has to be escaped by WriterJson, testing 32 8-byte characters at once with AVX2 instructions.
+template <bool escapeNonAscii>
+RAPIDJSONXML_TARGET_AVX2 inline const char* ScanJsonEscape_AVX2(const char* p, const char* end) {
+    if (p == end)
+        return end;
+
+    const __m256i k1F = _mm256_set1_epi8(0x1F);
+    const __m256i kQuote = _mm256_set1_epi8('"');
+    const __m256i kBackslash = _mm256_set1_epi8('\\');
+
+    // 32-byte align to the lower boundary
+    const char* ap = reinterpret_cast<const char*>(reinterpret_cast<size_t>(p) & ~static_cast<size_t>(31));
+    unsigned shift = static_cast<unsigned>(p - ap);
+
+    for (;; ap += 32) {
+        const __m256i s = _mm256_load_si256(reinterpret_cast<const __m256i*>(ap));
+        __m256i x = _mm256_cmpeq_epi8(_mm256_max_epu8(s, k1F), k1F); // s <= 0x1F
+        x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, kQuote));
+        x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, kBackslash));
+        if (escapeNonAscii)
+            x = _mm256_or_si256(x, s); // sign bit set for s >= 0x80
+        unsigned r = static_cast<unsigned>(_mm256_movemask_epi8(x));
+        r = r >> shift << shift; // Clear results before p
+        shift = 0;
+        if (end - ap < 32)
+            r &= (1u << (end - ap)) - 1; // Clear results after end
+        if (r != 0) {
+#ifdef _MSC_VER // Find the index of first escaped character
+            unsigned long offset;
+            _BitScanForward(&offset, r);
+            return ap + offset;
+#else
+            return ap + __builtin_ffs(static_cast<int>(r)) - 1;
+#endif
+        }
+        if (end - ap <= 32)
+            return end;
+    }
+}
+
+//! Find the first character which has to be escaped by WriterJson one at a time, for CPUs without SSE2.
+template <bool escapeNonAscii>
+inline const char* ScanJsonEscape_Scalar(const char* p, const char* end) {
+    for (; p != end; ++p) {
+        const unsigned char c = static_cast<unsigned char>(*p);
+        if (c < 0x20 || c == '"' || c == '\\' || (escapeNonAscii && c >= 0x80))
+            break;
+    }
+    return p;
+}
+#endif // RAPIDJSONXML_SIMD_DISPATCH
+
+//! Find the first character which has to be escaped by WriterJson with the selected SIMD instructions.
+template <bool escapeNonAscii>
+inline const char* ScanJsonEscape_SIMD(const char* p, const char* end) {
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+    typedef const char* (*Kernel)(const char*, const char*);
+    static const Kernel kKernels[kSimdLevelCount] = {
+        ScanJsonEscape_Scalar<escapeNonAscii>, ScanJsonEscape_SSE2<escapeNonAscii>, ScanJsonEscape_SSE2<escapeNonAscii>, ScanJsonEscape_AVX2<escapeNonAscii>
+    };
+    return kKernels[GetSimdLevel()](p, end);
+#else
+    return ScanJsonEscape_SSE2<escapeNonAscii>(p, end);
+#endif
+}
+#endif // RAPIDJSONXML_SIMD
+
 //! JSON writer
 /*! WriterJson implements the concept Handler.
     It generates JSON text by events to an output os.
@@ -36,6 +154,7 @@ template<typename OutputStream, typename SourceEncoding = UTF8<>, typename Targe
 class WriterJson {
 public:
     typedef typename SourceEncoding::Ch Ch;
+    typedef typename TargetEncoding::Ch TargetCh;
     typedef GenericAttributeIteratorPair<SourceEncoding, Allocator> AttributeIteratorPair;
     typedef AttributeIteratorPair* AttributeIteratorPairList;
 
@@ -46,11 +165,11 @@ public:
     */
     WriterJson(OutputStream& os, Allocator* allocator = 0, size_t levelDepth = kDefaultLevelDepth) :
         os_(&os), level_stack_(allocator, levelDepth * sizeof(Level)),
-        doublePrecision_(kDefaultDoublePrecision), hasRoot_(false) {}
+        doublePrecision_(kDefaultDoublePrecision), fixedDecimals_(kDefaultFixedDecimals), hasRoot_(false) {}
 
     WriterJson(Allocator* allocator = 0, size_t levelDepth = kDefaultLevelDepth) :
         os_(0), level_stack_(allocator, levelDepth * sizeof(Level)),
-        doublePrecision_(kDefaultDoublePrecision), hasRoot_(false) {}
+        doublePrecision_(kDefaultDoublePrecision), fixedDecimals_(kDefaultFixedDecimals), hasRoot_(false) {}
 
     //! Reset the writer with a new stream.
     /*!
@@ -73,6 +192,7 @@ public:
     void Reset(OutputStream& os) {
         os_ = &os;
         doublePrecision_ = kDefaultDoublePrecision;
+        fixedDecimals_ = kDefaultFixedDecimals;
         hasRoot_ = false;
         level_stack_.Clear();
     }
@@ -86,9 +206,11 @@ public:
     }
 
     //! Set the number of significant digits for \c double values
-    /*! When writing a \c double value to the \c OutputStream, the number
-        of significant digits is limited to 6 by default.
-        \param p maximum number of significant digits (default: 6)
+    /*! When writing a \c double value to the \c OutputStream, the shortest
+        representation which converts back to the same value is written by default.
+        Otherwise the value is rounded to the given number of significant digits,
+        as with \c printf("%.*g").
+        \param p maximum number of significant digits, 0 for the shortest representation (default: 0)
         \return The WriterJson itself for fluent API.
     */
     WriterJson& SetDoublePrecision(int p = kDefaultDoublePrecision) {
@@ -102,6 +224,24 @@ public:
         return doublePrecision_;
     }
 
+    //! Set a fixed number of decimals for \c double values
+    /*! When set, \c double values are written as with \c printf("%.*f"), correctly
+        rounded, instead of the format selected by \ref SetDoublePrecision().
+        Every finite value gets exactly \c n decimals, whatever its magnitude.
+        \param n number of decimals, up to 18, or negative to disable (default: disabled)
+        \return The WriterJson itself for fluent API.
+    */
+    WriterJson& SetFixedDecimals(int n = kDefaultFixedDecimals) {
+        if (n > internal::kMaxFixedDecimals) n = internal::kMaxFixedDecimals;
+        fixedDecimals_ = n < 0 ? kDefaultFixedDecimals : n;
+        return *this;
+    }
+
+    //! \see SetFixedDecimals()
+    int GetFixedDecimals() const {
+        return fixedDecimals_;
+    }
+
     /*!@name Implementation of Handler
         \see Handler
     */
@@ -134,8 +274,9 @@ public:
 
     //! Writes the given \c double value to the stream
     /*!
-        The number of significant digits (the precision) to be written
-        can be set by \ref SetDoublePrecision() for the WriterJson:
+        By default the shortest representation which reads back as the same
+        \c double is written. The number of significant digits (the precision)
+        to be written can be set by \ref SetDoublePrecision() for the WriterJson:
         \code
         WriterJson<...> writer(...);
         writer.SetDoublePrecision(12).Double(M_PI);
@@ -227,6 +368,23 @@ public:
         return ret;
     }
 
+    //! Writes the given \c double value to the stream with a fixed number of decimals
+    /*!
+        The currently set double format is ignored in favor of the explicitly
+        given number of decimals for this value.
+        \see Double(), SetFixedDecimals(), GetFixedDecimals()
+        \param d The value to be written
+        \param decimals The number of decimals for this value
+        \return Whether it is succeeded.
+    */
+    bool FixedDouble(double d, int decimals) {
+        int oldDecimals = GetFixedDecimals();
+        SetFixedDecimals(decimals);
+        bool ret = Double(d);
+        SetFixedDecimals(oldDecimals);
+        return ret;
+    }
+
     //! Simpler but slower overload.
     bool String(const Ch* str) {
         return String(str, internal::StrLen(str));
@@ -301,24 +459,44 @@ protected:
         return true;
     }
 
-#ifdef _MSC_VER
-#define RAPIDJSONXML_SNPRINTF sprintf_s
-#else
-#define RAPIDJSONXML_SNPRINTF snprintf
-#endif
-
-    //! \todo Optimization with custom double-to-string converter.
     bool WriteDouble(double d) {
-        char buffer[100];
-        int ret = RAPIDJSONXML_SNPRINTF(buffer, sizeof(buffer), "%.*g", doublePrecision_, d);
-        RAPIDJSONXML_ASSERT(ret >= 1);
-        for (int i = 0; i < ret; i++)
-            os_->Put(buffer[i]);
+        char buffer[internal::kDtoaBufferSize];
+        const char* end = fixedDecimals_ >= 0 ? internal::fixedtoa(d, buffer, fixedDecimals_) : internal::dtoa(d, buffer, doublePrecision_);
+        for (const char* p = buffer; p != end; ++p)
+            os_->Put(*p);
         return true;
     }
-#undef RAPIDJSONXML_SNPRINTF
 
     bool WriteString(const Ch* str, SizeType length)  {
+        os_->Put('\"');
+        GenericStringStream<SourceEncoding> is(str);
+#ifdef RAPIDJSONXML_SIMD
+        // 8-bit unicode source (UTF-8): copy the runs without escaping as blocks
+        if (sizeof(Ch) == 1 && (internal::IsSame<SourceEncoding, TargetEncoding>::Value || internal::IsSame<TargetEncoding, ASCII<> >::Value) && SourceEncoding::supportUnicode) {
+            const char* end = reinterpret_cast<const char*>(str) + length;
+            while (is.Tell() < length) {
+                const char* p = reinterpret_cast<const char*>(is.src_);
+                const char* q = TargetEncoding::supportUnicode ? ScanJsonEscape_SIMD<false>(p, end) : ScanJsonEscape_SIMD<true>(p, end);
+                PutBlock(*os_, reinterpret_cast<const TargetCh*>(p), static_cast<size_t>(q - p));
+                is.src_ += q - p;
+                if (q == end)
+                    break;
+                if (!WriteChar(is))
+                    return false;
+            }
+            os_->Put('\"');
+            return true;
+        }
+#endif
+        while (is.Tell() < length)
+            if (!WriteChar(is))
+                return false;
+        os_->Put('\"');
+        return true;
+    }
+
+    //! Write a character of a string, escaped if needed.
+    bool WriteChar(GenericStringStream<SourceEncoding>& is) {
         static const char hexDigits[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
         static const char escape[256] = {
 #define Z16 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
@@ -332,57 +510,52 @@ protected:
 #undef Z16
         };
 
-        os_->Put('\"');
-        GenericStringStream<SourceEncoding> is(str);
-        while (is.Tell() < length) {
-            const Ch c = is.Peek();
-            if (!TargetEncoding::supportUnicode && (unsigned)c >= 0x80) {
-                // Unicode escaping
-                unsigned codepoint;
-                if (!SourceEncoding::Decode(is, &codepoint))
-                    return false;
-                os_->Put('\\');
-                os_->Put('u');
-                if (codepoint <= 0xD7FF || (codepoint >= 0xE000 && codepoint <= 0xFFFF)) {
-                    os_->Put(hexDigits[(codepoint >> 12) & 15]);
-                    os_->Put(hexDigits[(codepoint >>  8) & 15]);
-                    os_->Put(hexDigits[(codepoint >>  4) & 15]);
-                    os_->Put(hexDigits[(codepoint      ) & 15]);
-                }
-                else if (codepoint >= 0x010000 && codepoint <= 0x10FFFF) {
-                    // Surrogate pair
-                    unsigned s = codepoint - 0x010000;
-                    unsigned lead = (s >> 10) + 0xD800;
-                    unsigned trail = (s & 0x3FF) + 0xDC00;
-                    os_->Put(hexDigits[(lead >> 12) & 15]);
-                    os_->Put(hexDigits[(lead >>  8) & 15]);
-                    os_->Put(hexDigits[(lead >>  4) & 15]);
-                    os_->Put(hexDigits[(lead      ) & 15]);
-                    os_->Put('\\');
-                    os_->Put('u');
-                    os_->Put(hexDigits[(trail >> 12) & 15]);
-                    os_->Put(hexDigits[(trail >>  8) & 15]);
-                    os_->Put(hexDigits[(trail >>  4) & 15]);
-                    os_->Put(hexDigits[(trail      ) & 15]);
-                }
-                else
-                    return false; // invalid code point
+        const Ch c = is.Peek();
+        if (!TargetEncoding::supportUnicode && (unsigned)c >= 0x80) {
+            // Unicode escaping
+            unsigned codepoint;
+            if (!SourceEncoding::Decode(is, &codepoint))
+                return false;
+            os_->Put('\\');
+            os_->Put('u');
+            if (codepoint <= 0xD7FF || (codepoint >= 0xE000 && codepoint <= 0xFFFF)) {
+                os_->Put(hexDigits[(codepoint >> 12) & 15]);
+                os_->Put(hexDigits[(codepoint >>  8) & 15]);
+                os_->Put(hexDigits[(codepoint >>  4) & 15]);
+                os_->Put(hexDigits[(codepoint      ) & 15]);
             }
-            else if ((sizeof(Ch) == 1 || (unsigned)c < 256) && escape[(unsigned char)c])  {
-                is.Take();
+            else if (codepoint >= 0x010000 && codepoint <= 0x10FFFF) {
+                // Surrogate pair
+                unsigned s = codepoint - 0x010000;
+                unsigned lead = (s >> 10) + 0xD800;
+                unsigned trail = (s & 0x3FF) + 0xDC00;
+                os_->Put(hexDigits[(lead >> 12) & 15]);
+                os_->Put(hexDigits[(lead >>  8) & 15]);
+                os_->Put(hexDigits[(lead >>  4) & 15]);
+                os_->Put(hexDigits[(lead      ) & 15]);
                 os_->Put('\\');
-                os_->Put(escape[(unsigned char)c]);
-                if (escape[(unsigned char)c] == 'u') {
-                    os_->Put('0');
-                    os_->Put('0');
-                    os_->Put(hexDigits[(unsigned char)c >> 4]);
-                    os_->Put(hexDigits[(unsigned char)c & 0xF]);
-                }
+                os_->Put('u');
+                os_->Put(hexDigits[(trail >> 12) & 15]);
+                os_->Put(hexDigits[(trail >>  8) & 15]);
+                os_->Put(hexDigits[(trail >>  4) & 15]);
+                os_->Put(hexDigits[(trail      ) & 15]);
             }
             else
-                Transcoder<SourceEncoding, TargetEncoding>::Transcode(is, *os_);
+                return false; // invalid code point
         }
-        os_->Put('\"');
+        else if ((sizeof(Ch) == 1 || (unsigned)c < 256) && escape[(unsigned char)c])  {
+            is.Take();
+            os_->Put('\\');
+            os_->Put(escape[(unsigned char)c]);
+            if (escape[(unsigned char)c] == 'u') {
+                os_->Put('0');
+                os_->Put('0');
+                os_->Put(hexDigits[(unsigned char)c >> 4]);
+                os_->Put(hexDigits[(unsigned char)c & 0xF]);
+            }
+        }
+        else
+            Transcoder<SourceEncoding, TargetEncoding>::Transcode(is, *os_);
         return true;
     }
 
@@ -426,9 +599,11 @@ protected:
     OutputStream* os_;
     internal::Stack<Allocator> level_stack_;
     int doublePrecision_;
+    int fixedDecimals_;
     bool hasRoot_;
 
-    static const int kDefaultDoublePrecision = 6;
+    static const int kDefaultDoublePrecision = 0;
+    static const int kDefaultFixedDecimals = -1;
 
 private:
     // Prohibit copy constructor & assignment operator.
@@ -470,6 +645,14 @@ inline bool WriterJson<StringBuffer>::WriteUint64(uint64_t u) {
     return true;
 }
 
+template<>
+inline bool WriterJson<StringBuffer>::WriteDouble(double d) {
+    char *buffer = os_->Push(internal::kDtoaBufferSize);
+    const char* end = fixedDecimals_ >= 0 ? internal::fixedtoa(d, buffer, fixedDecimals_) : internal::dtoa(d, buffer, doublePrecision_);
+    os_->Pop(internal::kDtoaBufferSize - (end - buffer));
+    return true;
+}
+
 } // namespace rapidjsonxml
 
 #ifdef _MSC_VER
@@ -5,8 +5,10 @@
 #include "internal/stack.h"
 #include "internal/strfunc.h"
 #include "internal/itoa.h"
+#include "internal/dtoa.h"
+#include "internal/meta.h"
 #include "stringbuffer.h"
-#include <cstdio>   // snprintf() or _sprintf_s()
+#include "simd.h"
 #include <new>      // placement new
 
 #ifdef _MSC_VER
@@ -16,6 +18,105 @@ RAPIDJSONXML_DIAG_OFF(4127) // conditional expression is constant
 
 namespace rapidjsonxml {
 
+#ifdef RAPIDJSONXML_SIMD
+//! Find the first character which has to be escaped by WriterXml, testing 16 8-byte characters at once.
+/*! Control characters (0x00~0x1F) and '&' are escaped, other characters are copied.
+    Only 16-byte aligned blocks are loaded, so no memory page boundary is crossed
+    before \c p or after \c end.
+    \return Pointer to the first character to escape, or \c end if none.
+    \note The same SSE2 instructions are used for RAPIDJSONXML_SSE42: a range
+    comparison with pcmpestrm is slower than the three SSE2 comparisons.
+*/
+RAPIDJSONXML_TARGET_SSE2 inline const char* ScanXmlEscape_SSE2(const char* p, const char* end) {
+    if (p == end)
+        return end;
+
+    const __m128i k1F = _mm_set1_epi8(0x1F);
+    const __m128i kAmp = _mm_set1_epi8('&');
+
+    // 16-byte align to the lower boundary
+    const char* ap = reinterpret_cast<const char*>(reinterpret_cast<size_t>(p) & ~static_cast<size_t>(15));
+    unsigned shift = static_cast<unsigned>(p - ap);
+
+    for (;; ap += 16) {
+        const __m128i s = _mm_load_si128(reinterpret_cast<const __m128i*>(ap));
+        const __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(s, k1F), k1F); // s <= 0x1F
+        const __m128i x = _mm_or_si128(control, _mm_cmpeq_epi8(s, kAmp));
+        unsigned r = static_cast<unsigned>(_mm_movemask_epi8(x));
+        r = r >> shift << shift; // Clear results before p
+        shift = 0;
+        if (end - ap <= 16)
+            r &= (1u << (end - ap)) - 1; // Clear results after end
+        if (r != 0) {
+#ifdef _MSC_VER // Find the index of first escaped character
+            unsigned long offset;
+            _BitScanForward(&offset, r);
+            return ap + offset;
+#else
+            return ap + __builtin_ffs(static_cast<int>(r)) - 1;
+#endif
+        }
+        if (end - ap <= 16)
+            return end;
+    }
+}
+
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+//! Find the first character which has to be escaped by WriterXml, testing 32 8-byte characters at once with AVX2 instructions.
+RAPIDJSONXML_TARGET_AVX2 inline const char* ScanXmlEscape_AVX2(const char* p, const char* end) {
+    if (p == end)
+        return end;
+
+    const __m256i k1F = _mm256_set1_epi8(0x1F);
+    const __m256i kAmp = _mm256_set1_epi8('&');
+
+    // 32-byte align to the lower boundary
+    const char* ap = reinterpret_cast<const char*>(reinterpret_cast<size_t>(p) & ~static_cast<size_t>(31));
+    unsigned shift = static_cast<unsigned>(p - ap);
+
+    for (;; ap += 32) {
+        const __m256i s = _mm256_load_si256(reinterpret_cast<const __m256i*>(ap));
+        const __m256i control = _mm256_cmpeq_epi8(_mm256_max_epu8(s, k1F), k1F); // s <= 0x1F
+        const __m256i x = _mm256_or_si256(control, _mm256_cmpeq_epi8(s, kAmp));
+        unsigned r = static_cast<unsigned>(_mm256_movemask_epi8(x));
+        r = r >> shift << shift; // Clear results before p
+        shift = 0;
+        if (end - ap < 32)
+            r &= (1u << (end - ap)) - 1; // Clear results after end
+        if (r != 0) {
+#ifdef _MSC_VER // Find the index of first escaped character
+            unsigned long offset;
+            _BitScanForward(&offset, r);
+            return ap + offset;
+#else
+            return ap + __builtin_ffs(static_cast<int>(r)) - 1;
+#endif
+        }
+        if (end - ap <= 32)
+            return end;
+    }
+}
+
+//! Find the first character which has to be escaped by WriterXml one at a time, for CPUs without SSE2.
+inline const char* ScanXmlEscape_Scalar(const char* p, const char* end) {
+    while (p != end && static_cast<unsigned char>(*p) >= 0x20 && *p != '&')
+        ++p;
+    return p;
+}
+#endif // RAPIDJSONXML_SIMD_DISPATCH
+
+//! Find the first character which has to be escaped by WriterXml with the selected SIMD instructions.
+inline const char* ScanXmlEscape_SIMD(const char* p, const char* end) {
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+    typedef const char* (*Kernel)(const char*, const char*);
+    static const Kernel kKernels[kSimdLevelCount] = { ScanXmlEscape_Scalar, ScanXmlEscape_SSE2, ScanXmlEscape_SSE2, ScanXmlEscape_AVX2 };
+    return kKernels[GetSimdLevel()](p, end);
+#else
+    return ScanXmlEscape_SSE2(p, end);
+#endif
+}
+#endif // RAPIDJSONXML_SIMD
+
 //! XML writer
 /*! WriterXml implements the concept Handler.
     It generates XML text by events to an output os.
@@ -36,6 +137,7 @@ template<typename OutputStream, typename SourceEncoding = UTF8<>, typename Targe
 class WriterXml {
 public:
     typedef typename SourceEncoding::Ch Ch;
+    typedef typename TargetEncoding::Ch TargetCh;
     typedef typename GenericValue<SourceEncoding, Allocator>::ConstAttributeIterator ConstAttributeIterator;
     typedef GenericAttributeIteratorPair<SourceEncoding, Allocator> AttributeIteratorPair;
     typedef AttributeIteratorPair* AttributeIteratorPairList;
@@ -46,21 +148,18 @@ public:
         \param levelDepth Initial capacity of stack.
     */
     WriterXml(OutputStream& os, Allocator* allocator = 0, size_t levelDepth = kDefaultLevelDepth) :
-        os_(&os), level_stack_(allocator, levelDepth * sizeof(Level)),
-        doublePrecision_(kDefaultDoublePrecision), hasRoot_(false),
-        lastTag(0), lastTagSize(0), lastAttrib() {}
+        os_(&os), level_stack_(allocator, levelDepth * sizeof(Level)), tag_stack_(allocator, kDefaultTagCapacity),
+        separator_stack_(allocator, kDefaultTagCapacity),
+        doublePrecision_(kDefaultDoublePrecision), fixedDecimals_(kDefaultFixedDecimals), hasRoot_(false),
+        lastTag(0), lastTagSize(0), hasLastTag(false), lastAttrib() {}
 
     WriterXml(Allocator* allocator = 0, size_t levelDepth = kDefaultLevelDepth) :
-        os_(0), level_stack_(allocator, levelDepth * sizeof(Level)),
-        doublePrecision_(kDefaultDoublePrecision), hasRoot_(false),
-        lastTag(0), lastTagSize(0), lastAttrib() {}
+        os_(0), level_stack_(allocator, levelDepth * sizeof(Level)), tag_stack_(allocator, kDefaultTagCapacity),
+        separator_stack_(allocator, kDefaultTagCapacity),
+        doublePrecision_(kDefaultDoublePrecision), fixedDecimals_(kDefaultFixedDecimals), hasRoot_(false),
+        lastTag(0), lastTagSize(0), hasLastTag(false), lastAttrib() {}
 
-    virtual ~WriterXml() {
-        delete lastTag;
-        lastTag = 0;
-        lastTagSize = 0;
-        lastAttrib = AttributeIteratorPair();
-    }
+    virtual ~WriterXml() {}
 
     //! Reset the writer with a new stream.
     /*!
@@ -83,13 +182,15 @@ public:
     void Reset(OutputStream& os) {
         os_ = &os;
         doublePrecision_ = kDefaultDoublePrecision;
+        fixedDecimals_ = kDefaultFixedDecimals;
         hasRoot_ = false;
         level_stack_.Clear();
+        tag_stack_.Clear(); // keeps its capacity, so a reused writer does not allocate again
+        separator_stack_.Clear();
 
-        delete lastTag;
         lastTag = 0;
         lastTagSize = 0;
-
+        hasLastTag = false;
         lastAttrib = AttributeIteratorPair();
     }
 
@@ -102,9 +203,11 @@ public:
     }
 
     //! Set the number of significant digits for \c double values
-    /*! When writing a \c double value to the \c OutputStream, the number
-        of significant digits is limited to 6 by default.
-        \param p maximum number of significant digits (default: 6)
+    /*! When writing a \c double value to the \c OutputStream, the shortest
+        representation which converts back to the same value is written by default.
+        Otherwise the value is rounded to the given number of significant digits,
+        as with \c printf("%.*g").
+        \param p maximum number of significant digits, 0 for the shortest representation (default: 0)
         \return The WriterXml itself for fluent API.
     */
     WriterXml& SetDoublePrecision(int p = kDefaultDoublePrecision) {
@@ -118,6 +221,24 @@ public:
         return doublePrecision_;
     }
 
+    //! Set a fixed number of decimals for \c double values
+    /*! When set, \c double values are written as with \c printf("%.*f"), correctly
+        rounded, instead of the format selected by \ref SetDoublePrecision().
+        Every finite value gets exactly \c n decimals, whatever its magnitude.
+        \param n number of decimals, up to 18, or negative to disable (default: disabled)
+        \return The WriterXml itself for fluent API.
+    */
+    WriterXml& SetFixedDecimals(int n = kDefaultFixedDecimals) {
+        if (n > internal::kMaxFixedDecimals) n = internal::kMaxFixedDecimals;
+        fixedDecimals_ = n < 0 ? kDefaultFixedDecimals : n;
+        return *this;
+    }
+
+    //! \see SetFixedDecimals()
+    int GetFixedDecimals() const {
+        return fixedDecimals_;
+    }
+
     /*!@name Implementation of Handler
         \see Handler
     */
@@ -150,8 +271,9 @@ public:
 
     //! Writes the given \c double value to the stream
     /*!
-        The number of significant digits (the precision) to be written
-        can be set by \ref SetDoublePrecision() for the WriterXml:
+        By default the shortest representation which reads back as the same
+        \c double is written. The number of significant digits (the precision)
+        to be written can be set by \ref SetDoublePrecision() for the WriterXml:
         \code
         WriterXml<...> writer(...);
         writer.SetDoublePrecision(12).Double(M_PI);
@@ -180,6 +302,7 @@ public:
         (void)memberCount;
         RAPIDJSONXML_ASSERT(level_stack_.GetSize() >= sizeof(Level));
         RAPIDJSONXML_ASSERT(!level_stack_.template Top<Level>()->inArray);
+        DiscardLastTag();
         level_stack_.template Pop<Level>(1);
         if (level_stack_.Empty()) // end of json text
             os_->Flush();
@@ -188,15 +311,26 @@ public:
 
     bool StartArray() {
         Prefix(kArrayType);
-        Level* level = new (level_stack_.template Push<Level>()) Level(true);
-        // Copy last tag reference
-        level->tag = lastTag;
-        level->tagSize = lastTagSize;
-        level->attrib = lastAttrib;
-        // Reset last tag reference
-        lastTag = 0;
-        lastTagSize = 0;
-        lastAttrib = AttributeIteratorPair();
+        Level level(true);
+        if (hasLastTag) {
+            // Take ownership of the last tag, it will be released by EndArray()
+            level.tag = lastTag;
+            level.tagSize = lastTagSize;
+            level.tagOwned = true;
+            level.attrib = lastAttrib;
+            hasLastTag = false;
+            lastTag = 0;
+            lastTagSize = 0;
+            lastAttrib = AttributeIteratorPair();
+        }
+        else if (level_stack_.GetSize() != 0 && level_stack_.template Top<Level>()->inArray) {
+            // Nested array: repeat the tag of the enclosing array
+            const Level* parent = level_stack_.template Top<Level>();
+            level.tag = parent->tag;
+            level.tagSize = parent->tagSize;
+            level.attrib = parent->attrib;
+        }
+        new (level_stack_.template Push<Level>()) Level(level);
         return true;
     }
 
@@ -204,7 +338,16 @@ public:
         (void)elementCount;
         RAPIDJSONXML_ASSERT(level_stack_.GetSize() >= sizeof(Level));
         RAPIDJSONXML_ASSERT(level_stack_.template Top<Level>()->inArray);
-        level_stack_.template Pop<Level>(1);
+        DiscardLastTag();
+        Level* level = level_stack_.template Pop<Level>(1);
+        if (level->tagOwned) {
+            RAPIDJSONXML_ASSERT(tag_stack_.GetSize() == (level->tag + level->tagSize) * sizeof(Ch));
+            tag_stack_.template Pop<Ch>(level->tagSize);
+        }
+        if (level->hasSeparator) {
+            RAPIDJSONXML_ASSERT(separator_stack_.GetSize() == (level->separator + level->separatorSize) * sizeof(TargetCh));
+            separator_stack_.template Pop<TargetCh>(level->separatorSize);
+        }
         if (level_stack_.Empty()) // end of json text
             os_->Flush();
         return true;
@@ -212,30 +355,15 @@ public:
 
     bool OpenTag(const Ch* str, SizeType length, const AttributeIteratorPairList attribs_list, bool copy = false) {
         (void)copy;
-        os_->Put('<');
-        if(!WriteString(str, length))
+        if (!WriteOpenTag(str, length, attribs_list))
             return false;
-        if (attribs_list) {
-            for (int i = 0; i < 2; ++i) {
-                AttributeIteratorPairList a = attribs_list + i;
-                if (a->IsValid()) {
-                    for (ConstAttributeIterator it = a->begin; it != a->end; ++it) {
-                        os_->Put(' ');
-                        WriteString(it->GetName(), it->GetNameLength());
-                        os_->Put('=');
-                        os_->Put('"');
-                        WriteString(it->GetValue(), it->GetValueLength());
-                        os_->Put('"');
-                    }
-                }
-            }
-        }
-        os_->Put('>');
 
-        // Save last tag
-        delete lastTag;
-        lastTag = strndup(str, length);
+        // Save last tag into the tag stack, it is needed if the value is an array
+        DiscardLastTag();
+        lastTag = tag_stack_.GetSize() / sizeof(Ch);
         lastTagSize = length;
+        hasLastTag = true;
+        memcpy(tag_stack_.template Push<Ch>(length), str, length * sizeof(Ch));
         if (attribs_list) {
             lastAttrib = *attribs_list;
         }
@@ -248,11 +376,7 @@ public:
 
     bool CloseTag(const Ch* str, SizeType length, bool copy = false) {
         (void)copy;
-        os_->Put('<'); os_->Put('/');
-        if(!WriteString(str, length))
-            return false;
-        os_->Put('>');
-        return true;
+        return WriteCloseTag(str, length);
     }
     //@}
 
@@ -276,6 +400,23 @@ public:
         return ret;
     }
 
+    //! Writes the given \c double value to the stream with a fixed number of decimals
+    /*!
+        The currently set double format is ignored in favor of the explicitly
+        given number of decimals for this value.
+        \see Double(), SetFixedDecimals(), GetFixedDecimals()
+        \param d The value to be written
+        \param decimals The number of decimals for this value
+        \return Whether it is succeeded.
+    */
+    bool FixedDouble(double d, int decimals) {
+        int oldDecimals = GetFixedDecimals();
+        SetFixedDecimals(decimals);
+        bool ret = Double(d);
+        SetFixedDecimals(oldDecimals);
+        return ret;
+    }
+
     //! Simpler but slower overload.
     bool String(const Ch* str) {
         return String(str, internal::StrLen(str));
@@ -286,16 +427,114 @@ public:
 protected:
     //! Information for each nested level
     struct Level {
-        Level(bool inArray_) : valueCount(0), inArray(inArray_), tag(0), tagSize(0), attrib() {}
-        ~Level() { delete tag; }
+        Level(bool inArray_) : valueCount(0), inArray(inArray_), tag(0), tagSize(0), tagOwned(false), attrib(),
+            separator(0), separatorSize(0), hasSeparator(false) {}
         size_t valueCount;  //!< number of values in this level
         bool inArray;       //!< true if in array, otherwise in object
-        const Ch* tag;
-        SizeType tagSize;
+        size_t tag;         //!< offset (in characters) of the tag name in tag_stack_
+        SizeType tagSize;   //!< length of the tag name
+        bool tagOwned;      //!< true if the tag name has to be popped from tag_stack_ with this level
         AttributeIteratorPair attrib;
+        size_t separator;       //!< offset (in characters) of the rendered "</tag><tag attribs>" in separator_stack_
+        size_t separatorSize;   //!< length of the rendered separator
+        bool hasSeparator;      //!< true if the separator has been rendered for this level
+    };
+
+    //! Output stream appending to separator_stack_
+    struct SeparatorStream {
+        typedef TargetCh Ch;
+        SeparatorStream(internal::Stack<Allocator>& stack) : stack_(stack) {}
+        void Put(Ch c) { *stack_.template Push<Ch>() = c; }
+        void Flush() {}
+        internal::Stack<Allocator>& stack_;
+    private:
+        SeparatorStream& operator=(const SeparatorStream&);
     };
 
     static const size_t kDefaultLevelDepth = 32;
+    static const size_t kDefaultTagCapacity = 256;
+
+    bool WriteOpenTag(const Ch* str, SizeType length, const AttributeIteratorPairList attribs_list) {
+        return WriteOpenTag(*os_, str, length, attribs_list);
+    }
+
+    template <typename OS>
+    static bool WriteOpenTag(OS& os, const Ch* str, SizeType length, const AttributeIteratorPairList attribs_list) {
+        os.Put('<');
+        if(!WriteString(os, str, length))
+            return false;
+        if (attribs_list) {
+            for (int i = 0; i < 2; ++i) {
+                AttributeIteratorPairList a = attribs_list + i;
+                if (a->IsValid()) {
+                    for (ConstAttributeIterator it = a->begin; it != a->end; ++it) {
+                        os.Put(' ');
+                        if (!WriteString(os, it->GetName(), it->GetNameLength()))
+                            return false;
+                        os.Put('=');
+                        os.Put('"');
+                        if (!WriteString(os, it->GetValue(), it->GetValueLength()))
+                            return false;
+                        os.Put('"');
+                    }
+                }
+            }
+        }
+        os.Put('>');
+        return true;
+    }
+
+    bool WriteCloseTag(const Ch* str, SizeType length) {
+        return WriteCloseTag(*os_, str, length);
+    }
+
+    template <typename OS>
+    static bool WriteCloseTag(OS& os, const Ch* str, SizeType length) {
+        os.Put('<'); os.Put('/');
+        if(!WriteString(os, str, length))
+            return false;
+        os.Put('>');
+        return true;
+    }
+
+    //! Render the separator between two items of the array level into separator_stack_.
+    /*! The separator closes the previous item and opens the next one with the
+        attributes of the array, it is rendered once and copied for every next item.
+        \return false if the tag or the attributes cannot be encoded.
+    */
+    bool RenderSeparator(Level& level) {
+        const Ch* tag = tag_stack_.template Bottom<Ch>() + level.tag;
+        AttributeIteratorPair attribs_list[2];
+        attribs_list[0] = level.attrib;
+
+        size_t begin = separator_stack_.GetSize();
+        SeparatorStream ss(separator_stack_);
+        if (!WriteCloseTag(ss, tag, level.tagSize) || !WriteOpenTag(ss, tag, level.tagSize, attribs_list)) {
+            separator_stack_.template Pop<char>(separator_stack_.GetSize() - begin);
+            return false;
+        }
+        level.separator = begin / sizeof(TargetCh);
+        level.separatorSize = (separator_stack_.GetSize() - begin) / sizeof(TargetCh);
+        level.hasSeparator = true;
+        return true;
+    }
+
+    //! Write already encoded characters to the stream.
+    void WriteRaw(const TargetCh* str, size_t length) {
+        PutBlock(*os_, str, length);
+    }
+
+    //! Release the last tag saved by OpenTag() if no array has taken it.
+    void DiscardLastTag() {
+        if (hasLastTag) {
+            RAPIDJSONXML_ASSERT(tag_stack_.GetSize() == (lastTag + lastTagSize) * sizeof(Ch));
+            tag_stack_.template Pop<Ch>(lastTagSize);
+            hasLastTag = false;
+        }
+        lastTag = 0;
+        lastTagSize = 0;
+        lastAttrib = AttributeIteratorPair();
+    }
 
     bool WriteNull()  {
         os_->Put('n');
@@ -354,24 +593,35 @@ protected:
         return true;
     }
 
-#ifdef _MSC_VER
-#define RAPIDJSONXML_SNPRINTF sprintf_s
-#else
-#define RAPIDJSONXML_SNPRINTF snprintf
-#endif
-
-    //! \todo Optimization with custom double-to-string converter.
     bool WriteDouble(double d) {
-        char buffer[100];
-        int ret = RAPIDJSONXML_SNPRINTF(buffer, sizeof(buffer), "%.*g", doublePrecision_, d);
-        RAPIDJSONXML_ASSERT(ret >= 1);
-        for (int i = 0; i < ret; i++)
-            os_->Put(buffer[i]);
+        char buffer[internal::kDtoaBufferSize];
+        const char* end = fixedDecimals_ >= 0 ? internal::fixedtoa(d, buffer, fixedDecimals_) : internal::dtoa(d, buffer, doublePrecision_);
+        for (const char* p = buffer; p != end; ++p)
+            os_->Put(*p);
         return true;
     }
-#undef RAPIDJSONXML_SNPRINTF
 
     bool WriteString(const Ch* str, SizeType length)  {
+#ifdef RAPIDJSONXML_SIMD
+        // Same 8-bit unicode encoding (UTF-8): copy the runs without escaping as blocks
+        if (sizeof(Ch) == 1 && internal::IsSame<SourceEncoding, TargetEncoding>::Value && TargetEncoding::supportUnicode) {
+            const char* p = reinterpret_cast<const char*>(str);
+            const char* end = p + length;
+            for (;;) {
+                const char* q = ScanXmlEscape_SIMD(p, end);
+                PutBlock(*os_, reinterpret_cast<const TargetCh*>(p), static_cast<size_t>(q - p));
+                if (q == end)
+                    return true;
+                WriteString(*os_, reinterpret_cast<const Ch*>(q), 1);
+                p = q + 1;
+            }
+        }
+#endif
+        return WriteString(*os_, str, length);
+    }
+
+    template <typename OS>
+    static bool WriteString(OS& os, const Ch* str, SizeType length)  {
         static const char hexDigits[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
         static const char escape[256] = {
 #define Z16 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
@@ -392,48 +642,48 @@ protected:
                 unsigned codepoint;
                 if (!SourceEncoding::Decode(is, &codepoint))
                     return false;
-                os_->Put('&');
-                os_->Put('#');
-                os_->Put('x');
+                os.Put('&');
+                os.Put('#');
+                os.Put('x');
                 if (codepoint <= 0xD7FF || (codepoint >= 0xE000 && codepoint <= 0xFFFF)) {
-                    os_->Put(hexDigits[(codepoint >> 12) & 15]);
-                    os_->Put(hexDigits[(codepoint >>  8) & 15]);
-                    os_->Put(hexDigits[(codepoint >>  4) & 15]);
-                    os_->Put(hexDigits[(codepoint      ) & 15]);
+                    os.Put(hexDigits[(codepoint >> 12) & 15]);
+                    os.Put(hexDigits[(codepoint >>  8) & 15]);
+                    os.Put(hexDigits[(codepoint >>  4) & 15]);
+                    os.Put(hexDigits[(codepoint      ) & 15]);
                 }
                 else if (codepoint >= 0x010000 && codepoint <= 0x10FFFF) {
                     // Surrogate pair
                     unsigned s = codepoint - 0x010000;
                     unsigned lead = (s >> 10) + 0xD800;
                     unsigned trail = (s & 0x3FF) + 0xDC00;
-                    os_->Put(hexDigits[(lead >> 12) & 15]);
-                    os_->Put(hexDigits[(lead >>  8) & 15]);
-                    os_->Put(hexDigits[(lead >>  4) & 15]);
-                    os_->Put(hexDigits[(lead      ) & 15]);
-                    os_->Put(hexDigits[(trail >> 12) & 15]);
-                    os_->Put(hexDigits[(trail >>  8) & 15]);
-                    os_->Put(hexDigits[(trail >>  4) & 15]);
-                    os_->Put(hexDigits[(trail      ) & 15]);
+                    os.Put(hexDigits[(lead >> 12) & 15]);
+                    os.Put(hexDigits[(lead >>  8) & 15]);
+                    os.Put(hexDigits[(lead >>  4) & 15]);
+                    os.Put(hexDigits[(lead      ) & 15]);
+                    os.Put(hexDigits[(trail >> 12) & 15]);
+                    os.Put(hexDigits[(trail >>  8) & 15]);
+                    os.Put(hexDigits[(trail >>  4) & 15]);
+                    os.Put(hexDigits[(trail      ) & 15]);
                 }
                 else
                     return false; // invalid code point
-                os_->Put(';');
+                os.Put(';');
             }
             else if ((sizeof(Ch) == 1 || (unsigned)c < 256) && escape[(unsigned char)c])  {
                 is.Take();
-                os_->Put('&');
-                os_->Put(escape[(unsigned char)c]);
+                os.Put('&');
+                os.Put(escape[(unsigned char)c]);
                 if (escape[(unsigned char)c] == '#') {
-                    os_->Put('x');
-                    os_->Put('0');
-                    os_->Put('0');
-                    os_->Put(hexDigits[(unsigned char)c >> 4]);
-                    os_->Put(hexDigits[(unsigned char)c & 0xF]);
+                    os.Put('x');
+                    os.Put('0');
+                    os.Put('0');
+                    os.Put(hexDigits[(unsigned char)c >> 4]);
+                    os.Put(hexDigits[(unsigned char)c & 0xF]);
                 }
-                os_->Put(';');
+                os.Put(';');
             }
             else
-                Transcoder<SourceEncoding, TargetEncoding>::Transcode(is, *os_);
+                Transcoder<SourceEncoding, TargetEncoding>::Transcode(is, os);
         }
         return true;
     }
@@ -442,14 +692,23 @@ protected:
         (void)type;
         if (level_stack_.GetSize() != 0) { // this value is not at root
             Level* level = level_stack_.template Top<Level>();
-            if (level->inArray && level->valueCount > 0) {
-                CloseTag(level->tag, level->tagSize);
+            if (level->inArray) {
+                DiscardLastTag(); // tag of a member of the previous item
+                if (level->valueCount > 0) {
+                    if (!attribs.IsValid() && (level->hasSeparator || RenderSeparator(*level))) {
+                        WriteRaw(separator_stack_.template Bottom<TargetCh>() + level->separator, level->separatorSize);
+                    }
+                    else {
+                        const Ch* tag = tag_stack_.template Bottom<Ch>() + level->tag;
+                        WriteCloseTag(tag, level->tagSize);
 
-                AttributeIteratorPair attribs_list[2];
-                attribs_list[0] = level->attrib;
-                attribs_list[1] = attribs;
+                        AttributeIteratorPair attribs_list[2];
+                        attribs_list[0] = level->attrib;
+                        attribs_list[1] = attribs;
 
-                OpenTag(level->tag, level->tagSize, attribs_list, false);
+                        WriteOpenTag(tag, level->tagSize, attribs_list);
+                    }
+                }
             }
             level->valueCount++;
         }
@@ -462,13 +721,18 @@ protected:
 
     OutputStream* os_;
     internal::Stack<Allocator> level_stack_;
+    internal::Stack<Allocator> tag_stack_;  //!< Tag names of the open arrays, followed by the last opened tag
+    internal::Stack<Allocator> separator_stack_;    //!< Rendered separators of the open arrays
     int doublePrecision_;
+    int fixedDecimals_;
     bool hasRoot_;
 
-    static const int kDefaultDoublePrecision = 6;
+    static const int kDefaultDoublePrecision = 0;
+    static const int kDefaultFixedDecimals = -1;
 
-    Ch* lastTag;
+    size_t lastTag;                 //!< offset (in characters) of the last opened tag in tag_stack_
     SizeType lastTagSize;
+    bool hasLastTag;                //!< true if the last opened tag is still on top of tag_stack_
     AttributeIteratorPair lastAttrib;
 
 private:
@@ -511,6 +775,14 @@ inline bool WriterXml<StringBuffer>::WriteUint64(uint64_t u) {
     return true;
 }
 
+template<>
+inline bool WriterXml<StringBuffer>::WriteDouble(double d) {
+    char *buffer = os_->Push(internal::kDtoaBufferSize);
+    const char* end = fixedDecimals_ >= 0 ? internal::fixedtoa(d, buffer, fixedDecimals_) : internal::dtoa(d, buffer, doublePrecision_);
+    os_->Pop(internal::kDtoaBufferSize - (end - buffer));
+    return true;
+}
+
 } // namespace rapidjsonxml
 
 #ifdef _MSC_VER
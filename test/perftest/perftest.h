@@ -2,6 +2,7 @@
 #define PERFTEST_H_
 
 #define TEST_RAPIDJSON	1
+#define TEST_RAPIDJSONXML	1
 #define TEST_JSONCPP	0
 #define TEST_YAJL		0
 #define TEST_ULTRAJSON  0
@@ -17,6 +18,12 @@
 #define RAPIDJSON_SSE42
 #endif
 
+#if TEST_RAPIDJSONXML && !(defined(__GNUC__) && TEST_VERSION_CODE(__GNUC__,__GNUC_MINOR__,__GNUC_PATCHLEVEL__) < TEST_VERSION_CODE(4,3,0))
+//#define RAPIDJSONXML_SSE2
+#define RAPIDJSONXML_SSE42
+#define RAPIDJSONXML_SIMD_DISPATCH
+#endif
+
 #if TEST_YAJL
 #include "yajl/yajl_common.h"
 #undef YAJL_MAX_DEPTH
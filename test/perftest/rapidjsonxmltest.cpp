@@ -0,0 +1,1186 @@
+#include "perftest.h"
+
+#if TEST_RAPIDJSONXML
+
+#include "rapidjsonxml/rapidjsonxml.h"
+#include "rapidjsonxml/document.h"
+#include "rapidjsonxml/writerxml.h"
+#include "rapidjsonxml/writerjson.h"
+#include "rapidjsonxml/prettywriterjson.h"
+#include "rapidjsonxml/stringbuffer.h"
+#include "rapidjsonxml/tagadapter.h"
+#include "rapidjsonxml/memberaccessor.h"
+#include "rapidjsonxml/lazydocument.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+#define SIMD_SUFFIX(name) name##_Dispatch
+#elif defined(RAPIDJSONXML_SSE2)
+#define SIMD_SUFFIX(name) name##_SSE2
+#elif defined(RAPIDJSONXML_SSE42)
+#define SIMD_SUFFIX(name) name##_SSE42
+#else
+#define SIMD_SUFFIX(name) name
+#endif
+
+using namespace rapidjsonxml;
+
+class RapidJsonXml : public PerfTest {
+public:
+	RapidJsonXml() : temp_(), doc_() {}
+
+	virtual void SetUp() {
+		PerfTest::SetUp();
+
+		// temp buffer for insitu parsing.
+		temp_ = (char *)malloc(length_ + 1);
+
+		// Parse as a document
+		EXPECT_FALSE(doc_.Parse(json_).IsNull());
+	}
+
+	virtual void TearDown() {
+		PerfTest::TearDown();
+		free(temp_);
+	}
+
+private:
+	RapidJsonXml(const RapidJsonXml&);
+	RapidJsonXml& operator=(const RapidJsonXml&);
+
+protected:
+	char *temp_;
+	Document doc_;
+};
+
+// Output stream that discards everything
+struct NullStream {
+	typedef char Ch;
+
+	NullStream() : length_(0) {}
+	void Put(Ch) { ++length_; }
+	void Flush() {}
+	size_t length_;
+};
+
+// Allocator which counts the requests made to it
+class CountingAllocator {
+public:
+	static const bool kNeedFree = true;
+	CountingAllocator() : count_(0) {}
+	void* Malloc(size_t size) { ++count_; return malloc(size); }
+	void* Realloc(void* originalPtr, size_t originalSize, size_t newSize) { (void)originalSize; ++count_; return realloc(originalPtr, newSize); }
+	static void Free(void *ptr) { free(ptr); }
+	size_t count_;
+};
+
+TEST_F(RapidJsonXml, WriterXml_NullStream) {
+	for (size_t i = 0; i < kTrialCount; i++) {
+		NullStream s;
+		WriterXml<NullStream> writer(s);
+		doc_.Accept(writer);
+		//if (i == 0)
+		//	std::cout << s.length_ << std::endl;
+	}
+}
+
+TEST_F(RapidJsonXml, WriterXml_StringBuffer) {
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringBuffer s(0, 1024 * 1024);
+		WriterXml<StringBuffer> writer(s);
+		doc_.Accept(writer);
+		const char* str = s.GetString();
+		(void)str;
+		//if (i == 0)
+		//	std::cout << strlen(str) << std::endl;
+	}
+}
+
+TEST_F(RapidJsonXml, WriterXml_ArrayItems) {
+	// 100k numbers in a single array with attributes: every item repeats the tag
+	Document d;
+	d.SetObject();
+	Value a(kArrayType);
+	for (int i = 0; i < 100000; i++)
+		a.PushBack(i, d.GetAllocator());
+	Value::AttributeType attrib("unit", "millisecond");
+	a.AddAttribute(attrib, d.GetAllocator());
+	d.AddMember("measurement_value", a, d.GetAllocator());
+
+	for (size_t i = 0; i < 100; i++) {
+		StringBuffer s(0, 1024 * 1024);
+		WriterXml<StringBuffer> writer(s);
+		d.Accept(writer);
+	}
+}
+
+// 10k text members of ~200 characters, one in ten with a character to escape
+static void MakeTextDocument(Document& d, const char* text) {
+	d.SetObject();
+	Value a(kArrayType);
+	for (int i = 0; i < 10000; i++) {
+		Value v(text, d.GetAllocator());
+		if (i % 10 == 0)
+			const_cast<char*>(v.GetString())[i % 100] = '&';
+		a.PushBack(v, d.GetAllocator());
+	}
+	d.AddMember("text", a, d.GetAllocator());
+}
+
+static const char kAsciiText[] =
+	"Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore "
+	"et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud exercitation ullamco laboris nisi ut.";
+static const char kUnicodeText[] =
+	"Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore "
+	"et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud \"exercitation\" ullamco \xC3\xA9\xE2\x82\xAC.";
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(WriterXml_Strings)) {
+	Document d;
+	MakeTextDocument(d, kAsciiText);
+
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringBuffer s(0, 4 * 1024 * 1024);
+		WriterXml<StringBuffer> writer(s);
+		d.Accept(writer);
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(WriterJson_StringBuffer)) {
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringBuffer s(0, 1024 * 1024);
+		WriterJson<StringBuffer> writer(s);
+		doc_.Accept(writer);
+		const char* str = s.GetString();
+		(void)str;
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(PrettyWriterJson_StringBuffer)) {
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringBuffer s(0, 2 * 1024 * 1024);
+		PrettyWriterJson<StringBuffer> writer(s);
+		writer.SetIndent(' ', 1);
+		doc_.Accept(writer);
+		const char* str = s.GetString();
+		(void)str;
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(WriterJson_Strings)) {
+	Document d;
+	MakeTextDocument(d, kUnicodeText);
+
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringBuffer s(0, 4 * 1024 * 1024);
+		WriterJson<StringBuffer> writer(s);
+		d.Accept(writer);
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(WriterJson_StringsAscii)) {
+	// ASCII only text written to an ASCII target
+	typedef GenericStringBuffer<ASCII<> > AsciiStringBuffer;
+	Document d;
+	MakeTextDocument(d, kAsciiText);
+
+	for (size_t i = 0; i < kTrialCount; i++) {
+		AsciiStringBuffer s(0, 4 * 1024 * 1024);
+		WriterJson<AsciiStringBuffer, UTF8<>, ASCII<> > writer(s);
+		d.Accept(writer);
+	}
+}
+
+// Document with an array of 10000 doubles with various magnitudes and digit counts
+static void MakeNumberDocument(Document& d) {
+	d.SetObject();
+	Value a(kArrayType);
+	unsigned r = 1;
+	for (int i = 0; i < 10000; i++) {
+		r = r * 1103515245 + 12345;
+		double v = (double)(r >> 8) / (1 << 24);
+		switch (i % 4) {
+			case 0: v = v * 1000; break;                          // random, 17 digits
+			case 1: v = (double)(int)(v * 100000) / 100; break;   // short decimals
+			case 2: v = v * 1e-20; break;
+			default: v = -v * 1e200; break;
+		}
+		a.PushBack(v, d.GetAllocator());
+	}
+	d.AddMember("number", a, d.GetAllocator());
+}
+
+TEST_F(RapidJsonXml, WriterJson_Doubles) {
+	Document d;
+	MakeNumberDocument(d);
+
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringBuffer s(0, 1024 * 1024);
+		WriterJson<StringBuffer> writer(s);
+		d.Accept(writer);
+	}
+}
+
+TEST_F(RapidJsonXml, WriterJson_DoublesPrecision6) {
+	Document d;
+	MakeNumberDocument(d);
+
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringBuffer s(0, 1024 * 1024);
+		WriterJson<StringBuffer> writer(s);
+		writer.SetDoublePrecision(6);
+		d.Accept(writer);
+	}
+}
+
+TEST_F(RapidJsonXml, WriterXml_Doubles) {
+	Document d;
+	MakeNumberDocument(d);
+
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringBuffer s(0, 1024 * 1024);
+		WriterXml<StringBuffer> writer(s);
+		d.Accept(writer);
+	}
+}
+
+// Baseline: the same numbers formatted with snprintf("%.17g") and "%.6g"
+TEST_F(RapidJsonXml, Doubles_Snprintf17) {
+	Document d;
+	MakeNumberDocument(d);
+	const Value& a = d["number"];
+
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringBuffer s(0, 1024 * 1024);
+		for (Value::ConstValueIterator itr = a.Begin(); itr != a.End(); ++itr) {
+			char* buffer = s.Push(32);
+			s.Pop(32 - snprintf(buffer, 32, "%.17g", itr->GetDouble()));
+		}
+	}
+}
+
+TEST_F(RapidJsonXml, Doubles_Snprintf6) {
+	Document d;
+	MakeNumberDocument(d);
+	const Value& a = d["number"];
+
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringBuffer s(0, 1024 * 1024);
+		for (Value::ConstValueIterator itr = a.Begin(); itr != a.End(); ++itr) {
+			char* buffer = s.Push(32);
+			s.Pop(32 - snprintf(buffer, 32, "%.6g", itr->GetDouble()));
+		}
+	}
+}
+
+// Document with an array of 10000 metric values, like prices and latencies
+static void MakeMetricDocument(Document& d) {
+	d.SetObject();
+	Value a(kArrayType);
+	unsigned r = 1;
+	for (int i = 0; i < 10000; i++) {
+		r = r * 1103515245 + 12345;
+		a.PushBack((double)(r >> 8) / (1 << 24) * (i % 2 ? 100000 : 10), d.GetAllocator());
+	}
+	d.AddMember("metric", a, d.GetAllocator());
+}
+
+TEST_F(RapidJsonXml, WriterJson_FixedDecimals) {
+	Document d;
+	MakeMetricDocument(d);
+
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringBuffer s(0, 1024 * 1024);
+		WriterJson<StringBuffer> writer(s);
+		writer.SetFixedDecimals(2);
+		d.Accept(writer);
+	}
+}
+
+TEST_F(RapidJsonXml, WriterXml_FixedDecimals) {
+	Document d;
+	MakeMetricDocument(d);
+
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringBuffer s(0, 1024 * 1024);
+		WriterXml<StringBuffer> writer(s);
+		writer.SetFixedDecimals(2);
+		d.Accept(writer);
+	}
+}
+
+// Baseline: the same metrics formatted with snprintf("%.2f")
+TEST_F(RapidJsonXml, FixedDecimals_Snprintf) {
+	Document d;
+	MakeMetricDocument(d);
+	const Value& a = d["metric"];
+
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringBuffer s(0, 1024 * 1024);
+		for (Value::ConstValueIterator itr = a.Begin(); itr != a.End(); ++itr) {
+			char* buffer = s.Push(32);
+			s.Pop(32 - snprintf(buffer, 32, "%.2f", itr->GetDouble()));
+		}
+	}
+}
+
+// JSON text with 10000 [longitude, latitude] pairs with 6 to 15 decimals, like GeoJSON
+static std::string MakeCoordinatesJson() {
+	std::string json("[");
+	unsigned r = 1;
+	char buffer[64];
+	for (int i = 0; i < 10000; i++) {
+		r = r * 1103515245 + 12345;
+		double lon = (double)(r >> 8) / (1 << 24) * 360 - 180;
+		r = r * 1103515245 + 12345;
+		double lat = (double)(r >> 8) / (1 << 24) * 180 - 90;
+		int decimals = 6 + i % 10;
+		sprintf(buffer, "%s[%.*f,%.*f]", i ? "," : "", decimals, lon, decimals, lat);
+		json += buffer;
+	}
+	return json += "]";
+}
+
+TEST_F(RapidJsonXml, Reader_ParseCoordinates) {
+	std::string json = MakeCoordinatesJson();
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringStream s(json.c_str());
+		BaseReaderHandler<> h;
+		Reader reader;
+		EXPECT_TRUE(reader.Parse<kParseDefaultFlags>(s, h));
+	}
+}
+
+TEST_F(RapidJsonXml, Reader_ParseCoordinatesFullPrecision) {
+	std::string json = MakeCoordinatesJson();
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringStream s(json.c_str());
+		BaseReaderHandler<> h;
+		Reader reader;
+		EXPECT_TRUE(reader.Parse<kParseFullPrecisionFlag>(s, h));
+	}
+}
+
+// JSON text with 100000 IDs and timestamps of 10 to 19 digits
+static std::string MakeIntegersJson() {
+	std::string json("[");
+	uint64_t r = 1;
+	char buffer[32];
+	for (int i = 0; i < 100000; i++) {
+		r = r * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+		uint64_t u = (r >> 1) % UINT64_C(10000000000000000000);
+		uint64_t min = UINT64_C(1000000000);
+		for (int k = i % 10; k > 0; k--)
+			min *= 10;
+		sprintf(buffer, "%s%llu", i ? "," : "", (unsigned long long)(min + u % (9 * min)));
+		json += buffer;
+	}
+	return json += "]";
+}
+
+// Input stream without the specializations for contiguous memory
+struct GenericCharStream {
+	typedef char Ch;
+	GenericCharStream(const char* src) : src_(src), head_(src) {}
+	Ch Peek() const { return *src_; }
+	Ch Take() { return *src_++; }
+	size_t Tell() const { return static_cast<size_t>(src_ - head_); }
+	Ch* PutBegin() { return 0; }
+	void Put(Ch) {}
+	void Flush() {}
+	size_t PutEnd(Ch*) { return 0; }
+	const Ch* src_;
+	const Ch* head_;
+};
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(Reader_ParseIntegers)) {
+	std::string json = MakeIntegersJson();
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringStream s(json.c_str());
+		BaseReaderHandler<> h;
+		Reader reader;
+		EXPECT_TRUE(reader.Parse(s, h));
+	}
+}
+
+TEST_F(RapidJsonXml, Reader_ParseIntegers_GenericStream) {
+	std::string json = MakeIntegersJson();
+	for (size_t i = 0; i < kTrialCount; i++) {
+		GenericCharStream s(json.c_str());
+		BaseReaderHandler<> h;
+		Reader reader;
+		EXPECT_TRUE(reader.Parse(s, h));
+	}
+}
+
+// JSON text with 10000 strings of 100 to 200 characters, some with escapes
+static std::string MakeStringsJson() {
+	std::string json("[");
+	for (int i = 0; i < 10000; i++) {
+		json += i ? ",\"" : "\"";
+		json.append(kAsciiText, 100 + i % 100);
+		if (i % 4 == 0)
+			json += "\\n\\\"quoted\\\"\\u00e9";
+		json += '"';
+	}
+	return json += "]";
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(ReaderParse_DummyHandler)) {
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringStream s(json_);
+		BaseReaderHandler<> h;
+		Reader reader;
+		EXPECT_TRUE(reader.Parse(s, h));
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(ReaderParseInsitu_DummyHandler)) {
+	for (size_t i = 0; i < kTrialCount; i++) {
+		memcpy(temp_, json_, length_);
+		InsituStringStream s(temp_);
+		BaseReaderHandler<> h;
+		Reader reader;
+		EXPECT_TRUE(reader.Parse<kParseInsituFlag>(s, h));
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(ReaderParseInsitu_DummyHandler_ValidateEncoding)) {
+	for (size_t i = 0; i < kTrialCount; i++) {
+		memcpy(temp_, json_, length_);
+		InsituStringStream s(temp_);
+		BaseReaderHandler<> h;
+		Reader reader;
+		EXPECT_TRUE(reader.Parse<kParseInsituFlag | kParseValidateEncodingFlag>(s, h));
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(ReaderValidate)) {
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringStream s(json_);
+		Reader reader;
+		EXPECT_FALSE(reader.Validate(s).IsError());
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(ReaderValidate_ValidateEncoding)) {
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringStream s(json_);
+		Reader reader;
+		EXPECT_FALSE(reader.Validate<kParseValidateEncodingFlag>(s).IsError());
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(ReaderParse_DummyHandler_ValidateEncoding)) {
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringStream s(json_);
+		BaseReaderHandler<> h;
+		Reader reader;
+		EXPECT_TRUE(reader.Parse<kParseValidateEncodingFlag>(s, h));
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(ReaderParseStructural_DummyHandler)) {
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringStream s(json_);
+		BaseReaderHandler<> h;
+		Reader reader;
+		EXPECT_TRUE(reader.Parse<kParseStructuralIndexFlag>(s, h));
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(ReaderParseInsituStructural_DummyHandler)) {
+	for (size_t i = 0; i < kTrialCount; i++) {
+		memcpy(temp_, json_, length_);
+		InsituStringStream s(temp_);
+		BaseReaderHandler<> h;
+		Reader reader;
+		EXPECT_TRUE(reader.Parse<kParseInsituFlag | kParseStructuralIndexFlag>(s, h));
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(ReaderParse_Strings)) {
+	std::string json = MakeStringsJson();
+	for (size_t i = 0; i < kTrialCount; i++) {
+		StringStream s(json.c_str());
+		BaseReaderHandler<> h;
+		Reader reader;
+		EXPECT_TRUE(reader.Parse(s, h));
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(ReaderParseInsitu_Strings)) {
+	std::string json = MakeStringsJson();
+	std::string temp;
+	for (size_t i = 0; i < kTrialCount; i++) {
+		temp = json;
+		InsituStringStream s(&temp[0]);
+		BaseReaderHandler<> h;
+		Reader reader;
+		EXPECT_TRUE(reader.Parse<kParseInsituFlag>(s, h));
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(DocumentParse_MemoryPoolAllocator)) {
+	for (size_t i = 0; i < kTrialCount; i++) {
+		Document doc;
+		doc.Parse(json_);
+		ASSERT_TRUE(doc.IsObject());
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(DocumentParseInsitu_MemoryPoolAllocator)) {
+	for (size_t i = 0; i < kTrialCount; i++) {
+		memcpy(temp_, json_, length_);
+		Document doc;
+		doc.ParseInsitu(temp_);
+		ASSERT_TRUE(doc.IsObject());
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(DocumentParseBorrow_MemoryPoolAllocator)) {
+	for (size_t i = 0; i < kTrialCount; i++) {
+		Document doc;
+		doc.Parse<kParseBorrowStringsFlag>(json_);
+		ASSERT_TRUE(doc.IsObject());
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(DocumentParse_Strings)) {
+	std::string json = MakeStringsJson();
+	for (size_t i = 0; i < kTrialCount; i++) {
+		Document doc;
+		doc.Parse(json.c_str());
+		ASSERT_FALSE(doc.HasParseError());
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(DocumentParseBorrow_Strings)) {
+	std::string json = MakeStringsJson();
+	for (size_t i = 0; i < kTrialCount; i++) {
+		Document doc;
+		doc.Parse<kParseBorrowStringsFlag>(json.c_str());
+		ASSERT_FALSE(doc.HasParseError());
+	}
+}
+
+// Writes a document of elementCount elements: records with scalar members and array members.
+template <typename Writer>
+static size_t WriteRecords(Writer& writer, size_t elementCount) {
+	typedef typename Writer::Ch Ch;
+	static const Ch kRecord[] = "record";
+	static const Ch kId[] = "id";
+	static const Ch kName[] = "name";
+	static const Ch kTag[] = "tag";
+	static const Ch kValue[] = "value";
+	typename Writer::AttributeIteratorPair noAttrib;
+	typename Writer::AttributeIteratorPair attribs_list[2];
+
+	size_t n = 0;
+	writer.StartObject(noAttrib);
+	writer.OpenTag(kRecord, 6, attribs_list);
+	writer.StartArray();
+	while (n < elementCount) {
+		writer.StartObject(noAttrib);
+		writer.OpenTag(kId, 2, attribs_list);	writer.Uint((unsigned)n);	writer.CloseTag(kId, 2);
+		writer.OpenTag(kName, 4, attribs_list);	writer.String(kValue, 5);	writer.CloseTag(kName, 4);
+		writer.OpenTag(kTag, 3, attribs_list);
+		writer.StartArray();
+		writer.Int(1);
+		writer.Int(2);
+		writer.EndArray(2);
+		writer.CloseTag(kTag, 3);
+		writer.EndObject(3);
+		n += 6; // record, id, name, tag x3
+	}
+	writer.EndArray();
+	writer.CloseTag(kRecord, 6);
+	writer.EndObject(1);
+	return n;
+}
+
+TEST_F(RapidJsonXml, WriterXml_AllocationsPerMillionElements) {
+	typedef WriterXml<NullStream, UTF8<>, UTF8<>, CountingAllocator> XmlWriter;
+	static const size_t kElementCount = 1000000;
+	CountingAllocator allocator;
+	NullStream s;
+	XmlWriter writer(s, &allocator);
+
+	// The first document may grow the internal stacks
+	WriteRecords(writer, 1000);
+	size_t warmup = allocator.count_;
+
+	size_t elements = 0;
+	while (elements < kElementCount) {
+		writer.Reset(s);
+		elements += WriteRecords(writer, 1000);
+	}
+	size_t allocations = allocator.count_ - warmup;
+	std::cout << allocations << " allocations for " << elements << " elements" << std::endl;
+	EXPECT_EQ(0u, allocations);
+}
+
+// JSON text of about 28 MB: records with scalar, array and object members
+static std::string MakeRecordsJson() {
+	std::string json("{\"record\":[");
+	char buffer[256];
+	for (int i = 0; i < 200000; i++) {
+		sprintf(buffer, "%s{\"id\":%d,\"name\":\"record %d\",\"score\":%d.%d,\"active\":%s,"
+			"\"tags\":[\"alpha\",\"beta\",\"gamma\"],\"position\":{\"x\":%d,\"y\":%d,\"label\":\"p&q\"}}",
+			i ? "," : "", i, i, i % 100, i % 7, i % 2 ? "true" : "false", i % 640, i % 480);
+		json += buffer;
+	}
+	return json += "]}";
+}
+
+static size_t DomToXml(const std::string& json) {
+	Document d;
+	d.Parse(json.c_str());
+	EXPECT_FALSE(d.HasParseError());
+	NullStream s;
+	WriterXml<NullStream> writer(s);
+	d.Accept(writer);
+	return s.length_;
+}
+
+static size_t StreamToXml(const std::string& json) {
+	NullStream s;
+	WriterXml<NullStream> writer(s);
+	TagAdapter<WriterXml<NullStream> > adapter(writer);
+	Reader reader;
+	StringStream is(json.c_str());
+	EXPECT_TRUE(reader.Parse(is, adapter));
+	return s.length_;
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(JsonToXml_Dom)) {
+	std::string json = MakeRecordsJson();
+	for (size_t i = 0; i < 10; i++) {
+		size_t length = DomToXml(json);
+		if (i == 0)
+			std::cout << json.size() << " -> " << length << std::endl;
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(JsonToXml_Streaming)) {
+	std::string json = MakeRecordsJson();
+	for (size_t i = 0; i < 10; i++) {
+		size_t length = StreamToXml(json);
+		if (i == 0)
+			std::cout << json.size() << " -> " << length << std::endl;
+	}
+}
+
+#if defined(__linux__) || defined(__APPLE__)
+// Peak resident set size of a child process running convert(json), in KB on Linux and bytes on OS X
+static long PeakRss(size_t (*convert)(const std::string&), const std::string& json) {
+	pid_t pid = fork();
+	if (pid == 0) {
+		if (convert)
+			convert(json);
+		_exit(0);
+	}
+	int status;
+	struct rusage usage;
+	if (pid < 0 || wait4(pid, &status, 0, &usage) != pid)
+		return -1;
+	return usage.ru_maxrss;
+}
+
+TEST_F(RapidJsonXml, JsonToXml_PeakRss) {
+	std::string json = MakeRecordsJson();
+	std::cout << "baseline " << PeakRss(0, json)
+		<< ", DOM " << PeakRss(DomToXml, json)
+		<< ", streaming " << PeakRss(StreamToXml, json) << std::endl;
+}
+#endif
+
+// The XML text written from MakeRecordsJson(), for comparing the readers on equivalent documents
+static std::string MakeRecordsXml() {
+	Document d;
+	d.Parse(MakeRecordsJson().c_str());
+	StringBuffer buffer;
+	WriterXml<StringBuffer> writer(buffer);
+	d.Accept(writer);
+	return buffer.GetString();
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(ReaderParse_Records)) {
+	std::string json = MakeRecordsJson();
+	for (size_t i = 0; i < 10; i++) {
+		StringStream s(json.c_str());
+		BaseReaderHandler<> h;
+		Reader reader;
+		EXPECT_TRUE(reader.Parse(s, h));
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(ReaderValidate_Records)) {
+	std::string json = MakeRecordsJson();
+	for (size_t i = 0; i < 10; i++) {
+		StringStream s(json.c_str());
+		Reader reader;
+		EXPECT_FALSE(reader.Validate(s).IsError());
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(ReaderParseStructural_Records)) {
+	std::string json = MakeRecordsJson();
+	for (size_t i = 0; i < 10; i++) {
+		StringStream s(json.c_str());
+		BaseReaderHandler<> h;
+		Reader reader;
+		EXPECT_TRUE(reader.Parse<kParseStructuralIndexFlag>(s, h));
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(XmlReaderParse_Records)) {
+	std::string xml = MakeRecordsXml();
+	std::cout << xml.size() << " bytes" << std::endl;
+	for (size_t i = 0; i < 10; i++) {
+		StringStream s(xml.c_str());
+		BaseReaderHandler<> h;
+		XmlReader reader;
+		EXPECT_TRUE(reader.Parse(s, h));
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(XmlReaderParseInsitu_Records)) {
+	std::string xml = MakeRecordsXml();
+	std::string temp;
+	for (size_t i = 0; i < 10; i++) {
+		temp = xml;
+		InsituStringStream s(&temp[0]);
+		BaseReaderHandler<> h;
+		XmlReader reader;
+		EXPECT_TRUE(reader.Parse<kParseInsituFlag>(s, h));
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(DocumentParse_Records)) {
+	std::string json = MakeRecordsJson();
+	for (size_t i = 0; i < 10; i++) {
+		Document d;
+		d.Parse(json.c_str());
+		EXPECT_FALSE(d.HasParseError());
+	}
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(DocumentParseXml_Records)) {
+	std::string xml = MakeRecordsXml();
+	for (size_t i = 0; i < 10; i++) {
+		Document d;
+		d.ParseXml(xml.c_str());
+		EXPECT_FALSE(d.HasParseError());
+	}
+}
+
+// Number of values of the tree, member names included
+static size_t CountNodes(const Value& v) {
+	size_t n = 1;
+	if (v.IsObject())
+		for (Value::ConstMemberIterator m = v.MemberBegin(); m != v.MemberEnd(); ++m)
+			n += 1 + CountNodes(m->value);
+	else if (v.IsArray())
+		for (Value::ConstValueIterator e = v.Begin(); e != v.End(); ++e)
+			n += CountNodes(*e);
+	return n;
+}
+
+TEST_F(RapidJsonXml, DocumentBytesPerNode) {
+	std::string json = MakeRecordsJson();
+	Document d;
+	d.Parse(json.c_str());
+	ASSERT_FALSE(d.HasParseError());
+	size_t nodes = CountNodes(d);
+	size_t bytes = d.GetAllocator().Size();
+	std::cout << "sizeof(Value) " << sizeof(Value) << ", " << nodes << " nodes, " << bytes << " bytes, "
+		<< static_cast<double>(bytes) / static_cast<double>(nodes) << " bytes per node" << std::endl;
+}
+
+// Records with descriptive member names, too long to be stored in the values
+static std::string MakeLongKeyRecordsJson() {
+	std::string json("[");
+	char buffer[512];
+	for (int i = 0; i < 100000; i++) {
+		sprintf(buffer, "%s{\"transactionIdentifier\":%d,\"customerAccountNumber\":\"AC%08d\",\"transactionTimestamp\":%d,"
+			"\"merchantCategoryCode\":%d,\"billingAddress\":{\"streetAddressLine\":\"%d main street\",\"postalCodeValue\":\"%05d\"}}",
+			i ? "," : "", i, i, 1400000000 + i, 5000 + i % 100, i % 1000, i % 100000);
+		json += buffer;
+	}
+	return json += "]";
+}
+
+static void ParseLongKeyRecords(bool interning) {
+	std::string json = MakeLongKeyRecordsJson();
+	size_t bytes = 0;
+	for (size_t i = 0; i < 10; i++) {
+		Document d;
+		d.SetKeyInterning(interning).Parse(json.c_str());
+		EXPECT_FALSE(d.HasParseError());
+		bytes = d.GetAllocator().Size();
+	}
+	std::cout << bytes << " bytes" << std::endl;
+}
+
+TEST_F(RapidJsonXml, DocumentParse_LongKeys) {
+	ParseLongKeyRecords(false);
+}
+
+TEST_F(RapidJsonXml, DocumentParse_LongKeysInterned) {
+	ParseLongKeyRecords(true);
+}
+
+// Text of a file of bin/data
+static std::string ReadDataFile(const char* name) {
+	std::string path = std::string("data/") + name;
+	FILE *fp = fopen(path.c_str(), "rb");
+	if (!fp)
+		fp = fopen((path = std::string("../../bin/data/") + name).c_str(), "rb");
+	EXPECT_TRUE(fp != 0);
+	std::string text;
+	char buffer[4096];
+	for (size_t n; fp && (n = fread(buffer, 1, sizeof(buffer), fp)) > 0; )
+		text.append(buffer, n);
+	if (fp)
+		fclose(fp);
+	return text;
+}
+
+// Reads the first five scalars found depth-first, as a gateway picking a few fields of a document
+template <typename ValueType>
+static size_t ReadFields(const ValueType& v, size_t& fields) {
+	size_t sum = 0;
+	if (v.IsObject()) {
+		for (typename ValueType::ConstMemberIterator m = v.MemberBegin(); m != v.MemberEnd() && fields < 5; ++m)
+			sum += ReadFields(m->value, fields);
+	}
+	else if (v.IsArray()) {
+		for (typename ValueType::ConstValueIterator e = v.Begin(); e != v.End() && fields < 5; ++e)
+			sum += ReadFields(*e, fields);
+	}
+	else {
+		fields++;
+		if (v.IsString())
+			sum += v.GetStringLength();
+		else if (v.IsNumber())
+			sum += static_cast<size_t>(v.GetDouble());
+	}
+	return sum;
+}
+
+// Root value of each kind of document
+static const Value& Root(Document& d) {
+	return d;
+}
+
+static LazyValue Root(LazyDocument& d) {
+	return d.GetRoot();
+}
+
+// Parses each file of bin/data and reads five of its values
+template <typename DocumentType>
+static void ParseDataFields(size_t trialCount) {
+	static const char* kFiles[] = { "glossary.json", "menu.json", "sample.json", "webapp.json", "widget.json" };
+	std::vector<std::string> texts;
+	for (size_t f = 0; f < sizeof(kFiles) / sizeof(kFiles[0]); f++)
+		texts.push_back(ReadDataFile(kFiles[f]));
+	size_t sum = 0;
+	for (size_t i = 0; i < trialCount; i++) {
+		for (size_t f = 0; f < texts.size(); f++) {
+			DocumentType d;
+			d.Parse(texts[f].c_str());
+			ASSERT_FALSE(d.HasParseError()) << kFiles[f];
+			size_t fields = 0;
+			sum += ReadFields(Root(d), fields);
+		}
+	}
+	std::cout << sum << std::endl;
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(DocumentParse_DataFields)) {
+	ParseDataFields<Document>(kTrialCount);
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(LazyDocumentParse_DataFields)) {
+	ParseDataFields<LazyDocument>(kTrialCount);
+}
+
+// Parses the records and reads five values of the last one
+template <typename DocumentType, typename ValueType>
+static void ParseRecordsFields() {
+	std::string json = MakeRecordsJson();
+	size_t sum = 0;
+	for (size_t i = 0; i < 10; i++) {
+		DocumentType d;
+		d.Parse(json.c_str());
+		ASSERT_FALSE(d.HasParseError());
+		const ValueType& records = Root(d)["record"];
+		const ValueType& last = records[records.Size() - 1];
+		sum += last["id"].GetUint() + last["name"].GetStringLength() + static_cast<size_t>(last["score"].GetDouble());
+		sum += last["active"].GetBool() + last["position"]["label"].GetStringLength();
+	}
+	std::cout << sum << std::endl;
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(DocumentParse_RecordsFields)) {
+	ParseRecordsFields<Document, Value>();
+}
+
+TEST_F(RapidJsonXml, SIMD_SUFFIX(LazyDocumentParse_RecordsFields)) {
+	ParseRecordsFields<LazyDocument, LazyValue>();
+}
+
+TEST_F(RapidJsonXml, DocumentFindMember_Records) {
+	std::string json = MakeRecordsJson();
+	Document d;
+	d.Parse(json.c_str());
+	ASSERT_FALSE(d.HasParseError());
+	const Value& records = d["record"];
+	size_t length = 0;
+	for (size_t i = 0; i < 10; i++) {
+		for (Value::ConstValueIterator r = records.Begin(); r != records.End(); ++r) {
+			length += (*r)["name"].GetStringLength();
+			length += (*r)["position"]["label"].GetStringLength();
+			length += (*r)["tags"][2u].GetStringLength();
+		}
+	}
+	std::cout << length << std::endl;
+}
+
+// 10 million lookups by name in an object of memberCount members
+static void FindMembers(SizeType memberCount) {
+	Document d;
+	d.SetObject();
+	std::vector<std::string> names;
+	for (SizeType i = 0; i < memberCount; i++) {
+		char name[32];
+		sprintf(name, "member%u", i);
+		names.push_back(name);
+		Value n(name, d.GetAllocator());
+		Value v(i);
+		d.AddMember(n, v, d.GetAllocator());
+	}
+	unsigned sum = 0;
+	for (SizeType i = 0; i < 10000000; i++) {
+		const std::string& name = names[(i * 7919u) % memberCount];
+		sum += d[Value(StringRef(name.c_str(), static_cast<SizeType>(name.size())))].GetUint();
+	}
+	std::cout << sum << std::endl;
+}
+
+TEST_F(RapidJsonXml, DocumentFindMember_16) {
+	FindMembers(16);
+}
+
+TEST_F(RapidJsonXml, DocumentFindMember_256) {
+	FindMembers(256);
+}
+
+TEST_F(RapidJsonXml, DocumentFindMember_65536) {
+	FindMembers(65536);
+}
+
+// 10 million lookups in an object of 16 long names of the same length, with copied keys
+TEST_F(RapidJsonXml, DocumentFindMember_LongNames) {
+	Document d;
+	d.SetObject();
+	Value keys[16];
+	for (unsigned i = 0; i < 16; i++) {
+		char name[64];
+		sprintf(name, "http://example.com/schema/record#field%02u", i);
+		Value n(name, d.GetAllocator());
+		Value v(i);
+		d.AddMember(n, v, d.GetAllocator());
+		keys[i].SetString(name, d.GetAllocator());
+	}
+	unsigned sum = 0;
+	for (SizeType i = 0; i < 10000000; i++)
+		sum += d[keys[(i * 7919u) % 16]].GetUint();
+	std::cout << sum << std::endl;
+}
+
+// 100k messages of 20 fields, in the same order or in a different order in each message
+static void MakeMessages(Document& d, bool shuffled) {
+	std::string json("[");
+	char buffer[32];
+	unsigned r = 1;
+	for (int i = 0; i < 100000; i++) {
+		int order[20];
+		for (int f = 0; f < 20; f++)
+			order[f] = f;
+		for (int f = 19; shuffled && f > 0; f--) {
+			r = r * 1103515245 + 12345;
+			std::swap(order[f], order[(r >> 8) % (f + 1)]);
+		}
+		json += i ? ",{" : "{";
+		for (int f = 0; f < 20; f++) {
+			sprintf(buffer, "%s\"field%02d\":%d", f ? "," : "", order[f], i + order[f]);
+			json += buffer;
+		}
+		json += "}";
+	}
+	json += "]";
+	d.Parse(json.c_str());
+	EXPECT_FALSE(d.HasParseError());
+}
+
+static const char* const kMessageFields[20] = {
+	"field00", "field01", "field02", "field03", "field04", "field05", "field06", "field07", "field08", "field09",
+	"field10", "field11", "field12", "field13", "field14", "field15", "field16", "field17", "field18", "field19"
+};
+
+// Reads the 20 fields of each message 10 times, with operator[] or with accessors
+static void ReadMessages(const Document& d, bool accessors) {
+	const MemberAccessor* fields[20];
+	for (int f = 0; f < 20; f++)
+		fields[f] = new MemberAccessor(StringRef(kMessageFields[f]));
+	int64_t sum = 0;
+	for (int i = 0; i < 10; i++) {
+		for (Value::ConstValueIterator m = d.Begin(); m != d.End(); ++m) {
+			for (int f = 0; f < 20; f++)
+				sum += accessors ? fields[f]->Get(*m)->GetInt() : (*m)[kMessageFields[f]].GetInt();
+		}
+	}
+	for (int f = 0; f < 20; f++)
+		delete fields[f];
+	std::cout << sum << std::endl;
+}
+
+TEST_F(RapidJsonXml, DocumentFindMember_Messages) {
+	Document d;
+	MakeMessages(d, false);
+	ReadMessages(d, false);
+}
+
+TEST_F(RapidJsonXml, DocumentFindMember_ShuffledMessages) {
+	Document d;
+	MakeMessages(d, true);
+	ReadMessages(d, false);
+}
+
+TEST_F(RapidJsonXml, DocumentMemberAccessor_Messages) {
+	Document d;
+	MakeMessages(d, false);
+	ReadMessages(d, true);
+}
+
+TEST_F(RapidJsonXml, DocumentMemberAccessor_ShuffledMessages) {
+	Document d;
+	MakeMessages(d, true);
+	ReadMessages(d, true);
+}
+
+// XML text with 10000 texts of 100 to 200 characters, some with entities
+static std::string MakeTextXml() {
+	std::string xml("<text>");
+	for (int i = 0; i < 10000; i++) {
+		xml += "<s>";
+		xml.append(kAsciiText, 100 + i % 100);
+		if (i % 4 == 0)
+			xml += "&lt;&quot;quoted&quot;&gt;&#xe9;";
+		xml += "</s>";
+	}
+	return xml += "</text>";
+}
+
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+// The SIMD code paths forced to each level, when supported by the CPU
+class RapidJsonXmlSimd : public RapidJsonXml {
+public:
+	RapidJsonXmlSimd() : saved_(GetSimdLevel()) {}
+
+	virtual void TearDown() {
+		SetSimdLevel(saved_);
+		RapidJsonXml::TearDown();
+	}
+
+protected:
+	bool SetLevel(SimdLevel level) {
+		if (SetSimdLevel(level))
+			return true;
+		std::cout << "Not supported by the CPU" << std::endl;
+		return false;
+	}
+
+	void RunSkipWhitespace() {
+		for (size_t i = 0; i < kTrialCount; i++) {
+			StringStream s(whitespace_);
+			SkipWhitespace(s);
+			EXPECT_EQ('[', s.Peek());
+		}
+	}
+
+	void RunReaderParseStructural() {
+		for (size_t i = 0; i < kTrialCount; i++) {
+			StringStream s(json_);
+			BaseReaderHandler<> h;
+			Reader reader;
+			EXPECT_TRUE(reader.Parse<kParseStructuralIndexFlag>(s, h));
+		}
+	}
+
+	void RunReaderParseStrings() {
+		std::string json = MakeStringsJson();
+		for (size_t i = 0; i < kTrialCount; i++) {
+			StringStream s(json.c_str());
+			BaseReaderHandler<> h;
+			Reader reader;
+			EXPECT_TRUE(reader.Parse(s, h));
+		}
+	}
+
+	void RunXmlReaderParseText() {
+		std::string xml = MakeTextXml();
+		for (size_t i = 0; i < kTrialCount; i++) {
+			StringStream s(xml.c_str());
+			BaseReaderHandler<> h;
+			XmlReader reader;
+			EXPECT_TRUE(reader.Parse(s, h));
+		}
+	}
+
+	void RunWriterJsonStrings() {
+		Document d;
+		MakeTextDocument(d, kUnicodeText);
+		for (size_t i = 0; i < kTrialCount; i++) {
+			StringBuffer s(0, 4 * 1024 * 1024);
+			WriterJson<StringBuffer> writer(s);
+			d.Accept(writer);
+		}
+	}
+
+	void RunWriterXmlStrings() {
+		Document d;
+		MakeTextDocument(d, kAsciiText);
+		for (size_t i = 0; i < kTrialCount; i++) {
+			StringBuffer s(0, 4 * 1024 * 1024);
+			WriterXml<StringBuffer> writer(s);
+			d.Accept(writer);
+		}
+	}
+
+private:
+	SimdLevel saved_;
+};
+
+#define TEST_SIMD_LEVELS(name) \
+	TEST_F(RapidJsonXmlSimd, name##_Scalar) { if (SetLevel(kSimdScalar)) Run##name(); } \
+	TEST_F(RapidJsonXmlSimd, name##_SSE2) { if (SetLevel(kSimdSSE2)) Run##name(); } \
+	TEST_F(RapidJsonXmlSimd, name##_SSE42) { if (SetLevel(kSimdSSE42)) Run##name(); } \
+	TEST_F(RapidJsonXmlSimd, name##_AVX2) { if (SetLevel(kSimdAVX2)) Run##name(); }
+
+TEST_SIMD_LEVELS(SkipWhitespace)
+TEST_SIMD_LEVELS(ReaderParseStructural)
+TEST_SIMD_LEVELS(ReaderParseStrings)
+TEST_SIMD_LEVELS(XmlReaderParseText)
+TEST_SIMD_LEVELS(WriterJsonStrings)
+TEST_SIMD_LEVELS(WriterXmlStrings)
+
+#endif // RAPIDJSONXML_SIMD_DISPATCH
+
+#endif // TEST_RAPIDJSONXML
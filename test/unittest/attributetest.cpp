@@ -0,0 +1,200 @@
+#include "unittest.h"
+
+#include "rapidjsonxml/document.h"
+#include "rapidjsonxml/writerxml.h"
+#include "rapidjsonxml/stringbuffer.h"
+
+using namespace rapidjsonxml;
+
+TEST(Attribute, ValueSize) {
+	// Attributes are stored out of line
+#if RAPIDJSONXML_48BITPOINTER_OPTIMIZATION || !RAPIDJSONXML_64BIT
+	EXPECT_EQ(16u, sizeof(Value));
+#else
+	EXPECT_EQ(24u, sizeof(Value));
+#endif
+	EXPECT_EQ(2 * sizeof(Value), sizeof(Value::Member));
+}
+
+template <typename Allocator>
+static void AddAttributes(GenericValue<UTF8<>, Allocator>& v, Allocator& allocator, int count) {
+	for (int i = 0; i < count; i++) {
+		std::string name(1, static_cast<char>('a' + i));
+		typename GenericValue<UTF8<>, Allocator>::AttributeType attrib(name, "v", allocator);
+		v.AddAttribute(attrib, allocator);
+	}
+}
+
+TEST(Attribute, AllTypes) {
+	Document d;
+	d.Parse("{\"n\":null,\"t\":true,\"i\":-1,\"u\":4294967295,\"d\":0.5,\"s\":\"text\",\"a\":[1,2,3],\"o\":{\"x\":1},\"e\":[]}");
+	ASSERT_FALSE(d.HasParseError());
+	for (Value::MemberIterator m = d.MemberBegin(); m != d.MemberEnd(); ++m) {
+		EXPECT_FALSE(m->value.HasAttributes());
+		EXPECT_EQ(0u, m->value.CountAttributes());
+		EXPECT_TRUE(m->value.AttributeBegin() == m->value.AttributeEnd());
+		AddAttributes(m->value, d.GetAllocator(), 5); // grows the attribute array
+		EXPECT_EQ(5u, m->value.CountAttributes());
+		EXPECT_STREQ("e", m->value.AttributeBegin()[4].GetName());
+	}
+
+	// The values are unchanged
+	EXPECT_TRUE(d["n"].IsNull());
+	EXPECT_TRUE(d["t"].IsTrue());
+	EXPECT_EQ(-1, d["i"].GetInt());
+	EXPECT_EQ(4294967295u, d["u"].GetUint());
+	EXPECT_EQ(0.5, d["d"].GetDouble());
+	EXPECT_STREQ("text", d["s"].GetString());
+	EXPECT_EQ(4u, d["s"].GetStringLength());
+	EXPECT_EQ(3u, d["a"].Size());
+	EXPECT_EQ(3, d["a"][2u].GetInt());
+	EXPECT_EQ(1, d["o"]["x"].GetInt());
+	EXPECT_TRUE(d["e"].Empty());
+
+	// Modified with their attributes
+	d["a"].PushBack(4, d.GetAllocator());
+	for (int i = 0; i < 40; i++)
+		d["e"].PushBack(i, d.GetAllocator());
+	d["o"].AddMember("y", 2, d.GetAllocator());
+	EXPECT_EQ(4, d["a"][3u].GetInt());
+	EXPECT_EQ(39, d["e"][39u].GetInt());
+	EXPECT_EQ(2, d["o"]["y"].GetInt());
+	EXPECT_TRUE(d["o"].RemoveMember("x"));
+	d["e"].Clear();
+	EXPECT_EQ(5u, d["e"].CountAttributes());
+
+	// Moved and swapped with the value
+	Value v;
+	v = d["a"];
+	EXPECT_TRUE(d["a"].IsNull());
+	EXPECT_FALSE(d["a"].HasAttributes());
+	EXPECT_EQ(5u, v.CountAttributes());
+	EXPECT_EQ(4u, v.Size());
+	v.Swap(d["s"]);
+	EXPECT_STREQ("text", v.GetString());
+	EXPECT_EQ(5u, v.CountAttributes());
+	EXPECT_EQ(4u, d["s"].Size());
+
+	// Cleared, kept by ClearAttributes() and dropped by a new value
+	v.ClearAttributes();
+	EXPECT_FALSE(v.HasAttributes());
+	EXPECT_STREQ("text", v.GetString());
+	AddAttributes(v, d.GetAllocator(), 1);
+	EXPECT_EQ(1u, v.CountAttributes());
+	v.SetString("other", d.GetAllocator());
+	EXPECT_FALSE(v.HasAttributes());
+	EXPECT_STREQ("other", v.GetString());
+
+	// Cloned
+	Value c(kObjectType);
+	c.CloneAttributes(d["o"], d.GetAllocator());
+	ASSERT_EQ(5u, c.CountAttributes());
+	EXPECT_NE(d["o"].AttributeBegin()->GetName(), c.AttributeBegin()->GetName());
+	EXPECT_STREQ("a", c.AttributeBegin()->GetName());
+	EXPECT_EQ(5u, d["o"].CountAttributes());
+
+	// Written
+	StringBuffer buffer;
+	WriterXml<StringBuffer> writer(buffer);
+	d["o"].Accept(writer);
+	EXPECT_STREQ("<y>2</y>", buffer.GetString());
+	buffer.Clear();
+	writer.Reset(buffer);
+	Document x;
+	x.SetObject();
+	x.AddMember("d", d["d"], x.GetAllocator());
+	x.Accept(writer);
+	EXPECT_STREQ("<d a=\"v\" b=\"v\" c=\"v\" d=\"v\" e=\"v\">0.5</d>", buffer.GetString());
+}
+
+TEST(Attribute, Free) {
+	// The attributes, and the strings, members and elements moved with them, are freed with the values
+	typedef GenericValue<UTF8<>, CrtAllocator> CrtValue;
+	CrtAllocator allocator;
+	CrtValue o(kObjectType);
+	for (int i = 0; i < 20; i++) {
+		CrtValue s("copied string", allocator);
+		AddAttributes(s, allocator, i % 3);
+		CrtValue a(kArrayType);
+		AddAttributes(a, allocator, 2);
+		a.PushBack(s, allocator);
+		a.PushBack(i, allocator);
+		CrtValue name(std::string(1, static_cast<char>('a' + i)), allocator);
+		AddAttributes(name, allocator, 1);
+		o.AddMember(name, a, allocator);
+	}
+	AddAttributes(o, allocator, 6);
+	EXPECT_EQ(20u, o.MemberEnd() - o.MemberBegin());
+	EXPECT_STREQ("copied string", o["t"][0u].GetString());
+	EXPECT_EQ(2u, o["t"].CountAttributes());
+	EXPECT_EQ(6u, o.CountAttributes());
+	o.SetNull();
+	EXPECT_FALSE(o.HasAttributes());
+}
+
+// CrtAllocator counting the strings not freed yet
+struct CountingAllocator : CrtAllocator {
+	void* Malloc(size_t size) { ++count; return CrtAllocator::Malloc(size); }
+	static void Free(void* ptr) { if (ptr) --count; CrtAllocator::Free(ptr); }
+	static int count;
+};
+int CountingAllocator::count = 0;
+
+TEST(Attribute, CopyFlags) {
+	// Setting one string as constant keeps the other one copied
+	typedef GenericAttribute<UTF8<>, CountingAllocator> CountingAttribute;
+	CountingAllocator allocator;
+	char name[] = "name", value[] = "value";
+	{
+		CountingAttribute a;
+		a.SetName(StringRef(name), allocator).SetValue(StringRef(value));
+		EXPECT_NE(name, a.GetName());
+		EXPECT_EQ(value, a.GetValue());
+		name[0] = 'N';
+		EXPECT_STREQ("name", a.GetName());
+		EXPECT_EQ(1, CountingAllocator::count);
+
+		a.SetValue(StringRef(value), allocator).SetName(StringRef(name));
+		EXPECT_EQ(name, a.GetName());
+		EXPECT_NE(value, a.GetValue());
+		EXPECT_EQ(1, CountingAllocator::count);
+
+		a.SetName(StringRef(name), allocator);
+		EXPECT_EQ(2, CountingAllocator::count);
+	}
+	EXPECT_EQ(0, CountingAllocator::count);
+}
+
+TEST(Attribute, CloneArrayElements) {
+	// Attributes of the elements after the first one are copied too
+	Document d;
+	d.Parse("{\"a\":[1,\"two\",3.5,null],\"n\":[[4,5],[6]]}");
+	ASSERT_FALSE(d.HasParseError());
+	Value::AttributeType second("s", "2"), third("t", "3"), thirdBis("u", "4"), nested("n", "6");
+	d["a"][1].AddAttribute(second, d.GetAllocator());
+	d["a"][2].AddAttribute(third, d.GetAllocator());
+	d["a"][2].AddAttribute(thirdBis, d.GetAllocator());
+	d["n"][1][0u].AddAttribute(nested, d.GetAllocator());
+
+	Document copy;
+	Value c(d, copy.GetAllocator());
+	EXPECT_FALSE(c["a"][0u].HasAttributes());
+	ASSERT_EQ(1u, c["a"][1].CountAttributes());
+	EXPECT_STREQ("s", c["a"][1].AttributeBegin()->GetName());
+	EXPECT_NE(d["a"][1].AttributeBegin()->GetName(), c["a"][1].AttributeBegin()->GetName());
+	ASSERT_EQ(2u, c["a"][2].CountAttributes());
+	EXPECT_STREQ("3", c["a"][2].AttributeBegin()[0].GetValue());
+	EXPECT_STREQ("4", c["a"][2].AttributeBegin()[1].GetValue());
+	EXPECT_FALSE(c["a"][3].HasAttributes());
+	EXPECT_FALSE(c["n"][0u][0u].HasAttributes());
+	EXPECT_FALSE(c["n"][1].HasAttributes());
+	ASSERT_EQ(1u, c["n"][1][0u].CountAttributes());
+	EXPECT_STREQ("6", c["n"][1][0u].AttributeBegin()->GetValue());
+
+	// Same XML text
+	StringBuffer b1, b2;
+	WriterXml<StringBuffer> w1(b1), w2(b2);
+	d.Accept(w1);
+	c.Accept(w2);
+	EXPECT_STREQ(b1.GetString(), b2.GetString());
+}
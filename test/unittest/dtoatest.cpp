@@ -0,0 +1,172 @@
+#include "unittest.h"
+
+#include "rapidjsonxml/internal/dtoa.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+
+using namespace rapidjsonxml::internal;
+
+static std::string Dtoa(double d, int precision = 0) {
+	char buffer[kDtoaBufferSize];
+	char* end = dtoa(d, buffer, precision);
+	return std::string(buffer, end);
+}
+
+static std::string Printf(double d, int precision) {
+	char buffer[kDtoaBufferSize];
+	int n = snprintf(buffer, sizeof(buffer), "%.*g", precision, d);
+	return std::string(buffer, n);
+}
+
+// Random doubles over the whole finite range, normal and subnormal
+static double RandomDouble(uint64_t& state) {
+	for (;;) {
+		state = state * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+		uint64_t u = state ^ (state >> 29);
+		double d;
+		std::memcpy(&d, &u, sizeof(d));
+		if (d == d && d - d == 0.0)
+			return d;
+	}
+}
+
+TEST(Dtoa, Shortest) {
+	EXPECT_EQ("0", Dtoa(0.0));
+	EXPECT_EQ("-0", Dtoa(-0.0));
+	EXPECT_EQ("1", Dtoa(1.0));
+	EXPECT_EQ("-1.5", Dtoa(-1.5));
+	EXPECT_EQ("0.1", Dtoa(0.1));
+	EXPECT_EQ("0.21313", Dtoa(0.21313));
+	EXPECT_EQ("3.25", Dtoa(3.25));
+	EXPECT_EQ("0.30000000000000004", Dtoa(0.1 + 0.2));
+	EXPECT_EQ("123456789012", Dtoa(123456789012.0));
+	EXPECT_EQ("0.0001", Dtoa(0.0001));
+	EXPECT_EQ("1e-05", Dtoa(0.00001));
+	EXPECT_EQ("1e+22", Dtoa(1e22));
+	EXPECT_EQ("9007199254740992", Dtoa(9007199254740992.0));
+	EXPECT_EQ("5e-324", Dtoa(5e-324));
+	EXPECT_EQ("2.2250738585072014e-308", Dtoa(2.2250738585072014e-308));
+	EXPECT_EQ("1.7976931348623157e+308", Dtoa(1.7976931348623157e308));
+}
+
+TEST(Dtoa, RoundTrip) {
+	uint64_t state = 1;
+	for (int i = 0; i < 200000; i++) {
+		double d = RandomDouble(state);
+		std::string s = Dtoa(d);
+		EXPECT_EQ(d, std::strtod(s.c_str(), 0)) << s;
+
+		// No shorter %g representation reads back as the same value
+		std::string digits;
+		for (size_t j = 0; j < s.size() && s[j] != 'e'; j++)
+			if (s[j] >= '0' && s[j] <= '9')
+				digits += s[j];
+		digits = digits.substr(0, digits.find_last_not_of('0') + 1);
+		digits = digits.substr(digits.find_first_not_of('0'));
+		if (digits.size() > 1 && std::strtod(Printf(d, (int)digits.size() - 1).c_str(), 0) == d)
+			ADD_FAILURE() << s << " is not the shortest representation";
+	}
+}
+
+TEST(Dtoa, Precision) {
+	EXPECT_EQ("3.14159", Dtoa(3.14159265358979, 6));
+	EXPECT_EQ("3.141592654", Dtoa(3.14159265358979, 10));
+	EXPECT_EQ("1e+02", Dtoa(99.99, 2));
+	EXPECT_EQ("0.5", Dtoa(0.5, 1));
+	EXPECT_EQ("2", Dtoa(2.5, 1));
+	EXPECT_EQ("0.12345678901234568", Dtoa(0.12345678901234568, 17));
+	EXPECT_EQ(Printf(std::numeric_limits<double>::infinity(), 6), Dtoa(std::numeric_limits<double>::infinity(), 6));
+
+	static const int kPrecisions[] = { 1, 2, 3, 6, 10, 15, 17 };
+	uint64_t state = 2;
+	for (int i = 0; i < 50000; i++) {
+		double d = RandomDouble(state);
+		for (size_t j = 0; j < sizeof(kPrecisions) / sizeof(kPrecisions[0]); j++)
+			EXPECT_EQ(Printf(d, kPrecisions[j]), Dtoa(d, kPrecisions[j]));
+	}
+}
+
+static std::string Fixedtoa(double d, int decimals) {
+	char buffer[kDtoaBufferSize];
+	char* end = fixedtoa(d, buffer, decimals);
+	return std::string(buffer, end);
+}
+
+// Double ulps steps away from a positive double
+static double NextDouble(double d, int ulps) {
+	uint64_t u;
+	std::memcpy(&u, &d, sizeof(d));
+	u += static_cast<uint64_t>(static_cast<int64_t>(ulps));
+	std::memcpy(&d, &u, sizeof(d));
+	return d;
+}
+
+static std::string PrintfFixed(double d, int decimals) {
+	char buffer[512];
+	int n = snprintf(buffer, sizeof(buffer), "%.*f", decimals, d);
+	return std::string(buffer, n);
+}
+
+TEST(Dtoa, Fixed) {
+	EXPECT_EQ("0.00", Fixedtoa(0.0, 2));
+	EXPECT_EQ("-0.00", Fixedtoa(-0.0, 2));
+	EXPECT_EQ("-0.00", Fixedtoa(-1e-300, 2));
+	EXPECT_EQ("0.00", Fixedtoa(5e-324, 2));
+	EXPECT_EQ("3", Fixedtoa(3.14159, 0));
+	EXPECT_EQ("3.14", Fixedtoa(3.14159, 2));
+	EXPECT_EQ("3.142", Fixedtoa(3.14159, 3));
+	EXPECT_EQ("12.05", Fixedtoa(12.05, 2));
+	EXPECT_EQ("0.007", Fixedtoa(0.007, 3));
+	EXPECT_EQ("1.0000000000", Fixedtoa(1.0, 10));
+	EXPECT_EQ("-42.50", Fixedtoa(-42.5, 2));
+
+	// Exact ties are rounded to even, others by the exact binary value
+	EXPECT_EQ("2", Fixedtoa(2.5, 0));
+	EXPECT_EQ("4", Fixedtoa(3.5, 0));
+	EXPECT_EQ("0.12", Fixedtoa(0.125, 2));
+	EXPECT_EQ("0.38", Fixedtoa(0.375, 2));
+	EXPECT_EQ("0.99", Fixedtoa(0.995, 2)); // 0.99499999999999999556
+	EXPECT_EQ("8.35", Fixedtoa(8.345, 2)); // 8.34500000000000063949
+	EXPECT_EQ("0.01", Fixedtoa(0.005, 2)); // 0.00500000000000000010
+
+	// Largest scaled values, then values whose scaled magnitude does not fit in 64 bits
+	EXPECT_EQ("18446744073709549568", Fixedtoa(18446744073709549568.0, 0));
+	EXPECT_EQ("18446744073709551616", Fixedtoa(18446744073709551616.0, 0));
+	EXPECT_EQ("100000000000000000000.00", Fixedtoa(1e20, 2));
+	EXPECT_EQ(PrintfFixed(1.0, 18), Fixedtoa(1.0, 18));
+	EXPECT_EQ(PrintfFixed(-1.7976931348623157e308, 18), Fixedtoa(-1.7976931348623157e308, 18));
+	EXPECT_EQ(PrintfFixed(9007199254740993.0, 3), Fixedtoa(9007199254740993.0, 3));
+	EXPECT_EQ("1.000", Fixedtoa(0.99999999999999989, 3));
+	EXPECT_EQ("19.000000000000000000", Fixedtoa(18.999999999999999999, 18));
+
+	// Just below, at and just above 2^64 / 10^n, for each n
+	for (int decimals = 1; decimals <= kMaxFixedDecimals; decimals++) {
+		const double boundary = 18446744073709551616.0 / std::pow(10.0, decimals);
+		for (int ulps = -2; ulps <= 4; ulps++) {
+			const double d = NextDouble(boundary, ulps);
+			EXPECT_EQ(PrintfFixed(d, decimals), Fixedtoa(d, decimals)) << decimals << " " << ulps;
+			EXPECT_EQ(PrintfFixed(-d, decimals), Fixedtoa(-d, decimals)) << decimals << " " << ulps;
+		}
+		EXPECT_EQ(PrintfFixed(boundary * 1.5, decimals), Fixedtoa(boundary * 1.5, decimals)) << decimals;
+		EXPECT_EQ(PrintfFixed(boundary * 1000, decimals), Fixedtoa(boundary * 1000, decimals)) << decimals;
+	}
+	EXPECT_EQ("1800000000000.000000", Fixedtoa(1.8e12, 6));
+	EXPECT_EQ("18000000000000.000000", Fixedtoa(1.8e13, 6));
+}
+
+TEST(Dtoa, FixedRandom) {
+	uint64_t state = 3;
+	for (int i = 0; i < 200000; i++) {
+		// Random significand with magnitudes from 1e-20 to 1e25
+		state = state * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+		double d = (double)(int64_t)(state >> 11) / (1 << 30) / (1 << 23);
+		d *= std::pow(10.0, (int)((state >> 3) % 46) - 20);
+		if (state & 1)
+			d = -d;
+		int decimals = (int)((state >> 7) % (kMaxFixedDecimals + 1));
+		EXPECT_EQ(PrintfFixed(d, decimals), Fixedtoa(d, decimals));
+	}
+}
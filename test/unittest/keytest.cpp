@@ -0,0 +1,137 @@
+#include "unittest.h"
+
+#include "rapidjsonxml/document.h"
+#include "rapidjsonxml/reader.h"
+
+#include <string>
+
+using namespace rapidjsonxml;
+
+// Records the events as text, names between < and >
+struct NameKeyHandler : BaseReaderHandler<> {
+	NameKeyHandler() : events() {}
+	bool String(const char* str, SizeType length, bool) {
+		events.append(str, length) += ' ';
+		return true;
+	}
+	bool Key(const char* str, SizeType length, bool) {
+		events.append("<").append(str, length) += "> ";
+		return true;
+	}
+	std::string events;
+};
+
+// Older handler, receiving the names as strings
+struct NameStringHandler : BaseReaderHandler<> {
+	NameStringHandler() : events() {}
+	bool String(const char* str, SizeType length, bool) {
+		events.append(str, length) += ' ';
+		return true;
+	}
+	std::string events;
+};
+
+template <unsigned parseFlags>
+static void TestKeyEvent() {
+	const char json[] = "{\"a\":\"b\",\"c\":[{\"d\":\"e\"},\"f\"],\"\":{}}";
+	Reader reader;
+	NameKeyHandler h;
+	StringStream s(json);
+	EXPECT_TRUE(reader.Parse<parseFlags>(s, h));
+	EXPECT_EQ("<a> b <c> <d> e f <> ", h.events);
+
+	NameStringHandler old;
+	StringStream s2(json);
+	EXPECT_TRUE(reader.Parse<parseFlags>(s2, old));
+	EXPECT_EQ("a b c d e f  ", old.events);
+
+	std::string insitu(json);
+	NameKeyHandler h2;
+	InsituStringStream s3(&insitu[0]);
+	EXPECT_TRUE(reader.Parse<parseFlags | kParseInsituFlag>(s3, h2));
+	EXPECT_EQ(h.events, h2.events);
+}
+
+TEST(Key, Event) {
+	EXPECT_TRUE(internal::HasKeyEvent<NameKeyHandler>::Value);
+	EXPECT_FALSE(internal::HasKeyEvent<NameStringHandler>::Value);
+	EXPECT_FALSE(internal::HasKeyEvent<BaseReaderHandler<> >::Value);
+	TestKeyEvent<kParseDefaultFlags>();
+	TestKeyEvent<kParseIterativeFlag>();
+}
+
+static std::string MakeRecords(int count) {
+	std::string json("[");
+	for (int i = 0; i < count; i++)
+		json += std::string(i ? "," : "") + "{\"a rather long member name\":1,\"another long member name\":{\"a rather long member name\":\"a rather long string value\"},\"id\":2}";
+	return json + "]";
+}
+
+TEST(Key, Interning) {
+	std::string json = MakeRecords(100);
+	Document copied, interned;
+	EXPECT_FALSE(copied.GetKeyInterning());
+	copied.Parse(json.c_str());
+	interned.SetKeyInterning(true).Parse(json.c_str());
+	ASSERT_FALSE(interned.HasParseError());
+	EXPECT_TRUE(interned == copied);
+	EXPECT_LT(interned.GetAllocator().Size() + 100 * 2 * 27, copied.GetAllocator().Size());
+
+	// The same names share one copy, with its hash
+	const char* name = interned[0u].MemberBegin()->name.GetString();
+	for (SizeType i = 0; i < 100; i++) {
+		const Value& r = interned[i];
+		EXPECT_EQ(name, r.MemberBegin()->name.GetString());
+		EXPECT_EQ(name, r["another long member name"].MemberBegin()->name.GetString());
+		EXPECT_NE(r["another long member name"]["a rather long member name"].GetString(), copied[i]["another long member name"]["a rather long member name"].GetString());
+		EXPECT_EQ(internal::StrHash(name, 25), r.MemberBegin()->name.GetStringHash());
+		EXPECT_EQ(2, r["id"].GetInt());
+	}
+	EXPECT_NE(name, copied[0u].MemberBegin()->name.GetString());
+	EXPECT_NE(name, interned[0u].MemberBegin()[1].name.GetString());
+
+	// Not shared between parsings, nor in place
+	const char* previous = name;
+	interned.Parse(json.c_str());
+	EXPECT_NE(previous, interned[0u].MemberBegin()->name.GetString());
+	std::string insitu(json);
+	interned.ParseInsitu(&insitu[0]);
+	const char* inPlace = interned[0u].MemberBegin()->name.GetString();
+	EXPECT_TRUE(inPlace > insitu.data() && inPlace < insitu.data() + insitu.size());
+
+	// Tag names
+	interned.ParseXml("<records><a_rather_long_tag_name>1</a_rather_long_tag_name><a_rather_long_tag_name>2</a_rather_long_tag_name></records>");
+	ASSERT_FALSE(interned.HasParseError());
+	const Value& records = interned["records"];
+	EXPECT_EQ(records.MemberBegin()[0].name.GetString(), records.MemberBegin()[1].name.GetString());
+	EXPECT_EQ(2, records.MemberBegin()[1].value.GetInt());
+}
+
+TEST(Key, InterningMany) {
+	// More names than the table keeps
+	std::string json("{");
+	for (int i = 0; i < 5000; i++) {
+		char member[64];
+		sprintf(member, "%s\"a rather long member name %d\":%d", i ? "," : "", i, i);
+		json += member;
+	}
+	json += "}";
+	Document d;
+	d.SetKeyInterning(true).Parse(json.c_str());
+	ASSERT_FALSE(d.HasParseError());
+	EXPECT_EQ(5000, d.MemberEnd() - d.MemberBegin());
+	EXPECT_EQ(4999, d["a rather long member name 4999"].GetInt());
+	EXPECT_EQ(0, d["a rather long member name 0"].GetInt());
+}
+
+TEST(Key, InterningAlignment) {
+	// The table holds pointers, whatever the alignment of the memory pool (4 bytes)
+	for (size_t offset = 0; offset < 8; offset += 4) {
+		Document d;
+		d.GetAllocator().Malloc(offset + 4);
+		d.SetKeyInterning(true).Parse("[{\"a rather long member name\":1},{\"a rather long member name\":2}]");
+		ASSERT_FALSE(d.HasParseError());
+		EXPECT_EQ(d[0u].MemberBegin()->name.GetString(), d[1].MemberBegin()->name.GetString());
+		EXPECT_EQ(2, d[1]["a rather long member name"].GetInt());
+	}
+}
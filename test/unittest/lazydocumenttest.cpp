@@ -0,0 +1,140 @@
+#include "unittest.h"
+
+#include "rapidjsonxml/lazydocument.h"
+
+#include <string>
+
+using namespace rapidjsonxml;
+
+// Compares a lazy value with the value of a document, read in the same order
+static void ExpectSameValue(const Value& expected, const LazyValue& v) {
+	ASSERT_EQ(expected.GetType(), v.GetType());
+	switch (expected.GetType()) {
+	case kObjectType: {
+			ASSERT_EQ(static_cast<SizeType>(expected.MemberEnd() - expected.MemberBegin()), v.MemberCount());
+			Value::ConstMemberIterator e = expected.MemberBegin();
+			for (LazyValue::ConstMemberIterator m = v.MemberBegin(); m != v.MemberEnd(); ++m, ++e) {
+				EXPECT_EQ(std::string(e->name.GetString(), e->name.GetStringLength()), std::string(m->name.GetString(), m->name.GetStringLength()));
+				ExpectSameValue(e->value, m->value);
+			}
+		}
+		break;
+	case kArrayType: {
+			ASSERT_EQ(expected.Size(), v.Size());
+			Value::ConstValueIterator e = expected.Begin();
+			for (LazyValue::ConstValueIterator i = v.Begin(); i != v.End(); ++i, ++e)
+				ExpectSameValue(*e, *i);
+		}
+		break;
+	default:
+		EXPECT_TRUE(expected == v.GetValue());
+		EXPECT_EQ(expected.IsInt(), v.IsInt());
+		EXPECT_EQ(expected.IsUint64(), v.IsUint64());
+		EXPECT_EQ(expected.IsDouble(), v.IsDouble());
+	}
+}
+
+static void ExpectSameDocument(const char* json) {
+	Document d;
+	d.Parse(json);
+	ASSERT_FALSE(d.HasParseError()) << json;
+	LazyDocument lazy;
+	lazy.Parse(json);
+	ASSERT_FALSE(lazy.HasParseError()) << json;
+	ExpectSameValue(d, lazy.GetRoot());
+}
+
+TEST(LazyDocument, Parse) {
+	ExpectSameDocument("{}");
+	ExpectSameDocument(" [ ] ");
+	ExpectSameDocument("[null,true,false,0,-1,2147483648,-2147483649,18446744073709551615,1.5,-0.25e-3,1E2]");
+	ExpectSameDocument("{\"a\":{\"b\":[[],{},[1,[2,{\"c\":3}]]],\"d\":\"e\"},\"f\":[{}],\"g\":\"\"}");
+	ExpectSameDocument("{ \"esc\\\"aped\" : \"\\b\\f\\n\\r\\t\\/\\\\\\u00e9\\uD834\\uDD1E\" , \"\\u0000\" : [ \"a long string without any escape\" ] }");
+	ExpectSameDocument("{\"a\":1,\"a\":2,\"b\":[1,2,3]}");
+}
+
+TEST(LazyDocument, Read) {
+	const char json[] = "{\"id\":123,\"name\":\"a name too long to be stored in a value\",\"tags\":[\"x\",\"y\",\"z\"],"
+		"\"price\":0.1,\"big\":12345678901234,\"nothing\":null,\"esc\\naped\":{\"ok\":true}}";
+	LazyDocument d;
+	d.Parse(json);
+	ASSERT_FALSE(d.HasParseError());
+	LazyValue root = d.GetRoot();
+	ASSERT_TRUE(root.IsObject());
+	EXPECT_EQ(7u, root.MemberCount());
+
+	// Nothing is decoded before being read
+	const size_t size = d.GetAllocator().Size();
+	EXPECT_TRUE(root["tags"].IsArray());
+	EXPECT_TRUE(root["name"].IsString());
+	EXPECT_TRUE(root["price"].IsNumber());
+	EXPECT_TRUE(root["nothing"].IsNull());
+	EXPECT_EQ(size, d.GetAllocator().Size());
+
+	// Decoded once
+	EXPECT_EQ(123, root["id"].GetInt());
+	EXPECT_TRUE(root["id"].IsUint());
+	EXPECT_FALSE(root["id"].IsDouble());
+	const char* name = root["name"].GetString();
+	EXPECT_STREQ("a name too long to be stored in a value", name);
+	EXPECT_EQ(name, root["name"].GetString());
+	const size_t decoded = d.GetAllocator().Size();
+	EXPECT_LT(size, decoded);
+	EXPECT_EQ(123, root["id"].GetInt());
+	EXPECT_EQ(name, root.FindMember("name")->value.GetString());
+	EXPECT_EQ(decoded, d.GetAllocator().Size());
+
+	EXPECT_EQ(0.1, root["price"].GetDouble());
+	EXPECT_EQ(12345678901234LL, root["big"].GetInt64());
+	EXPECT_TRUE(root["esc\naped"]["ok"].GetBool());
+	EXPECT_EQ(3u, root["tags"].Size());
+	EXPECT_STREQ("z", root["tags"][2u].GetString());
+	EXPECT_STREQ("x", root["tags"][0u].GetString());
+	EXPECT_FALSE(root["tags"].Empty());
+
+	// Missing members
+	EXPECT_FALSE(root.HasMember("missing"));
+	EXPECT_FALSE(root.HasMember("esc"));
+	EXPECT_FALSE(root.HasMember("i"));
+	EXPECT_TRUE(root.FindMember("ok") == root.MemberEnd());
+	EXPECT_TRUE(root.HasMember("nothing"));
+	EXPECT_TRUE(LazyValue().IsNull());
+
+	// Names with null characters
+	EXPECT_EQ(1, d.Parse("{\"a\\u0000b\":1,\"a\":2}").GetRoot().FindMember("a\0b", 3)->value.GetInt());
+	EXPECT_EQ(2, d.GetRoot()["a"].GetInt());
+}
+
+TEST(LazyDocument, Flags) {
+	// Correctly rounded with kParseFullPrecisionFlag
+	const char json[] = "[0.9868011474609375000000000000000000000001]";
+	Document full;
+	full.Parse<kParseFullPrecisionFlag>(json);
+	LazyDocument d;
+	EXPECT_EQ(full[0u].GetDouble(), d.Parse<kParseFullPrecisionFlag>(json).GetRoot()[0u].GetDouble());
+
+	EXPECT_TRUE(d.Parse("[1] [2]").HasParseError());
+	EXPECT_EQ(kParseErrorDocumentRootNotSingular, d.GetParseError());
+	EXPECT_TRUE(d.GetRoot().IsNull());
+	EXPECT_FALSE(d.Parse<kParseStopWhenDoneFlag>("[1] [2]").HasParseError());
+	EXPECT_EQ(1, d.GetRoot()[0u].GetInt());
+}
+
+TEST(LazyDocument, Error) {
+	// Same errors as a document
+	const char* kInvalid[] = {
+		"", " ", "1", "\"a\"", "[1] x", "[", "{", "[1", "[1 2]", "[1,]", "{\"a\":1", "{\"a\" 1}", "{1:1}", "{\"a\":1,}", "{\"a\":1 \"b\":2}",
+		"[nul]", "[truE]", "[f]", "[-]", "[+1]", "[.5]", "[1.]", "[1.e5]", "[1e]", "[1e+]", "[01]",
+		"[\"abc", "[\"a\x01\"]", "[\"\\x\"]", "[\"\\u12G4\"]", "[\"\\uD800\"]", "[\"\\uD800\\u0041\"]", "[\"\\uDBFF\\uE000\"]", "[\"\\"
+	};
+	for (size_t i = 0; i < sizeof(kInvalid) / sizeof(kInvalid[0]); i++) {
+		Document expected;
+		expected.Parse(kInvalid[i]);
+		ASSERT_TRUE(expected.HasParseError()) << kInvalid[i];
+		LazyDocument d;
+		d.Parse(kInvalid[i]);
+		EXPECT_TRUE(d.HasParseError()) << kInvalid[i];
+		EXPECT_EQ(expected.GetParseError(), d.GetParseError()) << kInvalid[i];
+		EXPECT_TRUE(d.GetRoot().IsNull());
+	}
+}
@@ -0,0 +1,112 @@
+#include "unittest.h"
+
+#include "rapidjsonxml/memberaccessor.h"
+#include "rapidjsonxml/writerjson.h"
+#include "rapidjsonxml/stringbuffer.h"
+
+#include <cstdio>
+
+using namespace rapidjsonxml;
+
+TEST(MemberAccessor, Find) {
+	Document d;
+	d.Parse("[{\"id\":1,\"name\":\"a\",\"tags\":[]},{\"id\":2,\"name\":\"b\",\"tags\":[]},{\"tags\":[3],\"name\":\"c\",\"id\":3},{\"name\":\"d\"},{\"ie\":5,\"nbme\":\"e\"}]");
+	ASSERT_FALSE(d.HasParseError());
+	const MemberAccessor id("id"), name("name"), missing("missing");
+	EXPECT_STREQ("id", id.GetName().GetString());
+
+	// Same shape, then members at other positions
+	for (SizeType i = 0; i < 3; i++) {
+		ASSERT_TRUE(id.Get(d[i]) != 0);
+		EXPECT_EQ(static_cast<int>(i + 1), id.Get(d[i])->GetInt());
+		EXPECT_EQ(std::string(1, static_cast<char>('a' + i)), name.Get(d[i])->GetString());
+		EXPECT_TRUE(id.Find(d[i]) == d[i].FindMember("id"));
+		EXPECT_FALSE(missing.Has(d[i]));
+	}
+
+	// Missing, and names of the same length at the last position
+	EXPECT_TRUE(id.Get(d[3u]) == 0);
+	EXPECT_STREQ("d", name.Get(d[3u])->GetString());
+	EXPECT_TRUE(id.Find(d[4u]) == d[4u].MemberEnd());
+	EXPECT_FALSE(name.Has(d[4u]));
+
+	// Objects with fewer members than the last position
+	const Value& constObject = d[2u];
+	EXPECT_STREQ("c", name.Get(constObject)->GetString());
+	Value empty(kObjectType);
+	EXPECT_TRUE(name.Get(empty) == 0);
+	EXPECT_TRUE(id.Get(d[0u]) != 0);
+
+	// Modified through the accessor
+	id.Get(d[0u])->SetInt(10);
+	EXPECT_EQ(10, d[0u]["id"].GetInt());
+
+	// Names with null characters
+	Value o(kObjectType);
+	o.AddMember(Value::StringRefType("a\0b", 3), 1, d.GetAllocator());
+	o.AddMember(Value::StringRefType("a\0c", 3), 2, d.GetAllocator());
+	const MemberAccessor ab(Value::StringRefType("a\0b", 3)), ac(Value::StringRefType("a\0c", 3));
+	EXPECT_EQ(1, ab.Get(o)->GetInt());
+	EXPECT_EQ(2, ac.Get(o)->GetInt());
+	EXPECT_EQ(1, ab.Get(o)->GetInt());
+}
+
+TEST(MemberAccessor, RepeatedNames) {
+	Document d;
+	d.ParseXml("<r><o><x>z</x><a>one</a></o><o><a>first</a><a>second</a></o></r>");
+	ASSERT_FALSE(d.HasParseError());
+	const Value& o1 = d["r"].MemberBegin()[0].value;
+	const Value& o2 = d["r"].MemberBegin()[1].value;
+	const MemberAccessor a("a");
+
+	// The position found in the first object is the second "a" of the next one
+	EXPECT_STREQ("one", a.Get(o1)->GetString());
+	EXPECT_STREQ("first", a.Get(o2)->GetString());
+	EXPECT_TRUE(a.Find(o2) == o2.FindMember("a"));
+	EXPECT_STREQ(o2["a"].GetString(), a.Get(o2)->GetString());
+
+	// Back to the first object from the first position
+	EXPECT_STREQ("one", a.Get(o1)->GetString());
+	EXPECT_STREQ("first", a.Get(o2)->GetString());
+}
+
+TEST(MemberAccessor, UniqueNames) {
+	// Objects built by AddMember(), small and indexed, with long names rejected by their hashes
+	Document d;
+	const char* kLong = "a name too long to be stored in the value";
+	const MemberAccessor a(StringRef(kLong));
+	for (SizeType count = 4; count <= 64; count *= 4) {
+		Value unique(kObjectType), repeated(kObjectType);
+		for (SizeType i = 0; i < count; i++) {
+			char name[16];
+			sprintf(name, "m%u", i);
+			Value n1(name, d.GetAllocator()), n2(name, d.GetAllocator()), v1(static_cast<int>(i)), v2(static_cast<int>(i));
+			unique.AddMember(n1, v1, d.GetAllocator());
+			if (i == 1)
+				repeated.AddMember(StringRef(kLong), -1, d.GetAllocator());
+			else
+				repeated.AddMember(n2, v2, d.GetAllocator());
+		}
+		unique.AddMember(StringRef(kLong), 100, d.GetAllocator());
+		repeated.AddMember(StringRef(kLong), 100, d.GetAllocator());
+		EXPECT_EQ(100, a.Get(unique)->GetInt()) << count;
+		EXPECT_EQ(-1, a.Get(repeated)->GetInt()) << count;
+		EXPECT_EQ(100, a.Get(unique)->GetInt()) << count;
+
+		// The same objects from a parsing, and their deep copies
+		StringBuffer buffer;
+		WriterJson<StringBuffer> writer(buffer);
+		repeated.Accept(writer);
+		Document parsed;
+		parsed.Parse(buffer.GetString());
+		ASSERT_FALSE(parsed.HasParseError());
+		Value copy(unique, d.GetAllocator());
+		EXPECT_EQ(100, a.Get(copy)->GetInt()) << count;
+		EXPECT_EQ(-1, a.Get(parsed)->GetInt()) << count;
+		EXPECT_EQ(100, a.Get(copy)->GetInt()) << count;
+
+		// Removing a member keeps the names different
+		copy.RemoveMember(copy.MemberBegin());
+		EXPECT_EQ(100, a.Get(copy)->GetInt()) << count;
+	}
+}
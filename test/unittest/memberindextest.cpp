@@ -0,0 +1,168 @@
+#include "unittest.h"
+
+#include "rapidjsonxml/document.h"
+#include "rapidjsonxml/writerjson.h"
+#include "rapidjsonxml/stringbuffer.h"
+
+#include <sstream>
+#include <string>
+
+using namespace rapidjsonxml;
+
+// Short names are stored in the values, long ones are allocated
+static std::string MemberName(int i) {
+	std::ostringstream name;
+	name << (i % 2 ? "m" : "a rather long member name ") << i;
+	return name.str();
+}
+
+template <typename ValueType>
+static void ExpectMembers(const ValueType& o, int begin, int end, int step) {
+	for (int i = begin; i < end; i += step) {
+		typename ValueType::ConstMemberIterator m = o.FindMember(MemberName(i).c_str());
+		ASSERT_TRUE(m != o.MemberEnd()) << i;
+		EXPECT_EQ(MemberName(i), m->name.GetString());
+		EXPECT_EQ(i, m->value.GetInt());
+	}
+}
+
+TEST(MemberIndex, AddRemove) {
+	Document d;
+	Value o(kObjectType);
+	for (int i = 0; i < 1000; i++) {
+		Value name(MemberName(i), d.GetAllocator());
+		Value value(i);
+		o.AddMember(name, value, d.GetAllocator());
+		ExpectMembers(o, i, i + 1, 1);
+	}
+	ExpectMembers(o, 0, 1000, 1);
+	EXPECT_FALSE(o.HasMember("m0"));
+	EXPECT_FALSE(o.HasMember(""));
+	EXPECT_FALSE(o.HasMember("a rather long member name 1"));
+	EXPECT_FALSE(o.HasMember("m1000"));
+
+	// Removed, moving the last members
+	for (int i = 0; i < 1000; i += 3)
+		EXPECT_TRUE(o.RemoveMember(MemberName(i).c_str())) << i;
+	EXPECT_EQ(666, o.MemberEnd() - o.MemberBegin());
+	for (int i = 0; i < 1000; i += 3)
+		EXPECT_FALSE(o.HasMember(MemberName(i).c_str())) << i;
+	ExpectMembers(o, 1, 1000, 3);
+	ExpectMembers(o, 2, 1000, 3);
+
+	// Removed by iterator while iterating
+	for (Value::MemberIterator m = o.MemberBegin(); m != o.MemberEnd(); ) {
+		if (m->value.GetInt() % 2)
+			m = o.RemoveMember(m);
+		else
+			++m;
+	}
+	EXPECT_EQ(333, o.MemberEnd() - o.MemberBegin());
+	ExpectMembers(o, 2, 1000, 6);
+	EXPECT_FALSE(o.HasMember("m1"));
+
+	// Added again
+	for (int i = 1; i < 1000; i += 2) {
+		Value name(MemberName(i), d.GetAllocator());
+		Value value(i);
+		o.AddMember(name, value, d.GetAllocator());
+	}
+	ExpectMembers(o, 1, 1000, 2);
+	ExpectMembers(o, 2, 1000, 6);
+}
+
+// Each name is found at its first member, as by a linear search
+static void ExpectFirstMembers(Value& o) {
+	for (Value::MemberIterator m = o.MemberBegin(); m != o.MemberEnd(); ++m) {
+		Value::MemberIterator first = o.MemberBegin();
+		while (std::string(first->name.GetString()) != m->name.GetString())
+			++first;
+		EXPECT_TRUE(o.FindMember(m->name) == first) << m->name.GetString();
+	}
+}
+
+TEST(MemberIndex, Duplicates) {
+	// Repeated XML elements are members with the same name
+	std::string xml("<r>");
+	for (int i = 0; i < 2000; i++) {
+		std::ostringstream element;
+		element << "<item>" << i << "</item>";
+		if (i % 10 == 0)
+			element << "<n" << i / 10 << ">" << i << "</n" << i / 10 << ">";
+		if (i % 100 == 0)
+			element << "<other>" << i << "</other>";
+		xml += element.str();
+	}
+	xml += "</r>";
+
+	Document d;
+	d.ParseXml(xml.c_str());
+	ASSERT_FALSE(d.HasParseError());
+	Value& r = d["r"];
+	EXPECT_EQ(2220, r.MemberEnd() - r.MemberBegin());
+	ExpectFirstMembers(r);
+
+	// Removed from the first ones, from the last ones and in the middle
+	unsigned seed = 1;
+	while (r.MemberBegin() != r.MemberEnd()) {
+		seed = seed * 1103515245 + 12345;
+		Value::MemberIterator m = r.MemberBegin() + (seed >> 8) % (r.MemberEnd() - r.MemberBegin());
+		if (seed % 3 == 0)
+			r.RemoveMember(m);
+		else if (seed % 3 == 1)
+			r.RemoveMember(m->name);
+		else
+			r.RemoveMember(r.MemberEnd() - 1);
+		if ((r.MemberEnd() - r.MemberBegin()) % 100 == 0)
+			ExpectFirstMembers(r);
+	}
+}
+
+TEST(MemberIndex, Parse) {
+	std::string json("{");
+	for (int i = 0; i < 300; i++) {
+		std::ostringstream member;
+		member << (i ? "," : "") << "\"" << MemberName(i) << "\":" << i;
+		json += member.str();
+	}
+	json += ",\"object\":{\"\\u0000\":1,\"x\":2}}";
+
+	Document d;
+	d.Parse(json.c_str());
+	ASSERT_FALSE(d.HasParseError());
+	ExpectMembers(d, 0, 300, 1);
+	EXPECT_EQ(1, d["object"][Value("\0", 1)].GetInt());
+	EXPECT_FALSE(d.HasMember("x"));
+
+	// Copied and written in the same order
+	Document copy;
+	copy.CopyFrom(d, copy.GetAllocator());
+	ExpectMembers(copy, 0, 300, 1);
+	StringBuffer buffer;
+	WriterJson<StringBuffer> writer(buffer);
+	copy.Accept(writer);
+	EXPECT_EQ(0u, std::string(buffer.GetString()).find("{\"a rather long member name 0\":0,\"m1\":1,"));
+
+	// Grown after parsing
+	Value name("added", d.GetAllocator());
+	Value value(300);
+	d.AddMember(name, value, d.GetAllocator());
+	EXPECT_EQ(300, d["added"].GetInt());
+	ExpectMembers(d, 0, 300, 1);
+}
+
+TEST(MemberIndex, Free) {
+	typedef GenericValue<UTF8<>, CrtAllocator> CrtValue;
+	CrtAllocator allocator;
+	CrtValue o(kObjectType);
+	for (int i = 0; i < 100; i++) {
+		CrtValue name(MemberName(i), allocator);
+		CrtValue value(MemberName(i), allocator);
+		o.AddMember(name, value, allocator);
+	}
+	for (int i = 0; i < 100; i += 2)
+		EXPECT_TRUE(o.RemoveMember(MemberName(i).c_str()));
+	for (int i = 1; i < 100; i += 2)
+		EXPECT_EQ(MemberName(i), o[MemberName(i).c_str()].GetString());
+	o.SetNull();
+}
@@ -0,0 +1,120 @@
+#include "unittest.h"
+
+#include "rapidjsonxml/reader.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace rapidjsonxml;
+
+// Records the number event as "type:value"
+struct NumberHandler : BaseReaderHandler<> {
+	NumberHandler() : result() {}
+	bool Int(int i) { return Set("Int", (long long)i); }
+	bool Uint(unsigned u) { return Set("Uint", (unsigned long long)u); }
+	bool Int64(int64_t i) { return Set("Int64", (long long)i); }
+	bool Uint64(uint64_t u) { return Set("Uint64", (unsigned long long)u); }
+	bool Double(double d) {
+		char buffer[64];
+		sprintf(buffer, "Double:%.17g", d);
+		result = buffer;
+		return true;
+	}
+	bool Set(const char* type, long long i) {
+		char buffer[64];
+		sprintf(buffer, "%s:%lld", type, i);
+		result = buffer;
+		return true;
+	}
+	bool Set(const char* type, unsigned long long u) {
+		char buffer[64];
+		sprintf(buffer, "%s:%llu", type, u);
+		result = buffer;
+		return true;
+	}
+	std::string result;
+};
+
+// Input stream without the digit parsing specializations
+struct CharStream {
+	typedef char Ch;
+	CharStream(const char* src) : src_(src), head_(src) {}
+	Ch Peek() const { return *src_; }
+	Ch Take() { return *src_++; }
+	size_t Tell() const { return static_cast<size_t>(src_ - head_); }
+	Ch* PutBegin() { RAPIDJSONXML_ASSERT(false); return 0; }
+	void Put(Ch) { RAPIDJSONXML_ASSERT(false); }
+	void Flush() { RAPIDJSONXML_ASSERT(false); }
+	size_t PutEnd(Ch*) { RAPIDJSONXML_ASSERT(false); return 0; }
+	const Ch* src_;
+	const Ch* head_;
+};
+
+template <typename Stream>
+static std::string ParseNumber(Stream& s) {
+	NumberHandler h;
+	Reader reader;
+	EXPECT_TRUE(reader.Parse<kParseStopWhenDoneFlag>(s, h));
+	return h.result;
+}
+
+// Parse "[number]" at the given position with StringStream, InsituStringStream and a generic stream
+static void TestNumber(char* buffer, const std::string& number, const char* expected) {
+	std::string json = "[" + number + "]";
+	std::memcpy(buffer, json.c_str(), json.size() + 1);
+	StringStream s(buffer);
+	std::string result = ParseNumber(s);
+	if (expected) {
+		EXPECT_EQ(expected, result) << number;
+	}
+	EXPECT_EQ(json.size(), s.Tell()) << number;
+
+	CharStream c(buffer);
+	EXPECT_EQ(result, ParseNumber(c)) << number;
+	EXPECT_EQ(json.size(), c.Tell()) << number;
+
+	InsituStringStream is(buffer);
+	EXPECT_EQ(result, ParseNumber(is)) << number;
+}
+
+TEST(ParseNumber, Integer) {
+	char buffer[64];
+	TestNumber(buffer, "0", "Uint:0");
+	TestNumber(buffer, "-0", "Int:0");
+	TestNumber(buffer, "7", "Uint:7");
+	TestNumber(buffer, "12345678", "Uint:12345678");
+	TestNumber(buffer, "123456789", "Uint:123456789");
+	TestNumber(buffer, "1234567890123456", "Uint64:1234567890123456");
+	TestNumber(buffer, "2147483647", "Uint:2147483647");
+	TestNumber(buffer, "-2147483648", "Int:-2147483648");
+	TestNumber(buffer, "-2147483649", "Int64:-2147483649");
+	TestNumber(buffer, "4294967295", "Uint:4294967295");
+	TestNumber(buffer, "4294967296", "Uint64:4294967296");
+	TestNumber(buffer, "-9223372036854775807", "Int64:-9223372036854775807");
+	TestNumber(buffer, "-9223372036854775809", "Double:-9.2233720368547758e+18");
+	TestNumber(buffer, "9999999999999999999", "Uint64:9999999999999999999");
+	TestNumber(buffer, "18446744073709551615", "Uint64:18446744073709551615");
+	TestNumber(buffer, "18446744073709551616", "Double:1.8446744073709552e+19");
+	TestNumber(buffer, "123456789012345678901234", 0); // same value as the generic stream
+	TestNumber(buffer, "1234567890123.5", "Double:1234567890123.5");
+	TestNumber(buffer, "12345678901234567e2", "Double:1.2345678901234568e+18");
+}
+
+TEST(ParseNumber, IntegerDigits) {
+	// Every digit count at every alignment, also near the end of a memory page
+	const size_t kPageSize = 4096;
+	char* pages = static_cast<char*>(malloc(3 * kPageSize));
+	char* pageEnd = reinterpret_cast<char*>((reinterpret_cast<size_t>(pages) + 2 * kPageSize) & ~(kPageSize - 1));
+	std::string digits = "9876543210123456789012345";
+	for (size_t length = 1; length <= digits.size(); length++) {
+		for (int minus = 0; minus < 2; minus++) {
+			std::string number = (minus ? "-" : "") + digits.substr(0, length);
+			for (size_t offset = 0; offset < 40; offset++) {
+				TestNumber(pages + offset, number, 0);
+				TestNumber(pageEnd - number.size() - 3 - offset % 20, number, 0);
+			}
+		}
+	}
+	free(pages);
+}
@@ -0,0 +1,230 @@
+#include "unittest.h"
+
+#include "rapidjsonxml/reader.h"
+#include "rapidjsonxml/document.h"
+#include "rapidjsonxml/memorystream.h"
+
+#include <string>
+
+using namespace rapidjsonxml;
+
+// Records the strings
+struct StringHandler : BaseReaderHandler<> {
+	StringHandler() : result() {}
+	bool String(const char* str, SizeType length, bool) {
+		result.append(str, length) += '|';
+		return true;
+	}
+	std::string result;
+};
+
+// Records the strings, the long ones decoded into its allocator
+template <typename Allocator>
+struct AllocatedStringHandler : BaseReaderHandler<> {
+	typedef Allocator AllocatorType;
+	AllocatedStringHandler() : allocator(), result() {}
+	Allocator& GetAllocator() { return allocator; }
+	bool String(const char* str, SizeType length, bool copy) {
+		EXPECT_TRUE(copy);
+		EXPECT_GT(32u, length);
+		result.append(str, length) += '|';
+		return true;
+	}
+	bool AllocatedString(char* str, SizeType length, bool) {
+		EXPECT_EQ('\0', str[length]);
+		EXPECT_LE(31u, length);
+		result.append(str, length) += '|';
+		Allocator::Free(str);
+		return true;
+	}
+	Allocator allocator;
+	std::string result;
+};
+
+// Input stream without the string scanning specializations
+struct CharStream {
+	typedef char Ch;
+	CharStream(const char* src) : src_(src), head_(src) {}
+	Ch Peek() const { return *src_; }
+	Ch Take() { return *src_++; }
+	size_t Tell() const { return static_cast<size_t>(src_ - head_); }
+	Ch* PutBegin() { RAPIDJSONXML_ASSERT(false); return 0; }
+	void Put(Ch) { RAPIDJSONXML_ASSERT(false); }
+	void Flush() { RAPIDJSONXML_ASSERT(false); }
+	size_t PutEnd(Ch*) { RAPIDJSONXML_ASSERT(false); return 0; }
+	const Ch* src_;
+	const Ch* head_;
+};
+
+template <unsigned parseFlags, typename Handler, typename Stream>
+static std::string ParseWith(Stream& s, ParseErrorCode* error = 0) {
+	Handler h;
+	Reader reader;
+	reader.Parse<parseFlags>(s, h);
+	if (error)
+		*error = reader.GetParseErrorCode();
+	return h.result;
+}
+
+template <unsigned parseFlags, typename Stream>
+static std::string Parse(Stream& s, ParseErrorCode* error = 0) {
+	return ParseWith<parseFlags, StringHandler>(s, error);
+}
+
+TEST(ParseString, Unescaped) {
+	// Escapes at every position of strings with various lengths and alignments,
+	// with StringStream, InsituStringStream and a generic stream
+	static const char* kEscapes[] = { "\\\"", "\\\\", "\\n", "\\u00e9", "\\ud834\\udd1e" };
+	static const char* kDecoded[] = { "\"", "\\", "\n", "\xC3\xA9", "\xF0\x9D\x84\x9E" };
+	char buffer[160];
+	for (size_t length = 0; length < 48; length++) {
+		for (size_t offset = 0; offset < 16; offset++) {
+			for (size_t escaped = 0; escaped <= length; escaped += 3) {
+				std::string json("["), expected;
+				for (int k = 0; k < 2; k++) { // twice, the second string follows escapes
+					json += "\"";
+					for (size_t i = 0; i < length; i++) {
+						if ((i == escaped || (i > escaped && (i - escaped) % 11 == 0)) && i % 6 != 3) {
+							json += kEscapes[i % 5];
+							expected += kDecoded[i % 5];
+						}
+						json += "ab\xC3\xA9xy"[i % 6]; // 'é' is 2 bytes, not cut by escapes
+						expected += "ab\xC3\xA9xy"[i % 6];
+					}
+					json += "\",";
+					expected += '|';
+				}
+				json[json.size() - 1] = ']';
+
+				char* str = buffer + offset;
+				std::memcpy(str, json.c_str(), json.size() + 1);
+				StringStream s(str);
+				EXPECT_EQ(expected, Parse<kParseDefaultFlags>(s)) << json;
+				CharStream c(str);
+				EXPECT_EQ(expected, Parse<kParseDefaultFlags>(c)) << json;
+				StringStream a(str);
+				EXPECT_EQ(expected, (ParseWith<kParseDefaultFlags, AllocatedStringHandler<CrtAllocator> >(a))) << json;
+				CharStream ac(str);
+				EXPECT_EQ(expected, (ParseWith<kParseDefaultFlags, AllocatedStringHandler<MemoryPoolAllocator<> > >(ac))) << json;
+				if (length % 6 != 3) { // otherwise ends in the middle of 'é'
+					StringStream v(str);
+					EXPECT_EQ(expected, Parse<kParseValidateEncodingFlag>(v)) << json;
+				}
+				InsituStringStream is(str);
+				EXPECT_EQ(expected, Parse<kParseInsituFlag>(is)) << json;
+			}
+		}
+	}
+}
+
+TEST(ParseString, Error) {
+	char buffer[64];
+	const char* kInvalid[] = { "[\"abcdefghijklmnopqrstuvwxyz\x01\"]", "[\"abcdefghijklmnopqrstuvwxyz", "[\"abc\\x\"]" };
+	const ParseErrorCode kErrors[] = { kParseErrorStringEscapeInvalid, kParseErrorStringMissQuotationMark, kParseErrorStringEscapeInvalid };
+	for (size_t i = 0; i < 3; i++) {
+		ParseErrorCode error;
+		std::strcpy(buffer, kInvalid[i]);
+		StringStream s(buffer);
+		Parse<kParseDefaultFlags>(s, &error);
+		EXPECT_EQ(kErrors[i], error) << i;
+		InsituStringStream is(buffer);
+		Parse<kParseInsituFlag>(is, &error);
+		EXPECT_EQ(kErrors[i], error) << i;
+		std::strcpy(buffer, kInvalid[i]);
+		StringStream a(buffer);
+		ParseWith<kParseDefaultFlags, AllocatedStringHandler<CrtAllocator> >(a, &error);
+		EXPECT_EQ(kErrors[i], error) << i;
+	}
+}
+
+TEST(ParseString, Document) {
+	// Strings stored in the values, decoded into the allocator, and interned names
+	const char json[] = "{\"short\":\"abc\",\"a rather long member name\":\"a string too long to be stored in the value\","
+		"\"object\":{\"a rather long member name\":\"\\u00e9\\u00e9\\u00e9\\u00e9\\u00e9\\u00e9\\u00e9\\u00e9\"}}";
+	Document d;
+	d.SetKeyInterning(true).Parse(json);
+	ASSERT_FALSE(d.HasParseError());
+	EXPECT_STREQ("abc", d["short"].GetString());
+	EXPECT_STREQ("a string too long to be stored in the value", d["a rather long member name"].GetString());
+	EXPECT_EQ(16u, d["object"]["a rather long member name"].GetStringLength());
+	EXPECT_EQ(d.MemberBegin()[1].name.GetString(), d["object"].MemberBegin()->name.GetString());
+	EXPECT_EQ(internal::StrHash("a string too long to be stored in the value", 43), d["a rather long member name"].GetStringHash());
+	Value copy(d, d.GetAllocator());
+	EXPECT_TRUE(copy == d);
+
+	// Only the strings too long for the values are kept
+	Document literals, strings;
+	literals.Parse("[true,false,null]");
+	strings.Parse("[\"abc\",\"\",\"0123456789\"]");
+	ASSERT_FALSE(strings.HasParseError());
+	EXPECT_EQ(literals.GetAllocator().Size(), strings.GetAllocator().Size());
+	Document longer;
+	longer.Parse("[\"abc\",\"\",\"a string too long to be stored in the value\"]");
+	EXPECT_EQ(literals.GetAllocator().Size() + RAPIDJSONXML_ALIGN(44), longer.GetAllocator().Size());
+}
+
+// Records the strings, the borrowed ones between < and >
+struct BorrowedStringHandler : BaseReaderHandler<> {
+	BorrowedStringHandler() : result() {}
+	bool String(const char* str, SizeType length, bool copy) {
+		result.append(copy ? "" : "<").append(str, length).append(copy ? "|" : ">");
+		return true;
+	}
+	std::string result;
+};
+
+TEST(ParseString, Borrow) {
+	const char json[] = "{\"name\":\"value\",\"esc\\naped\":[\"a\\\"b\",\"\",\"a long string without any escape\"]}";
+	Reader reader;
+	StringStream s(json);
+	BorrowedStringHandler h;
+	EXPECT_TRUE(reader.Parse<kParseBorrowStringsFlag>(s, h));
+	EXPECT_EQ("<name><value>esc\naped|a\"b|<><a long string without any escape>", h.result);
+
+	// Not null-terminated
+	MemoryStream m(json, sizeof(json) - 5);
+	BorrowedStringHandler hm;
+	EXPECT_FALSE(reader.Parse<kParseBorrowStringsFlag>(m, hm));
+	EXPECT_EQ(kParseErrorStringMissQuotationMark, reader.GetParseErrorCode());
+	EXPECT_EQ("<name><value>esc\naped|a\"b|<>", hm.result);
+
+	// Same errors as when decoding
+	const char* kInvalid[] = { "[\"abc\x01\"]", "[\"abc", "[\"abc\\x\"]" };
+	const ParseErrorCode kErrors[] = { kParseErrorStringEscapeInvalid, kParseErrorStringMissQuotationMark, kParseErrorStringEscapeInvalid };
+	for (size_t i = 0; i < 3; i++) {
+		StringStream e(kInvalid[i]);
+		BorrowedStringHandler he;
+		EXPECT_FALSE(reader.Parse<kParseBorrowStringsFlag | kParseIterativeFlag>(e, he));
+		EXPECT_EQ(kErrors[i], reader.GetParseErrorCode()) << i;
+	}
+
+	// Constant strings of the document, pointing into the text
+	Document d;
+	d.Parse<kParseBorrowStringsFlag>(json);
+	ASSERT_FALSE(d.HasParseError());
+	EXPECT_EQ(json + 2, d.MemberBegin()->name.GetString());
+	EXPECT_EQ(json + 9, d["name"].GetString());
+	EXPECT_STREQ("a\"b", d["esc\naped"][0u].GetString());
+	EXPECT_EQ(0u, d["esc\naped"][1u].GetStringLength());
+	EXPECT_EQ(std::string("a long string without any escape"), std::string(d["esc\naped"][2u].GetString(), d["esc\naped"][2u].GetStringLength()));
+	Document copy;
+	copy.Parse(json);
+	EXPECT_TRUE(copy == d);
+}
+
+TEST(MemoryPoolAllocator, Realloc) {
+	MemoryPoolAllocator<> allocator;
+	char* a = static_cast<char*>(allocator.Malloc(10));
+	const size_t size = allocator.Size();
+	EXPECT_EQ(a, allocator.Realloc(a, 10, 100)); // last allocation, grown in place
+	EXPECT_EQ(size + RAPIDJSONXML_ALIGN(100) - RAPIDJSONXML_ALIGN(10), allocator.Size());
+	EXPECT_EQ(a, allocator.Realloc(a, 100, 5)); // shrunk
+	EXPECT_EQ(size - RAPIDJSONXML_ALIGN(10) + RAPIDJSONXML_ALIGN(5), allocator.Size());
+	char* b = static_cast<char*>(allocator.Malloc(8));
+	EXPECT_EQ(a, allocator.Realloc(a, 5, 1)); // not the last one
+	char* c = static_cast<char*>(allocator.Realloc(a, 5, 16));
+	EXPECT_NE(a, c);
+	EXPECT_NE(b, c);
+	allocator.Realloc(c, 16, 0); // given back
+	EXPECT_EQ(b + RAPIDJSONXML_ALIGN(8), allocator.Malloc(1));
+}
@@ -0,0 +1,103 @@
+#include "unittest.h"
+
+#include "rapidjsonxml/document.h"
+#include "rapidjsonxml/writerjson.h"
+#include "rapidjsonxml/writerxml.h"
+#include "rapidjsonxml/stringbuffer.h"
+
+#include <string>
+
+using namespace rapidjsonxml;
+
+#if RAPIDJSONXML_48BITPOINTER_OPTIMIZATION || !RAPIDJSONXML_64BIT
+static const SizeType kMaxShortLength = 13;
+#else
+static const SizeType kMaxShortLength = 21;
+#endif
+
+TEST(ShortString, Lengths) {
+	const char* text = "0123456789abcdefghijklmnopqrstuvwxyz";
+	for (SizeType length = 0; length < 30; length++) {
+		Document d;
+		size_t size = d.GetAllocator().Size();
+		Value v(text, length, d.GetAllocator());
+		EXPECT_EQ(length <= kMaxShortLength, d.GetAllocator().Size() == size) << length; // stored in the value
+		ASSERT_TRUE(v.IsString());
+		EXPECT_EQ(length, v.GetStringLength());
+		EXPECT_EQ(std::string(text, length), v.GetString());
+		EXPECT_EQ('\0', v.GetString()[length]);
+
+		// Moved with the value
+		Value w;
+		w = v;
+		EXPECT_TRUE(v.IsNull());
+		EXPECT_EQ(std::string(text, length), std::string(w.GetString(), w.GetStringLength()));
+		Value a(kArrayType);
+		a.PushBack(w, d.GetAllocator());
+		a.Reserve(100, d.GetAllocator());
+		EXPECT_EQ(std::string(text, length), a[0u].GetString());
+	}
+
+	// Null characters are kept
+	Document d;
+	Value v("a\0b", 3, d.GetAllocator());
+	EXPECT_EQ(3u, v.GetStringLength());
+	EXPECT_EQ(0, std::memcmp("a\0b", v.GetString(), 4));
+}
+
+TEST(ShortString, Members) {
+	Document d;
+	d.Parse("{\"id\":1,\"a fairly long member name\":2,\"enum\":\"ON\",\"\":3,\"abcdefghijklm\":4,\"abcdefghijklmnopqrstuv\":5}");
+	ASSERT_FALSE(d.HasParseError());
+	EXPECT_EQ(1, d["id"].GetInt());
+	EXPECT_EQ(2, d["a fairly long member name"].GetInt());
+	EXPECT_STREQ("ON", d["enum"].GetString());
+	EXPECT_EQ(3, d[""].GetInt());
+	EXPECT_EQ(4, d["abcdefghijklm"].GetInt());
+	EXPECT_EQ(5, d["abcdefghijklmnopqrstuv"].GetInt());
+	EXPECT_FALSE(d.HasMember("i"));
+	EXPECT_FALSE(d.HasMember("abcdefghijkl"));
+
+	// Written and copied
+	StringBuffer json;
+	WriterJson<StringBuffer> writer(json);
+	d.Accept(writer);
+	EXPECT_STREQ("{\"id\":1,\"a fairly long member name\":2,\"enum\":\"ON\",\"\":3,\"abcdefghijklm\":4,\"abcdefghijklmnopqrstuv\":5}", json.GetString());
+	StringBuffer xml;
+	WriterXml<StringBuffer> writerXml(xml);
+	d.Accept(writerXml);
+	EXPECT_NE(std::string::npos, std::string(xml.GetString()).find("<enum>ON</enum>"));
+	Value copy(d, d.GetAllocator());
+	EXPECT_STREQ("ON", copy["enum"].GetString());
+	EXPECT_EQ(4, copy["abcdefghijklm"].GetInt());
+}
+
+TEST(ShortString, Attributes) {
+	// The short string is moved out of the value for the attributes
+	Document d;
+	Value v("short", d.GetAllocator());
+	Value::AttributeType attrib("k", "v");
+	v.AddAttribute(attrib, d.GetAllocator());
+	EXPECT_STREQ("short", v.GetString());
+	EXPECT_EQ(5u, v.GetStringLength());
+	EXPECT_EQ(1u, v.CountAttributes());
+
+	d.ParseXml("<r><s a=\"1\">text</s><t>text</t></r>");
+	ASSERT_FALSE(d.HasParseError());
+	EXPECT_STREQ("text", d["r"]["s"].GetString());
+	EXPECT_EQ(1u, d["r"]["s"].CountAttributes());
+	EXPECT_STREQ("text", d["r"]["t"].GetString());
+}
+
+TEST(ShortString, Utf16) {
+	typedef GenericDocument<UTF16<> > DocumentType;
+	typedef GenericValue<UTF16<> > ValueType;
+	const wchar_t* text = L"\x00E9t\x00E9 longer string";
+	DocumentType d;
+	for (SizeType length = 0; length < 16; length++) {
+		ValueType v(text, length, d.GetAllocator());
+		EXPECT_EQ(length, v.GetStringLength());
+		EXPECT_EQ(0, std::memcmp(text, v.GetString(), length * sizeof(wchar_t)));
+		EXPECT_EQ(L'\0', v.GetString()[length]);
+	}
+}
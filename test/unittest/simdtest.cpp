@@ -0,0 +1,166 @@
+#include "unittest.h"
+
+#include "rapidjsonxml/document.h"
+#include "rapidjsonxml/writerjson.h"
+#include "rapidjsonxml/writerxml.h"
+#include "rapidjsonxml/stringbuffer.h"
+
+#ifdef RAPIDJSONXML_SIMD_DISPATCH
+
+#include <cstring>
+#include <string>
+
+using namespace rapidjsonxml;
+
+// Forces a SIMD level during a scope
+class SimdLevelScope {
+public:
+	SimdLevelScope(SimdLevel level) : saved_(GetSimdLevel()), set_(SetSimdLevel(level)) {}
+	~SimdLevelScope() { SetSimdLevel(saved_); }
+	bool IsSet() const { return set_; }
+private:
+	SimdLevel saved_;
+	bool set_;
+};
+
+static const SimdLevel kLevels[] = { kSimdScalar, kSimdSSE2, kSimdSSE42, kSimdAVX2 };
+
+TEST(Simd, Level) {
+	// Detected before main(), without a race at the first use
+	EXPECT_EQ(internal::DetectSimdLevel(), GetCpuSimdLevel());
+	EXPECT_EQ(GetCpuSimdLevel(), GetSimdLevel());
+	{
+		SimdLevelScope scope(kSimdScalar);
+		EXPECT_TRUE(scope.IsSet());
+		EXPECT_EQ(kSimdScalar, GetSimdLevel());
+	}
+	EXPECT_EQ(GetCpuSimdLevel(), GetSimdLevel());
+	EXPECT_FALSE(SetSimdLevel(kSimdLevelCount));
+	EXPECT_EQ(GetCpuSimdLevel(), GetSimdLevel());
+}
+
+// Each kernel at each level, with the special character at every position of
+// strings with every alignment, compared with the scalar kernel
+TEST(Simd, Kernels) {
+	static const char kSpecials[] = { '"', '\\', '\n', '\x1F', '&', '<', '\x7F', '\x80', '\xE9', 'a', ' ', '\t', '\r' };
+	char storage[192 + 32];
+	char* buffer = reinterpret_cast<char*>((reinterpret_cast<size_t>(storage) + 31) & ~static_cast<size_t>(31));
+	for (size_t l = 0; l < sizeof(kLevels) / sizeof(kLevels[0]); l++) {
+		SimdLevelScope scope(kLevels[l]);
+		if (!scope.IsSet())
+			continue;
+		for (size_t offset = 0; offset < 32; offset++) {
+			for (size_t length = 0; length < 72; length++) {
+				for (size_t pos = 0; pos <= length; pos++) {
+					for (size_t c = 0; c < sizeof(kSpecials); c++) {
+						char* p = buffer + offset;
+						std::memset(buffer, '"', 192); // special before and after the string
+						for (size_t i = 0; i < length; i++)
+							p[i] = (i % 3 == 0) ? ' ' : 'x';
+						if (pos < length)
+							p[pos] = kSpecials[c];
+						const char* end = p + length;
+
+						EXPECT_EQ(ScanJsonEscape_Scalar<false>(p, end), ScanJsonEscape_SIMD<false>(p, end));
+						EXPECT_EQ(ScanJsonEscape_Scalar<true>(p, end), ScanJsonEscape_SIMD<true>(p, end));
+						EXPECT_EQ(ScanXmlEscape_Scalar(p, end), ScanXmlEscape_SIMD(p, end));
+
+						p[length] = '\0';
+						EXPECT_EQ(ScanUnescapedString_Scalar(p), ScanUnescapedString_SIMD(p));
+						EXPECT_EQ(ScanXmlText_Scalar(p), ScanXmlText_SIMD(p));
+						for (size_t i = 0; i < length; i++)
+							if (i != pos)
+								p[i] = " \n\r\t"[i % 4];
+						EXPECT_EQ(SkipWhitespace_Scalar(p), SkipWhitespace_SIMD(p));
+					}
+				}
+			}
+		}
+	}
+}
+
+// Characters up to the first special character or invalid sequence, checked one at a time by UTF8::Validate()
+static size_t ValidUtf8Prefix(const char* p) {
+	const char* q = p;
+	while (*q != '"' && *q != '\\' && static_cast<unsigned char>(*q) >= 0x20) {
+		StringStream s(q);
+		StringBuffer b;
+		if (!UTF8<>::Validate(s, b))
+			break;
+		q = s.src_;
+	}
+	return static_cast<size_t>(q - p);
+}
+
+// The UTF-8 kernel at each level, with an invalid sequence or a special character at every position of valid strings
+TEST(Simd, Utf8) {
+	static const char* kCharacters[] = { "a", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9D\x84\x9E", "\xED\x9F\xBF", "\xF4\x8F\xBF\xBF" };
+	static const char* kInserted[] = {
+		"\"", "\\", "\n", "\x80", "\xBF\x80", "\xC0\x80", "\xC1\xBF", "\xE0\x9F\xBF", "\xED\xA0\x80", "\xF0\x8F\xBF\xBF",
+		"\xF4\x90\x80\x80", "\xF5\x80\x80\x80", "\xFF", "\xC3", "\xE2\x82", "\xF0\x9D\x84", "\xC3\xA9\xA9", "\xE2\x82\xAC\x80"
+	};
+	char storage[256 + 32];
+	char* buffer = reinterpret_cast<char*>((reinterpret_cast<size_t>(storage) + 31) & ~static_cast<size_t>(31));
+	for (size_t l = 0; l < sizeof(kLevels) / sizeof(kLevels[0]); l++) {
+		SimdLevelScope scope(kLevels[l]);
+		if (!scope.IsSet())
+			continue;
+		for (size_t offset = 0; offset < 32; offset++) {
+			for (size_t length = 0; length < 80; length += 7) {
+				std::string valid;
+				for (size_t i = 0; valid.size() < length; i++)
+					valid += kCharacters[(i * 7 + length) % (sizeof(kCharacters) / sizeof(kCharacters[0]))];
+				for (size_t pos = 0; pos <= valid.size(); pos++) {
+					if (pos < valid.size() && (static_cast<unsigned char>(valid[pos]) & 0xC0) == 0x80)
+						continue;
+					for (size_t c = 0; c <= sizeof(kInserted) / sizeof(kInserted[0]); c++) {
+						const std::string str = valid.substr(0, pos) + (c < sizeof(kInserted) / sizeof(kInserted[0]) ? kInserted[c] : "") + valid.substr(pos);
+						char* p = buffer + offset;
+						std::memset(buffer, '\xE9', 256); // continuation and lead bytes before and after the string
+						std::memcpy(p, str.c_str(), str.size() + 1);
+						const size_t expected = ValidUtf8Prefix(p);
+						EXPECT_EQ(expected, ScanUnescapedUtf8String_Scalar(p)) << l << " " << offset << " " << pos << " " << c;
+						EXPECT_EQ(expected, ScanUnescapedUtf8String_SIMD(p)) << l << " " << offset << " " << pos << " " << c;
+					}
+				}
+			}
+		}
+	}
+}
+
+// Parsing and writing give the same results at each level
+TEST(Simd, ParseWrite) {
+	std::string json(" { \"item\" : [ ");
+	for (int i = 0; i < 200; i++) {
+		json += "\t\"";
+		json.append(static_cast<size_t>(i), 'a' + static_cast<char>(i % 26));
+		json += (i % 3 == 0) ? "\\n&\\\"\xC3\xA9\"" : "\"";
+		json += (i < 199) ? " ,\r\n" : "\n] }";
+	}
+
+	std::string expectedJson, expectedXml;
+	for (size_t l = 0; l < sizeof(kLevels) / sizeof(kLevels[0]); l++) {
+		SimdLevelScope scope(kLevels[l]);
+		if (!scope.IsSet())
+			continue;
+		Document d;
+		d.Parse<0>(json.c_str());
+		ASSERT_FALSE(d.HasParseError());
+		ASSERT_EQ(200u, d["item"].Size());
+
+		StringBuffer jsonBuffer;
+		WriterJson<StringBuffer> writerJson(jsonBuffer);
+		d.Accept(writerJson);
+		StringBuffer xmlBuffer;
+		WriterXml<StringBuffer> writerXml(xmlBuffer);
+		d.Accept(writerXml);
+		if (l == 0) {
+			expectedJson = jsonBuffer.GetString();
+			expectedXml = xmlBuffer.GetString();
+		}
+		EXPECT_EQ(expectedJson, jsonBuffer.GetString());
+		EXPECT_EQ(expectedXml, xmlBuffer.GetString());
+	}
+}
+
+#endif // RAPIDJSONXML_SIMD_DISPATCH
@@ -0,0 +1,153 @@
+#include "unittest.h"
+
+#include "rapidjsonxml/document.h"
+
+#include <string>
+
+using namespace rapidjsonxml;
+
+TEST(StringHash, Hash) {
+	// The same hash for every kind of string
+	Document d;
+	const char* texts[] = { "", "a", "short", "a string too long to be stored in the value" };
+	for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); i++) {
+		SizeType length = static_cast<SizeType>(std::strlen(texts[i]));
+		SizeType hash = internal::StrHash(texts[i], length);
+		EXPECT_NE(0u, hash);
+		EXPECT_EQ(hash, Value(StringRef(texts[i])).GetStringHash());
+		EXPECT_EQ(hash, Value(texts[i], d.GetAllocator()).GetStringHash());
+		Value v;
+		v.SetString(texts[i], length, d.GetAllocator());
+		EXPECT_EQ(hash, v.GetStringHash());
+		Value::AttributeType attrib("k", "v");
+		v.AddAttribute(attrib, d.GetAllocator()); // moves the short strings out of the value
+		EXPECT_EQ(hash, v.GetStringHash());
+	}
+	EXPECT_NE(Value("a string too long to be stored in the value").GetStringHash(), Value("a string too long to be stored in the valuE").GetStringHash());
+
+	// Reset by a new string
+	Value v("a string too long to be stored in the value", d.GetAllocator());
+	v.SetString("another string too long to be stored in the value", d.GetAllocator());
+	EXPECT_EQ(internal::StrHash(v.GetString(), v.GetStringLength()), v.GetStringHash());
+	v.SetString(StringRef("a constant string"));
+	EXPECT_EQ(internal::StrHash(v.GetString(), v.GetStringLength()), v.GetStringHash());
+
+	// Parsed in place, and hashed as member names
+	char json[] = "{\"a constant member name\":\"a constant string value\"}";
+	d.ParseInsitu<0>(json);
+	ASSERT_FALSE(d.HasParseError());
+	EXPECT_EQ(internal::StrHash("a constant member name", 22), d.MemberBegin()->name.GetStringHash());
+	EXPECT_EQ(internal::StrHash("a constant string value", 23), d.MemberBegin()->value.GetStringHash());
+}
+
+TEST(StringHash, FindMember) {
+	// Names of the same length, some only differing by their last character
+	Document d;
+	d.Parse("{\"http://example.com/schema#field1\":1,\"http://example.com/schema#field2\":2,\"http://example.com/schema#field3\":3,\"xttp://example.com/schema#field4\":4,\"\":5,\"f\":6}");
+	ASSERT_FALSE(d.HasParseError());
+	EXPECT_EQ(1, d["http://example.com/schema#field1"].GetInt());
+	EXPECT_EQ(3, d["http://example.com/schema#field3"].GetInt());
+	EXPECT_EQ(4, d["xttp://example.com/schema#field4"].GetInt());
+	EXPECT_EQ(5, d[""].GetInt());
+	EXPECT_EQ(6, d["f"].GetInt());
+	EXPECT_FALSE(d.HasMember("http://example.com/schema#field4"));
+	EXPECT_FALSE(d.HasMember("g"));
+
+	// With a copied name, which hash is kept
+	Value name("http://example.com/schema#field2", d.GetAllocator());
+	EXPECT_EQ(2, d[name].GetInt());
+	EXPECT_TRUE(d.RemoveMember(name));
+	EXPECT_FALSE(d.HasMember(name));
+	EXPECT_EQ(3, d["http://example.com/schema#field3"].GetInt());
+
+	// Added with constant names
+	d.AddMember("http://example.com/schema#field7", 7, d.GetAllocator());
+	EXPECT_EQ(7, d["http://example.com/schema#field7"].GetInt());
+	EXPECT_EQ(1, d["http://example.com/schema#field1"].GetInt());
+}
+
+TEST(StringHash, Equal) {
+	Document a, b;
+	a.Parse("{\"s\":\"a string too long to be stored in the value\",\"short\":\"text\",\"n\":[null,true,false,1,-1,4294967295,-9007199254740993,18446744073709551615,0.5],\"o\":{\"x\":1,\"y\":{}}}");
+	b.Parse("{\"o\":{\"y\":{},\"x\":1.0},\"short\":\"text\",\"n\":[null,true,false,1,-1,4294967295,-9007199254740993,18446744073709551615,0.5],\"s\":\"a string too long to be stored in the value\"}");
+	ASSERT_FALSE(a.HasParseError());
+	ASSERT_FALSE(b.HasParseError());
+	EXPECT_TRUE(a == b);
+	EXPECT_FALSE(a != b);
+	EXPECT_TRUE(a["short"] == "text");
+	EXPECT_TRUE(a["short"] != "texts");
+	EXPECT_TRUE(a["s"] == Value(StringRef("a string too long to be stored in the value")));
+	EXPECT_TRUE(a["s"] != Value(StringRef("a string too long to be stored in the valuE")));
+
+	// Integers with the same bits but different values
+	EXPECT_TRUE(Value(-1) != Value(UINT64_C(18446744073709551615)));
+	EXPECT_TRUE(Value(1u) == Value(INT64_C(1)));
+	EXPECT_TRUE(Value(2) == Value(2.0));
+
+	// Different members, elements, types and strings
+	b["o"]["x"] = 2;
+	EXPECT_TRUE(a != b);
+	b["o"]["x"] = 1;
+	EXPECT_TRUE(a == b);
+	b["n"].PushBack(1, b.GetAllocator());
+	EXPECT_TRUE(a != b);
+	b["n"].PopBack();
+	b["n"][0u] = false;
+	EXPECT_TRUE(a != b);
+	b["n"][0u].SetNull();
+	b["s"].SetString("a string too long to be stored in the valuE", b.GetAllocator());
+	EXPECT_TRUE(a != b);
+	b["s"].SetString("a string too long to be stored in the value", b.GetAllocator());
+	EXPECT_TRUE(a == b);
+	b.RemoveMember("short");
+	EXPECT_TRUE(a != b);
+	b.AddMember("other", "text", b.GetAllocator());
+	EXPECT_TRUE(a != b);
+}
+
+TEST(StringHash, EqualRepeatedNames) {
+	// The k-th member of a name is compared with the k-th member of this name
+	static const char* kEqual[][2] = {
+		{ "{\"a\":1,\"a\":2}", "{\"a\":1,\"a\":2}" },
+		{ "{\"a\":1,\"b\":0,\"a\":2}", "{\"b\":0,\"a\":1,\"a\":2}" },
+		{ "{\"b\":0,\"a\":1,\"c\":3,\"a\":2}", "{\"b\":0,\"a\":1,\"a\":2,\"c\":3}" },
+	};
+	static const char* kDifferent[][2] = {
+		{ "{\"a\":1,\"a\":2}", "{\"a\":2,\"a\":1}" },
+		{ "{\"a\":1,\"a\":1,\"b\":0}", "{\"a\":1,\"b\":0,\"b\":5}" },
+		{ "{\"a\":1,\"b\":0,\"b\":5}", "{\"a\":1,\"a\":1,\"b\":0}" },
+		{ "{\"a\":1,\"b\":0,\"a\":2}", "{\"b\":0,\"a\":2,\"a\":1}" },
+	};
+	for (size_t i = 0; i < sizeof(kEqual) / sizeof(kEqual[0]); i++) {
+		Document a, b;
+		a.Parse(kEqual[i][0]);
+		b.Parse(kEqual[i][1]);
+		EXPECT_TRUE(a == a) << kEqual[i][0];
+		EXPECT_TRUE(a == b) << kEqual[i][0];
+		EXPECT_TRUE(b == a) << kEqual[i][0];
+	}
+	for (size_t i = 0; i < sizeof(kDifferent) / sizeof(kDifferent[0]); i++) {
+		Document a, b;
+		a.Parse(kDifferent[i][0]);
+		b.Parse(kDifferent[i][1]);
+		EXPECT_TRUE(b == b) << kDifferent[i][1];
+		EXPECT_TRUE(a != b) << kDifferent[i][0];
+		EXPECT_TRUE(b != a) << kDifferent[i][0];
+	}
+
+	// Repeated elements of XML text, and members added in another order
+	Document x, y;
+	x.ParseXml("<r><item>1</item><item>2</item><n>3</n></r>");
+	ASSERT_FALSE(x.HasParseError());
+	y.ParseXml("<r><item>1</item><item>2</item><n>3</n></r>");
+	EXPECT_TRUE(x == x);
+	EXPECT_TRUE(x == y);
+	y["r"].MemberBegin()[1].value = 3;
+	EXPECT_TRUE(x != y);
+	Value o(kObjectType);
+	o.AddMember("n", 3, y.GetAllocator());
+	o.AddMember("item", 1, y.GetAllocator());
+	o.AddMember("item", 2, y.GetAllocator());
+	EXPECT_TRUE(x["r"] == o);
+	EXPECT_TRUE(o == x["r"]);
+}
@@ -0,0 +1,100 @@
+#include "unittest.h"
+
+#include "rapidjsonxml/internal/strtod.h"
+#include "rapidjsonxml/document.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace rapidjsonxml;
+
+static double ParseFullPrecision(const char* json) {
+	Document d;
+	d.Parse<kParseFullPrecisionFlag>(json);
+	EXPECT_FALSE(d.HasParseError()) << json;
+	EXPECT_TRUE(d.IsArray() && d.Size() == 1 && d[0u].IsNumber()) << json;
+	return d.HasParseError() ? 0.0 : d[0u].GetDouble();
+}
+
+static void TestFullPrecision(const std::string& number) {
+	double expected = std::strtod(number.c_str(), 0);
+	double actual = ParseFullPrecision(("[" + number + "]").c_str());
+	EXPECT_EQ(internal::BitsFromDouble(expected), internal::BitsFromDouble(actual)) << number;
+}
+
+TEST(Strtod, FullPrecision) {
+	TestFullPrecision("0.0");
+	TestFullPrecision("-0.0");
+	TestFullPrecision("1.5");
+	TestFullPrecision("-3.1416");
+	TestFullPrecision("0.1");
+	TestFullPrecision("0.21313");
+	TestFullPrecision("1e22");
+	TestFullPrecision("1e23");
+	TestFullPrecision("9007199254740993");           // 2^53 + 1, halfway to even
+	TestFullPrecision("9007199254740993.0000000000001");
+	TestFullPrecision("18446744073709551616");       // 2^64
+	TestFullPrecision("123456789012345678901234567890");
+	TestFullPrecision("1.7976931348623157e308");
+	TestFullPrecision("1.7976931348623158e308");     // rounded down to the largest double
+	TestFullPrecision("2.2250738585072011e-308");    // largest subnormal
+	TestFullPrecision("2.2250738585072012e-308");    // smallest normal
+	TestFullPrecision("4.9406564584124654e-324");    // smallest subnormal
+	TestFullPrecision("2.4703282292062327e-324");    // below half of it
+	TestFullPrecision("2.4703282292062328e-324");    // above half of it
+	TestFullPrecision("1e-400");
+	TestFullPrecision("0.000000000000000000000000000000000000000000000000001234567890123456789012");
+
+	// Exactly halfway between two doubles, decided by the last of many digits
+	TestFullPrecision("2.2250738585072012595738760375894737529542006271302545806624722567003306591486"
+		"15196612163418493396208399713424924102614449373697542839245768553917584960412712227412646700107"
+		"9125e-308");
+	TestFullPrecision("1.00000000000000011102230246251565404236316680908203125");  // 1 + 2^-53
+	TestFullPrecision("1.00000000000000011102230246251565404236316680908203124");
+	TestFullPrecision("1.00000000000000011102230246251565404236316680908203126");
+
+	// More significant digits than used exactly
+	std::string half("1.00000000000000011102230246251565404236316680908203125");
+	TestFullPrecision(half + std::string(1000, '0'));
+	TestFullPrecision(half + std::string(1000, '0') + "1");
+	TestFullPrecision(std::string(400, '1') + "e-300");
+}
+
+TEST(Strtod, FullPrecisionRandom) {
+	uint64_t state = 4;
+	char buffer[64];
+	for (int i = 0; i < 200000; i++) {
+		state = state * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+		uint64_t u = state ^ (state >> 29);
+		double d;
+		std::memcpy(&d, &u, sizeof(d));
+		if (d != d || d - d != 0.0)
+			continue;
+
+		// Shortest and longer representations, and halfway points between doubles
+		snprintf(buffer, sizeof(buffer), "%.17g", d);
+		TestFullPrecision(buffer);
+		snprintf(buffer, sizeof(buffer), "%.*g", (int)(state >> 59) + 1, d);
+		TestFullPrecision(buffer);
+		snprintf(buffer, sizeof(buffer), "%.40e", d);
+		TestFullPrecision(buffer);
+	}
+}
+
+TEST(Strtod, FullPrecisionError) {
+	std::string n1e309 = "[1" + std::string(309, '0') + "]";
+	Document d;
+	d.Parse<kParseFullPrecisionFlag>(n1e309.c_str());
+	EXPECT_EQ(kParseErrorNumberTooBig, d.GetParseError());
+	d.Parse<kParseFullPrecisionFlag>("[1.8e308]");
+	EXPECT_EQ(kParseErrorNumberTooBig, d.GetParseError());
+	d.Parse<kParseFullPrecisionFlag>("[1.]");
+	EXPECT_EQ(kParseErrorNumberMissFraction, d.GetParseError());
+	d.Parse<kParseFullPrecisionFlag>("[12345678901234567890123.e1]");
+	EXPECT_EQ(kParseErrorNumberMissFraction, d.GetParseError());
+	d.Parse<kParseFullPrecisionFlag>("[1.5,1e-5,-7,18446744073709551615]");
+	ASSERT_FALSE(d.HasParseError());
+	EXPECT_TRUE(d[2u].IsInt());
+	EXPECT_TRUE(d[3u].IsUint64());
+}
@@ -0,0 +1,195 @@
+#include "unittest.h"
+
+#include "rapidjsonxml/reader.h"
+#include "rapidjsonxml/document.h"
+#include "rapidjsonxml/memorystream.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace rapidjsonxml;
+
+// Records all the events as text
+struct EventTextHandler : BaseReaderHandler<> {
+	EventTextHandler() : events() {}
+	bool Null() { events += "null "; return true; }
+	bool Bool(bool b) { events += b ? "true " : "false "; return true; }
+	bool Int(int i) { return Number("i%d ", i); }
+	bool Uint(unsigned u) { return Number("u%u ", u); }
+	bool Int64(int64_t i) { return Number("I%lld ", static_cast<long long>(i)); }
+	bool Uint64(uint64_t u) { return Number("U%llu ", static_cast<unsigned long long>(u)); }
+	bool Double(double d) { return Number("d%.17g ", d); }
+	bool String(const char* str, SizeType length, bool) {
+		events.append("\"").append(str, length) += "\" ";
+		return true;
+	}
+	bool Key(const char* str, SizeType length, bool) {
+		events.append("<").append(str, length) += "> ";
+		return true;
+	}
+	bool StartObject(const AttributeIteratorPair) { events += "{ "; return true; }
+	bool EndObject(SizeType count) { return Number("}%u ", count); }
+	bool StartArray() { events += "[ "; return true; }
+	bool EndArray(SizeType count) { return Number("]%u ", count); }
+
+	template <typename T>
+	bool Number(const char* format, T value) {
+		char buffer[64];
+		std::sprintf(buffer, format, value);
+		events += buffer;
+		return true;
+	}
+	std::string events;
+};
+
+// Events and error of a parsing, from a StringStream, an InsituStringStream and a MemoryStream
+template <unsigned parseFlags>
+static std::string ParseEvents(const std::string& json, int stream) {
+	Reader reader;
+	EventTextHandler h;
+	std::string insitu(json);
+	if (stream == 0) {
+		StringStream s(json.c_str());
+		reader.Parse<parseFlags>(s, h);
+	}
+	else if (stream == 1) {
+		InsituStringStream s(&insitu[0]);
+		reader.Parse<parseFlags | kParseInsituFlag>(s, h);
+	}
+	else {
+		MemoryStream s(json.data(), json.size());
+		reader.Parse<parseFlags>(s, h);
+	}
+	char error[32];
+	std::sprintf(error, "error %d at %u", reader.GetParseErrorCode(), static_cast<unsigned>(reader.GetErrorOffset()));
+	return h.events + error;
+}
+
+static void ExpectSameEvents(const std::string& json) {
+	for (int stream = 0; stream < 3; stream++)
+		EXPECT_EQ(ParseEvents<kParseDefaultFlags>(json, stream), ParseEvents<kParseStructuralIndexFlag>(json, stream)) << json << " stream " << stream;
+}
+
+TEST(StructuralIndex, Events) {
+	ExpectSameEvents("{}");
+	ExpectSameEvents(" [ ] ");
+	ExpectSameEvents("[null,true,false,0,-1,2147483648,-2147483649,18446744073709551615,1.5,-0.25e-3,1E2]");
+	ExpectSameEvents("{\"a\":{\"b\":[[],{},[1,[2,{\"c\":3}]]],\"d\":\"e\"},\"f\":[{}],\"g\":\"\"}");
+	ExpectSameEvents("{ \"esc\\\"aped\" : \"\\b\\f\\n\\r\\t\\/\\\\\\u00e9\\uD834\\uDD1E\" , \"\\u0000\" : [ \"a long string without any escape\" ] }");
+	ExpectSameEvents("\n\t{\r\n  \"tokens in strings\": \"{}[]:, \\\"[1,2]\\\"\",\n  \"after\" :\t[ 1 ,\t2 ]\n}\n");
+	ExpectSameEvents("[\"\\\\\",\"\\\\\\\\\",\"\\\\\\\"\",\"\\\"\\\\\"]");
+
+	// Runs of backslashes and quotes across the 64-character blocks
+	for (size_t prefix = 50; prefix < 70; prefix++) {
+		for (size_t run = 1; run < 6; run++) {
+			std::string json("[\"");
+			json.append(prefix, 'a');
+			for (size_t i = 0; i < run; i++)
+				json += "\\\\";
+			json += "\\\",1]\", 2, \"";
+			json.append(run, ' ');
+			json += "[\"]";
+			ExpectSameEvents(json);
+			json.insert(1, prefix % 7, ' ');
+			ExpectSameEvents(json);
+		}
+	}
+}
+
+TEST(StructuralIndex, Error) {
+	// Same errors at the same offsets, after the same events
+	const char* kInvalid[] = {
+		"", " ", "1", "\"a\"", "[1] x", "[1]x", "[", "{", "[1", "[1 2]", "[1,]", "{\"a\":1", "{\"a\" 1}", "{1:1}", "{\"a\":1,}", "{\"a\":1 \"b\":2}",
+		"[nul]", "[truE]", "[truex]", "[true x]", "[f]", "[-]", "[+1]", "[.5]", "[1.]", "[1.e5]", "[1e]", "[1e+]", "[01]", "[1x]", "[1-2]", "[1\"a\"]",
+		"[\"abc", "[\"a\x01\"]", "[\"\\x\"]", "[\"\\u12G4\"]", "[\"\\uD800\"]", "[\"\\\"]", "[\"\\", "[1,\f2]", "[1\f,2]", "{\"a\"\x1A:1}"
+	};
+	for (size_t i = 0; i < sizeof(kInvalid) / sizeof(kInvalid[0]); i++) {
+		ASSERT_NE(std::string::npos, ParseEvents<kParseDefaultFlags>(kInvalid[i], 0).find("error")) << kInvalid[i];
+		ExpectSameEvents(kInvalid[i]);
+	}
+
+	// With kParseStopWhenDoneFlag
+	EXPECT_EQ(ParseEvents<kParseStopWhenDoneFlag>("[1] x", 0), ParseEvents<kParseStopWhenDoneFlag | kParseStructuralIndexFlag>("[1] x", 0));
+}
+
+TEST(StructuralIndex, Document) {
+	std::string json("{\"records\":[");
+	for (int i = 0; i < 100; i++) {
+		char record[128];
+		std::sprintf(record, "%s\n  {\"id\": %d, \"name\": \"record \\\"%d\\\"\", \"values\": [%d.5, true, null]}", i ? "," : "", i, i, i);
+		json += record;
+	}
+	json += "\n]}";
+	Document expected, d;
+	expected.Parse(json.c_str());
+	ASSERT_FALSE(expected.HasParseError());
+	d.Parse<kParseStructuralIndexFlag>(json.c_str());
+	ASSERT_FALSE(d.HasParseError());
+	EXPECT_TRUE(expected == d);
+	EXPECT_STREQ("record \"99\"", d["records"][99u]["name"].GetString());
+
+	// The same reader for texts of different lengths
+	Reader reader;
+	for (size_t length = json.size(); length > 0; length /= 3) {
+		std::string text("[" + json.substr(0, length) + "]");
+		EventTextHandler h1, h2;
+		StringStream s1(text.c_str()), s2(text.c_str());
+		Reader regular;
+		regular.Parse(s1, h1);
+		reader.Parse<kParseStructuralIndexFlag>(s2, h2);
+		EXPECT_EQ(h1.events, h2.events);
+		EXPECT_EQ(regular.GetParseErrorCode(), reader.GetParseErrorCode());
+		EXPECT_EQ(regular.GetErrorOffset(), reader.GetErrorOffset());
+	}
+}
+
+// Allocator failing above a size
+struct LimitedAllocator : CrtAllocator {
+	void* Malloc(size_t size) { return size <= kLimit ? CrtAllocator::Malloc(size) : 0; }
+	void* Realloc(void* originalPtr, size_t originalSize, size_t newSize) {
+		return newSize <= kLimit ? CrtAllocator::Realloc(originalPtr, originalSize, newSize) : 0;
+	}
+	static const size_t kLimit = 1024;
+};
+
+TEST(StructuralIndex, Allocator) {
+	// A text is not indexed when the positions cannot be allocated
+	internal::StructuralIndex<LimitedAllocator> index;
+	std::string json("[");
+	for (size_t i = 0; i < 1000; i++)
+		json += i ? ", 1" : "1";
+	json += "]";
+	StringStream small("[1, 2]"), large(json.c_str());
+	EXPECT_TRUE(index.Build(small));
+	EXPECT_FALSE(index.Build(large));
+
+	// The positions are not taken from the memory pool of the document, and are released after each parsing
+	Document d1, d2;
+	for (int i = 0; i < 3; i++) {
+		d1.Parse(json.c_str());
+		d2.Parse<kParseStructuralIndexFlag>(json.c_str());
+		ASSERT_FALSE(d2.HasParseError());
+		EXPECT_EQ(d1.GetAllocator().Size(), d2.GetAllocator().Size()) << i;
+	}
+	EXPECT_TRUE(d1 == d2);
+}
+
+TEST(StructuralIndex, Kernels) {
+	// Every kernel finds the same tokens
+	std::string json;
+	for (int i = 0; i < 40; i++)
+		json += std::string(static_cast<size_t>(i % 5), ' ') + "{\"a\\\\\":[1, -2.5e3 , \"x\\\"y{\"],\"b\" :\ttrue}";
+	std::vector<SizeType> expected(json.size()), positions(json.size());
+	const size_t count = static_cast<size_t>(FindStructurals_Scalar(json.data(), json.size(), &expected[0]) - &expected[0]);
+	EXPECT_EQ(count, static_cast<size_t>(FindStructurals(json.data(), json.size(), &positions[0]) - &positions[0]));
+	for (size_t i = 0; i < count; i++)
+		EXPECT_EQ(expected[i], positions[i]) << i;
+	EXPECT_EQ(0u, expected[0]);
+	EXPECT_EQ(1u, expected[1]);
+	EXPECT_EQ(6u, expected[2]);
+	EXPECT_EQ(7u, expected[3]);
+	EXPECT_EQ(8u, expected[4]);
+	EXPECT_EQ(9u, expected[5]);
+	EXPECT_EQ(11u, expected[6]);
+}
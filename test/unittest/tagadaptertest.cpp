@@ -0,0 +1,104 @@
+#include "unittest.h"
+
+#include "rapidjsonxml/document.h"
+#include "rapidjsonxml/writerxml.h"
+#include "rapidjsonxml/tagadapter.h"
+#include "rapidjsonxml/stringbuffer.h"
+
+#include <string>
+
+using namespace rapidjsonxml;
+
+typedef WriterXml<StringBuffer> XmlWriter;
+
+static std::string DomToXml(const char* json) {
+	Document d;
+	d.Parse(json);
+	EXPECT_FALSE(d.HasParseError());
+	StringBuffer buffer;
+	XmlWriter writer(buffer);
+	d.Accept(writer);
+	return buffer.GetString();
+}
+
+template <unsigned parseFlags>
+static std::string StreamToXml(const char* json) {
+	StringBuffer buffer;
+	XmlWriter writer(buffer);
+	TagAdapter<XmlWriter> adapter(writer);
+	Reader reader;
+	std::string insitu(json);
+	if (parseFlags & kParseInsituFlag) {
+		InsituStringStream s(&insitu[0]);
+		EXPECT_TRUE(reader.Parse<parseFlags>(s, adapter));
+	}
+	else {
+		StringStream s(json);
+		EXPECT_TRUE(reader.Parse<parseFlags>(s, adapter));
+	}
+	EXPECT_TRUE(writer.IsComplete());
+	return buffer.GetString();
+}
+
+TEST(TagAdapter, SameAsDocument) {
+	static const char* kJsons[] = {
+		"{}",
+		"{\"a\":1}",
+		"{\"a\":null,\"b\":true,\"c\":false,\"d\":-1,\"e\":4294967295,\"f\":-5000000000,\"g\":18446744073709551615,\"h\":0.5}",
+		"{\"s\":\"x&y\\n\",\"t\":\"\\u00e9\"}",
+		"{\"o\":{\"p\":{\"q\":\"deep\"},\"r\":2},\"s\":3}",
+		"{\"item\":[{\"id\":1,\"tags\":[\"x\",\"y\"]},{\"id\":2}]}",
+		"{\"a\":[],\"b\":{},\"c\":[[1,2],[3,[4,5]]],\"d\":[{},{\"e\":[]}]}",
+		"{\"a\\\"b\":1,\"a\\\"b\":[\"long member names are copied\"]}",
+	};
+	for (size_t i = 0; i < sizeof(kJsons) / sizeof(kJsons[0]); i++) {
+		const std::string expected = DomToXml(kJsons[i]);
+		EXPECT_EQ(expected, StreamToXml<0>(kJsons[i])) << kJsons[i];
+		EXPECT_EQ(expected, StreamToXml<kParseInsituFlag>(kJsons[i])) << kJsons[i];
+		EXPECT_EQ(expected, StreamToXml<kParseIterativeFlag>(kJsons[i])) << kJsons[i];
+	}
+}
+
+TEST(TagAdapter, Accept) {
+	// A source which already sends tags is forwarded unchanged
+	Document d;
+	d.Parse("{\"item\":[{\"id\":1,\"name\":\"a\"},{\"id\":2}],\"count\":{\"n\":\"2\"}}");
+	ASSERT_FALSE(d.HasParseError());
+
+	StringBuffer buffer;
+	XmlWriter writer(buffer);
+	TagAdapter<XmlWriter> adapter(writer);
+	d.Accept(adapter);
+	EXPECT_STREQ("<item><id>1</id><name>a</name></item><item><id>2</id></item><count><n>2</n></count>", buffer.GetString());
+}
+
+// Stops after the given number of events
+struct StopHandler : BaseReaderHandler<> {
+	StopHandler(int count) : count_(count) {}
+	bool Default() { return --count_ > 0; }
+	bool Uint(unsigned) { return Default(); }
+	bool StartObject(const AttributeIteratorPair) { return Default(); }
+	bool EndObject(SizeType) { return Default(); }
+	bool OpenTag(const Ch*, SizeType, const AttributeIteratorPairList, bool) { return Default(); }
+	bool CloseTag(const Ch*, SizeType, bool) { return Default(); }
+	int count_;
+};
+
+TEST(TagAdapter, Termination) {
+	const char* json = "{\"a\":{\"b\":1}}";
+	for (int count = 1; count <= 9; count++) {
+		StopHandler h(count);
+		TagAdapter<StopHandler> adapter(h);
+		Reader reader;
+		StringStream s(json);
+		EXPECT_FALSE(reader.Parse(s, adapter));
+		EXPECT_EQ(kParseErrorTermination, reader.GetParseErrorCode());
+
+		// Reusable after the interrupted parsing
+		StopHandler all(100);
+		adapter.Reset(all);
+		StringStream s2(json);
+		EXPECT_TRUE(reader.Parse(s2, adapter));
+		EXPECT_EQ(100 - 9, all.count_); // StartObject, OpenTag, StartObject, OpenTag, Uint, CloseTag x2 and EndObject x2
+	}
+}
@@ -0,0 +1,95 @@
+#include "unittest.h"
+
+#include "rapidjsonxml/reader.h"
+#include "rapidjsonxml/memorystream.h"
+
+#include <string>
+
+using namespace rapidjsonxml;
+
+// Checks that Validate() accepts or rejects a text like Parse(), with the same error at the same offset
+template <unsigned parseFlags>
+static void ExpectSameResult(const std::string& json) {
+	Reader reader;
+	BaseReaderHandler<> h;
+	StringStream expected(json.c_str());
+	const ParseResult result = reader.Parse<parseFlags>(expected, h);
+
+	StringStream s(json.c_str());
+	ParseResult r = reader.Validate<parseFlags>(s);
+	EXPECT_EQ(result.Code(), r.Code()) << json;
+	EXPECT_EQ(result.Offset(), r.Offset()) << json;
+
+	// Nothing written in place
+	std::string insitu(json);
+	InsituStringStream is(&insitu[0]);
+	r = reader.Validate<parseFlags | kParseInsituFlag>(is);
+	EXPECT_EQ(result.Code(), r.Code()) << json;
+	EXPECT_EQ(result.Offset(), r.Offset()) << json;
+	EXPECT_EQ(json, insitu);
+
+	// A MemoryStream stops at its end
+	MemoryStream expectedMemory(json.data(), json.size());
+	const ParseResult memoryResult = reader.Parse<parseFlags>(expectedMemory, h);
+	MemoryStream m(json.data(), json.size());
+	r = reader.Validate<parseFlags>(m);
+	EXPECT_EQ(memoryResult.Code(), r.Code()) << json;
+	EXPECT_EQ(memoryResult.Offset(), r.Offset()) << json;
+
+	StringStream iterative(json.c_str());
+	r = reader.Validate<parseFlags | kParseIterativeFlag>(iterative);
+	EXPECT_EQ(result.IsError(), r.IsError()) << json;
+}
+
+static void ExpectSameResult(const std::string& json) {
+	ExpectSameResult<kParseDefaultFlags>(json);
+	ExpectSameResult<kParseFullPrecisionFlag>(json);
+	ExpectSameResult<kParseValidateEncodingFlag>(json);
+	ExpectSameResult<kParseStructuralIndexFlag>(json);
+}
+
+TEST(Validate, Valid) {
+	const char* kValid[] = {
+		"{}", " [ ] ", "[null,true,false,0,-1,2147483648,-2147483649,18446744073709551615,1.5,-0.25e-3,1E2,1e+99]",
+		"{\"a\":{\"b\":[[],{},[1,[2,{\"c\":3}]]],\"d\":\"e\"},\"f\":[{}],\"g\":\"\"}",
+		"{ \"esc\\\"aped\" : \"\\b\\f\\n\\r\\t\\/\\\\\\u00e9\\uD834\\uDD1E\" , \"\\u0000\" : [ \"a long string without any escape\" ] }",
+		"[\"\xC3\xA9\xE2\x82\xAC\xF0\x9D\x84\x9E\"]"
+	};
+	for (size_t i = 0; i < sizeof(kValid) / sizeof(kValid[0]); i++) {
+		StringStream s(kValid[i]);
+		EXPECT_FALSE(Reader().Validate(s).IsError()) << kValid[i];
+		ExpectSameResult(kValid[i]);
+	}
+}
+
+TEST(Validate, Error) {
+	const char* kInvalid[] = {
+		"", " ", "1", "\"a\"", "[1] x", "[", "{", "[1", "[1 2]", "[1,]", "{\"a\":1", "{\"a\" 1}", "{1:1}", "{\"a\":1,}", "{\"a\":1 \"b\":2}",
+		"[nul]", "[truE]", "[f]", "[-]", "[+1]", "[.5]", "[1.]", "[-1.e5]", "[1e]", "[1e+]", "[01]", "[1x]",
+		"[\"abc", "[\"a\x01\"]", "[\"\\x\"]", "[\"\\u12G4\"]", "[\"\\uD800\"]", "[\"\\uD800\\u0041\"]", "[\"\\",
+		"[\"\xC3\x28\"]", "[\"\xFF\"]", "[\"a long string before an invalid byte \xE2\x82\"]"
+	};
+	for (size_t i = 0; i < sizeof(kInvalid) / sizeof(kInvalid[0]); i++)
+		ExpectSameResult(kInvalid[i]);
+
+	// The encoding only with kParseValidateEncodingFlag
+	StringStream s("[\"\xC3\x28\"]");
+	EXPECT_FALSE(Reader().Validate(s).IsError());
+	StringStream v("[\"\xC3\x28\"]");
+	EXPECT_EQ(kParseErrorStringInvalidEncoding, Reader().Validate<kParseValidateEncodingFlag>(v).Code());
+}
+
+TEST(Validate, Numbers) {
+	// The same numbers too big as when converting them
+	const char* kNumbers[] = {
+		"[1e308]", "[1e309]", "[1e-400]", "[1.5e99]", "[1e100]", "[2e308]", "[1e0000000001]", "[0.000001e-99]"
+	};
+	for (size_t i = 0; i < sizeof(kNumbers) / sizeof(kNumbers[0]); i++)
+		ExpectSameResult(kNumbers[i]);
+
+	for (size_t digits = 190; digits < 320; digits += 10) {
+		ExpectSameResult("[" + std::string(digits, '9') + "]");
+		ExpectSameResult("[-1" + std::string(digits, '0') + ".5e-3]");
+		ExpectSameResult("[1" + std::string(digits, '0') + "e99]");
+	}
+}
@@ -0,0 +1,104 @@
+#include "unittest.h"
+
+#include "rapidjsonxml/document.h"
+#include "rapidjsonxml/writerjson.h"
+#include "rapidjsonxml/prettywriterjson.h"
+#include "rapidjsonxml/stringbuffer.h"
+
+using namespace rapidjsonxml;
+
+// Reference escaping of a UTF-8 string, non-ASCII characters are escaped for ASCII output
+static std::string EscapeJson(const char* str, size_t length, bool ascii) {
+	static const char hexDigits[] = "0123456789ABCDEF";
+	std::string s("\"");
+	for (size_t i = 0; i < length; i++) {
+		unsigned char c = (unsigned char)str[i];
+		if (c == '"' || c == '\\')
+			(s += '\\') += (char)c;
+		else if (c == '\n')
+			s += "\\n";
+		else if (c < 0x20)
+			((s += "\\u00") += hexDigits[c >> 4]) += hexDigits[c & 15];
+		else if (ascii && c == 0xC3) // only 2-byte sequences in the tests
+			(((s += "\\u00") += hexDigits[((c & 0x1F) << 6 | (str[i + 1] & 0x3F)) >> 4]) += hexDigits[str[i + 1] & 15]), i++;
+		else
+			s += (char)c;
+	}
+	return s += '"';
+}
+
+TEST(WriterJson, String) {
+	// Escaped characters at every position of strings with various lengths and alignments
+	static const char kEscaped[] = { '"', '\\', '\n', '\x01' };
+	char buffer[80];
+	for (size_t length = 0; length < 48; length++) {
+		for (size_t offset = 0; offset < 16; offset++) {
+			for (size_t escaped = 0; escaped <= length; escaped++) {
+				char* str = buffer + offset;
+				for (size_t i = 0; i < length; i++) {
+					str[i] = "abc\xC3\xA9xyz"[i % 8];
+					if ((i == escaped || i + 5 == escaped) && (i % 8 < 3 || i % 8 > 4))
+						str[i] = kEscaped[i % 4];
+				}
+				str[length] = '"'; // not part of the string
+				if (length % 8 == 4)
+					continue; // would truncate a UTF-8 sequence
+
+				{
+					StringBuffer sb;
+					WriterJson<StringBuffer> writer(sb);
+					writer.StartArray();
+					writer.String(str, (SizeType)length);
+					writer.EndArray();
+					EXPECT_EQ("[" + EscapeJson(str, length, false) + "]", std::string(sb.GetString()));
+				}
+				{
+					GenericStringBuffer<ASCII<> > sb;
+					WriterJson<GenericStringBuffer<ASCII<> >, UTF8<>, ASCII<> > writer(sb);
+					writer.StartArray();
+					writer.String(str, (SizeType)length);
+					writer.EndArray();
+					EXPECT_EQ("[" + EscapeJson(str, length, true) + "]", std::string(sb.GetString()));
+				}
+			}
+		}
+	}
+}
+
+TEST(WriterJson, Pretty) {
+	Document d;
+	d.Parse("{\"a\":[1,\"x\\\"y\"],\"b\":{}}");
+	ASSERT_FALSE(d.HasParseError());
+	StringBuffer sb;
+	PrettyWriterJson<StringBuffer> writer(sb);
+	d.Accept(writer);
+	EXPECT_STREQ("{\n    \"a\": [\n        1,\n        \"x\\\"y\"\n    ],\n    \"b\": {}\n}", sb.GetString());
+}
+
+TEST(WriterJson, Double) {
+	StringBuffer sb;
+	WriterJson<StringBuffer> writer(sb);
+	writer.StartArray();
+	writer.Double(0.1);
+	writer.Double(1e22);
+	writer.Double(-2.5);
+	writer.Double(3.14159265358979, 3);
+	writer.SetDoublePrecision(6).Double(1.0 / 3);
+	writer.SetDoublePrecision().Double(1.0 / 3);
+	writer.EndArray();
+	EXPECT_STREQ("[0.1,1e+22,-2.5,3.14,0.333333,0.3333333333333333]", sb.GetString());
+}
+
+TEST(WriterJson, FixedDouble) {
+	StringBuffer sb;
+	PrettyWriterJson<StringBuffer> writer(sb);
+	writer.SetIndent(' ', 0);
+	writer.StartArray();
+	writer.FixedDouble(3.14159, 2);
+	writer.Double(0.1);
+	writer.SetFixedDecimals(3).Double(2.0);
+	writer.Double(-0.0005);
+	writer.SetFixedDecimals(-1).Double(2.0);
+	writer.EndArray();
+	EXPECT_STREQ("[\n3.14,\n0.1,\n2.000,\n-0.001,\n2\n]", sb.GetString());
+}
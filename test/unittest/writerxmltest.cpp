@@ -0,0 +1,129 @@
+#include "unittest.h"
+
+#include "rapidjsonxml/document.h"
+#include "rapidjsonxml/writerxml.h"
+#include "rapidjsonxml/stringbuffer.h"
+
+using namespace rapidjsonxml;
+
+// json -> document -> xml writer -> xml
+#define TEST_XML(json, xml) \
+	{ \
+		Document d; \
+		d.Parse(json); \
+		ASSERT_FALSE(d.HasParseError()); \
+		StringBuffer buffer; \
+		WriterXml<StringBuffer> writer(buffer); \
+		d.Accept(writer); \
+		EXPECT_STREQ(xml, buffer.GetString()); \
+		EXPECT_TRUE(writer.IsComplete()); \
+	}
+
+TEST(WriterXml, Object) {
+	TEST_XML("{\"a\":1,\"b\":\"hi\",\"c\":true,\"d\":null}", "<a>1</a><b>hi</b><c>true</c><d>null</d>");
+	TEST_XML("{\"a\":{\"b\":{\"c\":1}}}", "<a><b><c>1</c></b></a>");
+}
+
+TEST(WriterXml, Array) {
+	TEST_XML("{\"a\":[1,2,3]}", "<a>1</a><a>2</a><a>3</a>");
+	TEST_XML("{\"a\":[],\"b\":1}", "<a></a><b>1</b>");
+	TEST_XML("{\"a\":[{\"x\":1},{\"x\":2,\"y\":[3,4]}],\"b\":[5,6]}",
+		"<a><x>1</x></a><a><x>2</x><y>3</y><y>4</y></a><b>5</b><b>6</b>");
+}
+
+TEST(WriterXml, NestedArray) {
+	TEST_XML("{\"a\":[[1,2],[3]],\"b\":0}", "<a>1</a><a>2</a><a>3</a><b>0</b>");
+	TEST_XML("{\"a\":[1,[2,{\"c\":[4,5]}]]}", "<a>1</a><a>2</a><a><c>4</c><c>5</c></a>");
+}
+
+TEST(WriterXml, Reset) {
+	Document d;
+	d.Parse("{\"item\":[{\"id\":1,\"tags\":[\"x\",\"y\"]},{\"id\":2}]}");
+	ASSERT_FALSE(d.HasParseError());
+
+	StringBuffer buffer;
+	WriterXml<StringBuffer> writer(buffer);
+	for (int i = 0; i < 3; i++) {
+		buffer.Clear();
+		writer.Reset(buffer);
+		d.Accept(writer);
+		EXPECT_STREQ("<item><id>1</id><tags>x</tags><tags>y</tags></item><item><id>2</id></item>", buffer.GetString());
+		EXPECT_TRUE(writer.IsComplete());
+	}
+}
+
+TEST(WriterXml, ArrayAttributes) {
+	Document d;
+	d.Parse("{\"a\":[1,{\"b\":2},3],\"c\":[[4,5],6]}");
+	ASSERT_FALSE(d.HasParseError());
+	Value::AttributeType attrib("k", "v&w");
+	d["a"].AddAttribute(attrib, d.GetAllocator());
+	Value::AttributeType itemAttrib("i", "1");
+	d["a"][1].AddAttribute(itemAttrib, d.GetAllocator());
+	Value::AttributeType nestedAttrib("n", "2");
+	d["c"].AddAttribute(nestedAttrib, d.GetAllocator());
+
+	StringBuffer buffer;
+	WriterXml<StringBuffer> writer(buffer);
+	d.Accept(writer);
+	EXPECT_STREQ("<a k=\"v&#x0026;w\">1</a><a k=\"v&#x0026;w\" i=\"1\"><b>2</b></a><a k=\"v&#x0026;w\">3</a>"
+		"<c n=\"2\">4</c><c n=\"2\">5</c><c n=\"2\">6</c>", buffer.GetString());
+	EXPECT_TRUE(writer.IsComplete());
+}
+
+TEST(WriterXml, String) {
+	// Escaped characters at every position of strings with various lengths and alignments
+	char buffer[80];
+	for (size_t length = 0; length < 48; length++) {
+		for (size_t offset = 0; offset < 16; offset++) {
+			for (size_t escaped = 0; escaped <= length; escaped++) {
+				char* str = buffer + offset;
+				std::string expected;
+				for (size_t i = 0; i < length; i++) {
+					str[i] = "abc\xC3\xA9xyz"[i % 8];
+					if (i == escaped || i + 5 == escaped)
+						str[i] = (i & 1) ? '&' : '\n';
+					if (str[i] == '&')
+						expected += "&#x0026;";
+					else if (str[i] == '\n')
+						expected += "&#x000A;";
+					else
+						expected += str[i];
+				}
+				str[length] = '&'; // not part of the string
+
+				StringBuffer sb;
+				WriterXml<StringBuffer> writer(sb);
+				writer.StartArray();
+				writer.String(str, (SizeType)length);
+				writer.EndArray();
+				EXPECT_EQ(expected, std::string(sb.GetString()));
+			}
+		}
+	}
+}
+
+TEST(WriterXml, Double) {
+	TEST_XML("{\"a\":0.1,\"b\":[1e22,-2.5],\"c\":0.25}",
+		"<a>0.1</a><b>1e+22</b><b>-2.5</b><c>0.25</c>");
+
+	Document d;
+	d.Parse("{\"a\":3.14159265358979,\"b\":[0.1,1e22]}");
+	ASSERT_FALSE(d.HasParseError());
+	StringBuffer buffer;
+	WriterXml<StringBuffer> writer(buffer);
+	writer.SetDoublePrecision(3);
+	d.Accept(writer);
+	EXPECT_STREQ("<a>3.14</a><b>0.1</b><b>1e+22</b>", buffer.GetString());
+}
+
+TEST(WriterXml, FixedDouble) {
+	Document d;
+	d.Parse("{\"price\":[19.999,0.125,-3]}");
+	ASSERT_FALSE(d.HasParseError());
+	StringBuffer buffer;
+	WriterXml<StringBuffer> writer(buffer);
+	writer.SetFixedDecimals(2);
+	d.Accept(writer);
+	EXPECT_STREQ("<price>20.00</price><price>0.12</price><price>-3</price>", buffer.GetString());
+}
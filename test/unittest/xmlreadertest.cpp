@@ -0,0 +1,373 @@
+#include "unittest.h"
+
+#include "rapidjsonxml/document.h"
+#include "rapidjsonxml/writerjson.h"
+#include "rapidjsonxml/writerxml.h"
+#include "rapidjsonxml/stringbuffer.h"
+#include "rapidjsonxml/memorystream.h"
+#include "rapidjsonxml/error/en.h"
+
+#include <string>
+
+using namespace rapidjsonxml;
+
+template <unsigned parseFlags>
+static std::string XmlToJson(const char* xml) {
+	StringBuffer buffer;
+	WriterJson<StringBuffer> writer(buffer);
+	XmlReader reader;
+	std::string insitu(xml);
+	if (parseFlags & kParseInsituFlag) {
+		InsituStringStream s(&insitu[0]);
+		EXPECT_TRUE(reader.Parse<parseFlags>(s, writer)) << GetParseError_En(reader.GetParseErrorCode()) << " at " << reader.GetErrorOffset();
+	}
+	else {
+		StringStream s(xml);
+		EXPECT_TRUE(reader.Parse<parseFlags>(s, writer)) << GetParseError_En(reader.GetParseErrorCode()) << " at " << reader.GetErrorOffset();
+	}
+	return buffer.GetString();
+}
+
+TEST(XmlReader, Values) {
+	static const char* kXmls[][2] = {
+		{ "<a>1</a>", "{\"a\":1}" },
+		{ "<n>null</n><t>true</t><f>false</f><e/><s>abc</s><w> 1</w><z>0123</z><m>-</m>",
+		  "{\"n\":null,\"t\":true,\"f\":false,\"e\":\"\",\"s\":\"abc\",\"w\":\" 1\",\"z\":\"0123\",\"m\":\"-\"}" },
+		{ "<i>-1</i><u>4294967295</u><i64>-5000000000</i64><u64>18446744073709551615</u64><m>-9223372036854775808</m>",
+		  "{\"i\":-1,\"u\":4294967295,\"i64\":-5000000000,\"u64\":18446744073709551615,\"m\":-9223372036854775808}" },
+		{ "<d>0.5</d><e>-1e-3</e><b>18446744073709551616</b><z>-0.0</z><x>1E400</x><y>1e-400</y>",
+		  "{\"d\":0.5,\"e\":-0.001,\"b\":1.8446744073709552e+19,\"z\":-0,\"x\":\"1E400\",\"y\":0}" },
+		{ "<s>&lt;&gt;&amp;&quot;&apos;&#65;&#x42;&#xe9;&#x1F600;</s>", "{\"s\":\"<>&\\\"'AB\xC3\xA9\xF0\x9F\x98\x80\"}" },
+		{ "<c><![CDATA[<1>]]]]></c><n><![CDATA[12]]></n><m>1<![CDATA[2]]>3</m>", "{\"c\":\"<1>]]\",\"n\":\"12\",\"m\":\"123\"}" },
+		{ "<?xml version=\"1.0\"?>\n<!DOCTYPE r [<!ELEMENT r ANY>]>\n<!-- c -->\n<r><!-- x -->1<?pi?>2</r>\n<!-- end -->\n", "{\"r\":12}" },
+	};
+	for (size_t i = 0; i < sizeof(kXmls) / sizeof(kXmls[0]); i++) {
+		EXPECT_EQ(kXmls[i][1], XmlToJson<0>(kXmls[i][0])) << kXmls[i][0];
+		EXPECT_EQ(kXmls[i][1], XmlToJson<kParseInsituFlag>(kXmls[i][0])) << kXmls[i][0];
+	}
+}
+
+TEST(XmlReader, Elements) {
+	static const char* kXmls[][2] = {
+		{ "<r><a>1</a><b><c>x</c></b></r>", "{\"r\":{\"a\":1,\"b\":{\"c\":\"x\"}}}" },
+		{ "<r>\n  <item>1</item>\n  <item>2</item>\n</r>", "{\"r\":{\"item\":1,\"item\":2}}" },
+		{ "<p>Hello <b>world</b>!</p>", "{\"p\":{\"#text\":\"Hello \",\"b\":\"world\",\"#text\":\"!\"}}" },
+		{ "<a/><a></a><a >b</a ><b/>", "{\"a\":\"\",\"a\":\"\",\"a\":\"b\",\"b\":\"\"}" },
+		{ "<r><e/><f/></r>", "{\"r\":{\"e\":\"\",\"f\":\"\"}}" },
+		{ "<\xC3\xA9l\xC3\xA9ment>1</\xC3\xA9l\xC3\xA9ment>", "{\"\xC3\xA9l\xC3\xA9ment\":1}" },
+	};
+	for (size_t i = 0; i < sizeof(kXmls) / sizeof(kXmls[0]); i++) {
+		EXPECT_EQ(kXmls[i][1], XmlToJson<0>(kXmls[i][0])) << kXmls[i][0];
+		EXPECT_EQ(kXmls[i][1], XmlToJson<kParseInsituFlag>(kXmls[i][0])) << kXmls[i][0];
+	}
+
+	// Only the first element
+	EXPECT_EQ("{\"a\":1}", XmlToJson<kParseStopWhenDoneFlag>("<a>1</a><b>2</b>"));
+}
+
+// Records the attributes of each OpenTag and StartObject
+struct AttributeHandler : BaseReaderHandler<> {
+	AttributeHandler() : log() {}
+	bool StartObject(const AttributeIteratorPair attribs) {
+		log += "{";
+		Append(attribs);
+		return true;
+	}
+	bool OpenTag(const Ch* str, SizeType length, const AttributeIteratorPairList attribs_list, bool) {
+		log += "<" + std::string(str, length);
+		if (attribs_list) {
+			Append(attribs_list[0]);
+			EXPECT_FALSE(attribs_list[1].IsValid());
+		}
+		log += ">";
+		return true;
+	}
+	void Append(const AttributeIteratorPair attribs) {
+		if (attribs.IsValid())
+			for (AttributeIteratorPair::GenericAttributeIterator a = attribs.begin; a != attribs.end; ++a)
+				log += " " + std::string(a->GetName(), a->GetNameLength()) + "=" + std::string(a->GetValue(), a->GetValueLength());
+	}
+	std::string log;
+};
+
+template <unsigned parseFlags>
+static std::string Attributes(const char* xml) {
+	AttributeHandler h;
+	XmlReader reader;
+	std::string insitu(xml);
+	if (parseFlags & kParseInsituFlag) {
+		InsituStringStream s(&insitu[0]);
+		EXPECT_TRUE(reader.Parse<parseFlags>(s, h));
+	}
+	else {
+		StringStream s(xml);
+		EXPECT_TRUE(reader.Parse<parseFlags>(s, h));
+	}
+	return h.log;
+}
+
+TEST(XmlReader, Attributes) {
+	static const char* kXmls[][2] = {
+		{ "<a x=\"1\"/>", "{<a x=1>" },
+		{ "<a x = '1'  y=\"&lt;&#x26;'\">t</a>", "{<a x=1 y=<&'>" },
+		{ "<r id=\"r1\"><c k=\"v\">1</c><d/></r>", "{<r id=r1>{ id=r1<c k=v><d>" },
+		{ "<r a=\"\" b='\"'><!-- c --><c/></r>", "{<r a= b=\">{ a= b=\"<c>" },
+	};
+	for (size_t i = 0; i < sizeof(kXmls) / sizeof(kXmls[0]); i++) {
+		EXPECT_EQ(kXmls[i][1], Attributes<0>(kXmls[i][0])) << kXmls[i][0];
+		EXPECT_EQ(kXmls[i][1], Attributes<kParseInsituFlag>(kXmls[i][0])) << kXmls[i][0];
+	}
+}
+
+static std::string DomToXml(const Document& d) {
+	StringBuffer buffer;
+	WriterXml<StringBuffer> writer(buffer);
+	d.Accept(writer);
+	return buffer.GetString();
+}
+
+TEST(XmlReader, Document) {
+	// The XML written from JSON is read back to the same XML
+	static const char* kJsons[] = {
+		"{\"a\":1}",
+		"{\"a\":null,\"b\":true,\"c\":false,\"d\":-1,\"e\":4294967295,\"f\":-5000000000,\"g\":18446744073709551615,\"h\":0.5}",
+		"{\"s\":\"x&y\\n\",\"t\":\"\\u00e9\"}",
+		"{\"o\":{\"p\":{\"q\":\"deep\"},\"r\":2},\"s\":3}",
+		"{\"item\":[{\"id\":1,\"tags\":[\"x\",\"y\"]},{\"id\":2}]}",
+	};
+	for (size_t i = 0; i < sizeof(kJsons) / sizeof(kJsons[0]); i++) {
+		Document json;
+		json.Parse(kJsons[i]);
+		ASSERT_FALSE(json.HasParseError());
+		const std::string xml = DomToXml(json);
+
+		Document d;
+		d.ParseXml(xml.c_str());
+		ASSERT_FALSE(d.HasParseError()) << xml;
+		EXPECT_EQ(xml, DomToXml(d));
+
+		std::string insitu(xml);
+		Document d2;
+		d2.ParseXmlInsitu(&insitu[0]);
+		ASSERT_FALSE(d2.HasParseError()) << xml;
+		EXPECT_EQ(xml, DomToXml(d2));
+	}
+
+	Document d;
+	d.ParseXml("<r><id>7</id><name>n</name></r>");
+	ASSERT_FALSE(d.HasParseError());
+	EXPECT_EQ(7, d["r"]["id"].GetInt());
+	EXPECT_STREQ("n", d["r"]["name"].GetString());
+}
+
+TEST(XmlReader, Arrays) {
+	// Consecutive siblings of the same name are an array with kParseXmlArraysFlag
+	static const char* kXmls[][2] = {
+		{ "<a>1</a><a>2</a>", "{\"a\":[1,2]}" },
+		{ "<r>\n  <item>1</item>\n  <item>2</item>\n</r>", "{\"r\":{\"item\":[1,2]}}" },
+		{ "<r><a>1</a><!-- c --><a><b>x</b><b>y</b></a><a/><c>3</c></r>", "{\"r\":{\"a\":[1,{\"b\":[\"x\",\"y\"]},\"\"],\"c\":3}}" },
+		{ "<r><a>1</a><b/><a>2</a></r>", "{\"r\":{\"a\":1,\"b\":\"\",\"a\":2}}" },
+		{ "<p><a>1</a>t<a>2</a><a>3</a></p>", "{\"p\":{\"a\":1,\"#text\":\"t\",\"a\":[2,3]}}" },
+		{ "<p><a>1</a><![CDATA[ ]]><a>2</a><![CDATA[x]]><a>3</a></p>", "{\"p\":{\"a\":[1,2],\"#text\":\"x\",\"a\":3}}" },
+		{ "<r><a k=\">a\">1</a><a>2</a><a x='/'/></r>", "{\"r\":{\"a\":[1,2,\"\"]}}" },
+		{ "<a>1</a>", "{\"a\":1}" },
+	};
+	for (size_t i = 0; i < sizeof(kXmls) / sizeof(kXmls[0]); i++) {
+		EXPECT_EQ(kXmls[i][1], XmlToJson<kParseXmlArraysFlag>(kXmls[i][0])) << kXmls[i][0];
+		EXPECT_EQ(kXmls[i][1], XmlToJson<kParseXmlArraysFlag | kParseInsituFlag>(kXmls[i][0])) << kXmls[i][0];
+	}
+	EXPECT_EQ("{\"r\":{\"a\":1,\"a\":2}}", XmlToJson<0>("<r><a>1</a><a>2</a></r>"));
+	EXPECT_EQ("{\"a\":1}", XmlToJson<kParseXmlArraysFlag | kParseStopWhenDoneFlag>("<a>1</a><a>2</a>"));
+
+	// A MemoryStream is scanned ahead up to its end
+	const char xml[] = "<r><a>1</a><a>2</a></r><r>";
+	MemoryStream ms(xml, sizeof(xml) - 1 - 3);
+	StringBuffer buffer;
+	WriterJson<StringBuffer> writer(buffer);
+	XmlReader reader;
+	EXPECT_TRUE(reader.Parse<kParseXmlArraysFlag>(ms, writer));
+	EXPECT_STREQ("{\"r\":{\"a\":[1,2]}}", buffer.GetString());
+
+	// The XML written from JSON arrays is read back to the same JSON, with the attributes of the elements
+	const char* json = "{\"r\":{\"a\":[1,{\"b\":2},3],\"s\":[\"x\"],\"t\":[\"y\",\"z\"]},\"u\":[true,null]}";
+	Document d;
+	d.Parse(json);
+	ASSERT_FALSE(d.HasParseError());
+	Value::AttributeType attrib("k", "v");
+	d["r"]["a"][1].AddAttribute(attrib, d.GetAllocator());
+	const std::string xml2 = DomToXml(d);
+	Document d2;
+	d2.ParseXml<kParseXmlArraysFlag>(xml2.c_str());
+	ASSERT_FALSE(d2.HasParseError()) << xml2;
+	StringBuffer buffer2;
+	WriterJson<StringBuffer> writer2(buffer2);
+	d2.Accept(writer2);
+	EXPECT_STREQ("{\"r\":{\"a\":[1,{\"b\":2},3],\"s\":\"x\",\"t\":[\"y\",\"z\"]},\"u\":[true,null]}", buffer2.GetString()); // one element is not an array
+	EXPECT_FALSE(d2["r"]["a"].HasAttributes());
+	EXPECT_FALSE(d2["r"]["a"][0u].HasAttributes());
+	ASSERT_EQ(1u, d2["r"]["a"][1].CountAttributes());
+	EXPECT_STREQ("v", d2["r"]["a"][1].AttributeBegin()->GetValue());
+	EXPECT_EQ(xml2, DomToXml(d2));
+}
+
+TEST(XmlReader, DocumentAttributes) {
+	// Attributes are kept in the values, in objects and in leaf values
+	const char* xml = "<r id=\"1\" k=\"a&amp;b\"><c x=\"y\">2</c><e z=\"\"></e><o p=\"q\"><n>3</n></o></r>";
+	Document d;
+	d.ParseXml(xml);
+	ASSERT_FALSE(d.HasParseError());
+	const Value& r = d["r"];
+	ASSERT_EQ(2u, r.CountAttributes());
+	EXPECT_STREQ("id", r.AttributeBegin()[0].GetName());
+	EXPECT_STREQ("1", r.AttributeBegin()[0].GetValue());
+	EXPECT_STREQ("k", r.AttributeBegin()[1].GetName());
+	EXPECT_STREQ("a&b", r.AttributeBegin()[1].GetValue());
+	EXPECT_EQ(3u, r.AttributeBegin()[1].GetValueLength());
+	ASSERT_EQ(1u, r["c"].CountAttributes());
+	EXPECT_STREQ("y", r["c"].AttributeBegin()->GetValue());
+	EXPECT_EQ(2, r["c"].GetInt());
+	ASSERT_EQ(1u, r["e"].CountAttributes());
+	EXPECT_EQ(0u, r["e"].AttributeBegin()->GetValueLength());
+	ASSERT_EQ(1u, r["o"].CountAttributes());
+	EXPECT_STREQ("q", r["o"].AttributeBegin()->GetValue());
+	EXPECT_FALSE(r["o"]["n"].HasAttributes());
+	EXPECT_FALSE(d.HasAttributes());
+
+	// Written back with the attributes
+	Document d2;
+	d2.ParseXml(DomToXml(d).c_str());
+	ASSERT_FALSE(d2.HasParseError());
+	EXPECT_EQ(DomToXml(d), DomToXml(d2));
+	EXPECT_NE(std::string::npos, DomToXml(d2).find("<c x=\"y\">2</c>"));
+
+	// Deep copies keep the attributes, including the ones of the copied value
+	Document copy;
+	Value r2(r, copy.GetAllocator());
+	ASSERT_EQ(2u, r2.CountAttributes());
+	EXPECT_NE(r.AttributeBegin()->GetName(), r2.AttributeBegin()->GetName());
+	EXPECT_STREQ("a&b", r2.AttributeBegin()[1].GetValue());
+	Value c2(r["c"], copy.GetAllocator());
+	ASSERT_EQ(1u, c2.CountAttributes());
+	EXPECT_STREQ("x", c2.AttributeBegin()->GetName());
+	Value d3(d, copy.GetAllocator());
+	ASSERT_EQ(1u, d3["r"]["o"].CountAttributes());
+
+	// Attributes of arrays and of their first element
+	Document a;
+	a.Parse("{\"a\":[1,{\"b\":2},3],\"c\":[[4,5],6]}");
+	ASSERT_FALSE(a.HasParseError());
+	Value::AttributeType attrib("k", "v");
+	a["a"].AddAttribute(attrib, a.GetAllocator());
+	Value::AttributeType firstAttrib("f", "0");
+	a["a"][0u].AddAttribute(firstAttrib, a.GetAllocator());
+	Value::AttributeType itemAttrib("i", "1");
+	a["a"][1].AddAttribute(itemAttrib, a.GetAllocator());
+	Value::AttributeType nestedAttrib("n", "2");
+	a["c"][0u].AddAttribute(nestedAttrib, a.GetAllocator());
+	Value a2(a, copy.GetAllocator());
+	EXPECT_EQ(1u, a2["a"].CountAttributes());
+	EXPECT_EQ(1u, a2["a"][0u].CountAttributes());
+	EXPECT_EQ(1u, a2["a"][1].CountAttributes());
+	EXPECT_FALSE(a2["a"][2].HasAttributes());
+	EXPECT_FALSE(a2["c"].HasAttributes());
+	EXPECT_EQ(1u, a2["c"][0u].CountAttributes());
+	EXPECT_FALSE(a2["c"][0u][0u].HasAttributes());
+	EXPECT_FALSE(a2["c"][1].HasAttributes());
+}
+
+TEST(XmlReader, FullPrecision) {
+	Document d;
+	d.ParseXml("<a>0.1</a><b>2.2250738585072011e-308</b><c>1.00000000000000011102230246251565404236316680908203125</c>");
+	ASSERT_FALSE(d.HasParseError());
+	EXPECT_EQ(0.1, d["a"].GetDouble());
+	EXPECT_EQ(2.2250738585072011e-308, d["b"].GetDouble());
+	EXPECT_EQ(1.0, d["c"].GetDouble()); // halfway, ties to even
+
+	// Further digits only matter by being non-zero
+	std::string xml("<c>1.00000000000000011102230246251565404236316680908203125");
+	xml.append(1000, '0');
+	xml += "1</c>";
+	d.ParseXml(xml.c_str());
+	ASSERT_FALSE(d.HasParseError());
+	EXPECT_EQ(1.0000000000000002, d["c"].GetDouble());
+}
+
+TEST(XmlReader, Error) {
+	static const struct {
+		const char* xml;
+		ParseErrorCode code;
+		size_t offset;
+	} kErrors[] = {
+		{ "", kParseErrorDocumentEmpty, 0 },
+		{ " <!-- c --> ", kParseErrorDocumentEmpty, 12 },
+		{ "x", kParseErrorXmlTextOutsideElement, 0 },
+		{ "<a>1</a>x", kParseErrorXmlTextOutsideElement, 8 },
+		{ "<1a/>", kParseErrorXmlNameInvalid, 1 },
+		{ "<a b></a>", kParseErrorXmlAttributeMissEquals, 4 },
+		{ "<a b=1></a>", kParseErrorXmlAttributeMissQuotationMark, 5 },
+		{ "<a b=\"1", kParseErrorXmlAttributeMissQuotationMark, 7 },
+		{ "<a b='<'></a>", kParseErrorXmlAttributeValueInvalid, 6 },
+		{ "<a b='1'c='2'></a", kParseErrorXmlTagMissGreaterThan, 17 },
+		{ "<a/ >", kParseErrorXmlTagMissGreaterThan, 3 },
+		{ "<a>1</b>", kParseErrorXmlTagMismatch, 6 },
+		{ "<a><b>1</a></b>", kParseErrorXmlTagMismatch, 9 },
+		{ "<a>1", kParseErrorXmlElementUnterminated, 4 },
+		{ "<a><b>1</b>", kParseErrorXmlElementUnterminated, 11 },
+		{ "<a>&foo;</a>", kParseErrorXmlEntityInvalid, 3 },
+		{ "<a>&lt</a>", kParseErrorXmlEntityInvalid, 3 },
+		{ "<a>&#0;</a>", kParseErrorXmlEntityInvalid, 3 },
+		{ "<a>&#xD800;</a>", kParseErrorXmlEntityInvalid, 3 },
+		{ "<a>&#x110000;</a>", kParseErrorXmlEntityInvalid, 3 },
+		{ "<a>&#;</a>", kParseErrorXmlEntityInvalid, 3 },
+		{ "<a><!-- x</a>", kParseErrorXmlMarkupInvalid, 13 },
+		{ "<a><![CDATA[x</a>", kParseErrorXmlMarkupInvalid, 17 },
+		{ "<a><![CDATAx]]></a>", kParseErrorXmlMarkupInvalid, 11 },
+		{ "<![CDATA[x]]>", kParseErrorXmlMarkupInvalid, 2 },
+		{ "<?xml", kParseErrorXmlMarkupInvalid, 5 },
+	};
+	for (size_t i = 0; i < sizeof(kErrors) / sizeof(kErrors[0]); i++) {
+		BaseReaderHandler<> h;
+		XmlReader reader;
+		StringStream s(kErrors[i].xml);
+		EXPECT_FALSE(reader.Parse(s, h)) << kErrors[i].xml;
+		EXPECT_EQ(kErrors[i].code, reader.GetParseErrorCode()) << kErrors[i].xml;
+		EXPECT_EQ(kErrors[i].offset, reader.GetErrorOffset()) << kErrors[i].xml;
+
+		std::string insitu(kErrors[i].xml);
+		InsituStringStream is(&insitu[0]);
+		EXPECT_FALSE(reader.Parse<kParseInsituFlag>(is, h)) << kErrors[i].xml;
+		EXPECT_EQ(kErrors[i].code, reader.GetParseErrorCode()) << kErrors[i].xml;
+
+		Document d;
+		d.ParseXml(kErrors[i].xml);
+		EXPECT_EQ(kErrors[i].code, d.GetParseError()) << kErrors[i].xml;
+	}
+}
+
+// Stops after the given number of events
+struct XmlStopHandler : BaseReaderHandler<> {
+	XmlStopHandler(int count) : count_(count) {}
+	bool Default() { return --count_ > 0; }
+	bool Uint(unsigned) { return Default(); }
+	bool String(const Ch*, SizeType, bool) { return Default(); }
+	bool StartObject(const AttributeIteratorPair) { return Default(); }
+	bool EndObject(SizeType) { return Default(); }
+	bool OpenTag(const Ch*, SizeType, const AttributeIteratorPairList, bool) { return Default(); }
+	bool CloseTag(const Ch*, SizeType, bool) { return Default(); }
+	int count_;
+};
+
+TEST(XmlReader, Termination) {
+	const char* xml = "<a x=\"1\">t<b>1</b></a>";
+	XmlReader reader;
+	for (int count = 1; count <= 12; count++) {
+		XmlStopHandler h(count);
+		StringStream s(xml);
+		EXPECT_FALSE(reader.Parse(s, h));
+		EXPECT_EQ(kParseErrorTermination, reader.GetParseErrorCode());
+	}
+	XmlStopHandler all(100);
+	StringStream s(xml);
+	EXPECT_TRUE(reader.Parse(s, all));
+	EXPECT_EQ(100 - 12, all.count_); // StartObject x2, OpenTag x3, String, Uint, CloseTag x3 and EndObject x2
+}